@@ -390,7 +390,8 @@ struct OutputContext
     {
         None,
         ExpandValueComponents = 0x1,
-        DesignStudioWorkarounds = ExpandValueComponents | 0x2
+        DesignStudioWorkarounds = ExpandValueComponents | 0x2,
+        CompressMeshes = 0x4
     };
     QTextStream &stream;
     QDir outdir;
@@ -910,7 +911,7 @@ static PropertyPair valueToQml(const QSSGSceneDesc::Node &target, const QSSGScen
 
         if (value.metaType() == QMetaType::fromType<QSSGSceneDesc::Mesh *>()) {
             //
-            const auto outputMeshAsset = [&ok, &reason](const QSSGSceneDesc::Scene &scene, const QSSGSceneDesc::Mesh &meshNode, const QDir &outdir) {
+            const auto outputMeshAsset = [&ok, &reason, &output](const QSSGSceneDesc::Scene &scene, const QSSGSceneDesc::Mesh &meshNode, const QDir &outdir) {
                 const auto meshFolder = getMeshFolder();
                 const auto meshSourceName = QSSGQmlUtilities::getMeshSourceName(meshNode.name);
                 Q_ASSERT(scene.meshStorage.size() > meshNode.idx);
@@ -934,7 +935,8 @@ static PropertyPair valueToQml(const QSSGSceneDesc::Node &target, const QSSGScen
                     return QString();
                 }
 
-                if (mesh.save(&file) == 0) {
+                const bool compressBuffers = (output.options & OutputContext::Options::CompressMeshes);
+                if (mesh.save(&file, 0, compressBuffers) == 0) {
                     if (ok)
                         *ok = false;
                     return QString();
@@ -1573,6 +1575,9 @@ void writeQml(const QSSGSceneDesc::Scene &scene, QTextStream &stream, const QDir
     if (checkBooleanOption(QLatin1String("designStudioWorkarounds"), options))
         outputOptions |= OutputContext::Options::DesignStudioWorkarounds;
 
+    if (checkBooleanOption(QLatin1String("compressMeshes"), options))
+        outputOptions |= OutputContext::Options::CompressMeshes;
+
     OutputContext output { stream, outdir, scene.sourceDir, 0, OutputContext::Header, outputOptions };
 
     writeImportHeader(output, scene.animations.count() > 0);
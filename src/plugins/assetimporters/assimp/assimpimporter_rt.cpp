@@ -131,6 +131,10 @@ struct SceneInfo
         bool generateMeshLODs = false;
         float lodNormalMergeAngle = 60.0;
         float lodNormalSplitAngle = 25.0;
+
+        bool generateMeshBvh = false;
+        bool optimizeMeshData = false;
+        bool quantizeMeshAttributes = false;
     };
 
     using MaterialMap = QVarLengthArray<QPair<const aiMaterial *, QSSGSceneDesc::Material *>>;
@@ -1157,7 +1161,11 @@ static void setModelProperties(QSSGSceneDesc::Model &target, const aiNode &sourc
                                                       sceneInfo.opt.generateMeshLODs,
                                                       sceneInfo.opt.lodNormalMergeAngle,
                                                       sceneInfo.opt.lodNormalSplitAngle,
+                                                      sceneInfo.opt.optimizeMeshData,
+                                                      sceneInfo.opt.quantizeMeshAttributes,
                                                       errorString);
+        if (sceneInfo.opt.generateMeshBvh)
+            meshData.createBvhData();
         meshStorage.push_back(std::move(meshData));
 
         const auto idx = meshStorage.size() - 1;
@@ -1522,6 +1530,10 @@ static SceneInfo::Options processSceneOptions(const QJsonObject &optionsObject)
         sceneOptions.lightmapBaseResolution = v == 0.0 ? 1024 : int(v);
     }
 
+    sceneOptions.generateMeshBvh = checkBooleanOption(QStringLiteral("generateMeshBvh"), options);
+    sceneOptions.optimizeMeshData = checkBooleanOption(QStringLiteral("optimizeMeshData"), options);
+    sceneOptions.quantizeMeshAttributes = checkBooleanOption(QStringLiteral("quantizeMeshAttributes"), options);
+
     sceneOptions.generateMeshLODs = checkBooleanOption(QStringLiteral("generateMeshLevelsOfDetail"), options);
     if (sceneOptions.generateMeshLODs) {
         bool recalculateLODNormals = checkBooleanOption(QStringLiteral("recalculateLodNormals"), options);
@@ -13,6 +13,7 @@
 #include <QtQuick3DUtils/private/qssgutils_p.h>
 
 #include <QtCore/qstring.h>
+#include <QtCore/qfloat16.h>
 #include <QtCore/QHash>
 #include <QtCore/QSet>
 
@@ -76,6 +77,11 @@ struct VertexDataRequirments {
     bool needsUV1Data = false;
     bool needsBones = false;
     bool useFloatJointIndices = false;
+    // Store normals and texture coordinates as half floats. Texture coordinates
+    // are only quantized when all of them keep enough precision (see canQuantizeUVs()).
+    bool quantizeAttributes = false;
+    bool uv0NotQuantizable = false;
+    bool uv1NotQuantizable = false;
 
     quint32 numMorphTargets = 0;
     // All the target mesh will have the same components
@@ -98,6 +104,10 @@ struct VertexDataRequirments {
         needsTangentData |= mesh->HasTangentsAndBitangents();
         needsVertexColorData |=mesh->HasVertexColors(0);
         needsBones |= mesh->HasBones();
+        if (quantizeAttributes) {
+            uv0NotQuantizable |= !canQuantizeUVs(mesh, 0);
+            uv1NotQuantizable |= !canQuantizeUVs(mesh, 1);
+        }
         numMorphTargets = mesh->mNumAnimMeshes;
         if (numMorphTargets && mesh->mAnimMeshes) {
             for (uint i = 0; i < numMorphTargets; ++i) {
@@ -111,6 +121,29 @@ struct VertexDataRequirments {
             }
         }
     }
+
+    bool quantizeNormals() const { return quantizeAttributes; }
+    bool quantizeUV0() const { return quantizeAttributes && uv0Components == 2 && !uv0NotQuantizable; }
+    bool quantizeUV1() const { return quantizeAttributes && uv1Components == 2 && !uv1NotQuantizable; }
+
+    // Largest error allowed for a quantized texture coordinate: half a texel of a 2048x2048 texture
+    static constexpr float MaxUVQuantizationError = 1.0f / 4096.0f;
+
+    static bool canQuantizeUVs(const aiMesh *mesh, unsigned int channel)
+    {
+        // Only [0, 1] is quantized, where half floats stay within MaxUVQuantizationError. Tiled
+        // coordinates beyond that lose a bit of precision with every doubling of their range.
+        if (!mesh->HasTextureCoords(channel))
+            return true;
+        for (unsigned int index = 0; index < mesh->mNumVertices; ++index) {
+            const auto uv = mesh->mTextureCoords[channel][index];
+            for (const float c : { uv.x, uv.y }) {
+                if (!(c >= 0.0f && c <= 1.0f) || qAbs(float(qfloat16(c)) - c) > MaxUVQuantizationError)
+                    return false;
+            }
+        }
+        return true;
+    }
 };
 
 QVector<VertexAttributeDataExt> getVertexAttributeData(const aiMesh *mesh, const VertexDataRequirments &requirments)
@@ -284,12 +317,25 @@ struct VertexBufferDataExt {
         if (requirments.needsPositionData)
             vData.positionData += QByteArray::fromRawData(reinterpret_cast<const char *>(&vertex.aData.position), sizeof(QVector3D));
         // Normal
-        if (requirments.needsNormalData)
-            vData.normalData += QByteArray::fromRawData(reinterpret_cast<const char *>(&vertex.aData.normal), sizeof(QVector3D));
+        if (requirments.needsNormalData) {
+            if (requirments.quantizeNormals()) {
+                // Padded to 4 components to keep the following attributes 4 byte aligned
+                const qfloat16 normal[4] = { qfloat16(vertex.aData.normal.x()),
+                                             qfloat16(vertex.aData.normal.y()),
+                                             qfloat16(vertex.aData.normal.z()),
+                                             qfloat16(0.0f) };
+                vData.normalData += QByteArray(reinterpret_cast<const char *>(normal), sizeof(normal));
+            } else {
+                vData.normalData += QByteArray::fromRawData(reinterpret_cast<const char *>(&vertex.aData.normal), sizeof(QVector3D));
+            }
+        }
         // UV0
 
         if (requirments.needsUV0Data) {
-            if (requirments.uv0Components == 2) {
+            if (requirments.quantizeUV0()) {
+                const qfloat16 uv[2] = { qfloat16(vertex.aData.uv0.x()), qfloat16(vertex.aData.uv0.y()) };
+                vData.uv0Data += QByteArray(reinterpret_cast<const char *>(uv), sizeof(uv));
+            } else if (requirments.uv0Components == 2) {
                 const QVector2D uv(vertex.aData.uv0.x(), vertex.aData.uv0.y());
                 vData.uv0Data += QByteArray::fromRawData(reinterpret_cast<const char *>(&uv), sizeof(QVector2D));
             } else {
@@ -299,7 +345,10 @@ struct VertexBufferDataExt {
 
         // UV1
         if (requirments.needsUV1Data) {
-            if (requirments.uv1Components == 2) {
+            if (requirments.quantizeUV1()) {
+                const qfloat16 uv[2] = { qfloat16(vertex.aData.uv1.x()), qfloat16(vertex.aData.uv1.y()) };
+                vData.uv1Data += QByteArray(reinterpret_cast<const char *>(uv), sizeof(uv));
+            } else if (requirments.uv1Components == 2) {
                 const QVector2D uv(vertex.aData.uv1.x(), vertex.aData.uv1.y());
                 vData.uv1Data += QByteArray::fromRawData(reinterpret_cast<const char *>(&uv), sizeof(QVector2D));
             } else {
@@ -374,15 +423,17 @@ struct VertexBufferDataExt {
             entries.append({
                                QSSGMesh::MeshInternal::getNormalAttrName(),
                                vData.normalData,
-                               QSSGMesh::Mesh::ComponentType::Float32,
-                               3
+                               requirments.quantizeNormals() ? QSSGMesh::Mesh::ComponentType::Float16
+                                                             : QSSGMesh::Mesh::ComponentType::Float32,
+                               requirments.quantizeNormals() ? 4u : 3u
                            });
         }
         if (vData.uv0Data.size() > 0) {
             entries.append({
                                QSSGMesh::MeshInternal::getUV0AttrName(),
                                vData.uv0Data,
-                               QSSGMesh::Mesh::ComponentType::Float32,
+                               requirments.quantizeUV0() ? QSSGMesh::Mesh::ComponentType::Float16
+                                                         : QSSGMesh::Mesh::ComponentType::Float32,
                                requirments.uv0Components
                            });
         }
@@ -390,7 +441,8 @@ struct VertexBufferDataExt {
             entries.append({
                                QSSGMesh::MeshInternal::getUV1AttrName(),
                                vData.uv1Data,
-                               QSSGMesh::Mesh::ComponentType::Float32,
+                               requirments.quantizeUV1() ? QSSGMesh::Mesh::ComponentType::Float16
+                                                         : QSSGMesh::Mesh::ComponentType::Float32,
                                requirments.uv1Components
                            });
         }
@@ -669,6 +721,8 @@ QSSGMesh::Mesh AssimpUtils::generateMeshData(const aiScene &scene,
                                              bool generateLevelsOfDetail,
                                              float normalMergeAngle,
                                              float normalSplitAngle,
+                                             bool optimizeMeshData,
+                                             bool quantizeAttributes,
                                              QString &errorString)
 {
     // All Mesh subsets are stored in the same Vertex Buffer so we need to make
@@ -677,6 +731,7 @@ QSSGMesh::Mesh AssimpUtils::generateMeshData(const aiScene &scene,
     // So we need to walk through each subset first and see what the requirments are
     VertexDataRequirments requirments;
     requirments.useFloatJointIndices = useFloatJointIndices;
+    requirments.quantizeAttributes = quantizeAttributes;
     for (const auto *mesh : meshes)
         requirments.collectRequirmentsForMesh(mesh);
 
@@ -747,6 +802,35 @@ QSSGMesh::Mesh AssimpUtils::generateMeshData(const aiScene &scene,
         // Optimize the vertex chache for the original index values
         QSSGMesh::optimizeVertexCache(indexes.data(), indexes.data(), indexes.size(), vertexAttributes.size());
 
+        if (optimizeMeshData && !indexes.isEmpty()) {
+            // Reorder the triangles to reduce overdraw, at the cost of at most 5% of the
+            // vertex cache efficiency
+            QVector<QVector3D> positions;
+            positions.reserve(vertexAttributes.size());
+            for (const auto &vertex : std::as_const(vertexAttributes))
+                positions.append(vertex.aData.position);
+            QSSGMesh::optimizeOverdraw(indexes.data(), indexes.data(), indexes.size(),
+                                       reinterpret_cast<const float *>(positions.constData()), positions.size(),
+                                       sizeof(QVector3D), 1.05f);
+
+            // Store the vertices in the order they are first used, which also drops unused
+            // ones. The original indexes go first, as they are the ones drawn the most.
+            const QVector<quint32> allIndexes = indexes + lodIndexes;
+            QVector<quint32> remap(vertexAttributes.size());
+            const size_t vertexCount = QSSGMesh::optimizeVertexFetchRemap(remap.data(), allIndexes.constData(),
+                                                                          allIndexes.size(), vertexAttributes.size());
+            QVector<VertexAttributeDataExt> remappedAttributes(vertexCount);
+            for (qsizetype i = 0; i < vertexAttributes.size(); ++i) {
+                if (remap[i] != ~0u)
+                    remappedAttributes[remap[i]] = vertexAttributes[i];
+            }
+            vertexAttributes = remappedAttributes;
+            for (auto &index : indexes)
+                index = remap[index];
+            for (auto &index : lodIndexes)
+                index = remap[index];
+        }
+
         // Write Index Buffer Data
         QVector<quint32> combinedIndexValues = lodIndexes + indexes;
         // Set the absolute index relative to the larger vertex buffer
@@ -26,6 +26,8 @@ QSSGMesh::Mesh generateMeshData(const aiScene &scene,
                                 bool generateLevelsOfDetail,
                                 float normalMergeAngle,
                                 float normalSplitAngle,
+                                bool optimizeMeshData,
+                                bool quantizeAttributes,
                                 QString &errorString);
 
 }
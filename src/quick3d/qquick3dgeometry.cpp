@@ -800,6 +800,45 @@ void QQuick3DGeometry::addSubset(int offset, int count, const QVector3D &boundsM
     d->m_geometryChanged = true;
 }
 
+/*!
+    \since 6.6
+
+    Returns \c true if levels of detail are generated for the geometry.
+
+    \sa setAutomaticLevelsOfDetail()
+*/
+bool QQuick3DGeometry::automaticLevelsOfDetail() const
+{
+    Q_D(const QQuick3DGeometry);
+    return d->m_automaticLevelsOfDetail;
+}
+
+/*!
+    \since 6.6
+
+    Sets whether simplified levels of detail are generated for the geometry to \a enable.
+
+    When enabled, the renderer simplifies each subset of the geometry in the background, every
+    time the geometry data changes. Until the simplified versions are available, the geometry is
+    rendered at full detail. Afterwards, the subsets are rendered with fewer triangles the
+    smaller they appear on screen, the same way as meshes imported with levels of detail. See
+    \l {Model::levelOfDetailBias}{levelOfDetailBias}.
+
+    Levels of detail are only generated for triangle geometry that has index data, and position
+    data made of three 32-bit floats. The vertex data is left as is, the levels of detail only
+    add to the index data, so this is best suited for geometry that does not change every frame.
+
+    The default value is \c false.
+*/
+void QQuick3DGeometry::setAutomaticLevelsOfDetail(bool enable)
+{
+    Q_D(QQuick3DGeometry);
+    if (d->m_automaticLevelsOfDetail == enable)
+        return;
+    d->m_automaticLevelsOfDetail = enable;
+    d->m_geometryChanged = true;
+}
+
 static inline QSSGMesh::Mesh::DrawMode mapPrimitiveType(QQuick3DGeometry::PrimitiveType t)
 {
     switch (t) {
@@ -928,6 +967,7 @@ QSSGRenderGraphObject *QQuick3DGeometry::updateSpatialNode(QSSGRenderGraphObject
             for (auto &s : d->m_subsets)
                 geometry->addSubset(s.offset, s.count, s.boundsMin, s.boundsMax, s.name);
         }
+        geometry->setAutomaticLevelsOfDetail(d->m_automaticLevelsOfDetail);
         d->m_geometryChanged = false;
     }
     if (d->m_geometryBoundsChanged) {
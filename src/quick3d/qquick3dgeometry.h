@@ -104,6 +104,9 @@ public:
                                              int stride = 0);
     Q_REVISION(6, 4) void addTargetAttribute(const TargetAttribute &att);
 
+    Q_REVISION(6, 6) bool automaticLevelsOfDetail() const;
+    Q_REVISION(6, 6) void setAutomaticLevelsOfDetail(bool enable);
+
     void clear();
 
 Q_SIGNALS:
@@ -54,6 +54,7 @@ public:
     bool m_geometryBoundsChanged = true;
     bool m_targetChanged = true;
     bool m_usesOldTargetSemantics = false;
+    bool m_automaticLevelsOfDetail = false;
 
     static QQuick3DGeometry::Attribute::Semantic semanticFromName(const QByteArray &name);
     static QQuick3DGeometry::Attribute::ComponentType toComponentType(QSSGMesh::Mesh::ComponentType componentType);
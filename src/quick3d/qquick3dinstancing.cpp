@@ -6,6 +6,7 @@
 #include <QtQuick3DUtils/private/qssgutils_p.h>
 #include <QXmlStreamReader>
 #include <QtQml/QQmlFile>
+#include <QtCore/qthread.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -113,7 +114,8 @@ QT_BEGIN_NAMESPACE
 
     Implement this function to return the contents of the instance table. The number of instances should be
     returned in \a instanceCount. The subclass is responsible for caching the result if necessary. If the
-    instance table changes, the subclass should call markDirty().
+    instance table changes, the subclass should call markDirty(), or updateInstances() when only
+    some of the instances changed.
  */
 
 QQuick3DInstancingPrivate::QQuick3DInstancingPrivate()
@@ -339,6 +341,51 @@ void QQuick3DInstancing::markDirty()
     emit instanceTableChanged();
 }
 
+/*!
+  \since 6.6
+
+  Mark that the \a count instances starting at index \a offset have changed and must be
+  uploaded again.
+
+  Unlike markDirty(), only the changed instances are copied to the renderer and uploaded to
+  the graphics memory, which makes moving a few instances of a large table cheap. For this
+  to work the subclass should modify the buffer it returns from getInstanceBuffer() in place,
+  and keep the number of instances the same. Otherwise the whole table is uploaded again.
+  Ranges passed between two frames are combined.
+
+  This function can be called from any thread. The buffer returned by getInstanceBuffer() is
+  read on the render thread while the scene is synchronized, so a subclass that modifies it
+  from another thread must synchronize getInstanceBuffer() with those modifications.
+
+  \sa markDirty(), getInstanceBuffer()
+  */
+
+void QQuick3DInstancing::updateInstances(int offset, int count)
+{
+    Q_D(QQuick3DInstancing);
+    if (offset < 0 || count <= 0)
+        return;
+
+    {
+        QMutexLocker locker(&d->m_updatedRangesMutex);
+        const bool pending = !d->m_updatedRanges.isEmpty();
+        d->m_updatedRanges.append({ offset, count });
+        // The scene has already been marked dirty for the earlier ranges
+        if (pending)
+            return;
+    }
+
+    auto markContentDirty = [this]() {
+        Q_D(QQuick3DInstancing);
+        d->dirty(QQuick3DObjectPrivate::DirtyType::Content);
+        emit instanceTableChanged();
+    };
+    if (QThread::currentThread() == thread())
+        markContentDirty();
+    else
+        QMetaObject::invokeMethod(this, markContentDirty, Qt::QueuedConnection);
+}
+
 QSSGRenderGraphObject *QQuick3DInstancing::updateSpatialNode(QSSGRenderGraphObject *node)
 {
     Q_D(QQuick3DInstancing);
@@ -354,8 +401,23 @@ QSSGRenderGraphObject *QQuick3DInstancing::updateSpatialNode(QSSGRenderGraphObje
             return qMin(d->m_instanceCount, d->m_instanceCountOverride);
         return d->m_instanceCount;
     };
+    QVector<QSSGRenderInstanceTable::Range> updatedRanges;
+    {
+        QMutexLocker locker(&d->m_updatedRangesMutex);
+        updatedRanges.swap(d->m_updatedRanges);
+    }
     auto *instanceTable = static_cast<QSSGRenderInstanceTable *>(node);
-    if (d->m_instanceDataChanged) {
+    if (!d->m_instanceDataChanged && !updatedRanges.isEmpty()) {
+        const int previousCount = d->m_instanceCount;
+        QByteArray buffer = getInstanceBuffer(&d->m_instanceCount);
+        if (d->m_instanceCount == previousCount && buffer.size() == instanceTable->dataSize()) {
+            instanceTable->updateData(buffer, updatedRanges);
+            if (d->m_instanceCountOverrideChanged)
+                instanceTable->setInstanceCountOverride(effectiveInstanceCount());
+        } else {
+            instanceTable->setData(buffer, effectiveInstanceCount(), sizeof(InstanceTableEntry));
+        }
+    } else if (d->m_instanceDataChanged) {
         QByteArray buffer = getInstanceBuffer(&d->m_instanceCount);
         instanceTable->setData(buffer, effectiveInstanceCount(), sizeof(InstanceTableEntry));
         d->m_instanceDataChanged = false;
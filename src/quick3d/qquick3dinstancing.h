@@ -68,6 +68,7 @@ Q_SIGNALS:
 protected:
     virtual QByteArray getInstanceBuffer(int *instanceCount) = 0;
     void markDirty();
+    void updateInstances(int offset, int count);
     static InstanceTableEntry calculateTableEntry(const QVector3D &position,
                           const QVector3D &scale, const QVector3D &eulerRotation,
                                                   const QColor &color, const QVector4D &customData = {});
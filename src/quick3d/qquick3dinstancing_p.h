@@ -18,7 +18,10 @@
 #include <QtQuick3D/qquick3dinstancing.h>
 #include <QtQuick3D/private/qquick3dobject_p.h>
 
+#include <QtQuick3DRuntimeRender/private/qssgrenderinstancetable_p.h>
+
 #include <QtGui/qvector3d.h>
+#include <QtCore/qmutex.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -32,6 +35,9 @@ public:
     bool m_instanceDataChanged = true;
     bool m_instanceCountOverrideChanged = false;
     bool m_depthSortingEnabled = false;
+    // Ranges passed to updateInstances(), which can be called from any thread
+    QMutex m_updatedRangesMutex;
+    QVector<QSSGRenderInstanceTable::Range> m_updatedRanges;
 };
 
 class Q_QUICK3D_EXPORT QQuick3DInstanceListEntry : public QQuick3DObject
@@ -123,6 +123,41 @@ QT_BEGIN_NAMESPACE
     The default value is 1.
  */
 
+/*!
+    \qmlproperty int Lightmapper::passes
+    \since 6.6
+
+    The number of passes the indirect light \l samples are taken in. With
+    more than one pass, the baking is progressive: after each pass, the
+    lightmaps are written out with the samples taken so far, so the partial
+    results can be previewed, together with a checkpoint file next to each
+    lightmap (\c{qlm_<key>.checkpoint}).
+
+    When a progressive bake is interrupted, for example by cancelling it, the
+    next bake of the same scene with the same settings continues from the
+    checkpoints instead of starting over. The checkpoint files are removed
+    once the bake completes.
+
+    The default value is 1, meaning all the samples of a texel are taken at
+    once and no checkpoints are written.
+
+    \sa noiseThreshold
+ */
+
+/*!
+    \qmlproperty float Lightmapper::noiseThreshold
+    \since 6.6
+
+    Allows taking fewer indirect light samples for texels that have already
+    converged. After each progressive pass, a texel stops being sampled when
+    the estimated standard error of its indirect light luminance is below
+    this fraction of its mean luminance. For example, with a value of 0.01
+    sampling stops once the estimated noise is below 1%.
+
+    The value only has an effect when \l passes is larger than 1. The
+    default value is 0, meaning all texels get all the \l samples.
+ */
+
 float QQuick3DLightmapper::opacityThreshold() const
 {
     return m_opacityThreshold;
@@ -163,6 +198,16 @@ float QQuick3DLightmapper::indirectLightFactor() const
     return m_indirectFactor;
 }
 
+int QQuick3DLightmapper::passes() const
+{
+    return m_passes;
+}
+
+float QQuick3DLightmapper::noiseThreshold() const
+{
+    return m_noiseThreshold;
+}
+
 void QQuick3DLightmapper::setOpacityThreshold(float opacity)
 {
     if (m_opacityThreshold == opacity)
@@ -243,4 +288,24 @@ void QQuick3DLightmapper::setIndirectLightFactor(float factor)
     emit changed();
 }
 
+void QQuick3DLightmapper::setPasses(int count)
+{
+    if (m_passes == count)
+        return;
+
+    m_passes = count;
+    emit passesChanged();
+    emit changed();
+}
+
+void QQuick3DLightmapper::setNoiseThreshold(float threshold)
+{
+    if (m_noiseThreshold == threshold)
+        return;
+
+    m_noiseThreshold = threshold;
+    emit noiseThresholdChanged();
+    emit changed();
+}
+
 QT_END_NAMESPACE
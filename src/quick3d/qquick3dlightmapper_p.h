@@ -30,6 +30,8 @@ class Q_QUICK3D_EXPORT QQuick3DLightmapper : public QObject
     Q_PROPERTY(int indirectLightWorkgroupSize READ indirectLightWorkgroupSize WRITE setIndirectLightWorkgroupSize NOTIFY indirectLightWorkgroupSizeChanged)
     Q_PROPERTY(int bounces READ bounces WRITE setBounces NOTIFY bouncesChanged)
     Q_PROPERTY(float indirectLightFactor READ indirectLightFactor WRITE setIndirectLightFactor NOTIFY indirectLightFactorChanged)
+    Q_PROPERTY(int passes READ passes WRITE setPasses NOTIFY passesChanged REVISION(6, 6))
+    Q_PROPERTY(float noiseThreshold READ noiseThreshold WRITE setNoiseThreshold NOTIFY noiseThresholdChanged REVISION(6, 6))
 
     QML_NAMED_ELEMENT(Lightmapper)
 
@@ -42,6 +44,8 @@ public:
     int indirectLightWorkgroupSize() const;
     int bounces() const;
     float indirectLightFactor() const;
+    Q_REVISION(6, 6) int passes() const;
+    Q_REVISION(6, 6) float noiseThreshold() const;
 
 public Q_SLOTS:
     void setOpacityThreshold(float opacity);
@@ -52,6 +56,8 @@ public Q_SLOTS:
     void setIndirectLightWorkgroupSize(int size);
     void setBounces(int count);
     void setIndirectLightFactor(float factor);
+    Q_REVISION(6, 6) void setPasses(int count);
+    Q_REVISION(6, 6) void setNoiseThreshold(float threshold);
 
 Q_SIGNALS:
     void changed();
@@ -63,6 +69,8 @@ Q_SIGNALS:
     void indirectLightWorkgroupSizeChanged();
     void bouncesChanged();
     void indirectLightFactorChanged();
+    Q_REVISION(6, 6) void passesChanged();
+    Q_REVISION(6, 6) void noiseThresholdChanged();
 
 private:
     // keep the defaults in sync with the default values in QSSGLightmapperOptions
@@ -74,6 +82,8 @@ private:
     int m_workgroupSize = 32;
     int m_bounces = 3;
     float m_indirectFactor = 1.0f;
+    int m_passes = 1;
+    float m_noiseThreshold = 0.0f;
 };
 
 QT_END_NAMESPACE
@@ -153,6 +153,7 @@ QSSGRenderGraphObject *QQuick3DMaterial::updateSpatialNode(QSSGRenderGraphObject
 
         defaultMaterial->cullMode = QSSGCullFaceMode(m_cullMode);
         defaultMaterial->depthDrawMode = QSSGDepthDrawMode(m_depthDrawMode);
+        ++defaultMaterial->updateSerial;
 
         DebugViewHelpers::ensureDebugObjectName(defaultMaterial, this);
 
@@ -167,6 +168,7 @@ QSSGRenderGraphObject *QQuick3DMaterial::updateSpatialNode(QSSGRenderGraphObject
 
         customMaterial->m_cullMode = QSSGCullFaceMode(m_cullMode);
         customMaterial->m_depthDrawMode = QSSGDepthDrawMode(m_depthDrawMode);
+        ++customMaterial->m_updateSerial;
 
         DebugViewHelpers::ensureDebugObjectName(customMaterial, this);
 
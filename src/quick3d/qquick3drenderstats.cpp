@@ -423,6 +423,9 @@ void QQuick3DRenderStats::processRhiContextStats()
 
     m_results.imageDataSize = globalData.imageDataSize;
     m_results.meshDataSize = globalData.meshDataSize;
+    m_results.resourceCacheHitCount = globalData.residencyHitCount;
+    m_results.resourceCacheMissCount = globalData.residencyMissCount;
+    m_results.resourceEvictionCount = globalData.residencyEvictionCount;
 
     m_results.renderPassCount = data.renderPasses.size()
             + (data.externalRenderPass.pixelSize.isEmpty() ? 0 : 1);
@@ -543,6 +546,21 @@ void QQuick3DRenderStats::notifyRhiContextStats()
         emit meshDataSizeChanged();
     }
 
+    if (m_results.resourceCacheHitCount != m_notifiedResults.resourceCacheHitCount) {
+        m_notifiedResults.resourceCacheHitCount = m_results.resourceCacheHitCount;
+        emit resourceCacheHitCountChanged();
+    }
+
+    if (m_results.resourceCacheMissCount != m_notifiedResults.resourceCacheMissCount) {
+        m_notifiedResults.resourceCacheMissCount = m_results.resourceCacheMissCount;
+        emit resourceCacheMissCountChanged();
+    }
+
+    if (m_results.resourceEvictionCount != m_notifiedResults.resourceEvictionCount) {
+        m_notifiedResults.resourceEvictionCount = m_results.resourceEvictionCount;
+        emit resourceEvictionCountChanged();
+    }
+
     if (m_results.renderPassCount != m_notifiedResults.renderPassCount) {
         m_notifiedResults.renderPassCount = m_results.renderPassCount;
         emit renderPassCountChanged();
@@ -676,6 +694,78 @@ quint64 QQuick3DRenderStats::meshDataSize() const
     return m_results.meshDataSize;
 }
 
+/*!
+    \qmlproperty quint64 QtQuick3D::RenderStats::resourceCacheHitCount
+    \readonly
+
+    This property holds the number of times a mesh or a texture map was needed
+    by a frame and was already loaded, so no data had to be uploaded to the
+    GPU. Resources used by more than one frame count once per frame.
+
+    The value is updated only when extendedDataCollectionEnabled is enabled.
+
+    \note The value is reported on a per-QQuickWindow basis. If there are
+    multiple View3D instances within the same window, the DebugView shows the
+    same value for all those View3Ds.
+
+    \sa resourceCacheMissCount, resourceEvictionCount
+    \since 6.6
+*/
+quint64 QQuick3DRenderStats::resourceCacheHitCount() const
+{
+    return m_results.resourceCacheHitCount;
+}
+
+/*!
+    \qmlproperty quint64 QtQuick3D::RenderStats::resourceCacheMissCount
+    \readonly
+
+    This property holds the number of times a mesh or a texture map had to be
+    loaded and uploaded to the GPU.
+
+    The value is updated only when extendedDataCollectionEnabled is enabled.
+
+    \note The value is reported on a per-QQuickWindow basis. If there are
+    multiple View3D instances within the same window, the DebugView shows the
+    same value for all those View3Ds.
+
+    \sa resourceCacheHitCount, resourceEvictionCount
+    \since 6.6
+*/
+quint64 QQuick3DRenderStats::resourceCacheMissCount() const
+{
+    return m_results.resourceCacheMissCount;
+}
+
+/*!
+    \qmlproperty quint64 QtQuick3D::RenderStats::resourceEvictionCount
+    \readonly
+
+    This property holds the number of meshes and texture maps that were
+    released because they were no longer used by the scene.
+
+    By default such resources are released at the end of the first frame that
+    does not use them. When the environment variable
+    \c{QT_QUICK3D_RESOURCE_BUDGET_MB} is set to a number of megabytes, unused
+    resources instead stay loaded, and are released least recently used first
+    only when the total size of the mesh and image data (see \l meshDataSize
+    and \l imageDataSize) would exceed the budget. This avoids reloading
+    assets that are shown and hidden repeatedly.
+
+    The value is updated only when extendedDataCollectionEnabled is enabled.
+
+    \note The value is reported on a per-QQuickWindow basis. If there are
+    multiple View3D instances within the same window, the DebugView shows the
+    same value for all those View3Ds.
+
+    \sa resourceCacheHitCount, resourceCacheMissCount
+    \since 6.6
+*/
+quint64 QQuick3DRenderStats::resourceEvictionCount() const
+{
+    return m_results.resourceEvictionCount;
+}
+
 /*!
     \qmlproperty int QtQuick3D::RenderStats::renderPassCount
     \readonly
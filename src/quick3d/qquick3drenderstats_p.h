@@ -40,6 +40,9 @@ class Q_QUICK3D_EXPORT QQuick3DRenderStats : public QObject
     Q_PROPERTY(quint64 drawVertexCount READ drawVertexCount NOTIFY drawVertexCountChanged)
     Q_PROPERTY(quint64 imageDataSize READ imageDataSize NOTIFY imageDataSizeChanged)
     Q_PROPERTY(quint64 meshDataSize READ meshDataSize NOTIFY meshDataSizeChanged)
+    Q_PROPERTY(quint64 resourceCacheHitCount READ resourceCacheHitCount NOTIFY resourceCacheHitCountChanged)
+    Q_PROPERTY(quint64 resourceCacheMissCount READ resourceCacheMissCount NOTIFY resourceCacheMissCountChanged)
+    Q_PROPERTY(quint64 resourceEvictionCount READ resourceEvictionCount NOTIFY resourceEvictionCountChanged)
     Q_PROPERTY(int renderPassCount READ renderPassCount NOTIFY renderPassCountChanged)
     Q_PROPERTY(QString renderPassDetails READ renderPassDetails NOTIFY renderPassDetailsChanged)
     Q_PROPERTY(QString textureDetails READ textureDetails NOTIFY textureDetailsChanged)
@@ -79,6 +82,9 @@ public:
     quint64 drawVertexCount() const;
     quint64 imageDataSize() const;
     quint64 meshDataSize() const;
+    quint64 resourceCacheHitCount() const;
+    quint64 resourceCacheMissCount() const;
+    quint64 resourceEvictionCount() const;
     int renderPassCount() const;
     QString renderPassDetails() const;
     QString textureDetails() const;
@@ -106,6 +112,9 @@ Q_SIGNALS:
     void drawVertexCountChanged();
     void imageDataSizeChanged();
     void meshDataSizeChanged();
+    void resourceCacheHitCountChanged();
+    void resourceCacheMissCountChanged();
+    void resourceEvictionCountChanged();
     void renderPassCountChanged();
     void renderPassDetailsChanged();
     void textureDetailsChanged();
@@ -148,6 +157,9 @@ private:
         quint64 drawVertexCount = 0;
         quint64 imageDataSize = 0;
         quint64 meshDataSize = 0;
+        quint64 resourceCacheHitCount = 0;
+        quint64 resourceCacheMissCount = 0;
+        quint64 resourceEvictionCount = 0;
         int renderPassCount = 0;
         QString renderPassDetails;
         QString textureDetails;
@@ -1083,6 +1083,8 @@ void QQuick3DRenderLayerHelpers::updateLayerNodeHelper(const QQuick3DViewport &v
         layerNode.lmOptions.indirectLightWorkgroupSize = lightmapper->indirectLightWorkgroupSize();
         layerNode.lmOptions.indirectLightBounces = lightmapper->bounces();
         layerNode.lmOptions.indirectLightFactor = lightmapper->indirectLightFactor();
+        layerNode.lmOptions.indirectLightPasses = lightmapper->passes();
+        layerNode.lmOptions.indirectLightNoiseThreshold = lightmapper->noiseThreshold();
     } else {
         layerNode.lmOptions = {};
     }
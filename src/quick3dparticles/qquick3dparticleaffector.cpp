@@ -95,6 +95,17 @@ void QQuick3DParticleAffector::prepareToAffect()
 {
 }
 
+void QQuick3DParticleAffector::affectParticles(const QQuick3DParticleDataSpan &span)
+{
+    for (int i = 0; i < span.count; i++)
+        affectParticle(span.particleData[span.indices[i]], &span.currentData[i], span.times[i]);
+}
+
+bool QQuick3DParticleAffector::canAffectConcurrently() const
+{
+    return false;
+}
+
 // Particles
 
 /*!
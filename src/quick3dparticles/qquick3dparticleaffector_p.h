@@ -73,6 +73,12 @@ private:
     virtual void prepareToAffect();
     // Called for each living particle attached to the attractor.
     virtual void affectParticle(const QQuick3DParticleData &sd, QQuick3DParticleDataCurrent *d, float time) = 0;
+    // Called for a batch of living particles attached to the affector.
+    // The default implementation calls affectParticle() for each of them.
+    virtual void affectParticles(const QQuick3DParticleDataSpan &span);
+    // Whether affectParticles() can be called for different spans at the same time,
+    // from other threads than the one that called prepareToAffect().
+    virtual bool canAffectConcurrently() const;
 
     static void appendParticle(QQmlListProperty<QQuick3DParticle> *, QQuick3DParticle *);
     static qsizetype particleCount(QQmlListProperty<QQuick3DParticle> *);
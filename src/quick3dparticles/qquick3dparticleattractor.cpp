@@ -262,42 +262,61 @@ void QQuick3DParticleAttractor::prepareToAffect()
 }
 
 void QQuick3DParticleAttractor::affectParticle(const QQuick3DParticleData &sd, QQuick3DParticleDataCurrent *d, float time)
+{
+    const int index = 0;
+    affectParticles({ &sd, &index, &time, d, 1 });
+}
+
+void QQuick3DParticleAttractor::affectParticles(const QQuick3DParticleDataSpan &span)
 {
     if (!system())
         return;
 
     auto rand = system()->rand();
-    float duration = m_duration < 0 ? sd.lifetime : (m_duration / 1000.0f);
-    float durationVariation = m_durationVariation == 0
-            ? 0.0f
-            : (m_durationVariation / 1000.0f) - 2.0f * rand->get(sd.index, QPRand::AttractorDurationV) * (m_durationVariation / 1000.0f);
-    duration = std::max(duration + durationVariation, MIN_DURATION);
-    float pEnd = std::min(1.0f, std::max(0.0f, time / duration));
-    // TODO: Should we support easing?
-    //pEnd = easeInOutQuad(pEnd);
-
-    if (m_hideAtEnd && pEnd >= 1.0f) {
-        d->color.a = 0;
-        return;
-    }
+    const bool hasPositionVariation = !m_positionVariation.isNull();
+    const bool useShapePositions = m_shape && m_useCachedPositions;
+
+    for (int i = 0; i < span.count; i++) {
+        const QQuick3DParticleData &sd = span.particleData[span.indices[i]];
+        QQuick3DParticleDataCurrent *d = &span.currentData[i];
+        const float time = span.times[i];
+
+        float duration = m_duration < 0 ? sd.lifetime : (m_duration / 1000.0f);
+        float durationVariation = m_durationVariation == 0
+                ? 0.0f
+                : (m_durationVariation / 1000.0f) - 2.0f * rand->get(sd.index, QPRand::AttractorDurationV) * (m_durationVariation / 1000.0f);
+        duration = std::max(duration + durationVariation, MIN_DURATION);
+        float pEnd = std::min(1.0f, std::max(0.0f, time / duration));
+        // TODO: Should we support easing?
+        //pEnd = easeInOutQuad(pEnd);
+
+        if (m_hideAtEnd && pEnd >= 1.0f) {
+            d->color.a = 0;
+            continue;
+        }
 
-    float pStart = 1.0f - pEnd;
-    QVector3D pos = m_centerPos;
+        float pStart = 1.0f - pEnd;
+        QVector3D pos = m_centerPos;
 
-    if (m_shape) {
-        if (m_useCachedPositions)
+        if (useShapePositions)
             pos += m_shapePositionList[sd.index % m_shapePositionList.size()];
-        else
+        else if (m_shape)
             pos += m_shape->getPosition(sd.index);
-    }
 
-    if (!m_positionVariation.isNull()) {
-        pos.setX(pos.x() + m_positionVariation.x() - 2.0f * rand->get(sd.index, QPRand::AttractorPosVX) * m_positionVariation.x());
-        pos.setY(pos.y() + m_positionVariation.y() - 2.0f * rand->get(sd.index, QPRand::AttractorPosVY) * m_positionVariation.y());
-        pos.setZ(pos.z() + m_positionVariation.z() - 2.0f * rand->get(sd.index, QPRand::AttractorPosVZ) * m_positionVariation.z());
+        if (hasPositionVariation) {
+            pos.setX(pos.x() + m_positionVariation.x() - 2.0f * rand->get(sd.index, QPRand::AttractorPosVX) * m_positionVariation.x());
+            pos.setY(pos.y() + m_positionVariation.y() - 2.0f * rand->get(sd.index, QPRand::AttractorPosVY) * m_positionVariation.y());
+            pos.setZ(pos.z() + m_positionVariation.z() - 2.0f * rand->get(sd.index, QPRand::AttractorPosVZ) * m_positionVariation.z());
+        }
+
+        d->position = (pStart * d->position) + (pEnd * m_particleTransform.map(pos));
     }
+}
 
-    d->position = (pStart * d->position) + (pEnd * m_particleTransform.map(pos));
+bool QQuick3DParticleAttractor::canAffectConcurrently() const
+{
+    // Shapes may load and cache their data when asked for positions
+    return !m_shape || m_useCachedPositions;
 }
 
 QT_END_NAMESPACE
@@ -65,6 +65,8 @@ Q_SIGNALS:
 protected:
     void prepareToAffect() override;
     void affectParticle(const QQuick3DParticleData &sd, QQuick3DParticleDataCurrent *d, float time) override;
+    void affectParticles(const QQuick3DParticleDataSpan &span) override;
+    bool canAffectConcurrently() const override;
 
 private:
     void updateShapePositions();
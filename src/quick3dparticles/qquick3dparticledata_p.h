@@ -69,6 +69,18 @@ struct QQuick3DParticleData
     // Size: 12+12+3+3+4+4+4+4+4+4 = 54 bytes
 };
 
+// Living particles of one particle type, processed together by the affectors.
+// Entry i refers to particleData[indices[i]], emitted times[i] seconds ago,
+// with its current state in currentData[i].
+struct QQuick3DParticleDataSpan
+{
+    const QQuick3DParticleData *particleData = nullptr;
+    const int *indices = nullptr;
+    const float *times = nullptr;
+    QQuick3DParticleDataCurrent *currentData = nullptr;
+    int count = 0;
+};
+
 // Data structure for storing bursts
 struct QQuick3DParticleEmitBurstData {
     int amount = 0;
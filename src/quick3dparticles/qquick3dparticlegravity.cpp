@@ -71,9 +71,22 @@ void QQuick3DParticleGravity::setDirection(const QVector3D &direction)
 
 void QQuick3DParticleGravity::affectParticle(const QQuick3DParticleData &sd, QQuick3DParticleDataCurrent *d, float time)
 {
-    Q_UNUSED(sd);
-    float velocity = 0.5f * m_magnitude * (time * time);
-    d->position += velocity * m_directionNormalized;
+    const int index = 0;
+    affectParticles({ &sd, &index, &time, d, 1 });
+}
+
+void QQuick3DParticleGravity::affectParticles(const QQuick3DParticleDataSpan &span)
+{
+    const QVector3D acceleration = 0.5f * m_magnitude * m_directionNormalized;
+    for (int i = 0; i < span.count; i++) {
+        const float time = span.times[i];
+        span.currentData[i].position += (time * time) * acceleration;
+    }
+}
+
+bool QQuick3DParticleGravity::canAffectConcurrently() const
+{
+    return true;
 }
 
 QT_END_NAMESPACE
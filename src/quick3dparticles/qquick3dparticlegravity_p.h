@@ -44,6 +44,8 @@ Q_SIGNALS:
 
 protected:
     void affectParticle(const QQuick3DParticleData &sd, QQuick3DParticleDataCurrent *d, float time) override;
+    void affectParticles(const QQuick3DParticleDataSpan &span) override;
+    bool canAffectConcurrently() const override;
 
 private:
     float m_magnitude = 100.0f;
@@ -93,19 +93,37 @@ static float qt_smoothstep(float edge0, float edge1, float x)
     return t * t * (3.0f - 2.0f * t);
 }
 
-void QQuick3DParticleRepeller::affectParticle(const QQuick3DParticleData &, QQuick3DParticleDataCurrent *d, float )
+void QQuick3DParticleRepeller::affectParticle(const QQuick3DParticleData &sd, QQuick3DParticleDataCurrent *d, float time)
 {
-    QVector3D pos = position();
-    QVector3D dir = d->position - pos;
-    float radius = dir.length();
-    float outerRadius = qMax(m_outerRadius, m_radius);
-    if (radius > outerRadius || qFuzzyIsNull(radius))
-        return;
-
-    if (radius < m_radius)
-        d->position += dir * m_strength / radius;
-    else
-        d->position += dir * m_strength * (1.0f - qt_smoothstep(m_radius, outerRadius, radius)) / radius;
+    const int index = 0;
+    affectParticles({ &sd, &index, &time, d, 1 });
+}
+
+void QQuick3DParticleRepeller::affectParticles(const QQuick3DParticleDataSpan &span)
+{
+    const QVector3D pos = position();
+    const float outerRadius = qMax(m_outerRadius, m_radius);
+    const float outerRadiusSquared = outerRadius * outerRadius;
+    for (int i = 0; i < span.count; i++) {
+        QQuick3DParticleDataCurrent *d = &span.currentData[i];
+        const QVector3D dir = d->position - pos;
+        // Most particles are usually outside, so reject them without the sqrt
+        if (dir.lengthSquared() > outerRadiusSquared)
+            continue;
+        const float radius = dir.length();
+        if (radius > outerRadius || qFuzzyIsNull(radius))
+            continue;
+
+        if (radius < m_radius)
+            d->position += dir * m_strength / radius;
+        else
+            d->position += dir * m_strength * (1.0f - qt_smoothstep(m_radius, outerRadius, radius)) / radius;
+    }
+}
+
+bool QQuick3DParticleRepeller::canAffectConcurrently() const
+{
+    return true;
 }
 
 QT_END_NAMESPACE
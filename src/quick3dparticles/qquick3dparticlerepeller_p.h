@@ -47,6 +47,8 @@ Q_SIGNALS:
 protected:
     void prepareToAffect() override;
     void affectParticle(const QQuick3DParticleData &sd, QQuick3DParticleDataCurrent *d, float time) override;
+    void affectParticles(const QQuick3DParticleDataSpan &span) override;
+    bool canAffectConcurrently() const override;
 
 private:
     float m_radius = 0.0f;
@@ -143,13 +143,19 @@ void QQuick3DParticleScaleAffector::setEasingCurve(const QEasingCurve &curve)
 
 void QQuick3DParticleScaleAffector::prepareToAffect()
 {
-
+    // Bezier and TCB spline curves are set up on their first use. Do that here, so that it
+    // doesn't happen from several threads at once in affectParticles().
+    m_easing.valueForProgress(0.0);
 }
 
-void QQuick3DParticleScaleAffector::affectParticle(const QQuick3DParticleData &, QQuick3DParticleDataCurrent *d, float time)
+void QQuick3DParticleScaleAffector::affectParticle(const QQuick3DParticleData &sd, QQuick3DParticleDataCurrent *d, float time)
 {
-    float scale = 1.0f;
+    const int index = 0;
+    affectParticles({ &sd, &index, &time, d, 1 });
+}
 
+void QQuick3DParticleScaleAffector::affectParticles(const QQuick3DParticleDataSpan &span)
+{
     const auto fract = [](const float v) -> float {
         return v - qFloor(v);
     };
@@ -160,37 +166,56 @@ void QQuick3DParticleScaleAffector::affectParticle(const QQuick3DParticleData &,
         return a + (b - a) * f * f * (3.0f - 2.0f * f);
     };
 
-    float pos = fract(time / float(m_duration * 0.001f));
+    // The scaling type is the same for the whole span, so select it once
+    const float durationS = float(m_duration * 0.001f);
+    const auto scaleParticles = [&](auto scaleAt) {
+        for (int i = 0; i < span.count; i++)
+            span.currentData[i].scale *= scaleAt(fract(span.times[i] / durationS));
+    };
+
     switch (m_type) {
     case Linear:
-        scale = lerp(m_minSize, m_maxSize, m_easing.valueForProgress(pos));
-        scale = qMax(scale, 0.0f);
+        scaleParticles([&](float pos) {
+            return qMax(lerp(m_minSize, m_maxSize, m_easing.valueForProgress(pos)), 0.0f);
+        });
         break;
     case SewSaw:
-        if (pos < 0.5f)
-            scale = lerp(m_minSize, m_maxSize, m_easing.valueForProgress(pos * 2.0f));
-        else
-            scale = lerp(m_maxSize, m_minSize, m_easing.valueForProgress((pos - 0.5) * 2.0f));
-        scale = qMax(scale, 0.0f);
+        scaleParticles([&](float pos) {
+            float scale;
+            if (pos < 0.5f)
+                scale = lerp(m_minSize, m_maxSize, m_easing.valueForProgress(pos * 2.0f));
+            else
+                scale = lerp(m_maxSize, m_minSize, m_easing.valueForProgress((pos - 0.5) * 2.0f));
+            return qMax(scale, 0.0f);
+        });
         break;
     case SineWave:
-        scale = m_minSize + (m_maxSize - m_minSize) * (1.0f + qSin(2.0f * M_PI * pos)) * 0.5f;
+        scaleParticles([&](float pos) {
+            return float(m_minSize + (m_maxSize - m_minSize) * (1.0f + qSin(2.0f * M_PI * pos)) * 0.5f);
+        });
         break;
     case AbsSineWave:
-        scale = m_minSize + (m_maxSize - m_minSize) * qAbs(qSin(2.0f * M_PI * pos));
+        scaleParticles([&](float pos) {
+            return float(m_minSize + (m_maxSize - m_minSize) * qAbs(qSin(2.0f * M_PI * pos)));
+        });
         break;
     case Step:
-        if (pos < 0.5f)
-            scale = m_minSize;
-        else
-            scale = m_maxSize;
+        scaleParticles([&](float pos) {
+            return pos < 0.5f ? m_minSize : m_maxSize;
+        });
         break;
     case SmoothStep:
-        scale = smoothstep(m_minSize, m_maxSize, pos);
+        scaleParticles([&](float pos) {
+            return smoothstep(m_minSize, m_maxSize, pos);
+        });
         break;
     }
+}
 
-    d->scale *= scale;
+bool QQuick3DParticleScaleAffector::canAffectConcurrently() const
+{
+    // A custom easing function isn't known to be thread-safe
+    return m_easing.type() != QEasingCurve::Custom;
 }
 
 QT_END_NAMESPACE
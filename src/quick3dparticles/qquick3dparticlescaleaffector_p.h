@@ -67,6 +67,8 @@ Q_SIGNALS:
 protected:
     void prepareToAffect() override;
     void affectParticle(const QQuick3DParticleData &, QQuick3DParticleDataCurrent *d, float time) override;
+    void affectParticles(const QQuick3DParticleDataSpan &span) override;
+    bool canAffectConcurrently() const override;
 
 private:
     float m_minSize = 1.0f;
@@ -13,6 +13,10 @@
 #include "qquick3dparticlelineparticle_p.h"
 #include "qquick3dparticlemodelblendparticle_p.h"
 #include <QtQuick3DUtils/private/qquick3dprofiler_p.h>
+#ifdef QT_QUICK3D_HAS_CONCURRENT
+#include <QtConcurrent/qtconcurrentmap.h>
+#endif
+#include <QtCore/qthreadpool.h>
 #include <cmath>
 
 QT_BEGIN_NAMESPACE
@@ -526,7 +530,7 @@ void QQuick3DParticleSystem::updateCurrentTime(int currentTime)
     for (auto particle : std::as_const(m_particles)) {
 
         // Collect possible trail emits
-        QVector<TrailEmits> trailEmits;
+        m_trailEmits.clear();
         for (auto emitter : std::as_const(m_trailEmitters)) {
             if (emitter->follow() == particle) {
                 int emitAmount = emitter->getEmitAmount();
@@ -534,26 +538,37 @@ void QQuick3DParticleSystem::updateCurrentTime(int currentTime)
                     TrailEmits e;
                     e.emitter = emitter;
                     e.amount = emitAmount;
-                    trailEmits << e;
+                    m_trailEmits << e;
                 }
             }
         }
 
+        // Collect the affectors of this particle
+        m_particleAffectors.clear();
+        m_affectConcurrently = true;
+        for (auto affector : std::as_const(m_affectors)) {
+            // If affector is set to affect only particular particles, check these are included
+            if (affector->m_enabled && (affector->m_particles.isEmpty() || affector->m_particles.contains(particle))) {
+                m_particleAffectors << affector;
+                m_affectConcurrently &= affector->canAffectConcurrently();
+            }
+        }
+
         m_particlesMax += particle->maxAmount();
 
         QQuick3DParticleSpriteParticle *spriteParticle = qobject_cast<QQuick3DParticleSpriteParticle *>(particle);
         if (spriteParticle) {
-            processSpriteParticle(spriteParticle, trailEmits, timeS);
+            processSpriteParticle(spriteParticle, m_trailEmits, timeS);
             continue;
         }
         QQuick3DParticleModelParticle *modelParticle = qobject_cast<QQuick3DParticleModelParticle *>(particle);
         if (modelParticle) {
-            processModelParticle(modelParticle, trailEmits, timeS);
+            processModelParticle(modelParticle, m_trailEmits, timeS);
             continue;
         }
         QQuick3DParticleModelBlendParticle *mbp = qobject_cast<QQuick3DParticleModelBlendParticle *>(particle);
         if (mbp) {
-            processModelBlendParticle(mbp, trailEmits, timeS);
+            processModelBlendParticle(mbp, m_trailEmits, timeS);
             continue;
         }
     }
@@ -567,63 +582,149 @@ void QQuick3DParticleSystem::updateCurrentTime(int currentTime)
     Q_QUICK3D_PROFILE_END_WITH_ID(QQuick3DProfiler::Quick3DParticleUpdate, m_particlesUsed, Q_QUICK3D_PROFILE_GET_ID(this));
 }
 
+int QQuick3DParticleSystem::particleBatchSize(const QQuick3DParticle *particle, const QVector<TrailEmits> &trailEmits)
+{
+    // A trail emitter that emits the particle it follows can reuse the slots of particles
+    // that were alive at the start of the frame, so these are processed one by one.
+    for (auto trailEmit : trailEmits) {
+        if (trailEmit.emitter->particle() == particle)
+            return 1;
+    }
+    return std::max(1, particle->maxAmount());
+}
+
+void QQuick3DParticleSystem::collectLivingParticles(const QQuick3DParticle *particle, int first, int last, float timeS)
+{
+    m_livingIndices.clear();
+    m_livingTimes.clear();
+    const QQuick3DParticleData *particleData = particle->m_particleData.constData();
+    for (int i = first; i < last; i++) {
+        const QQuick3DParticleData &d = particleData[i];
+        if (timeS < d.startTime || timeS > d.startTime + d.lifetime)
+            continue;
+        m_livingIndices << i;
+        m_livingTimes << timeS - d.startTime;
+    }
+
+    const qsizetype count = m_livingIndices.size();
+    m_livingData.fill(QQuick3DParticleDataCurrent(), count);
+    m_livingTimeChanges.resize(count);
+    m_livingAnimationFrames.resize(count);
+    m_particlesUsed += int(count);
+}
+
+template <typename Simulate>
+void QQuick3DParticleSystem::simulateLivingParticles(const QQuick3DParticle *particle, Simulate simulate)
+{
+    // The living particles are processed in chunks small enough for their data to stay in
+    // the cache while all the affectors run. Chunks are independent of each other, so when
+    // the affectors allow it, large amounts of particles are simulated on the thread pool.
+    // The random values are indexed by the particle, so the results don't depend on that.
+    constexpr int chunkSize = 1024;
+
+    const int count = int(m_livingIndices.size());
+    const QQuick3DParticleData *particleData = particle->m_particleData.constData();
+    const int *indices = m_livingIndices.constData();
+    const float *times = m_livingTimes.constData();
+    QQuick3DParticleDataCurrent *currentData = m_livingData.data();
+
+    const auto simulateChunk = [&](int begin, int end) {
+        simulate(begin, end);
+        const QQuick3DParticleDataSpan span { particleData, indices + begin, times + begin, currentData + begin, end - begin };
+        for (auto affector : std::as_const(m_particleAffectors))
+            affector->affectParticles(span);
+    };
+
+#ifdef QT_QUICK3D_HAS_CONCURRENT
+    const bool multithreaded = count >= 2 * chunkSize && m_affectConcurrently
+            && !isMultithreadingDisabled() && QThreadPool::globalInstance()->maxThreadCount() > 1;
+    if (multithreaded) {
+        QVarLengthArray<std::pair<int, int>, 64> chunks;
+        for (int begin = 0; begin < count; begin += chunkSize)
+            chunks.append({ begin, std::min(begin + chunkSize, count) });
+        QtConcurrent::blockingMap(QThreadPool::globalInstance(), chunks, [&](const std::pair<int, int> &chunk) {
+            simulateChunk(chunk.first, chunk.second);
+        });
+        return;
+    }
+#endif
+
+    for (int begin = 0; begin < count; begin += chunkSize)
+        simulateChunk(begin, std::min(begin + chunkSize, count));
+}
+
 void QQuick3DParticleSystem::processModelParticle(QQuick3DParticleModelParticle *modelParticle, const QVector<TrailEmits> &trailEmits, float timeS)
 {
     modelParticle->clearInstanceTable();
 
     const int c = modelParticle->maxAmount();
+    const int batchSize = particleBatchSize(modelParticle, trailEmits);
+
+    for (int first = 0; first < c; first += batchSize) {
+        const int last = std::min(first + batchSize, c);
+        collectLivingParticles(modelParticle, first, last, timeS);
+
+        // Runs on the thread pool for large amounts of particles
+        QQuick3DParticleDataCurrent *livingData = m_livingData.data();
+        float *timeChanges = m_livingTimeChanges.data();
+        simulateLivingParticles(modelParticle, [&](int begin, int end) {
+            for (int j = begin; j < end; j++) {
+                const auto d = &modelParticle->m_particleData.at(m_livingIndices.at(j));
+                const float particleTimeS = m_livingTimes.at(j);
+                QQuick3DParticleDataCurrent &currentData = livingData[j];
+
+                // Process features shared for both model & sprite particles
+                processParticleCommon(currentData, d, particleTimeS);
+
+                // Add a base rotation if alignment requested
+                if (modelParticle->m_alignMode != QQuick3DParticle::AlignNone)
+                    processParticleAlignment(currentData, modelParticle, d);
+
+                // 0.0 -> 1.0 during the particle lifetime
+                const float timeChange = std::max(0.0f, std::min(1.0f, particleTimeS / d->lifetime));
+                timeChanges[j] = timeChange;
+
+                // Scale from initial to endScale
+                currentData.scale = modelParticle->m_initialScale * (d->endSize * timeChange + d->startSize * (1.0f - timeChange));
+
+                // Fade in & out
+                const float particleTimeLeftS = d->lifetime - particleTimeS;
+                processParticleFadeInOut(currentData, modelParticle, particleTimeS, particleTimeLeftS);
+            }
+        });
 
-    for (int i = 0; i < c; i++) {
-        const auto d = &modelParticle->m_particleData.at(i);
+        int living = 0;
+        for (int i = first; i < last; i++) {
+            const auto d = &modelParticle->m_particleData.at(i);
 
-        const float particleTimeEnd = d->startTime + d->lifetime;
+            const float particleTimeEnd = d->startTime + d->lifetime;
 
-        if (timeS < d->startTime || timeS > particleTimeEnd) {
-            if (timeS > particleTimeEnd && d->lifetime > 0.0f) {
-                for (auto trailEmit : std::as_const(trailEmits))
-                    trailEmit.emitter->emitTrailParticles(d->startPosition + (d->startVelocity * (particleTimeEnd - d->startTime)), 0, QQuick3DParticleDynamicBurst::TriggerEnd);
+            if (living == m_livingIndices.size() || m_livingIndices.at(living) != i) {
+                if (timeS > particleTimeEnd && d->lifetime > 0.0f) {
+                    for (auto trailEmit : std::as_const(trailEmits))
+                        trailEmit.emitter->emitTrailParticles(d->startPosition + (d->startVelocity * (particleTimeEnd - d->startTime)), 0, QQuick3DParticleDynamicBurst::TriggerEnd);
+                }
+                // Particle not alive currently
+                continue;
             }
-            // Particle not alive currently
-            continue;
-        }
-
-        const float particleTimeS = timeS - d->startTime;
-        QQuick3DParticleDataCurrent currentData;
-        if (timeS >= d->startTime && d->lifetime <= 0.0f) {
-            for (auto trailEmit : std::as_const(trailEmits))
-                trailEmit.emitter->emitTrailParticles(d->startPosition, 0, QQuick3DParticleDynamicBurst::TriggerStart);
-        }
-        // Process features shared for both model & sprite particles
-        processParticleCommon(currentData, d, particleTimeS);
-
-        // Add a base rotation if alignment requested
-        if (modelParticle->m_alignMode != QQuick3DParticle::AlignNone)
-            processParticleAlignment(currentData, modelParticle, d);
 
-        // 0.0 -> 1.0 during the particle lifetime
-        const float timeChange = std::max(0.0f, std::min(1.0f, particleTimeS / d->lifetime));
+            const QQuick3DParticleDataCurrent &currentData = m_livingData.at(living);
+            const float timeChange = m_livingTimeChanges.at(living);
+            living++;
 
-        // Scale from initial to endScale
-        currentData.scale = modelParticle->m_initialScale * (d->endSize * timeChange + d->startSize * (1.0f - timeChange));
+            if (timeS >= d->startTime && d->lifetime <= 0.0f) {
+                for (auto trailEmit : std::as_const(trailEmits))
+                    trailEmit.emitter->emitTrailParticles(d->startPosition, 0, QQuick3DParticleDynamicBurst::TriggerStart);
+            }
 
-        // Fade in & out
-        const float particleTimeLeftS = d->lifetime - particleTimeS;
-        processParticleFadeInOut(currentData, modelParticle, particleTimeS, particleTimeLeftS);
+            // Emit new particles from trails
+            for (auto trailEmit : std::as_const(trailEmits))
+                trailEmit.emitter->emitTrailParticles(currentData.position, trailEmit.amount, QQuick3DParticleDynamicBurst::TriggerTime);
 
-        // Affectors
-        for (auto affector : std::as_const(m_affectors)) {
-            // If affector is set to affect only particular particles, check these are included
-            if (affector->m_enabled && (affector->m_particles.isEmpty() || affector->m_particles.contains(modelParticle)))
-                affector->affectParticle(*d, &currentData, particleTimeS);
+            const QColor color(currentData.color.r, currentData.color.g, currentData.color.b, currentData.color.a);
+            // Set current particle properties
+            modelParticle->addInstance(currentData.position, currentData.scale, currentData.rotation, color, timeChange);
         }
-
-        // Emit new particles from trails
-        for (auto trailEmit : std::as_const(trailEmits))
-            trailEmit.emitter->emitTrailParticles(currentData.position, trailEmit.amount, QQuick3DParticleDynamicBurst::TriggerTime);
-
-        const QColor color(currentData.color.r, currentData.color.g, currentData.color.b, currentData.color.a);
-        // Set current particle properties
-        modelParticle->addInstance(currentData.position, currentData.scale, currentData.rotation, color, timeChange);
     }
     modelParticle->commitInstance();
 }
@@ -636,96 +737,112 @@ static QVector3D mix(const QVector3D &a, const QVector3D &b, float f)
 void QQuick3DParticleSystem::processModelBlendParticle(QQuick3DParticleModelBlendParticle *particle, const QVector<TrailEmits> &trailEmits, float timeS)
 {
     const int c = particle->maxAmount();
-
-    for (int i = 0; i < c; i++) {
-        const auto d = &particle->m_particleData.at(i);
-
-        const float particleTimeEnd = d->startTime + d->lifetime;
-
-        if (timeS < d->startTime || timeS > particleTimeEnd) {
-            if (timeS > particleTimeEnd && d->lifetime > 0.0f) {
-                for (auto trailEmit : std::as_const(trailEmits))
-                    trailEmit.emitter->emitTrailParticles(d->startPosition + (d->startVelocity * (particleTimeEnd - d->startTime)), 0, QQuick3DParticleDynamicBurst::TriggerEnd);
-            }
-            // Particle not alive currently
-            float age = 0.0f;
-            float size = 0.0f;
-            QVector3D pos;
-            QVector3D rot;
-            QVector4D color(float(d->startColor.r)/ 255.0f,
-                            float(d->startColor.g)/ 255.0f,
-                            float(d->startColor.b)/ 255.0f,
-                            float(d->startColor.a)/ 255.0f);
-            if (d->startTime > 0.0f && timeS > particleTimeEnd
-                    && (particle->modelBlendMode() == QQuick3DParticleModelBlendParticle::Construct ||
-                        particle->modelBlendMode() == QQuick3DParticleModelBlendParticle::Transfer)) {
-                age = 1.0f;
-                size = 1.0f;
-                pos = particle->particleEndPosition(i);
-                rot = particle->particleEndRotation(i);
-                if (particle->fadeOutEffect() == QQuick3DParticle::FadeOpacity)
-                    color.setW(0.0f);
-            } else if (particle->modelBlendMode() == QQuick3DParticleModelBlendParticle::Explode ||
-                       particle->modelBlendMode() == QQuick3DParticleModelBlendParticle::Transfer) {
-                age = 0.0f;
-                size = 1.0f;
-                pos = particle->particleCenter(i);
-                if (particle->fadeInEffect() == QQuick3DParticle::FadeOpacity)
-                    color.setW(0.0f);
+    const int batchSize = particleBatchSize(particle, trailEmits);
+
+    for (int first = 0; first < c; first += batchSize) {
+        const int last = std::min(first + batchSize, c);
+        collectLivingParticles(particle, first, last, timeS);
+
+        // Runs on the thread pool for large amounts of particles
+        QQuick3DParticleDataCurrent *livingData = m_livingData.data();
+        float *timeChanges = m_livingTimeChanges.data();
+        simulateLivingParticles(particle, [&](int begin, int end) {
+            for (int j = begin; j < end; j++) {
+                const auto d = &particle->m_particleData.at(m_livingIndices.at(j));
+                const float particleTimeS = m_livingTimes.at(j);
+                QQuick3DParticleDataCurrent &currentData = livingData[j];
+
+                // Process features shared for both model & sprite particles
+                processParticleCommon(currentData, d, particleTimeS);
+
+                // 0.0 -> 1.0 during the particle lifetime
+                const float timeChange = std::max(0.0f, std::min(1.0f, particleTimeS / d->lifetime));
+                timeChanges[j] = timeChange;
+
+                // Scale from initial to endScale
+                const float scale = d->endSize * timeChange + d->startSize * (1.0f - timeChange);
+                currentData.scale = QVector3D(scale, scale, scale);
+
+                // Fade in & out
+                const float particleTimeLeftS = d->lifetime - particleTimeS;
+                processParticleFadeInOut(currentData, particle, particleTimeS, particleTimeLeftS);
             }
-            particle->setParticleData(i, pos, rot, color, size, age);
-            continue;
-        }
+        });
 
-        const float particleTimeS = timeS - d->startTime;
-        QQuick3DParticleDataCurrent currentData;
-        if (timeS >= d->startTime && d->lifetime <= 0.0f) {
-            for (auto trailEmit : std::as_const(trailEmits))
-                trailEmit.emitter->emitTrailParticles(d->startPosition, 0, QQuick3DParticleDynamicBurst::TriggerStart);
-        }
-
-        // Process features shared for both model & sprite particles
-        processParticleCommon(currentData, d, particleTimeS);
+        int living = 0;
+        for (int i = first; i < last; i++) {
+            const auto d = &particle->m_particleData.at(i);
 
-        // 0.0 -> 1.0 during the particle lifetime
-        const float timeChange = std::max(0.0f, std::min(1.0f, particleTimeS / d->lifetime));
+            const float particleTimeEnd = d->startTime + d->lifetime;
 
-        // Scale from initial to endScale
-        const float scale = d->endSize * timeChange + d->startSize * (1.0f - timeChange);
-        currentData.scale = QVector3D(scale, scale, scale);
+            if (living == m_livingIndices.size() || m_livingIndices.at(living) != i) {
+                if (timeS > particleTimeEnd && d->lifetime > 0.0f) {
+                    for (auto trailEmit : std::as_const(trailEmits))
+                        trailEmit.emitter->emitTrailParticles(d->startPosition + (d->startVelocity * (particleTimeEnd - d->startTime)), 0, QQuick3DParticleDynamicBurst::TriggerEnd);
+                }
+                // Particle not alive currently
+                float age = 0.0f;
+                float size = 0.0f;
+                QVector3D pos;
+                QVector3D rot;
+                QVector4D color(float(d->startColor.r)/ 255.0f,
+                                float(d->startColor.g)/ 255.0f,
+                                float(d->startColor.b)/ 255.0f,
+                                float(d->startColor.a)/ 255.0f);
+                if (d->startTime > 0.0f && timeS > particleTimeEnd
+                        && (particle->modelBlendMode() == QQuick3DParticleModelBlendParticle::Construct ||
+                            particle->modelBlendMode() == QQuick3DParticleModelBlendParticle::Transfer)) {
+                    age = 1.0f;
+                    size = 1.0f;
+                    pos = particle->particleEndPosition(i);
+                    rot = particle->particleEndRotation(i);
+                    if (particle->fadeOutEffect() == QQuick3DParticle::FadeOpacity)
+                        color.setW(0.0f);
+                } else if (particle->modelBlendMode() == QQuick3DParticleModelBlendParticle::Explode ||
+                           particle->modelBlendMode() == QQuick3DParticleModelBlendParticle::Transfer) {
+                    age = 0.0f;
+                    size = 1.0f;
+                    pos = particle->particleCenter(i);
+                    if (particle->fadeInEffect() == QQuick3DParticle::FadeOpacity)
+                        color.setW(0.0f);
+                }
+                particle->setParticleData(i, pos, rot, color, size, age);
+                continue;
+            }
 
-        // Fade in & out
-        const float particleTimeLeftS = d->lifetime - particleTimeS;
-        processParticleFadeInOut(currentData, particle, particleTimeS, particleTimeLeftS);
+            QQuick3DParticleDataCurrent currentData = m_livingData.at(living);
+            const float particleTimeS = m_livingTimes.at(living);
+            const float timeChange = m_livingTimeChanges.at(living);
+            living++;
 
-        // Affectors
-        for (auto affector : std::as_const(m_affectors)) {
-            // If affector is set to affect only particular particles, check these are included
-            if (affector->m_enabled && (affector->m_particles.isEmpty() || affector->m_particles.contains(particle)))
-                affector->affectParticle(*d, &currentData, particleTimeS);
-        }
+            if (timeS >= d->startTime && d->lifetime <= 0.0f) {
+                for (auto trailEmit : std::as_const(trailEmits))
+                    trailEmit.emitter->emitTrailParticles(d->startPosition, 0, QQuick3DParticleDynamicBurst::TriggerStart);
+            }
 
-        // Emit new particles from trails
-        for (auto trailEmit : std::as_const(trailEmits))
-            trailEmit.emitter->emitTrailParticles(currentData.position, trailEmit.amount, QQuick3DParticleDynamicBurst::TriggerTime);
-
-        // Set current particle properties
-        const QVector4D color(float(currentData.color.r) / 255.0f,
-                              float(currentData.color.g) / 255.0f,
-                              float(currentData.color.b) / 255.0f,
-                              float(currentData.color.a) / 255.0f);
-        float endTimeS = particle->endTime() * 0.001f;
-        if ((particle->modelBlendMode() == QQuick3DParticleModelBlendParticle::Construct ||
-             particle->modelBlendMode() == QQuick3DParticleModelBlendParticle::Transfer)
-                && particleTimeLeftS < endTimeS) {
-            QVector3D endPosition = particle->particleEndPosition(i);
-            QVector3D endRotation = particle->particleEndRotation(i);
-            float factor = 1.0f - particleTimeLeftS / endTimeS;
-            currentData.position = mix(currentData.position, endPosition, factor);
-            currentData.rotation = mix(currentData.rotation, endRotation, factor);
+            // Emit new particles from trails
+            for (auto trailEmit : std::as_const(trailEmits))
+                trailEmit.emitter->emitTrailParticles(currentData.position, trailEmit.amount, QQuick3DParticleDynamicBurst::TriggerTime);
+
+            // Set current particle properties
+            const QVector4D color(float(currentData.color.r) / 255.0f,
+                                  float(currentData.color.g) / 255.0f,
+                                  float(currentData.color.b) / 255.0f,
+                                  float(currentData.color.a) / 255.0f);
+            const float particleTimeLeftS = d->lifetime - particleTimeS;
+            float endTimeS = particle->endTime() * 0.001f;
+            if ((particle->modelBlendMode() == QQuick3DParticleModelBlendParticle::Construct ||
+                 particle->modelBlendMode() == QQuick3DParticleModelBlendParticle::Transfer)
+                    && particleTimeLeftS < endTimeS) {
+                QVector3D endPosition = particle->particleEndPosition(i);
+                QVector3D endRotation = particle->particleEndRotation(i);
+                float factor = 1.0f - particleTimeLeftS / endTimeS;
+                currentData.position = mix(currentData.position, endPosition, factor);
+                currentData.rotation = mix(currentData.rotation, endRotation, factor);
+            }
+            particle->setParticleData(i, currentData.position, currentData.rotation,
+                                      color, currentData.scale.x(), timeChange);
         }
-        particle->setParticleData(i, currentData.position, currentData.rotation,
-                                  color, currentData.scale.x(), timeChange);
     }
     particle->commitParticles();
 }
@@ -733,100 +850,117 @@ void QQuick3DParticleSystem::processModelBlendParticle(QQuick3DParticleModelBlen
 void QQuick3DParticleSystem::processSpriteParticle(QQuick3DParticleSpriteParticle *spriteParticle, const QVector<TrailEmits> &trailEmits, float timeS)
 {
     const int c = spriteParticle->maxAmount();
+    const int batchSize = particleBatchSize(spriteParticle, trailEmits);
+    auto *lineParticle = qobject_cast<QQuick3DParticleLineParticle *>(spriteParticle);
+
+    for (int first = 0; first < c; first += batchSize) {
+        const int last = std::min(first + batchSize, c);
+        collectLivingParticles(spriteParticle, first, last, timeS);
+
+        // Runs on the thread pool for large amounts of particles
+        QQuick3DParticleDataCurrent *livingData = m_livingData.data();
+        float *timeChanges = m_livingTimeChanges.data();
+        float *animationFrames = m_livingAnimationFrames.data();
+        simulateLivingParticles(spriteParticle, [&](int begin, int end) {
+            for (int j = begin; j < end; j++) {
+                const auto d = &spriteParticle->m_particleData.at(m_livingIndices.at(j));
+                const float particleTimeS = m_livingTimes.at(j);
+                QQuick3DParticleDataCurrent &currentData = livingData[j];
+
+                // Process features shared for both model & sprite particles
+                processParticleCommon(currentData, d, particleTimeS);
+
+                // Add a base rotation if alignment requested
+                if (!spriteParticle->m_billboard && spriteParticle->m_alignMode != QQuick3DParticle::AlignNone)
+                    processParticleAlignment(currentData, spriteParticle, d);
+
+                // 0.0 -> 1.0 during the particle lifetime
+                const float timeChange = std::max(0.0f, std::min(1.0f, particleTimeS / d->lifetime));
+                timeChanges[j] = timeChange;
+
+                // Scale from initial to endScale
+                const float scale = d->endSize * timeChange + d->startSize * (1.0f - timeChange);
+                currentData.scale = QVector3D(scale, scale, scale);
+
+                // Fade in & out
+                const float particleTimeLeftS = d->lifetime - particleTimeS;
+                processParticleFadeInOut(currentData, spriteParticle, particleTimeS, particleTimeLeftS);
+
+                float animationFrame = 0.0f;
+                if (auto sequence = spriteParticle->m_spriteSequence) {
+                    // animationFrame range is [0..1) where 0.0 is the beginning of the first frame
+                    // and 0.9999 is the end of the last frame.
+                    const bool isSingleFrame = (sequence->animationDirection() == QQuick3DParticleSpriteSequence::SingleFrame);
+                    float startFrame = sequence->firstFrame(d->index, isSingleFrame);
+                    if (sequence->animationDirection() == QQuick3DParticleSpriteSequence::Normal) {
+                        animationFrame = fmodf(startFrame + particleTimeS / d->animationTime, 1.0f);
+                    } else if (sequence->animationDirection() == QQuick3DParticleSpriteSequence::Reverse) {
+                        animationFrame = fmodf(startFrame + 0.9999f - fmodf(particleTimeS / d->animationTime, 1.0f), 1.0f);
+                    } else if (sequence->animationDirection() == QQuick3DParticleSpriteSequence::Alternate) {
+                        animationFrame = startFrame + particleTimeS / d->animationTime;
+                        animationFrame = fabsf(fmodf(1.0f + animationFrame, 2.0f) - 1.0f);
+                    } else if (sequence->animationDirection() == QQuick3DParticleSpriteSequence::AlternateReverse) {
+                        animationFrame = fmodf(startFrame + 0.9999f, 1.0f) - particleTimeS / d->animationTime;
+                        animationFrame = fabsf(fmodf(fabsf(1.0f + animationFrame), 2.0f) - 1.0f);
+                    } else {
+                        // SingleFrame
+                        animationFrame = startFrame;
+                    }
+                    animationFrame = std::clamp(animationFrame, 0.0f, 0.9999f);
+                }
+                animationFrames[j] = animationFrame;
+            }
+        });
+
+        int living = 0;
+        for (int i = first; i < last; i++) {
+            const auto d = &spriteParticle->m_particleData.at(i);
+
+            const float particleTimeEnd = d->startTime + d->lifetime;
+            auto &particleData = spriteParticle->m_spriteParticleData[i];
+            if (living == m_livingIndices.size() || m_livingIndices.at(living) != i) {
+                if (timeS > particleTimeEnd && particleData.age > 0.0f) {
+                    for (auto trailEmit : std::as_const(trailEmits))
+                        trailEmit.emitter->emitTrailParticles(particleData.position, 0, QQuick3DParticleDynamicBurst::TriggerEnd);
+                    if (lineParticle)
+                        lineParticle->saveLineSegment(i, timeS);
+                }
+                // Particle not alive currently
+                spriteParticle->resetParticleData(i);
+                continue;
+            }
 
-    for (int i = 0; i < c; i++) {
-        const auto d = &spriteParticle->m_particleData.at(i);
+            const QQuick3DParticleDataCurrent &currentData = m_livingData.at(living);
+            const float timeChange = m_livingTimeChanges.at(living);
+            const float animationFrame = m_livingAnimationFrames.at(living);
+            living++;
 
-        const float particleTimeEnd = d->startTime + d->lifetime;
-        auto &particleData = spriteParticle->m_spriteParticleData[i];
-        if (timeS < d->startTime || timeS > particleTimeEnd) {
-            if (timeS > particleTimeEnd && particleData.age > 0.0f) {
+            if (timeS >= d->startTime && timeS < particleTimeEnd && particleData.age == 0.0f) {
                 for (auto trailEmit : std::as_const(trailEmits))
-                    trailEmit.emitter->emitTrailParticles(particleData.position, 0, QQuick3DParticleDynamicBurst::TriggerEnd);
-                auto *lineParticle = qobject_cast<QQuick3DParticleLineParticle *>(spriteParticle);
-                if (lineParticle)
-                    lineParticle->saveLineSegment(i, timeS);
-            }
-            // Particle not alive currently
-            spriteParticle->resetParticleData(i);
-            continue;
-        }
-        const float particleTimeS = timeS - d->startTime;
-        QQuick3DParticleDataCurrent currentData;
-        if (timeS >= d->startTime && timeS < particleTimeEnd && particleData.age == 0.0f) {
-            for (auto trailEmit : std::as_const(trailEmits))
-                trailEmit.emitter->emitTrailParticles(d->startPosition, 0, QQuick3DParticleDynamicBurst::TriggerStart);
-        }
-        // Process features shared for both model & sprite particles
-        processParticleCommon(currentData, d, particleTimeS);
-
-        // Add a base rotation if alignment requested
-        if (!spriteParticle->m_billboard && spriteParticle->m_alignMode != QQuick3DParticle::AlignNone)
-            processParticleAlignment(currentData, spriteParticle, d);
-
-        // 0.0 -> 1.0 during the particle lifetime
-        const float timeChange = std::max(0.0f, std::min(1.0f, particleTimeS / d->lifetime));
-
-        // Scale from initial to endScale
-        const float scale = d->endSize * timeChange + d->startSize * (1.0f - timeChange);
-        currentData.scale = QVector3D(scale, scale, scale);
-
-        // Fade in & out
-        const float particleTimeLeftS = d->lifetime - particleTimeS;
-        processParticleFadeInOut(currentData, spriteParticle, particleTimeS, particleTimeLeftS);
-
-        float animationFrame = 0.0f;
-        if (auto sequence = spriteParticle->m_spriteSequence) {
-            // animationFrame range is [0..1) where 0.0 is the beginning of the first frame
-            // and 0.9999 is the end of the last frame.
-            const bool isSingleFrame = (sequence->animationDirection() == QQuick3DParticleSpriteSequence::SingleFrame);
-            float startFrame = sequence->firstFrame(d->index, isSingleFrame);
-            if (sequence->animationDirection() == QQuick3DParticleSpriteSequence::Normal) {
-                animationFrame = fmodf(startFrame + particleTimeS / d->animationTime, 1.0f);
-            } else if (sequence->animationDirection() == QQuick3DParticleSpriteSequence::Reverse) {
-                animationFrame = fmodf(startFrame + 0.9999f - fmodf(particleTimeS / d->animationTime, 1.0f), 1.0f);
-            } else if (sequence->animationDirection() == QQuick3DParticleSpriteSequence::Alternate) {
-                animationFrame = startFrame + particleTimeS / d->animationTime;
-                animationFrame = fabsf(fmodf(1.0f + animationFrame, 2.0f) - 1.0f);
-            } else if (sequence->animationDirection() == QQuick3DParticleSpriteSequence::AlternateReverse) {
-                animationFrame = fmodf(startFrame + 0.9999f, 1.0f) - particleTimeS / d->animationTime;
-                animationFrame = fabsf(fmodf(fabsf(1.0f + animationFrame), 2.0f) - 1.0f);
-            } else {
-                // SingleFrame
-                animationFrame = startFrame;
+                    trailEmit.emitter->emitTrailParticles(d->startPosition, 0, QQuick3DParticleDynamicBurst::TriggerStart);
             }
-            animationFrame = std::clamp(animationFrame, 0.0f, 0.9999f);
-        }
 
-        // Affectors
-        for (auto affector : std::as_const(m_affectors)) {
-            // If affector is set to affect only particular particles, check these are included
-            if (affector->m_enabled && (affector->m_particles.isEmpty() || affector->m_particles.contains(spriteParticle)))
-                affector->affectParticle(*d, &currentData, particleTimeS);
+            // Emit new particles from trails
+            for (auto trailEmit : std::as_const(trailEmits))
+                trailEmit.emitter->emitTrailParticles(currentData.position, trailEmit.amount, QQuick3DParticleDynamicBurst::TriggerTime);
+
+
+            // Set current particle properties
+            const QVector4D color(float(currentData.color.r) / 255.0f,
+                                  float(currentData.color.g) / 255.0f,
+                                  float(currentData.color.b) / 255.0f,
+                                  float(currentData.color.a) / 255.0f);
+            const QVector3D offset(spriteParticle->offsetX(), spriteParticle->offsetY(), 0);
+            spriteParticle->setParticleData(i, currentData.position + (offset * currentData.scale.x()),
+                                            currentData.rotation, color, currentData.scale.x(), timeChange,
+                                            animationFrame);
         }
-
-        // Emit new particles from trails
-        for (auto trailEmit : std::as_const(trailEmits))
-            trailEmit.emitter->emitTrailParticles(currentData.position, trailEmit.amount, QQuick3DParticleDynamicBurst::TriggerTime);
-
-
-        // Set current particle properties
-        const QVector4D color(float(currentData.color.r) / 255.0f,
-                              float(currentData.color.g) / 255.0f,
-                              float(currentData.color.b) / 255.0f,
-                              float(currentData.color.a) / 255.0f);
-        const QVector3D offset(spriteParticle->offsetX(), spriteParticle->offsetY(), 0);
-        spriteParticle->setParticleData(i, currentData.position + (offset * currentData.scale.x()),
-                                        currentData.rotation, color, currentData.scale.x(), timeChange,
-                                        animationFrame);
     }
     spriteParticle->commitParticles(timeS);
 }
 
 void QQuick3DParticleSystem::processParticleCommon(QQuick3DParticleDataCurrent &currentData, const QQuick3DParticleData *d, float particleTimeS)
 {
-    m_particlesUsed++;
-
     currentData.position = d->startPosition;
 
     // Initial color from start color
@@ -888,6 +1022,12 @@ bool QQuick3DParticleSystem::isEditorModeOn()
     return editorMode;
 }
 
+bool QQuick3DParticleSystem::isMultithreadingDisabled()
+{
+    static const bool disabled = qEnvironmentVariableIntValue("QT_QUICK3D_DISABLE_PARTICLE_THREADS");
+    return disabled;
+}
+
 void QQuick3DParticleSystem::updateLoggingData()
 {
     if (m_updates == 0)
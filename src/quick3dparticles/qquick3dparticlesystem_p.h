@@ -133,11 +133,16 @@ private:
     void processModelParticle(QQuick3DParticleModelParticle *modelParticle, const QVector<TrailEmits> &trailEmits, float timeS);
     void processSpriteParticle(QQuick3DParticleSpriteParticle *spriteParticle, const QVector<TrailEmits> &trailEmits, float timeS);
     void processModelBlendParticle(QQuick3DParticleModelBlendParticle *particle, const QVector<TrailEmits> &trailEmits, float timeS);
+    static int particleBatchSize(const QQuick3DParticle *particle, const QVector<TrailEmits> &trailEmits);
+    void collectLivingParticles(const QQuick3DParticle *particle, int first, int last, float timeS);
+    template <typename Simulate>
+    void simulateLivingParticles(const QQuick3DParticle *particle, Simulate simulate);
     void processParticleCommon(QQuick3DParticleDataCurrent &currentData, const QQuick3DParticleData *d, float particleTimeS);
     void processParticleFadeInOut(QQuick3DParticleDataCurrent &currentData, const QQuick3DParticle *particle, float particleTimeS, float particleTimeLeftS);
     void processParticleAlignment(QQuick3DParticleDataCurrent &currentData, const QQuick3DParticle *particle, const QQuick3DParticleData *d);
     static bool isGloballyDisabled();
     static bool isEditorModeOn();
+    static bool isMultithreadingDisabled();
 
 private:
     friend class QQuick3DParticleEmitter;
@@ -182,6 +187,16 @@ private:
     QQuick3DParticleSystemLogging *m_loggingData = nullptr;
     QPRand m_rand;
     int m_particleIdIndex = 0;
+
+    // Scratch data of the particle being processed, kept to reuse the allocations
+    QVector<TrailEmits> m_trailEmits;
+    QList<QQuick3DParticleAffector *> m_particleAffectors;
+    bool m_affectConcurrently = true;
+    QList<int> m_livingIndices;
+    QList<float> m_livingTimes;
+    QList<float> m_livingTimeChanges;
+    QList<float> m_livingAnimationFrames;
+    QList<QQuick3DParticleDataCurrent> m_livingData;
 };
 
 class QQuick3DParticleSystemAnimation : public QAbstractAnimation
@@ -253,62 +253,74 @@ void QQuick3DParticleWander::setFadeOutDuration(int fadeOutDuration)
 }
 
 void QQuick3DParticleWander::affectParticle(const QQuick3DParticleData &sd, QQuick3DParticleDataCurrent *d, float time)
+{
+    const int index = 0;
+    affectParticles({ &sd, &index, &time, d, 1 });
+}
+
+void QQuick3DParticleWander::affectParticles(const QQuick3DParticleDataSpan &span)
 {
     if (!system())
         return;
     auto rand = system()->rand();
 
-    // Optionally smoothen the beginning & end of wander
-    float smooth = 1.0f;
-    if (m_fadeInDuration > 0) {
-        smooth = time / (float(m_fadeInDuration) / 1000.0f);
-        smooth = std::min(1.0f, smooth);
-    }
-    if (m_fadeOutDuration > 0) {
-        float timeLeft = (sd.lifetime - time);
-        float smoothOut = timeLeft / (float(m_fadeOutDuration) / 1000.0f);
-        // When fading both in & out, select smaller (which is always max 1.0)
-        smooth = std::min(smoothOut, smooth);
+    static constexpr QPRand::UserType paceStartUsers[3] = { QPRand::WanderXPS, QPRand::WanderYPS, QPRand::WanderZPS };
+    static constexpr QPRand::UserType paceVariationUsers[3] = { QPRand::WanderXPV, QPRand::WanderYPV, QPRand::WanderZPV };
+    static constexpr QPRand::UserType amountVariationUsers[3] = { QPRand::WanderXAV, QPRand::WanderYAV, QPRand::WanderZAV };
+
+    // Resolve the axes that wander once for the whole span
+    bool globalAxes[3];
+    bool uniqueAxes[3];
+    for (int axis = 0; axis < 3; axis++) {
+        globalAxes[axis] = !qFuzzyIsNull(m_globalAmount[axis]) && !qFuzzyIsNull(m_globalPace[axis]);
+        uniqueAxes[axis] = !qFuzzyIsNull(m_uniqueAmount[axis]) && !qFuzzyIsNull(m_uniquePace[axis]);
     }
 
     const float pi2 = float(M_PI * 2);
-    // Global
-    if (!qFuzzyIsNull(m_globalAmount.x()) && !qFuzzyIsNull(m_globalPace.x()))
-        d->position.setX(d->position.x() + smooth * QPSIN(m_globalPaceStart.x() + time * pi2 * m_globalPace.x()) * m_globalAmount.x());
-    if (!qFuzzyIsNull(m_globalAmount.y()) && !qFuzzyIsNull(m_globalPace.y()))
-        d->position.setY(d->position.y() + smooth * QPSIN(m_globalPaceStart.y() + time * pi2 * m_globalPace.y()) * m_globalAmount.y());
-    if (!qFuzzyIsNull(m_globalAmount.z()) && !qFuzzyIsNull(m_globalPace.z()))
-        d->position.setZ(d->position.z() + smooth * QPSIN(m_globalPaceStart.z() + time * pi2 * m_globalPace.z()) * m_globalAmount.z());
-
-    // Unique
-    // Rather simple to only use a single sin operation per direction
-    if (!qFuzzyIsNull(m_uniqueAmount.x()) && !qFuzzyIsNull(m_uniquePace.x())) {
-        // Values between  1.0 +/- variation
-        float paceVariation = 1.0f + m_uniquePaceVariation - 2.0f * rand->get(sd.index, QPRand::WanderXPV) * m_uniquePaceVariation;
-        float amountVariation = 1.0f + m_uniqueAmountVariation - 2.0f * rand->get(sd.index, QPRand::WanderXAV) * m_uniqueAmountVariation;
-        float startPace = rand->get(sd.index, QPRand::WanderXPS) * pi2;
-        float pace = startPace + paceVariation * time * pi2 * m_uniquePace.x();
-        float amount = amountVariation * m_uniqueAmount.x();
-        d->position.setX(d->position.x() + smooth * QPSIN(pace) * amount);
-    }
-    if (!qFuzzyIsNull(m_uniqueAmount.y()) && !qFuzzyIsNull(m_uniquePace.y())) {
-        // Values between  1.0 +/- variation
-        float paceVariation = 1.0f + m_uniquePaceVariation - 2.0f * rand->get(sd.index, QPRand::WanderYPV) * m_uniquePaceVariation;
-        float amountVariation = 1.0f + m_uniqueAmountVariation - 2.0f * rand->get(sd.index, QPRand::WanderYAV) * m_uniqueAmountVariation;
-        float startPace = rand->get(sd.index, QPRand::WanderYPS) * pi2;
-        float pace = startPace + paceVariation * time * pi2 * m_uniquePace.y();
-        float amount = amountVariation * m_uniqueAmount.y();
-        d->position.setY(d->position.y() + smooth * QPSIN(pace) * amount);
-    }
-    if (!qFuzzyIsNull(m_uniqueAmount.z()) && !qFuzzyIsNull(m_uniquePace.z())) {
-        // Values between  1.0 +/- variation
-        float paceVariation = 1.0f + m_uniquePaceVariation - 2.0f * rand->get(sd.index, QPRand::WanderZPV) * m_uniquePaceVariation;
-        float amountVariation = 1.0f + m_uniqueAmountVariation - 2.0f * rand->get(sd.index, QPRand::WanderZAV) * m_uniqueAmountVariation;
-        float startPace = rand->get(sd.index, QPRand::WanderZPS) * pi2;
-        float pace = startPace + paceVariation * time * pi2 * m_uniquePace.z();
-        float amount = amountVariation * m_uniqueAmount.z();
-        d->position.setZ(d->position.z() + smooth * QPSIN(pace) * amount);
+    for (int i = 0; i < span.count; i++) {
+        const QQuick3DParticleData &sd = span.particleData[span.indices[i]];
+        QQuick3DParticleDataCurrent *d = &span.currentData[i];
+        const float time = span.times[i];
+
+        // Optionally smoothen the beginning & end of wander
+        float smooth = 1.0f;
+        if (m_fadeInDuration > 0) {
+            smooth = time / (float(m_fadeInDuration) / 1000.0f);
+            smooth = std::min(1.0f, smooth);
+        }
+        if (m_fadeOutDuration > 0) {
+            float timeLeft = (sd.lifetime - time);
+            float smoothOut = timeLeft / (float(m_fadeOutDuration) / 1000.0f);
+            // When fading both in & out, select smaller (which is always max 1.0)
+            smooth = std::min(smoothOut, smooth);
+        }
+
+        // Global
+        for (int axis = 0; axis < 3; axis++) {
+            if (globalAxes[axis])
+                d->position[axis] = d->position[axis] + smooth * QPSIN(m_globalPaceStart[axis] + time * pi2 * m_globalPace[axis]) * m_globalAmount[axis];
+        }
+
+        // Unique
+        // Rather simple to only use a single sin operation per direction
+        for (int axis = 0; axis < 3; axis++) {
+            if (!uniqueAxes[axis])
+                continue;
+            // Values between  1.0 +/- variation
+            float paceVariation = 1.0f + m_uniquePaceVariation - 2.0f * rand->get(sd.index, paceVariationUsers[axis]) * m_uniquePaceVariation;
+            float amountVariation = 1.0f + m_uniqueAmountVariation - 2.0f * rand->get(sd.index, amountVariationUsers[axis]) * m_uniqueAmountVariation;
+            float startPace = rand->get(sd.index, paceStartUsers[axis]) * pi2;
+            float pace = startPace + paceVariation * time * pi2 * m_uniquePace[axis];
+            float amount = amountVariation * m_uniqueAmount[axis];
+            d->position[axis] = d->position[axis] + smooth * QPSIN(pace) * amount;
+        }
     }
 }
 
+bool QQuick3DParticleWander::canAffectConcurrently() const
+{
+    // Only uses the deterministic, read-only random values
+    return true;
+}
+
 QT_END_NAMESPACE
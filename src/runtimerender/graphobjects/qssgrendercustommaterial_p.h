@@ -125,6 +125,7 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGRenderCustomMaterial : public QSSGRende
     FlagT m_flags { FlagT(Flags::Dirty) };
     bool incompleteBuildTimeObject = false; // Used by the shadergen tool
     bool m_usesSharedVariables = false;
+    quint32 m_updateSerial = 0; // bumped on every sync from the frontend
 
     void markDirty();
     void clearDirty();
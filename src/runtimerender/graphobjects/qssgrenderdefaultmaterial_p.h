@@ -119,6 +119,7 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGRenderDefaultMaterial : QSSGRenderGraph
     QSSGDepthDrawMode depthDrawMode = QSSGDepthDrawMode::OpaqueOnly;
     bool vertexColorsEnabled = false;
     bool dirty = true;
+    quint32 updateSerial = 0; // bumped on every sync from the frontend
     TextureChannelMapping roughnessChannel = TextureChannelMapping::R;
     TextureChannelMapping opacityChannel = TextureChannelMapping::A;
     TextureChannelMapping translucencyChannel = TextureChannelMapping::A;
@@ -143,6 +143,14 @@ void QSSGRenderGeometry::setPrimitiveType(QSSGMesh::Mesh::DrawMode type)
     markDirty();
 }
 
+void QSSGRenderGeometry::setAutomaticLevelsOfDetail(bool enable)
+{
+    if (m_automaticLevelsOfDetail == enable)
+        return;
+    m_automaticLevelsOfDetail = enable;
+    markDirty();
+}
+
 void QSSGRenderGeometry::setBounds(const QVector3D &min, const QVector3D &max)
 {
     m_bounds = QSSGBounds3(min, max);
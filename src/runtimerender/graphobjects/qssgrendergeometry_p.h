@@ -60,6 +60,10 @@ public:
     void setBounds(const QVector3D &min, const QVector3D &max);
     void setPrimitiveType(QSSGMesh::Mesh::DrawMode type);
 
+    // Whether the buffer manager generates levels of detail for the subsets
+    bool automaticLevelsOfDetail() const { return m_automaticLevelsOfDetail; }
+    void setAutomaticLevelsOfDetail(bool enable);
+
     void addAttribute(QSSGMesh::RuntimeMeshData::Attribute::Semantic semantic,
                       int offset,
                       QSSGMesh::Mesh::ComponentType componentType);
@@ -91,6 +95,7 @@ protected:
     uint32_t m_generationId = 1;
     QSSGMesh::RuntimeMeshData m_meshData;
     QSSGBounds3 m_bounds;
+    bool m_automaticLevelsOfDetail = false;
 };
 
 QT_END_NAMESPACE
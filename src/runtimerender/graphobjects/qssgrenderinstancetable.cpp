@@ -3,6 +3,13 @@
 
 #include "qssgrenderinstancetable_p.h"
 
+#include <QtQuick3DRuntimeRender/private/qssgrenderinstancebvh_p.h>
+
+QSSGRenderInstanceTable::~QSSGRenderInstanceTable()
+{
+    qDeleteAll(pickingBvhs);
+}
+
 QMatrix4x4 QSSGRenderInstanceTable::getTransform(int index) const
 {
     Q_ASSERT(index < instanceCount);
@@ -16,3 +23,63 @@ QMatrix4x4 QSSGRenderInstanceTable::getTransform(int index) const
     res.setRow(3, { 0, 0, 0, 1 });
     return res;
 }
+
+QSSGBounds3 QSSGRenderInstanceTable::instanceBounds(int index, const QSSGBounds3 &localBounds) const
+{
+    Q_ASSERT(index < instanceCount);
+    auto *entry = reinterpret_cast<const QSSGRenderInstanceTableEntry*>(table.constData() + index * instanceStride);
+
+    QVector3D center;
+    QVector3D extents;
+    entry->transformBounds(localBounds.center(), localBounds.extents(), center, extents);
+    return QSSGBounds3(center - extents, center + extents);
+}
+
+QSSGRenderInstanceBvh *QSSGRenderInstanceTable::pickingBvh(const QSSGBounds3 &localBounds)
+{
+    // Rebuilding the tree each time another model sharing the table gets picked would be worse
+    // than not having one, but keeping a tree for every distinct bounds is not worth it either.
+    constexpr qsizetype MaxPickingBvhs = 4;
+
+    for (qsizetype idx = 0, end = pickingBvhs.size(); idx != end; ++idx) {
+        QSSGRenderInstanceBvh *bvh = pickingBvhs.at(idx);
+        if (bvh->localBounds().minimum == localBounds.minimum && bvh->localBounds().maximum == localBounds.maximum) {
+            if (idx != 0)
+                pickingBvhs.move(idx, 0);
+            return bvh;
+        }
+    }
+
+    if (pickingBvhs.size() == MaxPickingBvhs)
+        delete pickingBvhs.takeLast();
+    pickingBvhs.prepend(new QSSGRenderInstanceBvh(localBounds));
+    return pickingBvhs.first();
+}
+
+void QSSGRenderInstanceTable::updateData(const QByteArray &data, QVector<Range> ranges)
+{
+    Q_ASSERT(data.size() == table.size());
+    const int entryCount = int(table.size() / qMax(instanceStride, 1));
+
+    std::sort(ranges.begin(), ranges.end(), [](const Range &a, const Range &b) { return a.offset < b.offset; });
+    updatedRanges.clear();
+    for (const Range &range : std::as_const(ranges)) {
+        const int begin = qBound(0, range.offset, entryCount);
+        const int end = qBound(begin, range.offset + range.count, entryCount);
+        if (begin == end)
+            continue;
+        if (!updatedRanges.isEmpty() && begin <= updatedRanges.last().offset + updatedRanges.last().count) {
+            Range &last = updatedRanges.last();
+            last.count = qMax(last.offset + last.count, end) - last.offset;
+        } else {
+            updatedRanges.append({ begin, end - begin });
+        }
+    }
+
+    // Only detaches the first time the table is updated after setData()
+    char *dst = table.data();
+    for (const Range &range : std::as_const(updatedRanges))
+        memcpy(dst + range.offset * instanceStride, data.constData() + range.offset * instanceStride, range.count * instanceStride);
+
+    ++instanceUpdateSerial;
+}
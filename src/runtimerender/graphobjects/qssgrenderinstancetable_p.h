@@ -21,38 +21,78 @@
 
 QT_BEGIN_NAMESPACE
 
+class QSSGRenderInstanceBvh;
+
 struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGRenderInstanceTableEntry {
     QVector4D row0;
     QVector4D row1;
     QVector4D row2;
     QVector4D color;
     QVector4D instanceData;
+
+    // Center and extents of the bounds of the instance in the space of the table, given the
+    // center and extents of its bounds in its local space
+    void transformBounds(const QVector3D &localCenter, const QVector3D &localExtents, QVector3D &center, QVector3D &extents) const
+    {
+        const auto absRow = [](const QVector4D &row) { return QVector3D(qAbs(row.x()), qAbs(row.y()), qAbs(row.z())); };
+        center = QVector3D(QVector3D::dotProduct(row0.toVector3D(), localCenter) + row0.w(),
+                           QVector3D::dotProduct(row1.toVector3D(), localCenter) + row1.w(),
+                           QVector3D::dotProduct(row2.toVector3D(), localCenter) + row2.w());
+        extents = QVector3D(QVector3D::dotProduct(absRow(row0), localExtents),
+                            QVector3D::dotProduct(absRow(row1), localExtents),
+                            QVector3D::dotProduct(absRow(row2), localExtents));
+    }
 };
 
 struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGRenderInstanceTable : public QSSGRenderNode
 {
+    // A range of instances, in entries
+    struct Range
+    {
+        int offset;
+        int count;
+    };
+
     QSSGRenderInstanceTable() : QSSGRenderNode(QSSGRenderGraphObject::Type::ModelInstance) {}
+    ~QSSGRenderInstanceTable() override;
 
     int count() const { return instanceCount; }
     qsizetype dataSize() const { return table.size(); }
     const void *constData() const { return table.constData(); }
-    void setData(const QByteArray &data, int count, int stride) { table = data; instanceCount = count; instanceStride = stride; ++instanceSerial; }
+    void setData(const QByteArray &data, int count, int stride) { table = data; instanceCount = count; instanceStride = stride; updatedRanges.clear(); ++instanceSerial; }
+    // Copies the given ranges from data, which has the same layout as the current table.
+    // Unlike setData() this keeps the serial, and bumps updateSerial() instead.
+    void updateData(const QByteArray &data, QVector<Range> ranges);
     void setInstanceCountOverride(int count) { instanceCount = count; }
     int serial() const { return instanceSerial; }
+    // The ranges copied by the last updateData() call, sorted and without overlaps. Only
+    // valid for a renderer that has seen the table at updateSerial() - 1.
+    const QVector<Range> &lastUpdatedRanges() const { return updatedRanges; }
+    int updateSerial() const { return instanceUpdateSerial; }
     int stride() const { return instanceStride; }
     bool hasTransparency() { return transparency; }
     void setHasTransparency( bool t) { transparency = t; }
     void setDepthSorting(bool enable) { depthSorting = enable; }
     bool isDepthSortingEnabled() { return depthSorting; }
     QMatrix4x4 getTransform(int index) const;
+    // The bounds of the instance in the space of the table, given its bounds in its local space
+    QSSGBounds3 instanceBounds(int index, const QSSGBounds3 &localBounds) const;
+
+    // The picking tree for models using this table with the given local bounds, built by the
+    // renderer when picking. Models sharing the table with different bounds get trees of their
+    // own, the least recently used one is dropped when there are too many.
+    QSSGRenderInstanceBvh *pickingBvh(const QSSGBounds3 &localBounds);
 
 private:
     int instanceCount = 0;
     int instanceSerial = 0;
+    int instanceUpdateSerial = 0;
     int instanceStride = 0;
     bool transparency = false;
     bool depthSorting = false;
     QByteArray table;
+    QVector<Range> updatedRanges;
+    QVector<QSSGRenderInstanceBvh *> pickingBvhs; // most recently used first
 };
 
 QT_END_NAMESPACE
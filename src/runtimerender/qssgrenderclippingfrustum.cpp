@@ -6,6 +6,8 @@
 
 #include <QtQuick3DUtils/private/qssgutils_p.h>
 
+#include <QtCore/private/qsimd_p.h>
+
 QT_BEGIN_NAMESPACE
 
 QSSGClippingFrustum::QSSGClippingFrustum(const QMatrix4x4 &modelviewprojection, const QSSGClipPlane &nearPlane)
@@ -43,4 +45,132 @@ QSSGClippingFrustum::QSSGClippingFrustum(const QMatrix4x4 &modelviewprojection,
         mPlanes[idx].calculateBBoxEdges();
 }
 
+void QSSGBoundsSoA::reserve(qsizetype size)
+{
+    const qsizetype paddedSize = alignedSize(size);
+    minX.reserve(paddedSize);
+    minY.reserve(paddedSize);
+    minZ.reserve(paddedSize);
+    maxX.reserve(paddedSize);
+    maxY.reserve(paddedSize);
+    maxZ.reserve(paddedSize);
+}
+
+void QSSGBoundsSoA::resize(qsizetype size)
+{
+    const qsizetype paddedSize = alignedSize(size);
+    minX.resize(paddedSize);
+    minY.resize(paddedSize);
+    minZ.resize(paddedSize);
+    maxX.resize(paddedSize);
+    maxY.resize(paddedSize);
+    maxZ.resize(paddedSize);
+    count = size;
+}
+
+namespace {
+// For each plane we only need the box corner furthest along the plane normal (the
+// "upper edge"), so we select the min or max array per axis up-front instead of per box.
+struct PlaneStreams
+{
+    const float *x;
+    const float *y;
+    const float *z;
+    QVector3D n;
+    float d;
+};
+}
+
+qsizetype QSSGClippingFrustum::intersectsWith(const QSSGBoundsSoA &bounds, quint32 *visibilityMask) const
+{
+    const qsizetype count = bounds.size();
+    if (count == 0)
+        return 0;
+
+    PlaneStreams planes[6];
+    for (quint32 idx = 0; idx < 6; ++idx) {
+        const auto &plane = mPlanes[idx];
+        const auto edge = plane.mEdges.upperEdge;
+        planes[idx] = { (edge & QSSGClipPlane::xMax) ? bounds.maxX.constData() : bounds.minX.constData(),
+                        (edge & QSSGClipPlane::yMax) ? bounds.maxY.constData() : bounds.minY.constData(),
+                        (edge & QSSGClipPlane::zMax) ? bounds.maxZ.constData() : bounds.minZ.constData(),
+                        plane.normal,
+                        plane.d };
+    }
+
+    const qsizetype maskSize = QSSGBoundsSoA::maskSize(count);
+    std::fill_n(visibilityMask, maskSize, 0u);
+
+    const qsizetype end = bounds.paddedSize();
+    qsizetype i = 0;
+
+#if defined(__AVX__)
+    const __m256 zero = _mm256_setzero_ps();
+    for (; i + 8 <= end; i += 8) {
+        __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (const auto &p : planes) {
+            const __m256 dx = _mm256_mul_ps(_mm256_set1_ps(p.n.x()), _mm256_loadu_ps(p.x + i));
+            const __m256 dy = _mm256_mul_ps(_mm256_set1_ps(p.n.y()), _mm256_loadu_ps(p.y + i));
+            const __m256 dz = _mm256_mul_ps(_mm256_set1_ps(p.n.z()), _mm256_loadu_ps(p.z + i));
+            const __m256 dist = _mm256_add_ps(_mm256_add_ps(dx, dy), _mm256_add_ps(dz, _mm256_set1_ps(p.d)));
+            // !(dist < 0), same as the scalar QSSGClipPlane::intersectSimple()
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(dist, zero, _CMP_NLT_UQ));
+        }
+        visibilityMask[i >> 5] |= quint32(_mm256_movemask_ps(visible)) << (i & 31);
+    }
+#elif defined(__SSE2__)
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= end; i += 4) {
+        __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (const auto &p : planes) {
+            const __m128 dx = _mm_mul_ps(_mm_set1_ps(p.n.x()), _mm_loadu_ps(p.x + i));
+            const __m128 dy = _mm_mul_ps(_mm_set1_ps(p.n.y()), _mm_loadu_ps(p.y + i));
+            const __m128 dz = _mm_mul_ps(_mm_set1_ps(p.n.z()), _mm_loadu_ps(p.z + i));
+            const __m128 dist = _mm_add_ps(_mm_add_ps(dx, dy), _mm_add_ps(dz, _mm_set1_ps(p.d)));
+            // !(dist < 0), same as the scalar QSSGClipPlane::intersectSimple()
+            visible = _mm_and_ps(visible, _mm_cmpnlt_ps(dist, zero));
+        }
+        visibilityMask[i >> 5] |= quint32(_mm_movemask_ps(visible)) << (i & 31);
+    }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    for (; i + 4 <= end; i += 4) {
+        uint32x4_t visible = vdupq_n_u32(0xffffffff);
+        for (const auto &p : planes) {
+            float32x4_t dist = vdupq_n_f32(p.d);
+            dist = vmlaq_n_f32(dist, vld1q_f32(p.x + i), p.n.x());
+            dist = vmlaq_n_f32(dist, vld1q_f32(p.y + i), p.n.y());
+            dist = vmlaq_n_f32(dist, vld1q_f32(p.z + i), p.n.z());
+            // !(dist < 0), same as the scalar QSSGClipPlane::intersectSimple()
+            visible = vandq_u32(visible, vmvnq_u32(vcltq_f32(dist, zero)));
+        }
+        const quint32 bits = (vgetq_lane_u32(visible, 0) & 1)
+                | (vgetq_lane_u32(visible, 1) & 2)
+                | (vgetq_lane_u32(visible, 2) & 4)
+                | (vgetq_lane_u32(visible, 3) & 8);
+        visibilityMask[i >> 5] |= bits << (i & 31);
+    }
+#endif
+
+    for (; i < end; ++i) {
+        bool visible = true;
+        for (quint32 idx = 0; idx < 6 && visible; ++idx) {
+            const auto &p = planes[idx];
+            visible = !((p.n.x() * p.x[i] + p.n.y() * p.y[i] + p.n.z() * p.z[i] + p.d) < 0.0f);
+        }
+        if (visible)
+            visibilityMask[i >> 5] |= 1u << (i & 31);
+    }
+
+    // Drop the padding entries (paddedSize() never exceeds maskSize * 32, as 32 is a multiple of the alignment)
+    if (const qsizetype tail = count & 31)
+        visibilityMask[maskSize - 1] &= (1u << tail) - 1;
+
+    qsizetype visibleCount = 0;
+    for (qsizetype idx = 0; idx != maskSize; ++idx)
+        visibleCount += qPopulationCount(visibilityMask[idx]);
+
+    return visibleCount;
+}
+
 QT_END_NAMESPACE
@@ -20,6 +20,8 @@
 #include <QtQuick3DUtils/private/qssgbounds3_p.h>
 #include <QtQuick3DRuntimeRender/private/qtquick3druntimerenderexports_p.h>
 
+#include <QtCore/qlist.h>
+
 QT_BEGIN_NAMESPACE
 
 struct QSSGClipPlane
@@ -117,6 +119,61 @@ struct QSSGClipPlane
     }
 };
 
+// Structure-of-arrays copy of a list of (world space) bounding boxes.
+// The arrays are padded to a multiple of 'Alignment' so the SIMD culling
+// kernels can always work on full lanes; padding entries are never
+// reported as visible.
+struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGBoundsSoA
+{
+    static constexpr qsizetype Alignment = 8;
+
+    QVector<float> minX;
+    QVector<float> minY;
+    QVector<float> minZ;
+    QVector<float> maxX;
+    QVector<float> maxY;
+    QVector<float> maxZ;
+
+    [[nodiscard]] qsizetype size() const { return count; }
+    [[nodiscard]] bool isEmpty() const { return count == 0; }
+    [[nodiscard]] qsizetype paddedSize() const { return minX.size(); }
+
+    // Reserves room for 'size' boxes in all six vectors. clear() keeps the capacity.
+    void reserve(qsizetype size);
+    void resize(qsizetype size);
+    void clear() { resize(0); }
+
+    void set(qsizetype idx, const QSSGBounds3 &bounds)
+    {
+        minX[idx] = bounds.minimum.x();
+        minY[idx] = bounds.minimum.y();
+        minZ[idx] = bounds.minimum.z();
+        maxX[idx] = bounds.maximum.x();
+        maxY[idx] = bounds.maximum.y();
+        maxZ[idx] = bounds.maximum.z();
+    }
+
+    void append(const QSSGBounds3 &bounds)
+    {
+        // The padding holds the next boxes, the vectors only grow once it is used up
+        const qsizetype idx = count;
+        if (idx < paddedSize())
+            ++count;
+        else
+            resize(idx + 1);
+        set(idx, bounds);
+    }
+
+    // Number of 32-bit words needed for a visibility mask covering 'size' boxes.
+    [[nodiscard]] static constexpr qsizetype maskSize(qsizetype size) { return (size + 31) / 32; }
+
+    // Number of entries in each vector for 'size' boxes.
+    [[nodiscard]] static constexpr qsizetype alignedSize(qsizetype size) { return (size + Alignment - 1) & ~(Alignment - 1); }
+
+private:
+    qsizetype count = 0;
+};
+
 struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGClippingFrustum
 {
     QSSGClipPlane mPlanes[6];
@@ -141,6 +198,12 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGClippingFrustum
             ret = !(mPlanes[idx].distance(point) < radius);
         return ret;
     }
+
+    // Tests all boxes in 'bounds' against the six planes and sets bit (i % 32) of
+    // visibilityMask[i / 32] for every box i that intersects the frustum.
+    // visibilityMask must hold QSSGBoundsSoA::maskSize(bounds.size()) words.
+    // Returns the number of visible boxes.
+    qsizetype intersectsWith(const QSSGBoundsSoA &bounds, quint32 *visibilityMask) const;
 };
 QT_END_NAMESPACE
 
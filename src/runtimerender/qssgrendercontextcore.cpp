@@ -227,6 +227,9 @@ bool QSSGRenderContextInterface::endFrame(QSSGRenderLayer *layer, bool allowRecu
     cleanupUnreferencedBuffers(layer);
 
     m_renderer->endFrame(layer);
+    // Shaders compiled in the background for renderables that went away would otherwise
+    // stay pending, and keep requesting new frames.
+    m_shaderCache->collectFinishedCompilations();
     ++m_frameCount;
 
     return true;
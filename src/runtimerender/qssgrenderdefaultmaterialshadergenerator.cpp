@@ -1821,7 +1821,8 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGMaterialShaderGenerator::generateMaterialRhiS
                                                                                       const QSSGShaderLightListView &inLights,
                                                                                       QSSGRenderableImage *inFirstImage,
                                                                                       const QSSGRef<QSSGShaderLibraryManager> &shaderLibraryManager,
-                                                                                      const QSSGRef<QSSGShaderCache> &theCache)
+                                                                                      const QSSGRef<QSSGShaderCache> &theCache,
+                                                                                      QSSGShaderCache::CompileMode compileMode)
 {
     QByteArray materialInfoString; // also serves as the key for the cache in compileGeneratedRhiShader
     // inShaderKeyPrefix can be a static string for default materials, but must
@@ -1835,7 +1836,7 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGMaterialShaderGenerator::generateMaterialRhiS
     vertexPipeline.endVertexGeneration();
     vertexPipeline.endFragmentGeneration();
 
-    return vertexPipeline.programGenerator()->compileGeneratedRhiShader(materialInfoString, inFeatureSet, shaderLibraryManager, theCache, {});
+    return vertexPipeline.programGenerator()->compileGeneratedRhiShader(materialInfoString, inFeatureSet, shaderLibraryManager, theCache, {}, compileMode);
 }
 
 static float ZERO_MATRIX[16] = {};
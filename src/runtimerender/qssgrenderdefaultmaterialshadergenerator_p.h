@@ -72,7 +72,8 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGMaterialShaderGenerator
                                                                     const QSSGRenderGraphObject &inMaterial,
                                                                     const QSSGShaderLightListView &inLights,
                                                                     QSSGRenderableImage *inFirstImage, const QSSGRef<QSSGShaderLibraryManager> &shaderLibraryManager,
-                                                                    const QSSGRef<QSSGShaderCache> &theCache);
+                                                                    const QSSGRef<QSSGShaderCache> &theCache,
+                                                                    QSSGShaderCache::CompileMode compileMode = QSSGShaderCache::CompileMode::Synchronous);
 
     static void setRhiMaterialProperties(const QSSGRenderContextInterface &,
                                          QSSGRef<QSSGRhiShaderPipeline> &shaders,
@@ -21,6 +21,8 @@
 #include <QtQuick3DUtils/private/qssgbounds3_p.h>
 #include <QtQuick3DUtils/private/qssgmeshbvh_p.h>
 
+#include <QtCore/qfuture.h>
+
 QT_BEGIN_NAMESPACE
 
 struct QSSGRenderSubset
@@ -28,7 +30,7 @@ struct QSSGRenderSubset
     quint32 count;
     quint32 offset;
     QSSGBounds3 bounds; // Vertex buffer bounds
-    QSSGMeshBVHNode *bvhRoot = nullptr;
+    qint32 bvhRoot = QSSGMeshBVH::InvalidRoot; // index in QSSGRenderMesh::bvh
     struct {
         QSSGRef<QSSGRhiBuffer> vertexBuffer;
         QSSGRef<QSSGRhiBuffer> indexBuffer;
@@ -98,7 +100,13 @@ struct QSSGRenderMesh
     QSSGRenderDrawMode drawMode;
     QSSGRenderWinding winding;
     QSSGMeshBVH *bvh = nullptr;
+    // Background build of bvh, see QSSGBufferManager::loadMeshBVHAsync(). Once finished,
+    // resolveBvh() sets bvh to the result (so both refer to the same tree).
+    QFuture<QSSGMeshBVH *> bvhFuture;
     QSize lightmapSizeHint;
+    // Tells meshes apart beyond their address, which gets reused once a mesh is released.
+    // Set by QSSGBufferManager::createRenderMesh(), never 0 there.
+    quint32 generationId = 0;
 
     QSSGRenderMesh(QSSGRenderDrawMode inDrawMode, QSSGRenderWinding inWinding)
         : drawMode(inDrawMode), winding(inWinding)
@@ -107,7 +115,32 @@ struct QSSGRenderMesh
 
     ~QSSGRenderMesh()
     {
-        delete bvh;
+        if (bvhFuture.isValid()) {
+            // Don't wait for a build that is still running, the future owns its result
+            // (which bvh refers to once resolved) and deletes it when the build is done.
+            Q_ASSERT(!bvh || (bvhFuture.isFinished() && bvh == bvhFuture.result()));
+            bvhFuture.then([](QSSGMeshBVH *result) { delete result; });
+        } else {
+            delete bvh;
+        }
+    }
+
+    // Picks up the result of a finished background build and sets the subset roots.
+    // Returns true if bvh is available. Both the render thread and picking call this,
+    // so it must be called with QSSGBufferManager::meshUpdateMutex() locked.
+    bool resolveBvh()
+    {
+        if (bvh)
+            return true;
+        if (!bvhFuture.isValid() || !bvhFuture.isFinished())
+            return false;
+
+        bvh = bvhFuture.result();
+        if (!bvh)
+            return false;
+        for (qsizetype i = 0, end = qMin(bvh->roots.size(), subsets.size()); i < end; ++i)
+            subsets[i].bvhRoot = bvh->roots.at(i);
+        return true;
     }
 };
 QT_END_NAMESPACE
@@ -9,6 +9,8 @@
 #include <QtQuick3DUtils/private/qssgmeshbvh_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrendermesh_p.h>
 
+#include <QtCore/qvarlengtharray.h>
+
 #include <optional>
 
 QT_BEGIN_NAMESPACE
@@ -173,84 +175,83 @@ bool QSSGRenderRay::triangleIntersect(const QSSGRenderRay &ray,
 }
 
 void QSSGRenderRay::intersectWithBVH(const RayData &data,
-                                     const QSSGMeshBVHNode *bvh,
-                                     const QSSGRenderMesh *mesh,
-                                     QVector<IntersectionResult> &intersections,
-                                     int depth)
+                                     const QSSGMeshBVH *bvh,
+                                     qint32 rootNode,
+                                     QVector<IntersectionResult> &intersections)
 {
-    if (!bvh || !mesh || !mesh->bvh)
+    if (!bvh || rootNode < 0 || rootNode >= bvh->nodes.size())
         return;
 
-    // If this is a leaf node, process it's triangles
-    if (bvh->count != 0) {
-        // If there is an intersection on a leaf node, then test against geometry
-        auto results = intersectWithBVHTriangles(data, mesh->bvh->triangles, bvh->offset, bvh->count);
-        if (!results.isEmpty())
-            intersections.append(results);
+    const QSSGMeshBVHNode *nodes = bvh->nodes.constData();
+    if (!QSSGRenderRay::intersectWithAABBv2(data, nodes[rootNode].boundingData).intersects())
         return;
-    }
 
-    auto hit = QSSGRenderRay::intersectWithAABBv2(data, bvh->left->boundingData);
-    if (hit.intersects())
-        intersectWithBVH(data, bvh->left, mesh, intersections, depth + 1);
+    // The tree is at most QSSGMeshBVHBuilder's max depth (64) deep, so the stack
+    // only grows beyond its preallocated size for degenerate trees.
+    QVarLengthArray<quint32, 64> stack;
+    stack.push_back(quint32(rootNode));
+    while (!stack.isEmpty()) {
+        const QSSGMeshBVHNode &node = nodes[stack.takeLast()];
+
+        // If this is a leaf node, process it's triangles
+        if (node.isLeaf()) {
+            intersectWithBVHTriangles(data, bvh->triangles, node.offset, node.count, intersections);
+            continue;
+        }
 
-    hit = QSSGRenderRay::intersectWithAABBv2(data, bvh->right->boundingData);
-    if (hit.intersects())
-        intersectWithBVH(data, bvh->right, mesh, intersections, depth + 1);
+        if (QSSGRenderRay::intersectWithAABBv2(data, nodes[node.right()].boundingData).intersects())
+            stack.push_back(node.right());
+        if (QSSGRenderRay::intersectWithAABBv2(data, nodes[node.left()].boundingData).intersects())
+            stack.push_back(node.left());
+    }
 }
 
-
-
-QVector<QSSGRenderRay::IntersectionResult> QSSGRenderRay::intersectWithBVHTriangles(const RayData &data,
-                                                                                    const QVector<QSSGMeshBVHTriangle *> &bvhTriangles,
-                                                                                    int triangleOffset,
-                                                                                    int triangleCount)
+void QSSGRenderRay::intersectWithBVHTriangles(const RayData &data,
+                                              const QVector<QSSGMeshBVHTriangle> &bvhTriangles,
+                                              int triangleOffset,
+                                              int triangleCount,
+                                              QVector<IntersectionResult> &intersections)
 {
     Q_ASSERT(bvhTriangles.size() >= triangleOffset + triangleCount);
 
-    QVector<QSSGRenderRay::IntersectionResult> results;
+    const QSSGRenderRay relativeRay(data.origin, data.direction);
 
     for (int i = triangleOffset; i < triangleCount + triangleOffset; ++i) {
         const auto &triangle = bvhTriangles[i];
 
-        QSSGRenderRay relativeRay(data.origin, data.direction);
-
         // Use Barycentric Coordinates to get the intersection values
         float u = 0.f;
         float v = 0.f;
         QVector3D normal;
         const bool intersects = triangleIntersect(relativeRay,
-                                                  triangle->vertex1,
-                                                  triangle->vertex2,
-                                                  triangle->vertex3,
+                                                  triangle.vertex1,
+                                                  triangle.vertex2,
+                                                  triangle.vertex3,
                                                   u,
                                                   v,
                                                   normal);
         if (intersects) {
             const float w = 1.0f - u - v;
-            const QVector3D localIntersectionPoint = u * triangle->vertex1 +
-                                                     v * triangle->vertex2 +
-                                                     w * triangle->vertex3;
+            const QVector3D localIntersectionPoint = u * triangle.vertex1 +
+                                                     v * triangle.vertex2 +
+                                                     w * triangle.vertex3;
 
-            const QVector2D uvCoordinate = u * triangle->uvCoord1 +
-                                           v * triangle->uvCoord2 +
-                                           w * triangle->uvCoord3;
+            const QVector2D uvCoordinate = u * triangle.uvCoord1 +
+                                           v * triangle.uvCoord2 +
+                                           w * triangle.uvCoord3;
             // Get the intersection point in scene coordinates
             const QVector3D sceneIntersectionPos = mat44::transform(data.globalTransform,
                                                                     localIntersectionPoint);
             const QVector3D hitVector = data.ray.origin - sceneIntersectionPos;
             // Get the magnitude of the hit vector
             const float rayLengthSquared = vec3::magnitudeSquared(hitVector);
-            results.append(IntersectionResult(rayLengthSquared,
-                                              uvCoordinate,
-                                              sceneIntersectionPos,
-                                              localIntersectionPoint,
-                                              normal));
+            intersections.append(IntersectionResult(rayLengthSquared,
+                                                    uvCoordinate,
+                                                    sceneIntersectionPos,
+                                                    localIntersectionPoint,
+                                                    normal));
         }
     }
-
-    // Does not intersect with any of the triangles
-    return results;
 }
 
 std::optional<QVector2D> QSSGRenderRay::relative(const QMatrix4x4 &inGlobalTransform,
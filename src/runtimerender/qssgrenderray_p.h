@@ -26,8 +26,7 @@
 #include <optional>
 
 QT_BEGIN_NAMESPACE
-struct QSSGMeshBVHNode;
-struct QSSGRenderMesh;
+struct QSSGMeshBVH;
 struct QSSGMeshBVHTriangle;
 enum class QSSGRenderBasisPlanes
 {
@@ -115,15 +114,15 @@ struct Q_AUTOTEST_EXPORT QSSGRenderRay
                                          const QSSGBounds3 &bounds);
 
     static void intersectWithBVH(const RayData &data,
-                                        const QSSGMeshBVHNode *bvh,
-                                        const QSSGRenderMesh *mesh,
-                                        QVector<IntersectionResult> &intersections,
-                                        int depth = 0);
-
-    static QVector<IntersectionResult> intersectWithBVHTriangles(const RayData &data,
-                                                                 const QVector<QSSGMeshBVHTriangle *> &bvhTriangles,
-                                                                 int triangleOffset,
-                                                                 int triangleCount);
+                                 const QSSGMeshBVH *bvh,
+                                 qint32 rootNode,
+                                 QVector<IntersectionResult> &intersections);
+
+    static void intersectWithBVHTriangles(const RayData &data,
+                                          const QVector<QSSGMeshBVHTriangle> &bvhTriangles,
+                                          int triangleOffset,
+                                          int triangleCount,
+                                          QVector<IntersectionResult> &intersections);
 
     std::optional<QVector2D> relative(const QMatrix4x4 &inGlobalTransform,
                                         const QSSGBounds3 &inBounds,
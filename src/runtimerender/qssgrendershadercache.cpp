@@ -27,11 +27,18 @@
 #endif
 
 #include <QtCore/qmutex.h>
+#ifdef QT_QUICK3D_HAS_CONCURRENT
+#include <QtConcurrent/qtconcurrentrun.h>
+#endif
 
 QT_BEGIN_NAMESPACE
 
 static QtQuick3DEditorHelpers::ShaderBaker::StatusCallback s_statusCallback = nullptr;
 Q_GLOBAL_STATIC(QMutex, s_statusMutex);
+Q_GLOBAL_STATIC(QMutex, s_shaderManifestMutex);
+
+static constexpr quint64 ShaderManifestMagic = 0x464e4d5244485351;
+static constexpr quint32 ShaderManifestQtVersion = (QT_VERSION_MAJOR << 16) | (QT_VERSION_MINOR << 8) | (QT_VERSION_PATCH);
 
 size_t qHash(QSSGShaderFeatures features) noexcept { return (features.flags & (~QSSGShaderFeatures::IndexMask)); }
 
@@ -238,24 +245,36 @@ QSSGShaderCache::QSSGShaderCache(const QSSGRef<QSSGRhiContext> &ctx,
             && !qEnvironmentVariableIntValue("QT_DISABLE_SHADER_DISK_CACHE")
             && !qEnvironmentVariableIntValue("QSG_RHI_DISABLE_DISK_CACHE");
 
+    m_shaderManifestFileName = qEnvironmentVariable("QT_QUICK3D_RECORD_SHADER_MANIFEST");
+
     if (m_autoDiskCacheEnabled) {
         const bool shaderDebug = !QSSGRhiContext::editorMode() && QSSGRhiContext::shaderDebuggingEnabled();
         m_persistentShaderStorageFileName = persistentQsbcFileName();
         if (!m_persistentShaderStorageFileName.isEmpty()) {
-            const bool skipCacheFile = qEnvironmentVariableIntValue("QT_QUICK3D_NO_SHADER_CACHE_LOAD");
-            if (!skipCacheFile && QFileInfo(m_persistentShaderStorageFileName).exists()) {
-                if (shaderDebug)
-                    qDebug("Attempting to seed material shader cache from %s", qPrintable(m_persistentShaderStorageFileName));
-                if (m_persistentShaderBakingCache.load(m_persistentShaderStorageFileName)) {
-                    if (shaderDebug) {
-                        const int count = m_persistentShaderBakingCache.availableEntries().count();
-                        qDebug("Loaded %d shader pipelines into the material shader cache", count);
-                    }
+            // Only the index is read here, pipelines are decoded when they are first used,
+            // and newly baked ones are appended to the journal right away.
+            // When recording a manifest every pipeline in use needs to go through compileForRhi()
+            const bool skipCacheFile = qEnvironmentVariableIntValue("QT_QUICK3D_NO_SHADER_CACHE_LOAD")
+                    || !m_shaderManifestFileName.isEmpty();
+            if (shaderDebug && !skipCacheFile)
+                qDebug("Attempting to seed material shader cache from %s", qPrintable(m_persistentShaderStorageFileName));
+            auto *persistentCache = new QQsbPersistentCollection(m_persistentShaderStorageFileName);
+            if (persistentCache->open(!skipCacheFile)) {
+                m_persistentShaderBakingCache = persistentCache;
+                if (shaderDebug) {
+                    const int count = m_persistentShaderBakingCache->availableEntries().count();
+                    qDebug("Found %d shader pipelines in the material shader cache", count);
                 }
+            } else {
+                delete persistentCache;
+                m_persistentShaderStorageFileName.clear();
             }
         }
     }
 
+    if (!m_persistentShaderBakingCache)
+        m_persistentShaderBakingCache = new QQsbInMemoryCollection;
+
     if (!m_initBaker) {
         // It is important to generate all possible shader variants if the qsb
         // collection is going to be stored on disk. Otherwise switching the
@@ -271,8 +290,8 @@ QSSGShaderCache::QSSGShaderCache(const QSSGRef<QSSGRhiContext> &ctx,
 
 QSSGShaderCache::~QSSGShaderCache()
 {
-    if (!m_persistentShaderStorageFileName.isEmpty())
-        m_persistentShaderBakingCache.save(m_persistentShaderStorageFileName);
+    // Merges the journal into the cache file when it has grown large enough
+    delete m_persistentShaderBakingCache;
 }
 
 void QSSGShaderCache::releaseCachedResources()
@@ -292,6 +311,14 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGShaderCache::tryGetRhiShaderPipeline(const QB
     const auto theIter = m_rhiShaders.constFind(cacheKey);
     if (theIter != m_rhiShaders.cend())
         return theIter.value();
+#ifdef QT_QUICK3D_HAS_RUNTIME_SHADERS
+    const auto pendingIt = m_pendingShaders.constFind(cacheKey);
+    if (pendingIt != m_pendingShaders.cend() && pendingIt->future.isFinished()) {
+        const PendingCompilation pending = pendingIt.value();
+        m_pendingShaders.erase(pendingIt);
+        return finishCompile(cacheKey, pending.vertexCode, pending.fragmentCode, pending.stageFlags, pending.future.result());
+    }
+#endif
     return nullptr;
 }
 
@@ -346,34 +373,32 @@ QByteArray QSSGShaderCache::shaderCollectionFile()
     return QByteArrayLiteral("qtappshaders.qsbc");
 }
 
-QSSGRef<QSSGRhiShaderPipeline> QSSGShaderCache::compileForRhi(const QByteArray &inKey, const QByteArray &inVert, const QByteArray &inFrag,
-                                                              const QSSGShaderFeatures &inFeatures, QSSGRhiShaderPipeline::StageFlags stageFlags)
-{
 #ifdef QT_QUICK3D_HAS_RUNTIME_SHADERS
-    const QSSGRef<QSSGRhiShaderPipeline> &rhiShaders = tryGetRhiShaderPipeline(inKey, inFeatures);
-    if (rhiShaders)
-        return rhiShaders;
-
-    QSSGShaderCacheKey tempKey(inKey);
-    tempKey.m_features = inFeatures;
-    tempKey.updateHashCode();
-
-    QByteArray vertexCode = inVert;
-    QByteArray fragmentCode = inFrag;
+QSSGShaderCache::BakeResult QSSGShaderCache::bakeShaders(QShaderBaker *baker, const QByteArray &vertexCode, const QByteArray &fragmentCode)
+{
+    BakeResult result;
 
-    if (!vertexCode.isEmpty())
-        addShaderPreprocessor(vertexCode, inKey, ShaderType::Vertex, inFeatures);
+    baker->setSourceString(vertexCode, QShader::VertexStage);
+    result.vertexShader = baker->bake();
+    if (!result.vertexShader.isValid())
+        result.vertErr = baker->errorMessage();
 
-    if (!fragmentCode.isEmpty())
-        addShaderPreprocessor(fragmentCode, inKey, ShaderType::Fragment, inFeatures);
+    baker->setSourceString(fragmentCode, QShader::FragmentStage);
+    result.fragmentShader = baker->bake();
+    if (!result.fragmentShader.isValid())
+        result.fragErr = baker->errorMessage();
 
-    // lo and behold the final shader strings are ready
+    return result;
+}
 
+QSSGRef<QSSGRhiShaderPipeline> QSSGShaderCache::finishCompile(const QSSGShaderCacheKey &key,
+                                                              const QByteArray &vertexCode,
+                                                              const QByteArray &fragmentCode,
+                                                              QSSGRhiShaderPipeline::StageFlags stageFlags,
+                                                              const BakeResult &bakeResult)
+{
+    const QByteArray &inKey = key.m_key;
     QSSGRef<QSSGRhiShaderPipeline> shaders;
-    QString vertErr, fragErr;
-
-    QShaderBaker baker;
-    m_initBaker(&baker, m_rhiContext->rhi());
 
     const bool editorMode = QSSGRhiContext::editorMode();
     // Shader debug is disabled in editor mode
@@ -404,15 +429,12 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGShaderCache::compileForRhi(const QByteArray &
        f.close();
    };
 
-    baker.setSourceString(vertexCode, QShader::VertexStage);
-    QShader vertexShader = baker.bake();
-    const auto vertShaderValid = vertexShader.isValid();
+    const auto vertShaderValid = bakeResult.vertexShader.isValid();
     if (!vertShaderValid) {
-        vertErr = baker.errorMessage();
         if (!editorMode) {
             qWarning("Failed to compile vertex shader:\n");
             if (!shaderDebug)
-                qWarning() << inKey << '\n' << vertErr;
+                qWarning() << inKey << '\n' << bakeResult.vertErr;
         }
     }
 
@@ -422,15 +444,12 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGShaderCache::compileForRhi(const QByteArray &
             dumpShaderToFile(QShader::Stage::VertexStage, vertexCode);
     }
 
-    baker.setSourceString(fragmentCode, QShader::FragmentStage);
-    QShader fragmentShader = baker.bake();
-    const bool fragShaderValid = fragmentShader.isValid();
+    const bool fragShaderValid = bakeResult.fragmentShader.isValid();
     if (!fragShaderValid) {
-        fragErr = baker.errorMessage();
         if (!editorMode) {
             qWarning("Failed to compile fragment shader \n");
             if (!shaderDebug)
-                qWarning() << inKey << '\n' << fragErr;
+                qWarning() << inKey << '\n' << bakeResult.fragErr;
         }
     }
 
@@ -442,8 +461,8 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGShaderCache::compileForRhi(const QByteArray &
 
     if (vertShaderValid && fragShaderValid) {
         shaders = new QSSGRhiShaderPipeline(*m_rhiContext.data());
-        shaders->addStage(QRhiShaderStage(QRhiShaderStage::Vertex, vertexShader), stageFlags);
-        shaders->addStage(QRhiShaderStage(QRhiShaderStage::Fragment, fragmentShader), stageFlags);
+        shaders->addStage(QRhiShaderStage(QRhiShaderStage::Vertex, bakeResult.vertexShader), stageFlags);
+        shaders->addStage(QRhiShaderStage(QRhiShaderStage::Fragment, bakeResult.fragmentShader), stageFlags);
         if (shaderDebug)
             qDebug("Compilation for vertex and fragment stages succeeded");
     }
@@ -453,21 +472,75 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGShaderCache::compileForRhi(const QByteArray &
         const auto vertStatus = vertShaderValid ? Status::Success : Status::Error;
         const auto fragStatus = fragShaderValid ? Status::Success : Status::Error;
         QMutexLocker locker(&*s_statusMutex);
-        s_statusCallback(inKey, vertStatus, vertErr, QShader::VertexStage);
-        s_statusCallback(inKey, fragStatus, fragErr, QShader::FragmentStage);
+        s_statusCallback(inKey, vertStatus, bakeResult.vertErr, QShader::VertexStage);
+        s_statusCallback(inKey, fragStatus, bakeResult.fragErr, QShader::FragmentStage);
     }
 
-    QSSGRef<QSSGRhiShaderPipeline> result = m_rhiShaders.insert(tempKey, shaders).value();
+    QSSGRef<QSSGRhiShaderPipeline> result = m_rhiShaders.insert(key, shaders).value();
     if (result && result->vertexStage() && result->fragmentStage()) {
         QQsbCollection::EntryDesc entryDesc = {
             inKey,
-            QQsbCollection::toFeatureSet(inFeatures),
+            QQsbCollection::toFeatureSet(key.m_features),
             result->vertexStage()->shader(),
             result->fragmentStage()->shader()
         };
-        m_persistentShaderBakingCache.addEntry(entryDesc.generateSha(), entryDesc);
+        m_persistentShaderBakingCache->addEntry(entryDesc.generateSha(), entryDesc);
     }
     return result;
+}
+#endif // QT_QUICK3D_HAS_RUNTIME_SHADERS
+
+QSSGRef<QSSGRhiShaderPipeline> QSSGShaderCache::compileForRhi(const QByteArray &inKey, const QByteArray &inVert, const QByteArray &inFrag,
+                                                              const QSSGShaderFeatures &inFeatures, QSSGRhiShaderPipeline::StageFlags stageFlags,
+                                                              CompileMode mode)
+{
+#ifdef QT_QUICK3D_HAS_RUNTIME_SHADERS
+    const QSSGRef<QSSGRhiShaderPipeline> &rhiShaders = tryGetRhiShaderPipeline(inKey, inFeatures);
+    if (rhiShaders)
+        return rhiShaders;
+
+    QSSGShaderCacheKey tempKey(inKey);
+    tempKey.m_features = inFeatures;
+    tempKey.updateHashCode();
+
+    if (m_pendingShaders.contains(tempKey))
+        return {};
+
+    if (!m_shaderManifestFileName.isEmpty())
+        recordShaderManifestEntry({ inKey, inFeatures, inVert, inFrag });
+
+    QByteArray vertexCode = inVert;
+    QByteArray fragmentCode = inFrag;
+
+    if (!vertexCode.isEmpty())
+        addShaderPreprocessor(vertexCode, inKey, ShaderType::Vertex, inFeatures);
+
+    if (!fragmentCode.isEmpty())
+        addShaderPreprocessor(fragmentCode, inKey, ShaderType::Fragment, inFeatures);
+
+    // lo and behold the final shader strings are ready
+
+#ifdef QT_QUICK3D_HAS_CONCURRENT
+    if (mode == CompileMode::Asynchronous) {
+        // The baker is initialized here, as that may depend on the current (OpenGL) context
+        QShaderBaker *baker = new QShaderBaker;
+        m_initBaker(baker, m_rhiContext->rhi());
+        auto future = QtConcurrent::run(&m_compilePool, [baker, vertexCode, fragmentCode]() {
+            const BakeResult result = bakeShaders(baker, vertexCode, fragmentCode);
+            delete baker;
+            return result;
+        });
+        m_pendingShaders.insert(tempKey, { vertexCode, fragmentCode, stageFlags, future });
+        return {};
+    }
+#else
+    // Without Qt Concurrent asynchronous requests are compiled right away
+    Q_UNUSED(mode);
+#endif
+
+    QShaderBaker baker;
+    m_initBaker(&baker, m_rhiContext->rhi());
+    return finishCompile(tempKey, vertexCode, fragmentCode, stageFlags, bakeShaders(&baker, vertexCode, fragmentCode));
 
 #else
     Q_UNUSED(inKey);
@@ -475,12 +548,92 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGShaderCache::compileForRhi(const QByteArray &
     Q_UNUSED(inFrag);
     Q_UNUSED(inFeatures);
     Q_UNUSED(stageFlags);
+    Q_UNUSED(mode);
     qWarning("Cannot compile and condition shaders at runtime because this build of Qt Quick 3D is not linking to Qt Shader Tools. "
              "Only pre-processed materials are supported.");
     return {};
 #endif
 }
 
+void QSSGShaderCache::recordShaderManifestEntry(const ShaderManifestEntry &entry)
+{
+    // Several windows, each with their own shader cache, may record to the same file
+    QMutexLocker locker(&*s_shaderManifestMutex);
+
+    QFile f(m_shaderManifestFileName);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning("Failed to open shader manifest %s", qPrintable(m_shaderManifestFileName));
+        return;
+    }
+
+    QDataStream ds(&f);
+    ds.setVersion(QDataStream::Qt_6_0);
+    if (f.size() == 0)
+        ds << ShaderManifestMagic << ShaderManifestQtVersion;
+    ds << entry.key << entry.features.flags << entry.vertexSource << entry.fragmentSource;
+}
+
+bool QSSGShaderCache::readShaderManifest(const QString &fileName, QVector<ShaderManifestEntry> &entries)
+{
+    QFile f(fileName);
+    if (!f.open(QIODevice::ReadOnly)) {
+        qWarning("Failed to open shader manifest %s", qPrintable(fileName));
+        return false;
+    }
+
+    QDataStream ds(&f);
+    ds.setVersion(QDataStream::Qt_6_0);
+    quint64 magic = 0;
+    quint32 qtVersion = 0;
+    ds >> magic >> qtVersion;
+    if (magic != ShaderManifestMagic) {
+        qWarning("%s is not a shader manifest", qPrintable(fileName));
+        return false;
+    }
+    if (qtVersion != ShaderManifestQtVersion) {
+        qWarning("Shader manifest %s was recorded with a different Qt version", qPrintable(fileName));
+        return false;
+    }
+
+    while (!ds.atEnd()) {
+        ShaderManifestEntry entry;
+        ds >> entry.key >> entry.features.flags >> entry.vertexSource >> entry.fragmentSource;
+        if (ds.status() != QDataStream::Ok)
+            break; // The recording application did not finish writing the last entry
+        entries.append(entry);
+    }
+
+    return true;
+}
+
+void QSSGShaderCache::collectFinishedCompilations()
+{
+#ifdef QT_QUICK3D_HAS_RUNTIME_SHADERS
+    m_collectedCompilations = false;
+    for (auto it = m_pendingShaders.begin(); it != m_pendingShaders.end(); ) {
+        if (it->future.isFinished()) {
+            const QSSGShaderCacheKey key = it.key();
+            const PendingCompilation pending = it.value();
+            it = m_pendingShaders.erase(it);
+            finishCompile(key, pending.vertexCode, pending.fragmentCode, pending.stageFlags, pending.future.result());
+            m_collectedCompilations = true;
+        } else {
+            ++it;
+        }
+    }
+#endif
+}
+
+bool QSSGShaderCache::isCompilationPending(const QByteArray &inKey, const QSSGShaderFeatures &inFeatures) const
+{
+    if (m_pendingShaders.isEmpty())
+        return false;
+    QSSGShaderCacheKey cacheKey(inKey);
+    cacheKey.m_features = inFeatures;
+    cacheKey.updateHashCode();
+    return m_pendingShaders.contains(cacheKey);
+}
+
 QSSGRef<QSSGRhiShaderPipeline> QSSGShaderCache::newPipelineFromPregenerated(const QByteArray &inKey,
                                                                             const QSSGShaderFeatures &inFeatures,
                                                                             QQsbCollection::Entry entry,
@@ -546,7 +699,7 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGShaderCache::tryNewPipelineFromPersistentCach
 
     // Here we are allowed to return null to indicate that there is no such
     // entry in this particular cache.
-    if (!m_persistentShaderBakingCache.extractEntry(QQsbCollection::Entry(qsbcKey), entryDesc))
+    if (!m_persistentShaderBakingCache->extractEntry(QQsbCollection::Entry(qsbcKey), entryDesc))
         return {};
 
     if (entryDesc.vertShader.isValid() && entryDesc.fragShader.isValid()) {
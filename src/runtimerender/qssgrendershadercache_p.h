@@ -26,6 +26,8 @@
 #include <QtCore/qcryptographichash.h>
 #include <QtCore/QSharedPointer>
 #include <QtCore/QVector>
+#include <QtCore/qfuture.h>
+#include <QtCore/qthreadpool.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -165,18 +167,68 @@ public:
         Fragment = 1
     };
 
+    enum class CompileMode : quint8
+    {
+        Synchronous,
+        // compileForRhi() returns null and bakes the shaders on a worker thread. The
+        // pipeline is then returned by tryGetRhiShaderPipeline() once baking finished.
+        Asynchronous
+    };
+
+    // Inputs of a pipeline compiled by compileForRhi(). When the
+    // QT_QUICK3D_RECORD_SHADER_MANIFEST environment variable is set to a file
+    // name, one is appended to that file for each compiled pipeline. The file
+    // can then be passed to shadergen to bake the same pipelines offline.
+    struct ShaderManifestEntry
+    {
+        QByteArray key;
+        QSSGShaderFeatures features;
+        QByteArray vertexSource;
+        QByteArray fragmentSource;
+    };
+
     QAtomicInt ref;
 
     using InitBakerFunc = void (*)(QShaderBaker *baker, QRhi *rhi);
 private:
+    struct BakeResult
+    {
+        QShader vertexShader;
+        QShader fragmentShader;
+        QString vertErr;
+        QString fragErr;
+    };
+
+    struct PendingCompilation
+    {
+        QByteArray vertexCode;
+        QByteArray fragmentCode;
+        QSSGRhiShaderPipeline::StageFlags stageFlags;
+        QFuture<BakeResult> future;
+    };
+
     typedef QHash<QSSGShaderCacheKey, QSSGRef<QSSGRhiShaderPipeline>> TRhiShaderMap;
     QSSGRef<QSSGRhiContext> m_rhiContext;
     TRhiShaderMap m_rhiShaders;
     QByteArray m_insertStr; // member to potentially reuse the allocation after clear
     InitBakerFunc m_initBaker;
-    QQsbInMemoryCollection m_persistentShaderBakingCache;
+    // QQsbPersistentCollection when there is a cache file, QQsbInMemoryCollection otherwise
+    QQsbCollection *m_persistentShaderBakingCache = nullptr;
     QString m_persistentShaderStorageFileName;
     bool m_autoDiskCacheEnabled;
+    QHash<QSSGShaderCacheKey, PendingCompilation> m_pendingShaders;
+    bool m_collectedCompilations = false;
+    QThreadPool m_compilePool;
+    QString m_shaderManifestFileName;
+
+    void recordShaderManifestEntry(const ShaderManifestEntry &entry);
+
+    static BakeResult bakeShaders(QShaderBaker *baker, const QByteArray &vertexCode, const QByteArray &fragmentCode);
+    QSSGRef<QSSGRhiShaderPipeline> finishCompile(const QSSGShaderCacheKey &key,
+                                                 const QByteArray &vertexCode,
+                                                 const QByteArray &fragmentCode,
+                                                 QSSGRhiShaderPipeline::StageFlags stageFlags,
+                                                 const BakeResult &result);
 
     void addShaderPreprocessor(QByteArray &str,
                                const QByteArray &inKey,
@@ -208,12 +260,23 @@ public:
                                                const QByteArray &inVert,
                                                const QByteArray &inFrag,
                                                const QSSGShaderFeatures &inFeatures,
-                                               QSSGRhiShaderPipeline::StageFlags stageFlags);
+                                               QSSGRhiShaderPipeline::StageFlags stageFlags,
+                                               CompileMode mode = CompileMode::Synchronous);
+
+    bool isCompilationPending(const QByteArray &inKey, const QSSGShaderFeatures &inFeatures) const;
+    // Also true right after collectFinishedCompilations() added pipelines to the cache, as
+    // those are only used by the next frame.
+    bool hasPendingCompilations() const { return !m_pendingShaders.isEmpty() || m_collectedCompilations; }
+    // Adds the results of the finished background compilations to the cache, also the ones
+    // nothing asks for anymore. Called at the end of each frame.
+    void collectFinishedCompilations();
 
     QSSGRef<QSSGRhiShaderPipeline> loadBuiltinForRhi(const QByteArray &inKey);
 
     static QByteArray resourceFolder();
     static QByteArray shaderCollectionFile();
+
+    static bool readShaderManifest(const QString &fileName, QVector<ShaderManifestEntry> &entries);
 };
 
 namespace QtQuick3DEditorHelpers {
@@ -430,7 +430,8 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGProgramGenerator::compileGeneratedRhiShader(c
                                                                                const QSSGShaderFeatures &inFeatureSet,
                                                                                const QSSGRef<QSSGShaderLibraryManager> &shaderLibraryManager,
                                                                                const QSSGRef<QSSGShaderCache> &theCache,
-                                                                               QSSGRhiShaderPipeline::StageFlags stageFlags)
+                                                                               QSSGRhiShaderPipeline::StageFlags stageFlags,
+                                                                               QSSGShaderCache::CompileMode compileMode)
 {
     // No stages enabled
     if (((quint32)m_enabledStages) == 0) {
@@ -472,7 +473,8 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGProgramGenerator::compileGeneratedRhiShader(c
                                    m_vs.m_finalBuilder,
                                    m_fs.m_finalBuilder,
                                    inFeatureSet,
-                                   stageFlags);
+                                   stageFlags,
+                                   compileMode);
 }
 
 QSSGVertexShaderGenerator::QSSGVertexShaderGenerator()
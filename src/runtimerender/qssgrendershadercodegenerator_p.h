@@ -166,7 +166,8 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGProgramGenerator
                                                              const QSSGShaderFeatures &inFeatureSet,
                                                              const QSSGRef<QSSGShaderLibraryManager> &shaderLibraryManager,
                                                              const QSSGRef<QSSGShaderCache> &theCache,
-                                                             QSSGRhiShaderPipeline::StageFlags stageFlags);
+                                                             QSSGRhiShaderPipeline::StageFlags stageFlags,
+                                                             QSSGShaderCache::CompileMode compileMode = QSSGShaderCache::CompileMode::Synchronous);
 };
 
 QT_END_NAMESPACE
@@ -320,6 +320,8 @@ void QSSGShadowMapEntry::destroyRhiResources()
     m_rhiBlurRenderTarget1 = nullptr;
     delete m_rhiBlurRenderPassDesc;
     m_rhiBlurRenderPassDesc = nullptr;
+
+    m_contentCached = false;
 }
 
 QT_END_NAMESPACE
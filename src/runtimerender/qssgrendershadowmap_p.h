@@ -37,7 +37,7 @@ enum class ShadowMapModes
     CUBE, ///< cubemap omnidirectional shadows
 };
 
-struct QSSGShadowMapEntry
+struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGShadowMapEntry
 {
     QSSGShadowMapEntry();
 
@@ -73,6 +73,11 @@ struct QSSGShadowMapEntry
     QMatrix4x4 m_lightVP; ///< light view projection matrix
     QMatrix4x4 m_lightCubeView[6]; ///< light cubemap view matrices
     QMatrix4x4 m_lightView; ///< light view transform
+
+    // Identifies the light cameras and casters last rendered into the map, which
+    // is kept as-is while these don't change (QT_QUICK3D_SHADOW_MAP_CACHING=1).
+    size_t m_contentHash = 0;
+    bool m_contentCached = false;
 };
 
 class Q_QUICK3DRUNTIMERENDER_EXPORT QSSGRenderShadowMap
@@ -32,6 +32,14 @@ QSSGRhiBuffer::~QSSGRhiBuffer()
     delete m_buffer;
 }
 
+void QSSGRhiBuffer::releaseBufferLater()
+{
+    if (m_buffer) {
+        m_buffer->deleteLater();
+        m_buffer = nullptr;
+    }
+}
+
 QRhiVertexInputAttribute::Format QSSGRhiInputAssemblerState::toVertexInputFormat(QSSGRenderComponentType compType, quint32 numComps)
 {
     if (compType == QSSGRenderComponentType::Float32) {
@@ -47,6 +55,19 @@ QRhiVertexInputAttribute::Format QSSGRhiInputAssemblerState::toVertexInputFormat
         default:
             break;
         }
+    } else if (compType == QSSGRenderComponentType::Float16) {
+        switch (numComps) {
+        case 1:
+            return QRhiVertexInputAttribute::Half;
+        case 2:
+            return QRhiVertexInputAttribute::Half2;
+        case 3:
+            return QRhiVertexInputAttribute::Half3;
+        case 4:
+            return QRhiVertexInputAttribute::Half4;
+        default:
+            break;
+        }
     } else if (compType == QSSGRenderComponentType::UnsignedInt32) {
         switch (numComps) {
         case 1:
@@ -807,7 +828,7 @@ void QSSGRhiShaderPipeline::setUniformArray(char *ubufData, const char *name, co
 
 void QSSGRhiShaderPipeline::ensureCombinedMainLightsUniformBuffer(QRhiBuffer **ubuf)
 {
-    const quint32 totalBufferSize = m_ub0NextUBufOffset + sizeof(QSSGShaderLightsUniformData);
+    const quint32 totalBufferSize = combinedMainLightsUniformDataSize();
     if (!*ubuf) {
         *ubuf = m_context.rhi()->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, totalBufferSize);
         (*ubuf)->create();
@@ -826,6 +847,83 @@ void QSSGRhiShaderPipeline::ensureUniformBuffer(QRhiBuffer **ubuf)
     }
 }
 
+QSSGRhiUniformBufferRing::QSSGRhiUniformBufferRing(QSSGRhiContext &context)
+    : m_context(context)
+{
+}
+
+QSSGRhiUniformBufferRing::~QSSGRhiUniformBufferRing()
+{
+    endFrame();
+    // The srbs binding these buffers are shared between draw calls and stay
+    // cached in the context, they must not outlive the buffers.
+    QVector<QRhiBuffer *> buffers;
+    buffers.reserve(m_buffers.size());
+    for (const Buffer &buffer : std::as_const(m_buffers))
+        buffers.append(buffer.buffer);
+    m_context.releaseSrbsUsingBuffers(buffers);
+    qDeleteAll(buffers);
+}
+
+void QSSGRhiUniformBufferRing::beginFrame()
+{
+    endFrame();
+}
+
+QSSGRhiUniformBufferRing::Allocation QSSGRhiUniformBufferRing::allocate(quint32 size)
+{
+    QRhi *rhi = m_context.rhi();
+    if (m_bufferSize == 0) {
+        // Room for a good number of draw calls, while not going above what D3D11 allows
+        // for a constant buffer, as that is what MaxUniformBufferRange reports there.
+        m_bufferSize = quint32(qBound(64 * 1024, m_context.maxUniformBufferRange(), 1024 * 1024));
+    }
+    if (size == 0 || size > m_bufferSize)
+        return {};
+
+    quint32 offset = quint32(rhi->ubufAligned(int(m_used)));
+    if (m_current < 0 || offset + size > m_bufferSize) {
+        if (m_current + 1 == m_buffers.size()) {
+            QRhiBuffer *buffer = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, m_bufferSize);
+            if (!buffer->create()) {
+                qWarning("Failed to build uniform buffer with size %u", m_bufferSize);
+                delete buffer;
+                return {};
+            }
+            m_buffers.append({ buffer, nullptr });
+        }
+        ++m_current;
+        offset = 0;
+    }
+
+    Buffer &buffer = m_buffers[m_current];
+    if (!buffer.data)
+        buffer.data = buffer.buffer->beginFullDynamicBufferUpdateForCurrentFrame();
+    m_used = offset + size;
+    return { buffer.buffer, offset, buffer.data + offset };
+}
+
+void QSSGRhiUniformBufferRing::flush()
+{
+    if (m_current < 0 || !m_buffers.at(m_current).data)
+        return;
+    for (Buffer &buffer : m_buffers) {
+        if (buffer.data) {
+            buffer.buffer->endFullDynamicBufferUpdateForCurrentFrame();
+            buffer.data = nullptr;
+        }
+    }
+    // Can't map the current buffer again in this frame without losing what's in it
+    m_used = m_bufferSize;
+}
+
+void QSSGRhiUniformBufferRing::endFrame()
+{
+    flush();
+    m_current = -1;
+    m_used = 0;
+}
+
 int QSSGRhiShaderPipeline::bindingForTexture(const char *name, int hint)
 {
     if (hint >= 0) {
@@ -871,6 +969,7 @@ void QSSGRhiContext::releaseCachedResources()
     m_pipelines.clear();
     m_computePipelines.clear();
     m_srbCache.clear();
+    m_sharedSrbRefCounts.clear();
     m_dummyTextures.clear();
 
     for (const auto &samplerInfo : std::as_const(m_samplers))
@@ -922,17 +1021,87 @@ QRhiShaderResourceBindings *QSSGRhiContext::srb(const QSSGRhiShaderResourceBindi
     return srb;
 }
 
+void QSSGRhiContext::updateDrawCallSrb(QSSGRhiDrawCallData &dcd, const QSSGRhiShaderResourceBindingList &bindings)
+{
+    QRhiShaderResourceBindings *newSrb = srb(bindings);
+    if (newSrb && bindings.hasDynamicOffsets)
+        ++m_sharedSrbRefCounts[newSrb];
+    // Released after taking the reference on the new one, in case they are the same
+    if (dcd.srb && dcd.bindings.hasDynamicOffsets)
+        releaseSharedSrb(dcd.bindings, dcd.srb);
+    dcd.srb = newSrb;
+    dcd.bindings = bindings;
+}
+
+void QSSGRhiContext::releaseSharedSrb(const QSSGRhiShaderResourceBindingList &bindings, QRhiShaderResourceBindings *srb)
+{
+    auto it = m_sharedSrbRefCounts.find(srb);
+    if (it == m_sharedSrbRefCounts.end() || --it.value() > 0)
+        return;
+    m_sharedSrbRefCounts.erase(it);
+    const auto cached = m_srbCache.constFind(bindings);
+    if (cached != m_srbCache.cend() && cached.value() == srb)
+        m_srbCache.erase(cached);
+    // Commands recorded earlier in the frame may still use it
+    srb->deleteLater();
+}
+
 void QSSGRhiContext::releaseDrawCallData(QSSGRhiDrawCallData &dcd)
 {
     delete dcd.ubuf;
     dcd.ubuf = nullptr;
-    auto srb = m_srbCache.take(dcd.bindings);
-    QSSG_CHECK(srb == dcd.srb);
-    delete srb;
+    if (dcd.bindings.hasDynamicOffsets) {
+        // Shared with the other draw calls using the same QSSGRhiUniformBufferRing
+        // buffer and textures, released once none of them uses it anymore
+        if (dcd.srb)
+            releaseSharedSrb(dcd.bindings, dcd.srb);
+    } else {
+        auto srb = m_srbCache.take(dcd.bindings);
+        QSSG_CHECK(srb == dcd.srb);
+        delete srb;
+    }
     dcd.srb = nullptr;
+    dcd.bindings.clear();
     dcd.pipeline = nullptr;
 }
 
+void QSSGRhiContext::releaseSrbsUsingBuffers(const QVector<QRhiBuffer *> &buffers)
+{
+    if (buffers.isEmpty())
+        return;
+
+    const auto usesBuffers = [&buffers](const QSSGRhiShaderResourceBindingList &bindings) {
+        for (int i = 0; i < bindings.p; ++i) {
+            const QRhiShaderResourceBinding::Data *d = bindings.v[i].data();
+            if (d->type == QRhiShaderResourceBinding::UniformBuffer && buffers.contains(d->u.ubuf.buf))
+                return true;
+        }
+        return false;
+    };
+
+    QSet<QRhiShaderResourceBindings *> released;
+    for (auto it = m_srbCache.begin(); it != m_srbCache.end(); ) {
+        if (usesBuffers(it.key())) {
+            released.insert(it.value());
+            m_sharedSrbRefCounts.remove(it.value());
+            delete it.value();
+            it = m_srbCache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (released.isEmpty())
+        return;
+
+    for (QSSGRhiDrawCallData &dcd : m_drawCallData) {
+        if (released.contains(dcd.srb)) {
+            dcd.srb = nullptr;
+            dcd.bindings.clear();
+        }
+    }
+}
+
 QRhiGraphicsPipeline *QSSGRhiContext::pipeline(const QSSGGraphicsPipelineStateKey &key,
                                                QRhiRenderPassDescriptor *rpDesc,
                                                QRhiShaderResourceBindings *srb)
@@ -1074,6 +1243,12 @@ void QSSGRhiContext::releaseTexture(QRhiTexture *texture)
     delete texture;
 }
 
+void QSSGRhiContext::releaseTextureLater(QRhiTexture *texture)
+{
+    m_textures.remove(texture);
+    texture->deleteLater();
+}
+
 void QSSGRhiContext::registerMesh(QSSGRenderMesh *mesh)
 {
     m_meshes.insert(mesh);
@@ -1085,6 +1260,18 @@ void QSSGRhiContext::releaseMesh(QSSGRenderMesh *mesh)
     delete mesh;
 }
 
+void QSSGRhiContext::releaseMeshLater(QSSGRenderMesh *mesh)
+{
+    // The subsets may share their buffers, releaseBufferLater() only acts once
+    for (QSSGRenderSubset &subset : mesh->subsets) {
+        if (subset.rhi.vertexBuffer)
+            subset.rhi.vertexBuffer->releaseBufferLater();
+        if (subset.rhi.indexBuffer)
+            subset.rhi.indexBuffer->releaseBufferLater();
+    }
+    releaseMesh(mesh);
+}
+
 void QSSGRhiContext::cleanupDrawCallData(const QSSGRenderModel *model)
 {
     // Find all QSSGRhiUniformBufferSet that reference model
@@ -1139,6 +1326,8 @@ void QSSGRhiContextStats::start(QSSGRenderLayer *layer)
     PerLayerInfo &info(perLayerInfo[layerKey]);
     info.renderPasses.clear();
     info.externalRenderPass = {};
+    info.opaquePipelineSwitches = 0;
+    info.opaquePipelineSwitchesSaved = 0;
     info.currentRenderPassIndex = -1;
 }
 
@@ -1160,6 +1349,10 @@ void QSSGRhiContextStats::stop(QSSGRenderLayer *layer)
             qDebug("Within external render passes:");
             printRenderPass(info.externalRenderPass);
         }
+        if (info.opaquePipelineSwitches || info.opaquePipelineSwitchesSaved) {
+            qDebug("%llu pipeline switches for opaque objects, %lld less than in front to back order",
+                   info.opaquePipelineSwitches, info.opaquePipelineSwitchesSaved);
+        }
     }
 
     // a new start() may preceed stop() for the previous View3D, must handle this gracefully
@@ -20,6 +20,7 @@
 #include <QtQuick3DUtils/private/qssgrenderbasetypes_p.h>
 #include <QtGui/private/qrhi_p_p.h>
 #include "private/qquick3dprofiler_p.h"
+#include "qssgrenderclippingfrustum_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -88,6 +89,9 @@ public:
     }
     QRhiCommandBuffer::IndexFormat indexFormat() const { return m_indexFormat; }
 
+    // For buffers the frame being recorded may still use
+    void releaseBufferLater();
+
 private:
     QSSGRhiContext &m_context;
     QRhiBuffer *m_buffer = nullptr;
@@ -242,6 +246,11 @@ public:
     {
         return int(4 * sizeof(qint32) + m_lightsUniformData.count * sizeof(QSSGShaderLightData));
     }
+    // Size of the uniform data for ensureCombinedMainLightsUniformBuffer(), with room for all lights
+    quint32 combinedMainLightsUniformDataSize() const
+    {
+        return quint32(m_ub0NextUBufOffset + sizeof(QSSGShaderLightsUniformData));
+    }
 
     const QHash<QSSGRhiInputAssemblerState::InputSemantic, QShaderDescription::InOutVariable> &vertexInputs() const { return m_vertexInputs; }
 
@@ -547,14 +556,16 @@ struct QSSGRhiShaderResourceBindingList
     int p = 0;
     size_t h = 0;
     QRhiShaderResourceBinding v[MAX_SIZE];
+    bool hasDynamicOffsets = false;
 
-    void clear() { p = 0; h = 0; }
+    void clear() { p = 0; h = 0; hasDynamicOffsets = false; }
 
     QSSGRhiShaderResourceBindingList() { }
 
     QSSGRhiShaderResourceBindingList(const QSSGRhiShaderResourceBindingList &other)
         : p(other.p),
-          h(other.h)
+          h(other.h),
+          hasDynamicOffsets(other.hasDynamicOffsets)
     {
         for (int i = 0; i < p; ++i)
             v[i] = other.v[i];
@@ -565,6 +576,7 @@ struct QSSGRhiShaderResourceBindingList
         if (this != &other) {
             p = other.p;
             h = other.h;
+            hasDynamicOffsets = other.hasDynamicOffsets;
             for (int i = 0; i < p; ++i)
                 v[i] = other.v[i];
         }
@@ -572,6 +584,7 @@ struct QSSGRhiShaderResourceBindingList
     }
 
     void addUniformBuffer(int binding, QRhiShaderResourceBinding::StageFlags stage, QRhiBuffer *buf, int offset, int size);
+    void addUniformBufferWithDynamicOffset(int binding, QRhiShaderResourceBinding::StageFlags stage, QRhiBuffer *buf, int size);
     void addTexture(int binding, QRhiShaderResourceBinding::StageFlags stage, QRhiTexture *tex, QRhiSampler *sampler);
 };
 
@@ -618,6 +631,27 @@ inline void QSSGRhiShaderResourceBindingList::addUniformBuffer(int binding, QRhi
     d->u.ubuf.hasDynamicOffset = false;
 }
 
+inline void QSSGRhiShaderResourceBindingList::addUniformBufferWithDynamicOffset(int binding, QRhiShaderResourceBinding::StageFlags stage,
+                                                                                QRhiBuffer *buf, int size)
+{
+#ifdef QT_DEBUG
+    if (p == MAX_SIZE) {
+        qWarning("Out of shader resource bindings slots (max is %d)", MAX_SIZE);
+        return;
+    }
+#endif
+    QRhiShaderResourceBinding::Data *d = QRhiImplementation::shaderResourceBindingData(v[p++]);
+    h ^= qintptr(buf);
+    d->binding = binding;
+    d->stage = stage;
+    d->type = QRhiShaderResourceBinding::UniformBuffer;
+    d->u.ubuf.buf = buf;
+    d->u.ubuf.offset = 0;
+    d->u.ubuf.maybeSize = size;
+    d->u.ubuf.hasDynamicOffset = true;
+    hasDynamicOffsets = true;
+}
+
 inline void QSSGRhiShaderResourceBindingList::addTexture(int binding, QRhiShaderResourceBinding::StageFlags stage,
                                                          QRhiTexture *tex, QRhiSampler *sampler)
 {
@@ -699,6 +733,62 @@ struct QSSGRhiDrawCallData
     QSSGRhiGraphicsPipelineState ps;
 };
 
+// Linear per-frame allocator for the uniform data of draw calls, handing out
+// aligned ranges of a few large dynamic uniform buffers instead of having one
+// buffer per draw call. The ranges are bound with dynamic offsets, so draw
+// calls that only differ in their uniform data share the same srb. Each
+// buffer is mapped once per frame, from its first allocation until flush() or
+// endFrame(), as the whole contents of a dynamic buffer is replaced when
+// mapping it.
+class Q_QUICK3DRUNTIMERENDER_EXPORT QSSGRhiUniformBufferRing
+{
+    Q_DISABLE_COPY(QSSGRhiUniformBufferRing)
+public:
+    struct Allocation
+    {
+        QRhiBuffer *buffer = nullptr;
+        quint32 offset = 0;
+        char *data = nullptr; // mapped memory at offset
+
+        bool isValid() const { return buffer != nullptr; }
+    };
+
+    explicit QSSGRhiUniformBufferRing(QSSGRhiContext &context);
+    ~QSSGRhiUniformBufferRing();
+
+    void beginFrame();
+    // Returns an invalid allocation when size doesn't fit in one buffer
+    Allocation allocate(quint32 size);
+    // Unmaps the buffers, needed before recording draw calls that use the
+    // allocations made so far. Later allocations go to another buffer.
+    void flush();
+    void endFrame();
+
+    qsizetype bufferCount() const { return m_buffers.size(); }
+
+private:
+    struct Buffer
+    {
+        QRhiBuffer *buffer = nullptr;
+        char *data = nullptr; // while mapped for the current frame
+    };
+
+    QSSGRhiContext &m_context;
+    QVector<Buffer> m_buffers;
+    quint32 m_bufferSize = 0;
+    qsizetype m_current = -1;
+    quint32 m_used = 0;
+};
+
+// The dynamic offsets to pass with an srb that has uniform buffers from a QSSGRhiUniformBufferRing
+struct QSSGRhiUniformBufferOffsets
+{
+    QRhiCommandBuffer::DynamicOffset offsets[2];
+    int count = 0;
+
+    void append(int binding, quint32 offset) { offsets[count++] = { binding, offset }; }
+};
+
 struct QSSGRhiRenderableTexture
 {
     QRhiTexture *texture = nullptr;
@@ -729,14 +819,22 @@ struct QSSGRhiSortData
 struct QSSGRhiInstanceBufferData
 {
     QRhiBuffer *buffer = nullptr;
-    QByteArray sortedData;
-    QList<QSSGRhiSortData> sortData;
+    QVector<quint32> sortOrder;
     QVector3D sortedCameraDirection;
     QVector3D cameraPosition;
     QByteArray lodData;
+    QSSGBoundsSoA cullingBounds;
+    QVector<quint32> cullingMask;
+    QVector4D cullingPlanes[6];
+    QSSGBounds3 cullingLocalBounds;
+    quint32 instanceCount = 0;
+    quint32 visibleInstanceCount = 0;
+    int tableCount = -1;
     int serial = -1;
+    int updateSerial = -1;
     bool owned = true;
     bool sorting = false;
+    bool culling = false;
 };
 
 struct QSSGRhiParticleData
@@ -811,6 +909,11 @@ public:
         // control of Qt Quick 3D)
         RenderPassInfo externalRenderPass;
 
+        // Pipeline switches between the opaque draw calls of the main pass, and how many fewer
+        // these are than with a plain front to back order (see QT_QUICK3D_OPAQUE_SORT_MODE).
+        quint64 opaquePipelineSwitches = 0;
+        qint64 opaquePipelineSwitchesSaved = 0;
+
         int currentRenderPassIndex = -1;
     };
     struct GlobalInfo { // global as in per QSSGRhiContext which is per-QQuickWindow
@@ -818,6 +921,9 @@ public:
         quint64 imageDataSize = 0;
         qint64 materialGenerationTime = 0;
         qint64 effectGenerationTime = 0;
+        quint64 residencyHitCount = 0;
+        quint64 residencyMissCount = 0;
+        quint64 residencyEvictionCount = 0;
     };
 
     QHash<QSSGRenderLayer *, PerLayerInfo> perLayerInfo;
@@ -895,6 +1001,20 @@ public:
         globalInfo.imageDataSize = newSize;
     }
 
+    void bufferResidencyChanges(quint64 hits, quint64 misses, quint64 evictions) // can be called outside start-stop
+    {
+        globalInfo.residencyHitCount = hits;
+        globalInfo.residencyMissCount = misses;
+        globalInfo.residencyEvictionCount = evictions;
+    }
+
+    void registerOpaquePipelineSwitches(quint64 switches, quint64 switchesInDistanceOrder)
+    {
+        PerLayerInfo &info(perLayerInfo[layerKey]);
+        info.opaquePipelineSwitches = switches;
+        info.opaquePipelineSwitchesSaved = qint64(switchesInDistanceOrder) - qint64(switches);
+    }
+
     void registerMaterialShaderGenerationTime(qint64 ms)
     {
         globalInfo.materialGenerationTime += ms;
@@ -960,6 +1080,9 @@ public:
     int mainPassSampleCount() const { return m_mainSamples; }
 
     QRhiShaderResourceBindings *srb(const QSSGRhiShaderResourceBindingList &bindings);
+    // Sets the srb and bindings of a draw call. The srbs of bindings with dynamic offsets
+    // are shared between draw calls, and released when the last one stops using them.
+    void updateDrawCallSrb(QSSGRhiDrawCallData &dcd, const QSSGRhiShaderResourceBindingList &bindings);
     void releaseDrawCallData(QSSGRhiDrawCallData &dcd);
     QRhiGraphicsPipeline *pipeline(const QSSGGraphicsPipelineStateKey &key,
                                    QRhiRenderPassDescriptor *rpDesc,
@@ -977,10 +1100,14 @@ public:
 
     void registerTexture(QRhiTexture *texture);
     void releaseTexture(QRhiTexture *texture);
+    // For textures the frame being recorded may still use
+    void releaseTextureLater(QRhiTexture *texture);
     QSet<QRhiTexture *> registeredTextures() const { return m_textures; }
 
     void registerMesh(QSSGRenderMesh *mesh);
     void releaseMesh(QSSGRenderMesh *mesh);
+    // For meshes the frame being recorded may still use
+    void releaseMeshLater(QSSGRenderMesh *mesh);
     QSet<QSSGRenderMesh *> registeredMeshes() const { return m_meshes; }
 
     QHash<QSSGGraphicsPipelineStateKey, QRhiGraphicsPipeline *> pipelines() const { return m_pipelines; }
@@ -1005,9 +1132,11 @@ public:
         return m_instanceBuffers[instanceTable];
     }
 
-    QSSGRhiInstanceBufferData &instanceBufferData(const QSSGRenderModel *model)
+    // Instances culled against a frustum also depend on the view, several layers can render
+    // the same model. The frustum is owned by the layer, so it identifies the view.
+    QSSGRhiInstanceBufferData &instanceBufferData(const QSSGRenderModel *model, const QSSGClippingFrustum *cullingFrustum = nullptr)
     {
-        return m_instanceBuffersLod[model];
+        return m_instanceBuffersLod[{ model, cullingFrustum }];
     }
 
     QSSGRhiParticleData &particleData(const QSSGRenderGraphObject *particlesOrModel)
@@ -1020,14 +1149,20 @@ public:
     int maxUniformBufferRange() const { return m_rhi->resourceLimit(QRhi::MaxUniformBufferRange); }
 
     void releaseCachedResources();
+    // Releases the cached srbs that have any of the buffers as a uniform buffer
+    void releaseSrbsUsingBuffers(const QVector<QRhiBuffer *> &buffers);
 
 private:
+    void releaseSharedSrb(const QSSGRhiShaderResourceBindingList &bindings, QRhiShaderResourceBindings *srb);
+
     QRhi *m_rhi = nullptr;
     QRhiRenderPassDescriptor *m_mainRpDesc = nullptr;
     QRhiCommandBuffer *m_cb = nullptr;
     QRhiRenderTarget *m_rt = nullptr;
     int m_mainSamples = 1;
     QHash<QSSGRhiShaderResourceBindingList, QRhiShaderResourceBindings *> m_srbCache;
+    // The number of draw calls using each srb with dynamic offsets
+    QHash<QRhiShaderResourceBindings *, int> m_sharedSrbRefCounts;
     QHash<QSSGGraphicsPipelineStateKey, QRhiGraphicsPipeline *> m_pipelines;
     QHash<QSSGComputePipelineStateKey, QRhiComputePipeline *> m_computePipelines;
     QHash<QSSGRhiDrawCallDataKey, QSSGRhiDrawCallData> m_drawCallData;
@@ -1036,7 +1171,7 @@ private:
     QSet<QSSGRenderMesh *> m_meshes;
     QHash<QSSGRhiDummyTextureKey, QRhiTexture *> m_dummyTextures;
     QHash<QSSGRenderInstanceTable *, QSSGRhiInstanceBufferData> m_instanceBuffers;
-    QHash<const QSSGRenderModel *, QSSGRhiInstanceBufferData> m_instanceBuffersLod;
+    QHash<std::pair<const QSSGRenderModel *, const QSSGClippingFrustum *>, QSSGRhiInstanceBufferData> m_instanceBuffersLod;
     QHash<const QSSGRenderGraphObject *, QSSGRhiParticleData> m_particleData;
     QSSGRhiContextStats m_stats;
 };
@@ -71,9 +71,19 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGCustomMaterialSystem::shadersForCustomMateria
         QSSGShaderDefaultMaterialKey matKey(renderable.shaderDescription);
         matKey.toString(shaderString, context->renderer()->defaultMaterialShaderKeyProperties());
 
-        // Try the persistent (disk-based) cache.
+        // Check if there's a pre-built (offline generated) shader available, such as the ones
+        // shadergen bakes from a recorded shader manifest.
         const QByteArray qsbcKey = QQsbCollection::EntryDesc::generateSha(shaderString, QQsbCollection::toFeatureSet(featureSet));
-        shaderPipeline = context->shaderCache()->tryNewPipelineFromPersistentCache(qsbcKey, material.m_shaderPathKey, featureSet);
+        const QQsbCollection::EntryMap &pregenEntries = context->shaderLibraryManager()->m_preGeneratedShaderEntries;
+        if (!pregenEntries.isEmpty()) {
+            const auto foundIt = pregenEntries.constFind(QQsbCollection::Entry(qsbcKey));
+            if (foundIt != pregenEntries.cend())
+                shaderPipeline = context->shaderCache()->newPipelineFromPregenerated(shaderString, featureSet, *foundIt, material);
+        }
+
+        // Try the persistent (disk-based) cache then.
+        if (!shaderPipeline)
+            shaderPipeline = context->shaderCache()->tryNewPipelineFromPersistentCache(qsbcKey, material.m_shaderPathKey, featureSet);
 
         if (!shaderPipeline) {
             // Have to generate the shaders and send it all through the shader conditioning pipeline.
@@ -606,7 +616,10 @@ void QSSGCustomMaterialSystem::rhiRenderRenderable(QSSGRhiContext *rhiCtx,
     vertexBuffers[0] = QRhiCommandBuffer::VertexInput(vertexBuffer, 0);
     quint32 instances = 1;
     if (renderable.modelContext.model.instancing()) {
-        instances = renderable.modelContext.model.instanceCount();
+        // Instances outside of the camera frustum are only drawn into reflection maps
+        instances = (cubeFace >= 0) ? renderable.instanceCount : renderable.visibleInstanceCount;
+        if (instances == 0)
+            return;
         vertexBuffers[1] = QRhiCommandBuffer::VertexInput(renderable.instanceBuffer, 0);
         vertexBufferCount = 2;
     }
@@ -38,7 +38,13 @@
 
 #include <QtCore/QCoreApplication>
 #include <QtCore/QBitArray>
+#ifdef QT_QUICK3D_HAS_CONCURRENT
+#include <QtConcurrent/qtconcurrentmap.h>
+#include <QtCore/QThreadPool>
+#endif
 #include <array>
+#include <limits>
+#include <numeric>
 
 #include "qssgrenderpass_p.h"
 
@@ -94,6 +100,51 @@ qsizetype QSSGLayerRenderData::frustumCullingInline(const QSSGClippingFrustum &c
     return back + 1;
 }
 
+qsizetype QSSGLayerRenderData::frustumCulling(const QSSGClippingFrustum &clipFrustum, const QVector<quint32> &visibilityMask, const QSSGRenderableObjectList &renderables, QSSGRenderableObjectList &visibleRenderables)
+{
+    QSSG_ASSERT(visibleRenderables.isEmpty(), visibleRenderables.clear());
+    visibleRenderables.reserve(renderables.size());
+    const qsizetype maskBits = visibilityMask.size() * 32;
+    for (const auto &handle : renderables) {
+        const qint32 idx = handle.boundsIndex;
+        const bool visible = (idx >= 0 && idx < maskBits) ? (visibilityMask.at(idx / 32) & (1u << (idx % 32))) != 0
+                                                          : clipFrustum.intersectsWith(handle.obj->globalBounds);
+        if (visible)
+            visibleRenderables.push_back(handle);
+    }
+
+    return visibleRenderables.size();
+}
+
+QSSGRenderableObjectHandle QSSGLayerRenderData::createRenderableHandle(QSSGRenderableObject *obj, float cameraDistanceSq)
+{
+    QSSGRenderableObjectHandle handle(obj, cameraDistanceSq);
+    handle.boundsIndex = qint32(renderableBounds.size());
+    renderableBounds.append(obj->globalBounds);
+    return handle;
+}
+
+qsizetype QSSGLayerRenderData::frustumCulling(const QSSGClippingFrustum &clipFrustum, const QVector<QSSGRenderSpatialIndex::Visibility> &modelVisibility, const QSSGRenderableObjectList &renderables, QSSGRenderableObjectList &visibleRenderables)
+{
+    QSSG_ASSERT(visibleRenderables.isEmpty(), visibleRenderables.clear());
+    visibleRenderables.reserve(renderables.size());
+    for (const auto &handle : renderables) {
+        const QSSGRenderableObject &obj = *handle.obj;
+        auto visibility = QSSGRenderSpatialIndex::Visibility::Intersecting;
+        if (obj.type == QSSGRenderableObject::Type::DefaultMaterialMeshSubset || obj.type == QSSGRenderableObject::Type::CustomMaterialMeshSubset) {
+            const qint32 leaf = static_cast<const QSSGSubsetRenderable &>(obj).modelContext.spatialIndexLeaf;
+            if (leaf >= 0 && leaf < modelVisibility.size())
+                visibility = modelVisibility.at(leaf);
+        }
+
+        if (visibility == QSSGRenderSpatialIndex::Visibility::Inside
+                || (visibility == QSSGRenderSpatialIndex::Visibility::Intersecting && clipFrustum.intersectsWith(obj.globalBounds)))
+            visibleRenderables.push_back(handle);
+    }
+
+    return visibleRenderables.size();
+}
+
 static void collectBoneTransforms(QSSGRenderNode *node, QSSGRenderModel *modelNode, const QVector<QMatrix4x4> &poses)
 {
     if (node->type == QSSGRenderGraphObject::Type::Joint) {
@@ -182,13 +233,14 @@ static bool maybeQueueNodeForRender(QSSGRenderNode &inNode,
                                     int &ioReflectionProbeCount,
                                     quint32 &ioDFSIndex)
 {
-    bool wasDirty = inNode.isDirty(QSSGRenderNode::DirtyFlag::GlobalValuesDirty) && inNode.calculateGlobalVariables();
+    const bool globalValuesDirty = inNode.isDirty(QSSGRenderNode::DirtyFlag::GlobalValuesDirty);
+    bool wasDirty = globalValuesDirty && inNode.calculateGlobalVariables();
     if (inNode.getGlobalState(QSSGRenderNode::GlobalState::Active)) {
         ++ioDFSIndex;
         inNode.dfsIndex = ioDFSIndex;
         if (QSSGRenderGraphObject::isRenderable(inNode.type)) {
             if (inNode.type == QSSGRenderNode::Type::Model)
-                collectNode(QSSGRenderableNodeEntry(inNode), outRenderableModels, ioRenderableModelsCount);
+                collectNode(QSSGRenderableNodeEntry(inNode, globalValuesDirty), outRenderableModels, ioRenderableModelsCount);
             else if (inNode.type == QSSGRenderNode::Type::Particles)
                 collectNode(QSSGRenderableNodeEntry(inNode), outRenderableParticles, ioRenderableParticlesCount);
             else if (inNode.type == QSSGRenderNode::Type::Item2D) // Pushing front to keep item order inside QML file
@@ -245,6 +297,237 @@ QSSGCameraData QSSGLayerRenderData::getCameraDirectionAndPosition()
     return QVector3D::dotProduct(difference, camera.direction) + obj.depthBiasSq;
 }
 
+QSSGLayerRenderData::OpaqueSortMode QSSGLayerRenderData::opaqueSortMode()
+{
+    static const int mode = qEnvironmentVariableIntValue("QT_QUICK3D_OPAQUE_SORT_MODE");
+    if (mode > int(OpaqueSortMode::Distance) && mode <= int(OpaqueSortMode::CoarseDistanceThenState))
+        return OpaqueSortMode(mode);
+    return OpaqueSortMode::Distance;
+}
+
+namespace {
+// LSD radix sort on Entry::key, one byte per pass, stable. Passes where all keys have the
+// same byte are skipped. Returns the sorted entries, which are either in entries or scratch.
+template<typename Entry>
+Entry *radixSortByKey(Entry *entries, Entry *scratch, qsizetype count)
+{
+    constexpr int keyBytes = int(sizeof(Entry::key));
+    quint32 histograms[keyBytes][256] = {};
+    for (qsizetype idx = 0; idx != count; ++idx) {
+        for (int byte = 0; byte < keyBytes; ++byte)
+            ++histograms[byte][(entries[idx].key >> (byte * 8)) & 0xff];
+    }
+
+    Entry *src = entries;
+    Entry *dst = scratch;
+    for (int byte = 0; byte < keyBytes; ++byte) {
+        quint32 *histogram = histograms[byte];
+        if (histogram[(src[0].key >> (byte * 8)) & 0xff] == quint32(count))
+            continue;
+        quint32 offset = 0;
+        for (int bucket = 0; bucket < 256; ++bucket) {
+            const quint32 bucketSize = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketSize;
+        }
+        for (qsizetype idx = 0; idx != count; ++idx)
+            dst[histogram[(src[idx].key >> (byte * 8)) & 0xff]++] = src[idx];
+        std::swap(src, dst);
+    }
+    return src;
+}
+
+#ifdef QT_QUICK3D_HAS_CONCURRENT
+struct RadixSortChunk
+{
+    qsizetype begin;
+    qsizetype end;
+    std::array<quint32, 256> histogram;
+};
+
+// Same as radixSortByKey(), with the histogram and the scatter of each pass split over
+// chunkCount chunks on the thread pool. The output offsets are handed out bucket by bucket,
+// chunk by chunk within a bucket, which keeps the sort stable.
+template<typename Entry>
+Entry *parallelRadixSortByKey(Entry *entries, Entry *scratch, qsizetype count, int chunkCount)
+{
+    constexpr int keyBytes = int(sizeof(Entry::key));
+    const qsizetype chunkSize = (count + chunkCount - 1) / chunkCount;
+    QVector<RadixSortChunk> chunks;
+    for (qsizetype begin = 0; begin < count; begin += chunkSize)
+        chunks.append({ begin, qMin(begin + chunkSize, count), {} });
+
+    Entry *src = entries;
+    Entry *dst = scratch;
+    for (int byte = 0; byte < keyBytes; ++byte) {
+        const int shift = byte * 8;
+        QtConcurrent::blockingMap(QThreadPool::globalInstance(), chunks, [&](RadixSortChunk &chunk) {
+            chunk.histogram.fill(0);
+            for (qsizetype idx = chunk.begin; idx != chunk.end; ++idx)
+                ++chunk.histogram[(src[idx].key >> shift) & 0xff];
+        });
+
+        const quint32 firstBucket = (src[0].key >> shift) & 0xff;
+        quint32 firstBucketSize = 0;
+        for (const RadixSortChunk &chunk : std::as_const(chunks))
+            firstBucketSize += chunk.histogram[firstBucket];
+        if (firstBucketSize == quint32(count))
+            continue;
+        quint32 offset = 0;
+        for (int bucket = 0; bucket < 256; ++bucket) {
+            for (RadixSortChunk &chunk : chunks) {
+                const quint32 bucketSize = chunk.histogram[bucket];
+                chunk.histogram[bucket] = offset;
+                offset += bucketSize;
+            }
+        }
+
+        QtConcurrent::blockingMap(QThreadPool::globalInstance(), chunks, [&](RadixSortChunk &chunk) {
+            for (qsizetype idx = chunk.begin; idx != chunk.end; ++idx)
+                dst[chunk.histogram[(src[idx].key >> shift) & 0xff]++] = src[idx];
+        });
+        std::swap(src, dst);
+    }
+    return src;
+}
+#endif
+
+struct StateSortEntry
+{
+    quint64 key;
+    quint32 index;
+};
+
+// Hands out dense ids in the order of first use, saturating at the given maximum
+template<typename Key>
+class StateIds
+{
+public:
+    explicit StateIds(quint32 maxId) : m_maxId(maxId) {}
+    quint64 id(Key key)
+    {
+        auto it = m_ids.constFind(key);
+        if (it == m_ids.cend())
+            it = m_ids.insert(key, qMin(quint32(m_ids.size()), m_maxId));
+        return it.value();
+    }
+private:
+    QHash<Key, quint32> m_ids;
+    quint32 m_maxId;
+};
+}
+
+// Pipelines are not known until rhiPrepare, so the shader key, and the material for custom
+// materials, together with the cull mode stand in for them.
+static size_t estimatedPipelineKey(const QSSGRenderableObject &obj)
+{
+    switch (obj.type) {
+    case QSSGRenderableObject::Type::DefaultMaterialMeshSubset:
+    {
+        const auto &subset = static_cast<const QSSGSubsetRenderable &>(obj);
+        return qHashMulti(0, int(obj.type), subset.shaderDescription.hash(), int(subset.defaultMaterial().cullMode));
+    }
+    case QSSGRenderableObject::Type::CustomMaterialMeshSubset:
+    {
+        const auto &subset = static_cast<const QSSGSubsetRenderable &>(obj);
+        return qHashMulti(0, int(obj.type), &subset.material, subset.shaderDescription.hash(), int(subset.customMaterial().m_cullMode));
+    }
+    case QSSGRenderableObject::Type::Particles:
+        break;
+    }
+    return qHash(int(obj.type));
+}
+
+static const void *materialKey(const QSSGRenderableObject &obj)
+{
+    if (obj.type == QSSGRenderableObject::Type::Particles)
+        return &static_cast<const QSSGParticlesRenderable &>(obj).particles;
+    return &static_cast<const QSSGSubsetRenderable &>(obj).material;
+}
+
+static const void *meshKey(const QSSGRenderableObject &obj)
+{
+    if (obj.type == QSSGRenderableObject::Type::Particles)
+        return &static_cast<const QSSGParticlesRenderable &>(obj).particles;
+    return static_cast<const QSSGSubsetRenderable &>(obj).subset.rhi.vertexBuffer.data();
+}
+
+// Key layout, from the most significant bit:
+//   State:                   pipeline (14) | material (14) | mesh (16) | distance (20)
+//   CoarseDistanceThenState: distance slice (4) | pipeline (14) | material (14) | mesh (16) | distance (16)
+static constexpr quint32 pipelineKeyBits = 14;
+static constexpr quint32 materialKeyBits = 14;
+static constexpr quint32 meshKeyBits = 16;
+static constexpr quint32 sliceKeyBits = 4;
+
+quint64 QSSGLayerRenderData::stateSortKey(quint64 pipelineId, quint64 materialId, quint64 meshId, float normalizedDistance, OpaqueSortMode mode)
+{
+    const quint32 distanceBits = (mode == OpaqueSortMode::CoarseDistanceThenState) ? 16 : 20;
+    const quint64 state = (pipelineId << (materialKeyBits + meshKeyBits)) | (materialId << meshKeyBits) | meshId;
+    quint64 key = (state << distanceBits) | quint64(normalizedDistance * float((1u << distanceBits) - 1));
+    if (mode == OpaqueSortMode::CoarseDistanceThenState) {
+        // Equally sized slices, only the far end would land in slice 16
+        constexpr quint64 sliceCount = 1u << sliceKeyBits;
+        const quint64 slice = qMin(quint64(normalizedDistance * float(sliceCount)), sliceCount - 1);
+        key |= slice << (64 - sliceKeyBits);
+    }
+    return key;
+}
+
+QVector<quint32> QSSGLayerRenderData::sortedKeyOrder(const QVector<quint64> &keys)
+{
+    const qsizetype count = keys.size();
+    QVector<quint32> order(count);
+    if (count == 0)
+        return order;
+
+    QVector<StateSortEntry> entries(count);
+    for (qsizetype idx = 0; idx != count; ++idx)
+        entries[idx] = { keys.at(idx), quint32(idx) };
+
+    // With the dense ids the upper bytes are usually the same for all keys, and skipped
+    QVector<StateSortEntry> scratch(count);
+    const StateSortEntry *sorted = radixSortByKey(entries.data(), scratch.data(), count);
+    for (qsizetype idx = 0; idx != count; ++idx)
+        order[idx] = sorted[idx].index;
+    return order;
+}
+
+void QSSGLayerRenderData::sortByStateKeys(QSSGRenderableObjectList &renderables, OpaqueSortMode mode)
+{
+    const qsizetype count = renderables.size();
+    if (count < 2)
+        return;
+
+    float minDistance = std::numeric_limits<float>::max();
+    float maxDistance = std::numeric_limits<float>::lowest();
+    for (const QSSGRenderableObjectHandle &handle : std::as_const(renderables)) {
+        minDistance = qMin(minDistance, handle.cameraDistanceSq);
+        maxDistance = qMax(maxDistance, handle.cameraDistanceSq);
+    }
+    const float range = maxDistance - minDistance;
+    const float distanceScale = range > 0.0f ? 1.0f / range : 0.0f;
+
+    StateIds<size_t> pipelineIds((1u << pipelineKeyBits) - 1);
+    StateIds<const void *> materialIds((1u << materialKeyBits) - 1);
+    StateIds<const void *> meshIds((1u << meshKeyBits) - 1);
+
+    QVector<quint64> keys(count);
+    for (qsizetype idx = 0; idx != count; ++idx) {
+        const QSSGRenderableObjectHandle &handle = renderables.at(idx);
+        const float normalizedDistance = qBound(0.0f, (handle.cameraDistanceSq - minDistance) * distanceScale, 1.0f);
+        keys[idx] = stateSortKey(pipelineIds.id(estimatedPipelineKey(*handle.obj)),
+                                 materialIds.id(materialKey(*handle.obj)),
+                                 meshIds.id(meshKey(*handle.obj)),
+                                 normalizedDistance, mode);
+    }
+
+    const QVector<quint32> order = sortedKeyOrder(keys);
+    const QSSGRenderableObjectList unsorted = renderables;
+    for (qsizetype idx = 0; idx != count; ++idx)
+        renderables[idx] = unsorted.at(order.at(idx));
+}
+
 // Per-frame cache of renderable objects post-sort.
 const QVector<QSSGRenderableObjectHandle> &QSSGLayerRenderData::getSortedOpaqueRenderableObjects()
 {
@@ -257,8 +540,13 @@ const QVector<QSSGRenderableObjectHandle> &QSSGLayerRenderData::getSortedOpaqueR
             return lhs.cameraDistanceSq < rhs.cameraDistanceSq;
         };
 
-        // Render nearest to furthest objects
-        std::sort(renderedOpaqueObjects.begin(), renderedOpaqueObjects.end(), isRenderObjectPtrLessThan);
+        const OpaqueSortMode sortMode = opaqueSortMode();
+        if (sortMode == OpaqueSortMode::Distance) {
+            // Render nearest to furthest objects
+            std::sort(renderedOpaqueObjects.begin(), renderedOpaqueObjects.end(), isRenderObjectPtrLessThan);
+        } else {
+            sortByStateKeys(renderedOpaqueObjects, sortMode);
+        }
     }
     return renderedOpaqueObjects;
 }
@@ -391,6 +679,13 @@ void QSSGLayerRenderData::updateSortedDepthObjectsListImp()
             else if (depthMode == QSSGDepthDrawMode::OpaquePrePass)
                 renderedOpaqueDepthPrepassObjects.append(screenTextureObject);
         }
+
+        // Only depth is written, so the transparent objects don't need to stay back to front
+        const OpaqueSortMode sortMode = opaqueSortMode();
+        if (sortMode != OpaqueSortMode::Distance) {
+            sortByStateKeys(renderedDepthWriteObjects, sortMode);
+            sortByStateKeys(renderedOpaqueDepthPrepassObjects, sortMode);
+        }
     }
 }
 
@@ -481,7 +776,16 @@ void QSSGLayerRenderData::prepareImageForRender(QSSGRenderImage &inImage,
     // models (QSSGRenderModel -> QSSGRenderMesh retrieved from the
     // bufferManager in each prepareModelForRender, etc.).
 
-    const QSSGRenderImageTexture texture = bufferManager->loadRenderImage(&inImage);
+    // A tiled image needs more texels than the subset covers pixels
+    const float tiling = qMax(1.0f, qMax(qAbs(inImage.m_scale.x()), qAbs(inImage.m_scale.y())));
+    const quint32 requiredSize = quint32(qMin(float(textureSizeHint) * tiling, 65536.0f));
+    QSSGBufferManager::LoadRenderImageFlags loadFlags = QSSGBufferManager::LoadWithFlippedY;
+    if (inMapType == QSSGRenderableImage::Type::Normal || inMapType == QSSGRenderableImage::Type::ClearcoatNormal)
+        loadFlags |= QSSGBufferManager::LoadAsNormalMap;
+    const QSSGRenderImageTexture texture = bufferManager->loadRenderImage(&inImage,
+                                                                          QSSGBufferManager::MipModeFollowRenderImage,
+                                                                          loadFlags,
+                                                                          requiredSize);
 
     if (texture.m_texture) {
         if (texture.m_flags.hasTransparency()
@@ -917,6 +1221,31 @@ QSSGDefaultMaterialPreparationResult QSSGLayerRenderData::prepareCustomMaterialF
 // here: in case there is a scene shared between multiple View3Ds in different
 // QQuickWindows, each window may run this in their own render thread, while
 // inModel is the same.
+// Rough size, in pixels, of the bounds on screen. 0 when the camera is inside
+// them, as then there's no telling how close to it the surfaces are.
+static quint32 projectedPixelSize(const QSSGRenderCamera &camera, const QSSGBounds3 &bounds, int viewportWidth)
+{
+    if (bounds.isEmpty())
+        return 0;
+
+    // See the mesh level of detail selection in prepareModelForRender()
+    float distance = 2.0f;
+    if (camera.type != QSSGRenderGraphObject::Type::OrthographicCamera) {
+        const QVector3D cameraNormal = camera.getScalingCorrectDirection();
+        const QSSGPlane cameraPlane = QSSGPlane(camera.getGlobalPos(), cameraNormal);
+        const float distanceMin = cameraPlane.distance(bounds.getSupport(-cameraNormal));
+        const float distanceMax = cameraPlane.distance(bounds.getSupport(cameraNormal));
+        if (distanceMin * distanceMax <= 0.0f)
+            return 0;
+        distance = distanceMin > 0.0f ? distanceMin : -distanceMax;
+    }
+
+    const QVector3D extents = bounds.dimensions();
+    const float size = qMax(extents.x(), qMax(extents.y(), extents.z()));
+    const float viewportFraction = size / (distance * camera.getLevelOfDetailMultiplier());
+    return quint32(qCeil(qMin(viewportFraction, 16.0f) * viewportWidth));
+}
+
 bool QSSGLayerRenderData::prepareModelForRender(const RenderableNodeEntries &renderableModels,
                                                 const QMatrix4x4 &inViewProjection,
                                                 QSSGLayerRenderPreparationResultFlags &ioFlags,
@@ -940,6 +1269,12 @@ bool QSSGLayerRenderData::prepareModelForRender(const RenderableNodeEntries &ren
     }
 
     { // 1. Load meshes as needed
+        // Get all the meshes that are not loaded yet going before waiting for the first one
+        if (bufferManager->meshLoadingMode() == QSSGBufferManager::MeshLoadingMode::Parallel) {
+            for (const QSSGRenderableNodeEntry &renderable : renderableModels)
+                bufferManager->prefetchMesh(static_cast<QSSGRenderModel *>(renderable.node));
+        }
+
         for (const QSSGRenderableNodeEntry &renderable : renderableModels) {
             // It's up to the BufferManager to employ the appropriate caching mechanisms, so
             // loadMesh() is expected to be fast if already loaded. Note that preparing
@@ -958,22 +1293,27 @@ bool QSSGLayerRenderData::prepareModelForRender(const RenderableNodeEntries &ren
                         && (renderer->isGlobalPickingEnabled()
                             || model.getGlobalState(QSSGRenderModel::GlobalState::Pickable));
                 if (canModelBePickable) {
-                    // Check if there is BVH data, if not generate it
+                    // Check if there is BVH data, if not generate it in the background.
+                    // Picks that happen before it is ready only hit test the bounds.
+                    // bvh and bvhFuture are shared with picking, hence the mutex.
+                    QMutexLocker meshLocker(bufferManager->meshUpdateMutex());
                     if (!theMesh->bvh) {
-                        if (!model.meshPath.isNull())
-                            theMesh->bvh = bufferManager->loadMeshBVH(model.meshPath);
-                        else if (model.geometry)
-                            theMesh->bvh = bufferManager->loadMeshBVH(model.geometry);
-
-                        if (theMesh->bvh) {
-                            for (int i = 0; i < theMesh->bvh->roots.size(); ++i)
-                                theMesh->subsets[i].bvhRoot = theMesh->bvh->roots.at(i);
+                        if (!theMesh->bvhFuture.isValid()) {
+                            if (!model.meshPath.isNull())
+                                theMesh->bvhFuture = bufferManager->loadMeshBVHAsync(model.meshPath);
+                            else if (model.geometry)
+                                theMesh->bvhFuture = bufferManager->loadMeshBVHAsync(model.geometry);
+                        } else if (theMesh->bvhFuture.isFinished()) {
+                            theMesh->resolveBvh();
                         }
                     }
                 }
             }
         }
 
+        if (spatialIndex)
+            spatialIndex->update(renderableModels);
+
         // Now is the time to kick off the vertex/index buffer updates for all the
         // new meshes (and their submeshes). This here is the last possible place
         // to kick this off because the rest of the rendering pipeline will only
@@ -1019,8 +1359,25 @@ bool QSSGLayerRenderData::prepareModelForRender(const RenderableNodeEntries &ren
             continue;
 
         QSSGModelContext &theModelContext = *RENDER_FRAME_NEW<QSSGModelContext>(contextInterface, model, inViewProjection);
+        theModelContext.spatialIndexLeaf = renderable.spatialIndexLeaf;
+        theModelContext.globalValuesDirty = renderable.globalValuesDirty;
         modelContexts.push_back(&theModelContext);
 
+        // With frustum culling enabled on the camera, instances are culled one by one
+        // using the mesh bounds. Skinned and morphed meshes don't stay within those.
+        if (clippingFrustum.has_value() && model.instancing() && model.boneCount == 0 && !model.particleBuffer) {
+            QSSGBounds3 meshBounds;
+            bool hasMorphTargets = false;
+            for (const QSSGRenderSubset &subset : std::as_const(theMesh->subsets)) {
+                meshBounds.include(subset.bounds);
+                hasMorphTargets |= (subset.rhi.targetsTexture != nullptr);
+            }
+            if (!hasMorphTargets && !meshBounds.isEmpty()) {
+                theModelContext.instanceCullingFrustum = &clippingFrustum.value();
+                theModelContext.instanceCullingBounds = meshBounds;
+            }
+        }
+
         // many renderableFlags are the same for all the subsets
         QSSGRenderableObjectFlags renderableFlagsForModel;
 
@@ -1286,8 +1643,16 @@ bool QSSGLayerRenderData::prepareModelForRender(const RenderableNodeEntries &ren
                 theMaterialObject->type == QSSGRenderGraphObject::Type::PrincipledMaterial ||
                 theMaterialObject->type == QSSGRenderGraphObject::Type::SpecularGlossyMaterial) {
                 QSSGRenderDefaultMaterial &theMaterial(static_cast<QSSGRenderDefaultMaterial &>(*theMaterialObject));
+                textureSizeHint = 0;
+                if (camera && !usesInstancing && bufferManager->textureStreamingEnabled()) {
+                    QSSGBounds3 subsetBounds = theSubset.bounds;
+                    subsetBounds.transform(model.globalTransform);
+                    textureSizeHint = projectedPixelSize(*camera, subsetBounds, renderer->contextInterface()->viewport().width());
+                }
                 QSSGDefaultMaterialPreparationResult theMaterialPrepResult(
                         prepareDefaultMaterialForRender(theMaterial, renderableFlags, subsetOpacity, lights, ioFlags));
+                // Only the images of this default material are loaded for that size
+                textureSizeHint = 0;
                 QSSGShaderDefaultMaterialKey &theGeneratedKey(theMaterialPrepResult.materialKey);
                 subsetOpacity = theMaterialPrepResult.opacity;
                 QSSGRenderableImage *firstImage(theMaterialPrepResult.firstImage);
@@ -1399,15 +1764,16 @@ bool QSSGLayerRenderData::prepareModelForRender(const RenderableNodeEntries &ren
                                                                              lights);
             }
             if (theRenderableObject) {
+                const auto handle = createRenderableHandle(theRenderableObject, getCameraDistanceSq(*theRenderableObject, cameraData));
                 if (theRenderableObject->renderableFlags.requiresScreenTexture())
-                    screenTextureObjects.push_back({theRenderableObject, getCameraDistanceSq(*theRenderableObject, cameraData)});
+                    screenTextureObjects.push_back(handle);
                 else if (theRenderableObject->renderableFlags.hasTransparency())
-                    transparentObjects.push_back({theRenderableObject, getCameraDistanceSq(*theRenderableObject, cameraData)});
+                    transparentObjects.push_back(handle);
                 else
-                    opaqueObjects.push_back({theRenderableObject, getCameraDistanceSq(*theRenderableObject, cameraData)});
+                    opaqueObjects.push_back(handle);
 
                 if (theRenderableObject->renderableFlags.usedInBakedLighting())
-                    bakedLightingObjects.push_back({theRenderableObject, getCameraDistanceSq(*theRenderableObject, cameraData)});
+                    bakedLightingObjects.push_back(handle);
             }
         }
 
@@ -1488,12 +1854,13 @@ bool QSSGLayerRenderData::prepareParticlesForRender(const RenderableNodeEntries
                                                                                   lights,
                                                                                   opacity);
             if (theRenderableObject) {
+                const auto handle = createRenderableHandle(theRenderableObject, getCameraDistanceSq(*theRenderableObject, cameraData));
                 if (theRenderableObject->renderableFlags.requiresScreenTexture())
-                    screenTextureObjects.push_back({theRenderableObject, getCameraDistanceSq(*theRenderableObject, cameraData)});
+                    screenTextureObjects.push_back(handle);
                 else if (theRenderableObject->renderableFlags.hasTransparency())
-                    transparentObjects.push_back({theRenderableObject, getCameraDistanceSq(*theRenderableObject, cameraData)});
+                    transparentObjects.push_back(handle);
                 else
-                    opaqueObjects.push_back({theRenderableObject, getCameraDistanceSq(*theRenderableObject, cameraData)});
+                    opaqueObjects.push_back(handle);
             }
         }
     }
@@ -1973,6 +2340,8 @@ void QSSGLayerRenderData::prepareForRender()
 
     const QSSGCameraData &cameraData = getCameraDirectionAndPosition();
 
+    // At least one renderable per model and particle system, more for models with several subsets
+    renderableBounds.reserve(renderableModels.size() + renderableParticles.size());
     wasDirty |= prepareModelForRender(renderableModels, viewProjection, thePrepResult.flags, cameraData, meshLodThreshold);
     wasDirty |= prepareParticlesForRender(renderableParticles, cameraData);
     wasDirty |= prepareItem2DsForRender(*renderer->contextInterface(), renderableItem2Ds, viewProjection);
@@ -2073,6 +2442,7 @@ void QSSGLayerRenderData::resetForFrame()
     renderedOpaqueDepthPrepassObjects.clear();
     renderedDepthWriteObjects.clear();
     renderedBakedLightingModels.clear();
+    renderableBounds.clear();
     renderableItem2Ds.clear();
     globalLights.clear();
     modelContexts.clear();
@@ -2118,11 +2488,19 @@ QSSGLayerRenderData::QSSGLayerRenderData(QSSGRenderLayer &inLayer, const QSSGRef
     : layer(inLayer)
     , renderer(inRenderer)
 {
+    static const bool useSpatialIndex = (qEnvironmentVariableIntValue("QT_QUICK3D_SPATIAL_INDEX") != 0);
+    if (useSpatialIndex)
+        spatialIndex = new QSSGRenderSpatialIndex;
+    static const bool useUniformBufferRing = (qEnvironmentVariableIntValue("QT_QUICK3D_UNIFORM_BUFFER_RING") != 0);
+    if (useUniformBufferRing)
+        uniformBufferRing = new QSSGRhiUniformBufferRing(*renderer->contextInterface()->rhiContext());
 }
 
 QSSGLayerRenderData::~QSSGLayerRenderData()
 {
     delete m_lightmapper;
+    delete spatialIndex;
+    delete uniformBufferRing;
     shadowMapPass.release();
     reflectionMapPass.release();
     zPrePassPass.release();
@@ -2132,61 +2510,189 @@ QSSGLayerRenderData::~QSSGLayerRenderData()
     mainPass.release();
 }
 
-static void sortInstances(QByteArray &sortedData, QList<QSSGRhiSortData> &sortData, const void *instances,
-                          int stride, int count, const QVector3D &cameraDirection)
+QSSGClippingFrustum QSSGLayerRenderData::instanceSpaceFrustum(const QSSGClippingFrustum &frustum, const QMatrix4x4 &parentTransform)
 {
-    sortData.resize(count);
-    Q_ASSERT(stride == sizeof(QSSGRenderInstanceTableEntry));
-    // create sort data
-    {
-        const QSSGRenderInstanceTableEntry *instance = reinterpret_cast<const QSSGRenderInstanceTableEntry *>(instances);
-        for (int i = 0; i < count; i++) {
-            const QVector3D pos = QVector3D(instance->row0.w(), instance->row1.w(), instance->row2.w());
-            sortData[i] = {QVector3D::dotProduct(pos, cameraDirection), i};
-            instance++;
+    const float *m = parentTransform.constData();
+    QSSGClippingFrustum result;
+    for (int idx = 0; idx < 6; ++idx) {
+        const QVector3D &n = frustum.mPlanes[idx].normal;
+        QSSGClipPlane &plane = result.mPlanes[idx];
+        plane.normal = QVector3D(m[0] * n.x() + m[1] * n.y() + m[2] * n.z(),
+                                 m[4] * n.x() + m[5] * n.y() + m[6] * n.z(),
+                                 m[8] * n.x() + m[9] * n.y() + m[10] * n.z());
+        plane.d = m[12] * n.x() + m[13] * n.y() + m[14] * n.z() + frustum.mPlanes[idx].d;
+        plane.calculateBBoxEdges();
+    }
+    return result;
+}
+
+void QSSGLayerRenderData::collectInstanceBounds(QSSGBoundsSoA &bounds, const QSSGRenderInstanceTableEntry *instances, quint32 count, const QSSGBounds3 &localBounds)
+{
+    bounds.resize(count);
+    float *minX = bounds.minX.data();
+    float *minY = bounds.minY.data();
+    float *minZ = bounds.minZ.data();
+    float *maxX = bounds.maxX.data();
+    float *maxY = bounds.maxY.data();
+    float *maxZ = bounds.maxZ.data();
+    const QVector3D localCenter = localBounds.center();
+    const QVector3D localExtents = localBounds.extents();
+    QVector3D center;
+    QVector3D extents;
+    for (quint32 i = 0; i < count; ++i) {
+        instances[i].transformBounds(localCenter, localExtents, center, extents);
+        minX[i] = center.x() - extents.x();
+        minY[i] = center.y() - extents.y();
+        minZ[i] = center.z() - extents.z();
+        maxX[i] = center.x() + extents.x();
+        maxY[i] = center.y() + extents.y();
+        maxZ[i] = center.z() + extents.z();
+    }
+}
+
+quint32 QSSGLayerRenderData::compactInstances(QSSGRenderInstanceTableEntry *dest, const QSSGRenderInstanceTableEntry *instances, quint32 count,
+                                              const quint32 *visibilityMask, const InstanceLodRange *lodRange, quint32 *visibleCount)
+{
+    const auto isVisible = [visibilityMask](quint32 idx) {
+        return !visibilityMask || (visibilityMask[idx >> 5] & (1u << (idx & 31)));
+    };
+    const auto inLodRange = [lodRange](const QSSGRenderInstanceTableEntry &instance) {
+        return !lodRange || lodRange->contains(instance);
+    };
+
+    QSSGRenderInstanceTableEntry *out = dest;
+    for (quint32 i = 0; i < count; ++i) {
+        if (isVisible(i) && inLodRange(instances[i]))
+            *out++ = instances[i];
+    }
+    *visibleCount = quint32(out - dest);
+
+    // The instances outside of the frustum can still cast shadows and show up in reflections
+    if (visibilityMask) {
+        for (quint32 i = 0; i < count; ++i) {
+            if (!isVisible(i) && inLodRange(instances[i]))
+                *out++ = instances[i];
         }
     }
 
-    // sort
-    std::sort(sortData.begin(), sortData.end(), [](const QSSGRhiSortData &a, const QSSGRhiSortData &b){
-        return a.d > b.d;
-    });
+    return quint32(out - dest);
+}
 
-    // copy instances
-    {
-        const QSSGRenderInstanceTableEntry *instance = reinterpret_cast<const QSSGRenderInstanceTableEntry *>(instances);
-        QSSGRenderInstanceTableEntry *dest = reinterpret_cast<QSSGRenderInstanceTableEntry *>(sortedData.data());
-        for (auto &s : sortData)
-            *dest++ = instance[s.indexOrOffset];
+namespace {
+struct DepthSortEntry
+{
+    quint32 key;
+    quint32 index;
+};
+}
+
+// Maps the depth to an unsigned key that orders back to front
+static inline quint32 depthSortKey(float depth)
+{
+    quint32 bits;
+    memcpy(&bits, &depth, sizeof(bits));
+    bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+    return ~bits;
+}
+
+static const DepthSortEntry *radixSortDepthEntries(DepthSortEntry *entries, DepthSortEntry *scratch, qsizetype count)
+{
+#ifdef QT_QUICK3D_HAS_CONCURRENT
+    // Sorts of at least two chunks of this size go to the thread pool
+    constexpr qsizetype parallelDepthSortChunkSize = 32768;
+    const int chunkCount = int(qMin<qsizetype>(QThreadPool::globalInstance()->maxThreadCount(), count / parallelDepthSortChunkSize));
+    if (chunkCount > 1)
+        return parallelRadixSortByKey(entries, scratch, count, chunkCount);
+#endif
+    return radixSortByKey(entries, scratch, count);
+}
+
+// Insertion sort for nearly sorted input. Gives up, leaving a permutation of the input, once
+// more than maxMoves moves were needed.
+static bool insertionSortBounded(DepthSortEntry *entries, qsizetype count, qsizetype maxMoves)
+{
+    qsizetype moves = 0;
+    for (qsizetype i = 1; i < count; ++i) {
+        const DepthSortEntry entry = entries[i];
+        qsizetype j = i;
+        while (j > 0 && entries[j - 1].key > entry.key) {
+            entries[j] = entries[j - 1];
+            --j;
+            if (++moves > maxMoves) {
+                entries[j] = entry;
+                return false;
+            }
+        }
+        entries[j] = entry;
     }
+    return true;
 }
 
-static void cullLodInstances(QByteArray &lodData, const void *instances, int count,
-                             const QVector3D &cameraPosition, float minThreshold, float maxThreshold)
+// Only the instances that passed the filters are sorted. Small camera movements only change
+// the order a little, so the instances are sorted in the previous order first using an
+// insertion sort, and a radix sort is only needed for larger jumps. The radix sort runs on
+// the thread pool when there are enough instances.
+quint32 QSSGLayerRenderData::sortInstances(QSSGRenderInstanceTableEntry *dest, QVector<quint32> &sortOrder,
+                                           const QSSGRenderInstanceTableEntry *instances, quint32 count,
+                                           const quint32 *visibilityMask, const InstanceLodRange *lodRange,
+                                           const QVector3D &sortDirection, quint32 *visibleCount)
 {
-    const QSSGRenderInstanceTableEntry *instance = reinterpret_cast<const QSSGRenderInstanceTableEntry *>(instances);
-    QSSGRenderInstanceTableEntry *dest = reinterpret_cast<QSSGRenderInstanceTableEntry *>(lodData.data());
-    for (int i = 0; i < count; ++i) {
-        const float x = cameraPosition.x() - instance->row0.w();
-        const float y = cameraPosition.y() - instance->row1.w();
-        const float z = cameraPosition.z() - instance->row2.w();
-        const float distanceSq = x * x + y * y + z * z;
-        if (distanceSq >= minThreshold * minThreshold && (maxThreshold < 0 || distanceSq < maxThreshold * maxThreshold))
-            *dest = *instance;
-        else
-            *dest= {};
-        dest++;
-        instance++;
+    if (quint32(sortOrder.size()) != count) {
+        sortOrder.resize(count);
+        std::iota(sortOrder.begin(), sortOrder.end(), 0u);
     }
+
+    // The visible instances in the previous order, with the positions in sortOrder they came from
+    QVector<DepthSortEntry> entries;
+    QVector<quint32> positions;
+    QVector<quint32> hidden;
+    entries.reserve(count);
+    positions.reserve(count);
+    for (quint32 position = 0; position < count; ++position) {
+        const quint32 idx = sortOrder.at(position);
+        const QSSGRenderInstanceTableEntry &instance = instances[idx];
+        if (lodRange && !lodRange->contains(instance))
+            continue;
+        if (visibilityMask && !(visibilityMask[idx >> 5] & (1u << (idx & 31)))) {
+            hidden.append(idx);
+            continue;
+        }
+        const QVector3D pos(instance.row0.w(), instance.row1.w(), instance.row2.w());
+        entries.append({ depthSortKey(QVector3D::dotProduct(pos, sortDirection)), idx });
+        positions.append(position);
+    }
+
+    const qsizetype visible = entries.size();
+    const DepthSortEntry *sorted = entries.constData();
+    QVector<DepthSortEntry> scratch;
+    if (!insertionSortBounded(entries.data(), visible, 4 * visible + 64)) {
+        scratch.resize(visible);
+        sorted = radixSortDepthEntries(entries.data(), scratch.data(), visible);
+    }
+
+    // The visible instances swap places among the positions they had, so that sortOrder stays
+    // a permutation of all instances.
+    for (qsizetype i = 0; i < visible; ++i) {
+        sortOrder[positions.at(i)] = sorted[i].index;
+        *dest++ = instances[sorted[i].index];
+    }
+    for (quint32 idx : std::as_const(hidden))
+        *dest++ = instances[idx];
+
+    *visibleCount = quint32(visible);
+    return quint32(visible + hidden.size());
 }
 
 bool QSSGSubsetRenderable::prepareInstancing(QSSGRhiContext *rhiCtx, const QVector3D &cameraDirection, const QVector3D &cameraPosition, float minThreshold, float maxThreshold)
 {
     if (!modelContext.model.instancing() || instanceBuffer)
         return instanceBuffer;
-    auto *table = modelContext.model.instanceTable;
+    const QSSGRenderModel &model = modelContext.model;
+    auto *table = model.instanceTable;
     bool usesLod = minThreshold >= 0 || maxThreshold >= 0;
-    QSSGRhiInstanceBufferData &instanceData(usesLod ? rhiCtx->instanceBufferData(&modelContext.model) : rhiCtx->instanceBufferData(table));
+    const QSSGClippingFrustum *cullingFrustum = modelContext.instanceCullingFrustum;
+    // Filtered instance data depends on the model (and the view when culled), not only on the table
+    QSSGRhiInstanceBufferData &instanceData((usesLod || cullingFrustum) ? rhiCtx->instanceBufferData(&model, cullingFrustum) : rhiCtx->instanceBufferData(table));
     quint32 instanceBufferSize = table->dataSize();
     // Create or resize the instance buffer ### if (instanceData.owned)
     bool sortingChanged = table->isDepthSortingEnabled() != instanceData.sorting;
@@ -2194,12 +2700,35 @@ bool QSSGSubsetRenderable::prepareInstancing(QSSGRhiContext *rhiCtx, const QVect
     bool cameraPositionChanged = !qFuzzyCompare(instanceData.cameraPosition, cameraPosition);
     bool updateInstanceBuffer = table->serial() != instanceData.serial || sortingChanged || (cameraDirectionChanged && table->isDepthSortingEnabled());
     bool updateForLod = cameraPositionChanged && usesLod;
+    // The instance count override doesn't change the serial, but filtered data has to be redone
+    bool countChanged = table->count() != instanceData.tableCount;
+    if (countChanged && (usesLod || cullingFrustum || table->isDepthSortingEnabled()))
+        updateInstanceBuffer = true;
+    instanceData.tableCount = table->count();
     if (sortingChanged && !table->isDepthSortingEnabled()) {
-        instanceData.sortedData.clear();
-        instanceData.sortData.clear();
+        instanceData.sortOrder.clear();
         instanceData.sortedCameraDirection = {};
     }
     instanceData.sorting = table->isDepthSortingEnabled();
+
+    // Instances only need to be culled again when the frustum or the instance bounds
+    // changed relative to the instance table.
+    QSSGClippingFrustum instanceFrustum;
+    QSSGBounds3 localBounds;
+    bool updateForCulling = (cullingFrustum != nullptr) != instanceData.culling;
+    if (cullingFrustum) {
+        instanceFrustum = QSSGLayerRenderData::instanceSpaceFrustum(*cullingFrustum, model.globalInstanceTransform);
+        localBounds = modelContext.instanceCullingBounds;
+        localBounds.transform(model.localInstanceTransform);
+        for (int idx = 0; idx < 6 && !updateForCulling; ++idx) {
+            const QSSGClipPlane &plane = instanceFrustum.mPlanes[idx];
+            updateForCulling = instanceData.cullingPlanes[idx] != QVector4D(plane.normal, plane.d);
+        }
+        updateForCulling |= localBounds.minimum != instanceData.cullingLocalBounds.minimum
+                || localBounds.maximum != instanceData.cullingLocalBounds.maximum;
+    }
+    instanceData.culling = (cullingFrustum != nullptr);
+
     if (instanceData.buffer && instanceData.buffer->size() < instanceBufferSize) {
         updateInstanceBuffer = true;
         //                    qDebug() << "Resizing instance buffer";
@@ -2212,47 +2741,77 @@ bool QSSGSubsetRenderable::prepareInstancing(QSSGRhiContext *rhiCtx, const QVect
         instanceData.buffer = rhiCtx->rhi()->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::VertexBuffer, instanceBufferSize);
         instanceData.buffer->create();
     }
-    if (updateInstanceBuffer || updateForLod) {
-        const void *data = nullptr;
-        if (table->isDepthSortingEnabled()) {
-            if (updateInstanceBuffer) {
-                QMatrix4x4 invGlobalTransform = modelContext.model.globalTransform.inverted();
-                instanceData.sortedData.resize(table->dataSize());
-                sortInstances(instanceData.sortedData,
-                              instanceData.sortData,
-                              table->constData(),
-                              table->stride(),
-                              table->count(),
-                              invGlobalTransform.map(cameraDirection).normalized());
-            }
-            data = instanceData.sortedData.constData();
-            instanceData.sortedCameraDirection = cameraDirection;
+    // When the buffer holds the table as is, only the ranges that were updated since the
+    // previous upload need to be uploaded again.
+    if (table->updateSerial() != instanceData.updateSerial) {
+        const bool unfiltered = !usesLod && !cullingFrustum && !table->isDepthSortingEnabled();
+        if (!updateInstanceBuffer && unfiltered && table->updateSerial() == instanceData.updateSerial + 1) {
+            const char *tableData = static_cast<const char *>(table->constData());
+            const int stride = table->stride();
+            QRhiResourceUpdateBatch *rub = rhiCtx->rhi()->nextResourceUpdateBatch();
+            for (const QSSGRenderInstanceTable::Range &range : table->lastUpdatedRanges())
+                rub->updateDynamicBuffer(instanceData.buffer, range.offset * stride, range.count * stride, tableData + range.offset * stride);
+            rhiCtx->commandBuffer()->resourceUpdate(rub);
         } else {
-            data = table->constData();
+            updateInstanceBuffer = true;
         }
+        instanceData.updateSerial = table->updateSerial();
+    }
+    if (updateInstanceBuffer || updateForLod || updateForCulling) {
+        const void *data = table->constData();
         if (data) {
-            if (updateForLod) {
-                if (table->isDepthSortingEnabled()) {
-                    instanceData.lodData.resize(table->dataSize());
-                    cullLodInstances(instanceData.lodData, instanceData.sortedData.constData(), instanceData.sortedData.size(), cameraPosition, minThreshold, maxThreshold);
-                    data = instanceData.lodData.constData();
+            const bool sorting = table->isDepthSortingEnabled();
+            quint32 count = quint32(table->count());
+            quint32 visibleCount = count;
+            if (usesLod || cullingFrustum || sorting) {
+                const auto *instances = reinterpret_cast<const QSSGRenderInstanceTableEntry *>(data);
+                const quint32 *visibilityMask = nullptr;
+                if (cullingFrustum) {
+                    QSSGLayerRenderData::collectInstanceBounds(instanceData.cullingBounds, instances, count, localBounds);
+                    instanceData.cullingMask.resize(QSSGBoundsSoA::maskSize(count));
+                    instanceFrustum.intersectsWith(instanceData.cullingBounds, instanceData.cullingMask.data());
+                    visibilityMask = instanceData.cullingMask.constData();
+                    for (int idx = 0; idx < 6; ++idx)
+                        instanceData.cullingPlanes[idx] = QVector4D(instanceFrustum.mPlanes[idx].normal, instanceFrustum.mPlanes[idx].d);
+                    instanceData.cullingLocalBounds = localBounds;
+                }
+                const QSSGLayerRenderData::InstanceLodRange lodRange { cameraPosition, minThreshold, maxThreshold };
+                instanceData.lodData.resize(table->dataSize());
+                auto *dest = reinterpret_cast<QSSGRenderInstanceTableEntry *>(instanceData.lodData.data());
+                if (sorting) {
+                    Q_ASSERT(table->stride() == sizeof(QSSGRenderInstanceTableEntry));
+                    const QMatrix4x4 invGlobalTransform = model.globalTransform.inverted();
+                    count = QSSGLayerRenderData::sortInstances(dest, instanceData.sortOrder, instances, count, visibilityMask,
+                                                               usesLod ? &lodRange : nullptr,
+                                                               invGlobalTransform.map(cameraDirection).normalized(), &visibleCount);
+                    instanceData.sortedCameraDirection = cameraDirection;
                 } else {
-                    instanceData.lodData.resize(table->dataSize());
-                    cullLodInstances(instanceData.lodData, table->constData(), table->count(), cameraPosition, minThreshold, maxThreshold);
-                    data = instanceData.lodData.constData();
+                    count = QSSGLayerRenderData::compactInstances(dest, instances, count, visibilityMask, usesLod ? &lodRange : nullptr, &visibleCount);
                 }
+                data = instanceData.lodData.constData();
             }
-            QRhiResourceUpdateBatch *rub = rhiCtx->rhi()->nextResourceUpdateBatch();
-            rub->updateDynamicBuffer(instanceData.buffer, 0, instanceBufferSize, data);
-            rhiCtx->commandBuffer()->resourceUpdate(rub);
-            //qDebug() << "****** UPDATING INST BUFFER. Size" << instanceBufferSize;
+            // Unfiltered data is uploaded as a whole, the instance count override can go up
+            // without a new serial.
+            const quint32 uploadSize = (data == table->constData()) ? instanceBufferSize : count * table->stride();
+            if (uploadSize > 0) {
+                QRhiResourceUpdateBatch *rub = rhiCtx->rhi()->nextResourceUpdateBatch();
+                rub->updateDynamicBuffer(instanceData.buffer, 0, uploadSize, data);
+                rhiCtx->commandBuffer()->resourceUpdate(rub);
+            }
+            //qDebug() << "****** UPDATING INST BUFFER. Size" << uploadSize;
+            instanceData.instanceCount = count;
+            instanceData.visibleInstanceCount = visibleCount;
         } else {
             qWarning() << "NO DATA IN INSTANCE TABLE";
         }
         instanceData.serial = table->serial();
         instanceData.cameraPosition = cameraPosition;
     }
+    if (!usesLod && !cullingFrustum)
+        instanceData.instanceCount = instanceData.visibleInstanceCount = quint32(table->count());
     instanceBuffer = instanceData.buffer;
+    instanceCount = instanceData.instanceCount;
+    visibleInstanceCount = instanceData.visibleInstanceCount;
     return instanceBuffer;
 }
 
@@ -28,6 +28,7 @@
 #include <QtQuick3DRuntimeRender/private/qssgrenderreflectionmap_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrendercamera_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrhicontext_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrenderspatialindex_p.h>
 
 #include <QtQuick3DUtils/private/qssgrenderbasetypes_p.h>
 
@@ -156,8 +157,11 @@ struct QSSGRenderableNodeEntry
     QSSGRenderNode *node = nullptr;
     mutable QSSGRenderMesh *mesh = nullptr;
     mutable QSSGShaderLightListView lights;
+    mutable qint32 spatialIndexLeaf = -1;
+    bool globalValuesDirty = false; // The node's global values were recalculated this frame
     QSSGRenderableNodeEntry() = default;
-    QSSGRenderableNodeEntry(QSSGRenderNode &inNode) : node(&inNode) {}
+    QSSGRenderableNodeEntry(QSSGRenderNode &inNode, bool inGlobalValuesDirty = false)
+        : node(&inNode), globalValuesDirty(inGlobalValuesDirty) {}
 };
 
 struct QSSGDefaultMaterialPreparationResult
@@ -237,6 +241,8 @@ public:
                                const QSSGCameraData &cameraData,
                                float lodThreshold = 0.0f);
     bool prepareParticlesForRender(const RenderableNodeEntries &renderableParticles, const QSSGCameraData &cameraData);
+    // Creates the handle for a renderable prepared in this frame and records its global bounds in renderableBounds
+    QSSGRenderableObjectHandle createRenderableHandle(QSSGRenderableObject *obj, float cameraDistanceSq);
     static bool prepareItem2DsForRender(const QSSGRenderContextInterface &ctxIfc, const RenderableItem2DEntries &renderableItem2Ds,
                                         const QMatrix4x4 &inViewProjection);
 
@@ -248,6 +254,70 @@ public:
 
     static qsizetype frustumCulling(const QSSGClippingFrustum &clipFrustum, const QSSGRenderableObjectList &renderables, QSSGRenderableObjectList &visibleRenderables);
     [[nodiscard]] static qsizetype frustumCullingInline(const QSSGClippingFrustum &clipFrustum, QSSGRenderableObjectList &renderables);
+    // Same as frustumCulling() above, but takes the result from visibilityMask, as written by the SIMD kernel in
+    // QSSGClippingFrustum for the packed bounds the handles' boundsIndex refers to (see renderableBounds), instead
+    // of visiting each renderable's bounds individually. Renderables without packed bounds are tested on their own.
+    static qsizetype frustumCulling(const QSSGClippingFrustum &clipFrustum, const QVector<quint32> &visibilityMask, const QSSGRenderableObjectList &renderables, QSSGRenderableObjectList &visibleRenderables);
+    // Same as frustumCulling() above, but uses the per-model classification from the spatial index: subsets of
+    // models that are fully inside or outside of the frustum are not tested individually.
+    static qsizetype frustumCulling(const QSSGClippingFrustum &clipFrustum, const QVector<QSSGRenderSpatialIndex::Visibility> &modelVisibility, const QSSGRenderableObjectList &renderables, QSSGRenderableObjectList &visibleRenderables);
+
+    // How the opaque and depth prepass lists are ordered. Distance sorts front to back. State groups
+    // the renderables by (estimated) pipeline, material and mesh, with the distance only ordering
+    // renderables sharing all of these. CoarseDistanceThenState groups by state within 16 depth
+    // slices, which keeps a rough front to back order for early depth rejection.
+    enum class OpaqueSortMode : quint8
+    {
+        Distance,
+        State,
+        CoarseDistanceThenState
+    };
+    // From QT_QUICK3D_OPAQUE_SORT_MODE (0, 1 or 2, defaults to Distance)
+    [[nodiscard]] static OpaqueSortMode opaqueSortMode();
+    // Sorts with 64-bit keys packing the state and the quantized camera distance, using a radix sort
+    static void sortByStateKeys(QSSGRenderableObjectList &renderables, OpaqueSortMode mode);
+    // The key for the given dense state ids and the camera distance normalized to [0, 1]
+    [[nodiscard]] static quint64 stateSortKey(quint64 pipelineId, quint64 materialId, quint64 meshId, float normalizedDistance, OpaqueSortMode mode);
+    // Indices of the keys in ascending key order, equal keys keep their relative order
+    [[nodiscard]] static QVector<quint32> sortedKeyOrder(const QVector<quint64> &keys);
+
+    // Per-instance filtering of instanced models, see QSSGSubsetRenderable::prepareInstancing()
+    struct InstanceLodRange
+    {
+        QVector3D cameraPosition;
+        float minThreshold;
+        float maxThreshold;
+
+        bool contains(const QSSGRenderInstanceTableEntry &instance) const
+        {
+            const float x = cameraPosition.x() - instance.row0.w();
+            const float y = cameraPosition.y() - instance.row1.w();
+            const float z = cameraPosition.z() - instance.row2.w();
+            const float distanceSq = x * x + y * y + z * z;
+            return (minThreshold < 0 || distanceSq >= minThreshold * minThreshold)
+                    && (maxThreshold < 0 || distanceSq < maxThreshold * maxThreshold);
+        }
+    };
+    // The frustum planes in the space the instance table is in (the parent of the instance
+    // root), so that the instances don't have to be transformed to world space one by one.
+    [[nodiscard]] static QSSGClippingFrustum instanceSpaceFrustum(const QSSGClippingFrustum &frustum, const QMatrix4x4 &parentTransform);
+    // Bounds of each instance in the space of the instance table, given the bounds in the
+    // instance's local space.
+    static void collectInstanceBounds(QSSGBoundsSoA &bounds, const QSSGRenderInstanceTableEntry *instances, quint32 count, const QSSGBounds3 &localBounds);
+    // Copies the instances that are within the level of detail range (when given) to dest, the
+    // ones set in visibilityMask (when given) first, keeping their order. Returns the number of
+    // instances copied, visibleCount gets the number of instances that were set in the mask.
+    // Passes drawing from the camera draw the first visibleCount instances, shadow and
+    // reflection map passes draw all of them.
+    static quint32 compactInstances(QSSGRenderInstanceTableEntry *dest, const QSSGRenderInstanceTableEntry *instances, quint32 count,
+                                    const quint32 *visibilityMask, const InstanceLodRange *lodRange, quint32 *visibleCount);
+    // Same as compactInstances(), but with the visible instances sorted back to front along
+    // sortDirection. sortOrder holds the table indices in the order of the previous sort, and
+    // gets updated.
+    static quint32 sortInstances(QSSGRenderInstanceTableEntry *dest, QVector<quint32> &sortOrder,
+                                 const QSSGRenderInstanceTableEntry *instances, quint32 count,
+                                 const quint32 *visibilityMask, const InstanceLodRange *lodRange,
+                                 const QVector3D &sortDirection, quint32 *visibleCount);
 
     [[nodiscard]] QSSGCameraData getCameraDirectionAndPosition();
     // Per-frame cache of renderable objects post-sort (for the MAIN rendering camera, i.e., don't use these lists for rendering from a different camera).
@@ -303,6 +373,10 @@ public:
     QSSGRenderableObjectList renderedOpaqueDepthPrepassObjects;
     QSSGRenderableObjectList renderedDepthWriteObjects;
     QVector<QSSGBakedLightingModel> renderedBakedLightingModels;
+    // Packed global bounds of all renderables prepared in this frame, recorded as they are created
+    // (see createRenderableHandle()), and the frustum culling result for them.
+    QSSGBoundsSoA renderableBounds;
+    QVector<quint32> renderableVisibility;
     RenderableItem2DEntries renderedItem2Ds;
 
     std::optional<QSSGClippingFrustum> clippingFrustum;
@@ -321,6 +395,14 @@ public:
 
     QSSGLightmapper *m_lightmapper = nullptr;
 
+    // Optional (QT_QUICK3D_SPATIAL_INDEX=1) hierarchy over the world bounds of the renderable models.
+    QSSGRenderSpatialIndex *spatialIndex = nullptr;
+    QVector<QSSGRenderSpatialIndex::Visibility> spatialIndexVisibility;
+
+    // Optional (QT_QUICK3D_UNIFORM_BUFFER_RING=1) per-frame allocator for the uniform data of
+    // the default material draw calls. Per layer, as each View3D prepares its own draw calls.
+    QSSGRhiUniformBufferRing *uniformBufferRing = nullptr;
+
     QSSGShaderFeatures getShaderFeatures() const { return features; }
     QSSGRhiGraphicsPipelineState getPipelineState() const { return ps; }
 
@@ -333,6 +415,7 @@ private:
     void updateSortedDepthObjectsListImp();
     QSSGRhiGraphicsPipelineState ps; // Base pipleline state
     QSSGShaderFeatures features; // Base feature set
+    quint32 textureSizeHint = 0; // On screen size of the subset being prepared, for texture streaming
 };
 
 QT_END_NAMESPACE
@@ -11,6 +11,8 @@
 #ifdef QT_QUICK3D_HAS_LIGHTMAPPER
 #include <QtCore/qfuture.h>
 #include <QtCore/qfileinfo.h>
+#include <QtCore/qsavefile.h>
+#include <QtCore/qdatastream.h>
 #include <QtConcurrent/qtconcurrentrun.h>
 #include <QRandomGenerator>
 #include <qsimd.h>
@@ -115,12 +117,22 @@ struct QSSGLightmapperPrivate
         QVector3D directLight;
         QVector3D allLight;
     };
+    // Indirect light samples accumulated for a texel so far. Stored as is in the
+    // checkpoint files, so this must stay trivially copyable.
+    struct IndirectLightTexel {
+        QVector3D sum;
+        float luminanceSum = 0.0f;
+        float luminanceSquaredSum = 0.0f;
+        quint32 sampleCount = 0;
+        quint32 converged = 0;
+    };
     struct Lightmap {
         Lightmap(const QSize &pixelSize) : pixelSize(pixelSize) {
             entries.resize(pixelSize.width() * pixelSize.height());
         }
         QSize pixelSize;
         QVector<LightmapEntry> entries;
+        QVector<IndirectLightTexel> indirectLight; // empty when there is no indirect light
         QByteArray imageFP32;
         bool hasBaseColorTransparency = false;
     };
@@ -148,6 +160,11 @@ struct QSSGLightmapperPrivate
     bool prepareLightmaps();
     void computeDirectLight();
     void computeIndirectLight();
+    void computeIndirectLightForTexel(const LightmapEntry &lmPix, IndirectLightTexel &texel, int sampleCount);
+    quint64 sceneFingerprint() const;
+    bool loadIndirectLightCheckpoints(quint64 fingerprint);
+    bool storeIndirectLightCheckpoints(quint64 fingerprint);
+    void removeIndirectLightCheckpoints();
     bool postProcess();
     bool storeLightmaps();
     void sendOutputInfo(QSSGLightmapper::BakingStatus type, std::optional<QString> msg);
@@ -155,6 +172,14 @@ struct QSSGLightmapperPrivate
 
 static const int LM_SEAM_BLEND_ITER_COUNT = 4;
 
+static QString lightmapOutputFolder(const QSSGRenderModel &model)
+{
+    // An empty outputFolder equates to working directory
+    if (!model.lightmapLoadPath.startsWith(QStringLiteral(":/")))
+        return model.lightmapLoadPath;
+    return QString();
+}
+
 QSSGLightmapper::QSSGLightmapper(QSSGRhiContext *rhiCtx, QSSGRenderer *renderer)
     : d(new QSSGLightmapperPrivate)
 {
@@ -263,6 +288,9 @@ bool QSSGLightmapperPrivate::commitGeometry()
     geomPrepTimer.start();
 
     const QSSGRef<QSSGBufferManager> &bufferManager(renderer->contextInterface()->bufferManager());
+    // The baked result must not have the placeholders of textures that are still loading
+    const QSSGBufferManager::LoadRenderImageFlags bakeImageFlags = QSSGBufferManager::LoadWithFlippedY
+            | QSSGBufferManager::LoadSynchronously;
 
     const int bakedLightingModelCount = bakedLightingModels.size();
     subMeshInfos.resize(bakedLightingModelCount);
@@ -296,17 +324,17 @@ bool QSSGLightmapperPrivate::commitGeometry()
                 info.emissiveFactor = defMat->emissiveColor;
                 if (defMat->colorMap) {
                     info.baseColorNode = defMat->colorMap;
-                    QSSGRenderImageTexture texture = bufferManager->loadRenderImage(defMat->colorMap);
+                    QSSGRenderImageTexture texture = bufferManager->loadRenderImage(defMat->colorMap, QSSGBufferManager::MipModeFollowRenderImage, bakeImageFlags);
                     info.baseColorMap = texture.m_texture;
                 }
                 if (defMat->emissiveMap) {
                     info.emissiveNode = defMat->emissiveMap;
-                    QSSGRenderImageTexture texture = bufferManager->loadRenderImage(defMat->emissiveMap);
+                    QSSGRenderImageTexture texture = bufferManager->loadRenderImage(defMat->emissiveMap, QSSGBufferManager::MipModeFollowRenderImage, bakeImageFlags);
                     info.emissiveMap = texture.m_texture;
                 }
                 if (defMat->normalMap) {
                     info.normalMapNode = defMat->normalMap;
-                    QSSGRenderImageTexture texture = bufferManager->loadRenderImage(defMat->normalMap);
+                    QSSGRenderImageTexture texture = bufferManager->loadRenderImage(defMat->normalMap, QSSGBufferManager::MipModeFollowRenderImage, bakeImageFlags);
                     info.normalMap = texture.m_texture;
                     info.normalStrength = defMat->bumpAmount;
                 }
@@ -1154,6 +1182,119 @@ static inline QVector3D cosWeightedHemisphereSample()
     return QVector3D(sqr1 * std::cos(r2), sqr1 * std::sin(r2), sqr1m);
 }
 
+void QSSGLightmapperPrivate::computeIndirectLightForTexel(const LightmapEntry &lmPix, IndirectLightTexel &texel, int sampleCount)
+{
+    // indirect lighting is slow, so parallelize per groups of samples,
+    // e.g. if sample count is 256 and workgroup size is 32, then do up to
+    // 8 sets in parallel, each calculating 32 samples (how many of the 8
+    // are really done concurrently that's up to the thread pool to manage)
+
+    struct WorkgroupResult {
+        QVector3D sum;
+        float luminanceSum = 0.0f;
+        float luminanceSquaredSum = 0.0f;
+    };
+
+    const int wgSizePerGroup = qMax(1, options.indirectLightWorkgroupSize);
+    int wgCount = sampleCount / wgSizePerGroup;
+    if (sampleCount % wgSizePerGroup)
+        ++wgCount;
+
+    QVarLengthArray<QFuture<WorkgroupResult>, 64> wg(wgCount);
+
+    for (int wgIdx = 0; wgIdx < wgCount; ++wgIdx) {
+        const int beginIdx = wgIdx * wgSizePerGroup;
+        const int endIdx = qMin(beginIdx + wgSizePerGroup, sampleCount);
+
+        wg[wgIdx] = QtConcurrent::run([this, beginIdx, endIdx, &lmPix] {
+            WorkgroupResult wgResult;
+            for (int sampleIdx = beginIdx; sampleIdx < endIdx; ++sampleIdx) {
+                QVector3D position = lmPix.worldPos;
+                QVector3D normal = lmPix.normal;
+                QVector3D throughput(1.0f, 1.0f, 1.0f);
+                QVector3D sampleResult;
+
+                for (int bounce = 0; bounce < options.indirectLightBounces; ++bounce) {
+                    if (options.useAdaptiveBias)
+                        position += vectorSign(normal) * vectorAbs(position * 0.0000002f);
+
+                    // get a sample using a cosine-weighted hemisphere sampler
+                    const QVector3D sample = cosWeightedHemisphereSample();
+
+                    // transform to the point's local coordinate system
+                    const QVector3D v0 = qFuzzyCompare(qAbs(normal.z()), 1.0f)
+                            ? QVector3D(0.0f, 1.0f, 0.0f)
+                            : QVector3D(0.0f, 0.0f, 1.0f);
+                    const QVector3D tangent = QVector3D::crossProduct(v0, normal).normalized();
+                    const QVector3D bitangent = QVector3D::crossProduct(tangent, normal).normalized();
+                    QVector3D direction(
+                                tangent.x() * sample.x() + bitangent.x() * sample.y() + normal.x() * sample.z(),
+                                tangent.y() * sample.x() + bitangent.y() * sample.y() + normal.y() * sample.z(),
+                                tangent.z() * sample.x() + bitangent.z() * sample.y() + normal.z() * sample.z());
+                    direction.normalize();
+
+                    // probability distribution function
+                    const float NdotL = qMax(0.0f, QVector3D::dotProduct(normal, direction));
+                    const float pdf = NdotL / float(M_PI);
+                    if (qFuzzyIsNull(pdf))
+                        break;
+
+                    // shoot ray, stop if no hit
+                    RayHit ray(position, direction, options.bias);
+                    if (!ray.intersect(rscene))
+                        break;
+
+                    // see what (sub)mesh and which texel it intersected with
+                    const LightmapEntry &hitEntry = texelForLightmapUV(ray.rayhit.hit.geomID,
+                                                                       ray.rayhit.hit.u,
+                                                                       ray.rayhit.hit.v);
+
+                    // won't bounce further from a back face
+                    const bool hitBackFace = QVector3D::dotProduct(hitEntry.normal, direction) > 0.0f;
+                    if (hitBackFace)
+                        break;
+
+                    // the BRDF of a diffuse surface is albedo / PI
+                    const QVector3D brdf = hitEntry.baseColor.toVector3D() / float(M_PI);
+
+                    // calculate result for this bounce
+                    sampleResult += throughput * hitEntry.emission;
+                    throughput *= brdf * NdotL / pdf;
+                    sampleResult += throughput * hitEntry.directLight;
+
+                    // stop if we guess there's no point in bouncing further
+                    // (low throughput path wouldn't contribute much)
+                    const float p = qMax(qMax(throughput.x(), throughput.y()), throughput.z());
+                    if (p < uniformRand())
+                        break;
+
+                    // was not terminated: boost the energy by the probability to be terminated
+                    throughput /= p;
+
+                    // next bounce starts from the hit's position
+                    position = hitEntry.worldPos;
+                    normal = hitEntry.normal;
+                }
+
+                // the luminance moments are used to estimate the noise of the texel
+                const float luminance = QVector3D::dotProduct(sampleResult, QVector3D(0.2126f, 0.7152f, 0.0722f));
+                wgResult.sum += sampleResult;
+                wgResult.luminanceSum += luminance;
+                wgResult.luminanceSquaredSum += luminance * luminance;
+            }
+            return wgResult;
+        });
+    }
+
+    for (const auto &future : wg) {
+        const WorkgroupResult result = future.result();
+        texel.sum += result.sum;
+        texel.luminanceSum += result.luminanceSum;
+        texel.luminanceSquaredSum += result.luminanceSquaredSum;
+    }
+    texel.sampleCount += quint32(sampleCount);
+}
+
 void QSSGLightmapperPrivate::computeIndirectLight()
 {
     sendOutputInfo(QSSGLightmapper::BakingStatus::Progress, QStringLiteral("Computing indirect lighting..."));
@@ -1162,146 +1303,207 @@ void QSSGLightmapperPrivate::computeIndirectLight()
 
     const int bakedLightingModelCount = bakedLightingModels.size();
 
-    for (int lmIdx = 0; lmIdx < bakedLightingModelCount; ++lmIdx) {
-        // here we only care about the models that will store the lightmap image persistently
-        if (!bakedLightingModels[lmIdx].model->hasLightmap())
-            continue;
-
-        const QSSGBakedLightingModel &lm(bakedLightingModels[lmIdx]);
-        Lightmap &lightmap(lightmaps[lmIdx]);
-        int texelsDone = 0;
-        sendOutputInfo(QSSGLightmapper::BakingStatus::Progress, QStringLiteral("Total texels to compute for model %1: %2").
-                                                              arg(lm.model->debugObjectName).
-                                                              arg(lightmap.entries.size()));
-        QElapsedTimer indirectLightTimer;
-        indirectLightTimer.start();
+    // The samples are taken in passes over all the lightmaps. Each texel keeps the sum of its
+    // samples, so a pass can be interrupted at any texel. With more than one pass the baking
+    // is progressive: the lightmaps and a checkpoint of the accumulated samples are written
+    // after each pass, and a later bake of the same scene continues from the checkpoint.
+    const int passCount = qBound(1, options.indirectLightPasses, qMax(1, options.indirectLightSamples));
+    const int samplesPerPass = (options.indirectLightSamples + passCount - 1) / passCount;
+    const bool progressive = passCount > 1;
+    const quint64 fingerprint = progressive ? sceneFingerprint() : 0;
 
-        // indirect lighting is slow, so parallelize per groups of samples,
-        // e.g. if sample count is 256 and workgroup size is 32, then do up to
-        // 8 sets in parallel, each calculating 32 samples (how many of the 8
-        // are really done concurrently that's up to the thread pool to manage)
+    for (int lmIdx = 0; lmIdx < bakedLightingModelCount; ++lmIdx) {
+        if (bakedLightingModels[lmIdx].model->hasLightmap())
+            lightmaps[lmIdx].indirectLight.fill(IndirectLightTexel(), lightmaps[lmIdx].entries.size());
+    }
 
-        int wgSizePerGroup = qMax(1, options.indirectLightWorkgroupSize);
-        int wgCount = options.indirectLightSamples / wgSizePerGroup;
-        if (options.indirectLightSamples % wgSizePerGroup)
-            ++wgCount;
+    if (progressive && loadIndirectLightCheckpoints(fingerprint))
+        sendOutputInfo(QSSGLightmapper::BakingStatus::Progress, QStringLiteral("Resuming indirect lighting from checkpoint"));
 
-        QVector<QFuture<QVector3D>> wg(wgCount);
+    for (int pass = 0; pass < passCount; ++pass) {
+        const quint32 passSampleTarget = quint32(qMin((pass + 1) * samplesPerPass, options.indirectLightSamples));
+        if (progressive)
+            sendOutputInfo(QSSGLightmapper::BakingStatus::Progress, QStringLiteral("Indirect lighting pass %1 of %2").
+                                                                  arg(pass + 1).
+                                                                  arg(passCount));
 
-        sendOutputInfo(QSSGLightmapper::BakingStatus::Progress, QStringLiteral("Computing indirect lighting for model %1 with key %2").
-                                                              arg(lm.model->debugObjectName).
-                                                              arg(lm.model->lightmapKey));
-        sendOutputInfo(QSSGLightmapper::BakingStatus::Progress, QStringLiteral("Sample count: %1, Workgroup size: %2, Max bounces: %3, Multiplier: %4").
-                                                              arg(options.indirectLightSamples).
-                                                              arg(wgSizePerGroup).
-                                                              arg(options.indirectLightBounces).
-                                                              arg(options.indirectLightFactor));
-        for (LightmapEntry &lmPix : lightmap.entries) {
-            if (!lmPix.isValid())
+        for (int lmIdx = 0; lmIdx < bakedLightingModelCount; ++lmIdx) {
+            // here we only care about the models that will store the lightmap image persistently
+            if (!bakedLightingModels[lmIdx].model->hasLightmap())
                 continue;
 
-            for (int wgIdx = 0; wgIdx < wgCount; ++wgIdx) {
-                const int beginIdx = wgIdx * wgSizePerGroup;
-                const int endIdx = qMin(beginIdx + wgSizePerGroup, options.indirectLightSamples);
-
-                wg[wgIdx] = QtConcurrent::run([this, beginIdx, endIdx, &lmPix] {
-                    QVector3D wgResult;
-                    for (int sampleIdx = beginIdx; sampleIdx < endIdx; ++sampleIdx) {
-                        QVector3D position = lmPix.worldPos;
-                        QVector3D normal = lmPix.normal;
-                        QVector3D throughput(1.0f, 1.0f, 1.0f);
-                        QVector3D sampleResult;
-
-                        for (int bounce = 0; bounce < options.indirectLightBounces; ++bounce) {
-                            if (options.useAdaptiveBias)
-                                position += vectorSign(normal) * vectorAbs(position * 0.0000002f);
-
-                            // get a sample using a cosine-weighted hemisphere sampler
-                            const QVector3D sample = cosWeightedHemisphereSample();
-
-                            // transform to the point's local coordinate system
-                            const QVector3D v0 = qFuzzyCompare(qAbs(normal.z()), 1.0f)
-                                    ? QVector3D(0.0f, 1.0f, 0.0f)
-                                    : QVector3D(0.0f, 0.0f, 1.0f);
-                            const QVector3D tangent = QVector3D::crossProduct(v0, normal).normalized();
-                            const QVector3D bitangent = QVector3D::crossProduct(tangent, normal).normalized();
-                            QVector3D direction(
-                                        tangent.x() * sample.x() + bitangent.x() * sample.y() + normal.x() * sample.z(),
-                                        tangent.y() * sample.x() + bitangent.y() * sample.y() + normal.y() * sample.z(),
-                                        tangent.z() * sample.x() + bitangent.z() * sample.y() + normal.z() * sample.z());
-                            direction.normalize();
-
-                            // probability distribution function
-                            const float NdotL = qMax(0.0f, QVector3D::dotProduct(normal, direction));
-                            const float pdf = NdotL / float(M_PI);
-                            if (qFuzzyIsNull(pdf))
-                                break;
-
-                            // shoot ray, stop if no hit
-                            RayHit ray(position, direction, options.bias);
-                            if (!ray.intersect(rscene))
-                                break;
-
-                            // see what (sub)mesh and which texel it intersected with
-                            const LightmapEntry &hitEntry = texelForLightmapUV(ray.rayhit.hit.geomID,
-                                                                               ray.rayhit.hit.u,
-                                                                               ray.rayhit.hit.v);
-
-                            // won't bounce further from a back face
-                            const bool hitBackFace = QVector3D::dotProduct(hitEntry.normal, direction) > 0.0f;
-                            if (hitBackFace)
-                                break;
-
-                            // the BRDF of a diffuse surface is albedo / PI
-                            const QVector3D brdf = hitEntry.baseColor.toVector3D() / float(M_PI);
-
-                            // calculate result for this bounce
-                            sampleResult += throughput * hitEntry.emission;
-                            throughput *= brdf * NdotL / pdf;
-                            sampleResult += throughput * hitEntry.directLight;
-
-                            // stop if we guess there's no point in bouncing further
-                            // (low throughput path wouldn't contribute much)
-                            const float p = qMax(qMax(throughput.x(), throughput.y()), throughput.z());
-                            if (p < uniformRand())
-                                break;
-
-                            // was not terminated: boost the energy by the probability to be terminated
-                            throughput /= p;
-
-                            // next bounce starts from the hit's position
-                            position = hitEntry.worldPos;
-                            normal = hitEntry.normal;
-                        }
+            const QSSGBakedLightingModel &lm(bakedLightingModels[lmIdx]);
+            Lightmap &lightmap(lightmaps[lmIdx]);
+            int texelsDone = 0;
+            int texelsConverged = 0;
+            sendOutputInfo(QSSGLightmapper::BakingStatus::Progress, QStringLiteral("Total texels to compute for model %1: %2").
+                                                                  arg(lm.model->debugObjectName).
+                                                                  arg(lightmap.entries.size()));
+            QElapsedTimer indirectLightTimer;
+            indirectLightTimer.start();
+
+            sendOutputInfo(QSSGLightmapper::BakingStatus::Progress, QStringLiteral("Computing indirect lighting for model %1 with key %2").
+                                                                  arg(lm.model->debugObjectName).
+                                                                  arg(lm.model->lightmapKey));
+            sendOutputInfo(QSSGLightmapper::BakingStatus::Progress, QStringLiteral("Sample count: %1, Workgroup size: %2, Max bounces: %3, Multiplier: %4").
+                                                                  arg(options.indirectLightSamples).
+                                                                  arg(qMax(1, options.indirectLightWorkgroupSize)).
+                                                                  arg(options.indirectLightBounces).
+                                                                  arg(options.indirectLightFactor));
+            for (qsizetype texelIdx = 0, texelCount = lightmap.entries.size(); texelIdx < texelCount; ++texelIdx) {
+                const LightmapEntry &lmPix(lightmap.entries[texelIdx]);
+                if (!lmPix.isValid())
+                    continue;
 
-                        wgResult += sampleResult;
+                IndirectLightTexel &texel(lightmap.indirectLight[texelIdx]);
+                if (!texel.converged && texel.sampleCount < passSampleTarget) {
+                    computeIndirectLightForTexel(lmPix, texel, int(passSampleTarget - texel.sampleCount));
+
+                    // Stop sampling the texel once the standard error of its mean luminance
+                    // is small enough compared to the mean.
+                    if (options.indirectLightNoiseThreshold > 0.0f && pass + 1 < passCount) {
+                        const float n = float(texel.sampleCount);
+                        const float mean = texel.luminanceSum / n;
+                        const float variance = qMax(0.0f, texel.luminanceSquaredSum / n - mean * mean);
+                        const float standardError = std::sqrt(variance / n);
+                        texel.converged = standardError <= options.indirectLightNoiseThreshold * qMax(mean, 0.001f);
                     }
-                    return wgResult;
-                });
+                }
+                texelsConverged += texel.converged ? 1 : 0;
+
+                ++texelsDone;
+                if (texelsDone % 10000 == 0)
+                    sendOutputInfo(QSSGLightmapper::BakingStatus::Progress, QStringLiteral("%1 texels left").
+                                                                          arg(lightmap.entries.size() - texelsDone));
+
+                if (bakingControl.cancelled) {
+                    // keep what was computed so far, the next bake continues from here
+                    if (progressive)
+                        storeIndirectLightCheckpoints(fingerprint);
+                    return;
+                }
             }
+            sendOutputInfo(QSSGLightmapper::BakingStatus::Progress, QStringLiteral("Indirect lighting computed for model %1 with key %2 in %3 ms").
+                                                                  arg(lm.model->debugObjectName).
+                                                                  arg(lm.model->lightmapKey).
+                                                                  arg(indirectLightTimer.elapsed()));
+            if (options.indirectLightNoiseThreshold > 0.0f && progressive)
+                sendOutputInfo(QSSGLightmapper::BakingStatus::Progress, QStringLiteral("%1 texels below the noise threshold").
+                                                                      arg(texelsConverged));
+        }
 
-            QVector3D totalIndirect;
-            for (const auto &future : wg)
-                totalIndirect += future.result();
+        // Write out the intermediate results, the final ones are written by bake()
+        if (progressive && pass + 1 < passCount) {
+            if (!storeIndirectLightCheckpoints(fingerprint) || !postProcess() || !storeLightmaps())
+                sendOutputInfo(QSSGLightmapper::BakingStatus::Warning, QStringLiteral("Failed to write the intermediate results of pass %1").
+                                                                     arg(pass + 1));
+        }
+    }
 
-            lmPix.allLight += totalIndirect * options.indirectLightFactor / options.indirectLightSamples;
+    sendOutputInfo(QSSGLightmapper::BakingStatus::Progress, QStringLiteral("Indirect light computation completed in %1 ms").
+                                                          arg(fullIndirectLightTimer.elapsed()));
+}
 
-            ++texelsDone;
-            if (texelsDone % 10000 == 0)
-                sendOutputInfo(QSSGLightmapper::BakingStatus::Progress, QStringLiteral("%1 texels left").
-                                                                      arg(lightmap.entries.size() - texelsDone));
+static const quint32 LM_CHECKPOINT_MAGIC = 0x514c4d43; // 'QLMC'
+static const quint32 LM_CHECKPOINT_VERSION = 1;
 
-            if (bakingControl.cancelled)
-                return;
+quint64 QSSGLightmapperPrivate::sceneFingerprint() const
+{
+    // Anything that changes the light arriving at the texels invalidates the checkpoints:
+    // the texel positions, materials and direct light of all the lightmaps, and the
+    // settings the samples are taken with.
+    size_t seed = qHashMulti(0, options.indirectLightSamples, options.indirectLightBounces,
+                             options.useAdaptiveBias, options.bias, lightmaps.size());
+    for (const Lightmap &lightmap : lightmaps) {
+        seed = qHashMulti(seed, lightmap.pixelSize.width(), lightmap.pixelSize.height());
+        for (const LightmapEntry &lmPix : lightmap.entries) {
+            seed = qHashBits(&lmPix.worldPos, sizeof(QVector3D), seed);
+            seed = qHashBits(&lmPix.normal, sizeof(QVector3D), seed);
+            seed = qHashBits(&lmPix.baseColor, sizeof(QVector4D), seed);
+            seed = qHashBits(&lmPix.emission, sizeof(QVector3D), seed);
+            seed = qHashBits(&lmPix.directLight, sizeof(QVector3D), seed);
         }
-        sendOutputInfo(QSSGLightmapper::BakingStatus::Progress, QStringLiteral("Indirect lighting computed for model %1 with key %2 in %3 ms").
-                                                              arg(lm.model->debugObjectName).
-                                                              arg(lm.model->lightmapKey).
-                                                              arg(indirectLightTimer.elapsed()));
     }
+    return quint64(seed);
+}
 
-    sendOutputInfo(QSSGLightmapper::BakingStatus::Progress, QStringLiteral("Indirect light computation completed in %1 ms").
-                                                          arg(fullIndirectLightTimer.elapsed()));
+bool QSSGLightmapperPrivate::loadIndirectLightCheckpoints(quint64 fingerprint)
+{
+    bool loaded = false;
+    for (int lmIdx = 0, lmCount = bakedLightingModels.size(); lmIdx < lmCount; ++lmIdx) {
+        const QSSGRenderModel &model(*bakedLightingModels[lmIdx].model);
+        if (!model.hasLightmap())
+            continue;
+
+        QFile f(QSSGLightmapper::lightmapAssetPathForSave(model, QSSGLightmapper::LightmapAsset::IndirectLightCheckpoint,
+                                                          lightmapOutputFolder(model)));
+        if (!f.open(QIODevice::ReadOnly))
+            continue;
+
+        Lightmap &lightmap(lightmaps[lmIdx]);
+        QDataStream ds(&f);
+        quint32 magic = 0;
+        quint32 version = 0;
+        quint64 storedFingerprint = 0;
+        qint64 texelCount = 0;
+        ds >> magic >> version >> storedFingerprint >> texelCount;
+        if (magic != LM_CHECKPOINT_MAGIC || version != LM_CHECKPOINT_VERSION
+                || storedFingerprint != fingerprint || texelCount != lightmap.indirectLight.size()) {
+            sendOutputInfo(QSSGLightmapper::BakingStatus::Progress, QStringLiteral("Ignoring outdated checkpoint %1").
+                                                                  arg(f.fileName()));
+            continue;
+        }
+
+        QVector<IndirectLightTexel> texels(texelCount);
+        const int byteSize = int(texelCount * sizeof(IndirectLightTexel));
+        if (ds.readRawData(reinterpret_cast<char *>(texels.data()), byteSize) != byteSize) {
+            sendOutputInfo(QSSGLightmapper::BakingStatus::Warning, QStringLiteral("Failed to read checkpoint %1").
+                                                                 arg(f.fileName()));
+            continue;
+        }
+        lightmap.indirectLight = std::move(texels);
+        loaded = true;
+    }
+    return loaded;
+}
+
+bool QSSGLightmapperPrivate::storeIndirectLightCheckpoints(quint64 fingerprint)
+{
+    for (int lmIdx = 0, lmCount = bakedLightingModels.size(); lmIdx < lmCount; ++lmIdx) {
+        const QSSGRenderModel &model(*bakedLightingModels[lmIdx].model);
+        if (!model.hasLightmap())
+            continue;
+
+        // write to a temporary file first, the previous checkpoint stays usable until then
+        QSaveFile f(QSSGLightmapper::lightmapAssetPathForSave(model, QSSGLightmapper::LightmapAsset::IndirectLightCheckpoint,
+                                                              lightmapOutputFolder(model)));
+        if (!f.open(QIODevice::WriteOnly)) {
+            sendOutputInfo(QSSGLightmapper::BakingStatus::Warning, QStringLiteral("Failed to create checkpoint %1").
+                                                                 arg(f.fileName()));
+            return false;
+        }
+
+        const Lightmap &lightmap(lightmaps[lmIdx]);
+        QDataStream ds(&f);
+        ds << LM_CHECKPOINT_MAGIC << LM_CHECKPOINT_VERSION << fingerprint << qint64(lightmap.indirectLight.size());
+        ds.writeRawData(reinterpret_cast<const char *>(lightmap.indirectLight.constData()),
+                        int(lightmap.indirectLight.size() * sizeof(IndirectLightTexel)));
+        if (!f.commit()) {
+            sendOutputInfo(QSSGLightmapper::BakingStatus::Warning, QStringLiteral("Failed to write checkpoint %1").
+                                                                 arg(f.fileName()));
+            return false;
+        }
+    }
+    return true;
+}
+
+void QSSGLightmapperPrivate::removeIndirectLightCheckpoints()
+{
+    for (const QSSGBakedLightingModel &lm : std::as_const(bakedLightingModels)) {
+        if (lm.model->hasLightmap())
+            QFile::remove(QSSGLightmapper::lightmapAssetPathForSave(*lm.model, QSSGLightmapper::LightmapAsset::IndirectLightCheckpoint,
+                                                                    lightmapOutputFolder(*lm.model)));
+    }
 }
 
 struct Edge {
@@ -1450,10 +1652,17 @@ bool QSSGLightmapperPrivate::postProcess()
         // Assemble the RGBA32F image from the baker data structures
         QByteArray lightmapFP32(lightmap.entries.size() * 4 * sizeof(float), Qt::Uninitialized);
         float *lightmapFloatPtr = reinterpret_cast<float *>(lightmapFP32.data());
-        for (const LightmapEntry &lmPix : std::as_const(lightmap.entries)) {
-            *lightmapFloatPtr++ = lmPix.allLight.x();
-            *lightmapFloatPtr++ = lmPix.allLight.y();
-            *lightmapFloatPtr++ = lmPix.allLight.z();
+        for (qsizetype texelIdx = 0, texelCount = lightmap.entries.size(); texelIdx < texelCount; ++texelIdx) {
+            const LightmapEntry &lmPix(lightmap.entries[texelIdx]);
+            QVector3D light = lmPix.allLight;
+            if (!lightmap.indirectLight.isEmpty()) {
+                const IndirectLightTexel &texel(lightmap.indirectLight[texelIdx]);
+                if (texel.sampleCount > 0)
+                    light += texel.sum * options.indirectLightFactor / float(texel.sampleCount);
+            }
+            *lightmapFloatPtr++ = light.x();
+            *lightmapFloatPtr++ = light.y();
+            *lightmapFloatPtr++ = light.z();
             *lightmapFloatPtr++ = lmPix.isValid() ? 1.0f : 0.0f;
         }
 
@@ -1611,10 +1820,7 @@ bool QSSGLightmapperPrivate::storeLightmaps()
         QElapsedTimer writeTimer;
         writeTimer.start();
 
-        // An empty outputFolder equates to working directory
-        QString outputFolder;
-        if (!lm.model->lightmapLoadPath.startsWith(QStringLiteral(":/")))
-            outputFolder = lm.model->lightmapLoadPath;
+        const QString outputFolder = lightmapOutputFolder(*lm.model);
 
         const QString fn = QSSGLightmapper::lightmapAssetPathForSave(*lm.model, QSSGLightmapper::LightmapAsset::LightmapImage, outputFolder);
         const QByteArray fns = fn.toUtf8();
@@ -1754,6 +1960,9 @@ bool QSSGLightmapper::bake()
         return false;
     }
 
+    // the bake is complete, there is nothing to resume anymore
+    d->removeIndirectLightCheckpoints();
+
     d->sendOutputInfo(QSSGLightmapper::BakingStatus::Progress, QStringLiteral("Baking took %1 ms").arg(totalTimer.elapsed()));
     d->sendOutputInfo(QSSGLightmapper::BakingStatus::Complete, std::nullopt);
     return true;
@@ -1828,6 +2037,9 @@ QString QSSGLightmapper::lightmapAssetPathForSave(const QSSGRenderModel &model,
     case LightmapAsset::MeshWithLightmapUV:
         result += QStringLiteral("qlm_%1.mesh").arg(model.lightmapKey);
         break;
+    case LightmapAsset::IndirectLightCheckpoint:
+        result += QStringLiteral("qlm_%1.checkpoint").arg(model.lightmapKey);
+        break;
     default:
         result += lightmapAssetPathForSave(asset, outputFolder);
         break;
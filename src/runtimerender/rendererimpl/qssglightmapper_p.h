@@ -37,6 +37,8 @@ struct QSSGLightmapperOptions
     int indirectLightWorkgroupSize = 32;
     int indirectLightBounces = 3;
     float indirectLightFactor = 1.0f;
+    int indirectLightPasses = 1;
+    float indirectLightNoiseThreshold = 0.0f;
 };
 
 class QSSGLightmapper
@@ -68,7 +70,8 @@ public:
     enum class LightmapAsset {
         LightmapImage,
         MeshWithLightmapUV,
-        LightmapImageList
+        LightmapImageList,
+        IndirectLightCheckpoint
     };
     static QString lightmapAssetPathForLoad(const QSSGRenderModel &model, LightmapAsset asset);
     static QString lightmapAssetPathForSave(const QSSGRenderModel &model, LightmapAsset asset, const QString& outputFolder = {});
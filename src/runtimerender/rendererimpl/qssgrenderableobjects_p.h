@@ -193,6 +193,8 @@ struct QSSGRenderableObjectHandle
     {}
     QSSGRenderableObject *obj = nullptr;
     float cameraDistanceSq = 0.0f;
+    // Index of obj->globalBounds in QSSGLayerRenderData::renderableBounds, -1 when not recorded there
+    qint32 boundsIndex = -1;
 };
 Q_DECLARE_TYPEINFO(QSSGRenderableObjectHandle, Q_PRIMITIVE_TYPE);
 
@@ -245,6 +247,8 @@ struct QSSGRenderableObject
 
 Q_STATIC_ASSERT(std::is_trivially_destructible<QSSGRenderableObject>::value);
 
+struct QSSGClippingFrustum;
+
 // Different subsets from the same model will get the same
 // model context so we can generate the MVP and normal matrix once
 // and only once per subset.
@@ -254,6 +258,12 @@ struct QSSGModelContext
     QMatrix4x4 modelViewProjection;
     QMatrix3x3 normalMatrix;
     QRhiTexture *lightmapTexture = nullptr;
+    qint32 spatialIndexLeaf = -1;
+    bool globalValuesDirty = false; // The model's global values were recalculated this frame
+    // Set for instanced models that can be culled per instance against the camera
+    // frustum, together with the bounds of all subsets of the mesh (in mesh space).
+    const QSSGClippingFrustum *instanceCullingFrustum = nullptr;
+    QSSGBounds3 instanceCullingBounds;
 
     QSSGModelContext(const QSSGRenderModel &inModel, const QMatrix4x4 &inViewProjection) : model(inModel)
     {
@@ -284,6 +294,10 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGSubsetRenderable : public QSSGRenderabl
     const QSSGModelContext &modelContext;
     const QSSGRenderSubset &subset;
     QRhiBuffer *instanceBuffer = nullptr;
+    // Set by prepareInstancing(). The instance buffer holds the instances that passed
+    // the level of detail range, the ones in the camera frustum first.
+    quint32 instanceCount = 0;
+    quint32 visibleInstanceCount = 0;
     float opacity;
     const QSSGRenderGraphObject &material;
     QSSGRenderableImage *firstImage;
@@ -297,6 +311,7 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGSubsetRenderable : public QSSGRenderabl
         struct {
             QRhiGraphicsPipeline *pipeline = nullptr;
             QRhiShaderResourceBindings *srb = nullptr;
+            QSSGRhiUniformBufferOffsets ubufOffsets;
         } mainPass;
         struct {
             QRhiGraphicsPipeline *pipeline = nullptr;
@@ -309,6 +324,7 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGSubsetRenderable : public QSSGRenderabl
         struct {
             QRhiGraphicsPipeline *pipeline = nullptr;
             QRhiShaderResourceBindings *srb[6] = {};
+            QSSGRhiUniformBufferOffsets ubufOffsets[6];
         } reflectionPass;
     } rhiRenderData;
 
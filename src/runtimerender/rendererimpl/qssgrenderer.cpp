@@ -19,6 +19,8 @@
 #include <QtQuick3DRuntimeRender/private/qssgrendertexturedata_p.h>
 #include <QtQuick3DRuntimeRender/private/qssglayerrenderdata_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrhiparticles_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrenderinstancetable_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrenderinstancebvh_p.h>
 
 #include <QtQuick3DUtils/private/qquick3dprofiler_p.h>
 #include <QtQuick3DUtils/private/qssgdataref_p.h>
@@ -27,6 +29,8 @@
 
 #include <QtCore/QMutexLocker>
 #include <QtCore/QBitArray>
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QThread>
 
 #include <cstdlib>
 #include <algorithm>
@@ -157,12 +161,21 @@ void QSSGRenderer::rhiPrepare(QSSGRenderLayer &inLayer)
         // that does can and should be done in the rhi prepare phase.
         // It is assumed that passes are sorted in the list with regards to
         // execution order.
+        QSSGRhiUniformBufferRing *uniformBufferRing = theRenderData->uniformBufferRing;
+        if (uniformBufferRing)
+            uniformBufferRing->beginFrame();
         const auto &activePasses = theRenderData->activePasses;
         for (const auto &pass : activePasses) {
             pass->renderPrep(this, *theRenderData);
-            if (pass->passType() == QSSGRenderPass::Type::PreMain)
+            if (pass->passType() == QSSGRenderPass::Type::PreMain) {
+                // The uniform data written so far must be in place before recording the draw calls
+                if (uniformBufferRing)
+                    uniformBufferRing->flush();
                 pass->renderPass(this);
+            }
         }
+        if (uniformBufferRing)
+            uniformBufferRing->endFrame();
 
         endLayerRender();
     }
@@ -249,7 +262,8 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGRenderer::generateRhiShaderPipelineImpl(QSSGS
                                                                            const QSSGRef<QSSGProgramGenerator> &shaderProgramGenerator,
                                                                            QSSGShaderDefaultMaterialKeyProperties &shaderKeyProperties,
                                                                            const QSSGShaderFeatures &featureSet,
-                                                                           QByteArray &shaderString)
+                                                                           QByteArray &shaderString,
+                                                                           QSSGShaderCache::CompileMode compileMode)
 {
     shaderString = logPrefix();
     QSSGShaderDefaultMaterialKey theKey(renderable.shaderDescription);
@@ -268,6 +282,10 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGRenderer::generateRhiShaderPipelineImpl(QSSGS
     if (maybePipeline)
         return maybePipeline;
 
+    // Still being baked in the background, no need to generate it again.
+    if (shaderCache->isCompilationPending(shaderString, featureSet))
+        return {};
+
     // Check if there's a pre-built (offline generated) shader for available.
     const QByteArray qsbcKey = QQsbCollection::EntryDesc::generateSha(shaderString, QQsbCollection::toFeatureSet(featureSet));
     const QQsbCollection::EntryMap &pregenEntries = shaderLibraryManager->m_preGeneratedShaderEntries;
@@ -297,7 +315,8 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGRenderer::generateRhiShaderPipelineImpl(QSSGS
                                                                   renderable.lights,
                                                                   renderable.firstImage,
                                                                   shaderLibraryManager,
-                                                                  shaderCache);
+                                                                  shaderCache,
+                                                                  compileMode);
 }
 
 QSSGRef<QSSGRhiShaderPipeline> QSSGRenderer::generateRhiShaderPipeline(QSSGSubsetRenderable &inRenderable,
@@ -306,7 +325,11 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGRenderer::generateRhiShaderPipeline(QSSGSubse
     const QSSGRef<QSSGShaderCache> &theCache = m_contextInterface->shaderCache();
     const auto &shaderProgramGenerator = contextInterface()->shaderProgramGenerator();
     const auto &shaderLibraryManager = contextInterface()->shaderLibraryManager();
-    return generateRhiShaderPipelineImpl(inRenderable, shaderLibraryManager, theCache, shaderProgramGenerator, m_defaultMaterialShaderKeyProperties, inFeatureSet, m_generatedShaderString);
+    // Opt-in, as renderables are skipped until their shaders are ready
+    static const bool asyncCompilation = qEnvironmentVariableIntValue("QT_QUICK3D_ASYNC_SHADER_COMPILATION");
+    const auto compileMode = asyncCompilation ? QSSGShaderCache::CompileMode::Asynchronous
+                                              : QSSGShaderCache::CompileMode::Synchronous;
+    return generateRhiShaderPipelineImpl(inRenderable, shaderLibraryManager, theCache, shaderProgramGenerator, m_defaultMaterialShaderKeyProperties, inFeatureSet, m_generatedShaderString, compileMode);
 }
 
 void QSSGRenderer::beginFrame(QSSGRenderLayer *layer)
@@ -420,7 +443,10 @@ void QSSGRenderer::endLayerRender()
 
 bool QSSGRenderer::rendererRequestsFrames() const
 {
-    return m_progressiveAARenderRequest;
+    return m_progressiveAARenderRequest
+            || m_contextInterface->shaderCache()->hasPendingCompilations()
+            || m_contextInterface->bufferManager()->hasPendingImageLoads()
+            || m_contextInterface->bufferManager()->hasPendingMeshLoads();
 }
 
 using RenderableList = QVarLengthArray<const QSSGRenderNode *>;
@@ -443,6 +469,10 @@ void QSSGRenderer::getLayerHitObjectList(const QSSGRenderLayer &layer,
     for (const auto &childNode : layer.children)
         dfs(childNode, renderables);
 
+    // Skip the models the spatial index knows the ray can't hit.
+    if (layer.renderData && layer.renderData->spatialIndex)
+        layer.renderData->spatialIndex->removeRayMisses(ray, renderables);
+
     for (int idx = renderables.size() - 1; idx >= 0; --idx) {
         const auto &pickableObject = renderables.at(idx);
         if (inPickEverything || pickableObject->getLocalState(QSSGRenderNode::LocalState::Pickable))
@@ -477,6 +507,24 @@ void QSSGRenderer::intersectRayWithSubsetRenderable(const QSSGRef<QSSGBufferMana
     if (!mesh)
         return;
 
+    // The mesh's BVH may still be built in the background. Until it is ready only the subset
+    // bounds are hit tested, unless QT_QUICK3D_PICK_BVH_WAIT_TIMEOUT (in ms) is set, in which
+    // case we wait up to that long. The mutex is released while waiting, so that the render
+    // thread isn't blocked, and the mesh is looked up again after.
+    static const int bvhWaitTimeout = qEnvironmentVariableIntValue("QT_QUICK3D_PICK_BVH_WAIT_TIMEOUT");
+    if (!mesh->resolveBvh() && bvhWaitTimeout > 0 && mesh->bvhFuture.isValid() && !mesh->bvhFuture.isFinished()) {
+        const QFuture<QSSGMeshBVH *> bvhFuture = mesh->bvhFuture;
+        mutexLocker.unlock();
+        const QDeadlineTimer deadline(bvhWaitTimeout);
+        while (!bvhFuture.isFinished() && !deadline.hasExpired())
+            QThread::msleep(1);
+        mutexLocker.relock();
+        mesh = bufferManager->getMeshForPicking(model);
+        if (!mesh)
+            return;
+        mesh->resolveBvh();
+    }
+
     const auto &subMeshes = mesh->subsets;
     QSSGBounds3 modelBounds;
     for (const auto &subMesh : subMeshes)
@@ -488,7 +536,21 @@ void QSSGRenderer::intersectRayWithSubsetRenderable(const QSSGRef<QSSGBufferMana
     const bool instancing = model.instancing(); // && instancePickingEnabled
     int instanceCount = instancing ? model.instanceTable->count() : 1;
 
-    for (int instanceIndex = 0; instanceIndex < instanceCount; ++instanceIndex) {
+    // Only the instances whose bounds are hit by the ray are tested one by one
+    QVector<int> candidateInstances;
+    if (instancing) {
+        QSSGRenderInstanceTable &table = *model.instanceTable;
+        QSSGBounds3 localBounds = modelBounds;
+        localBounds.transform(model.localInstanceTransform);
+        QSSGRenderInstanceBvh *bvh = table.pickingBvh(localBounds);
+        bvh->update(table);
+        const auto tableRayData = QSSGRenderRay::createRayData(model.globalInstanceTransform, inRay);
+        bvh->intersect(tableRayData, candidateInstances);
+        instanceCount = candidateInstances.size();
+    }
+
+    for (int candidate = 0; candidate < instanceCount; ++candidate) {
+        const int instanceIndex = instancing ? candidateInstances.at(candidate) : 0;
 
         QMatrix4x4 modelTransform;
         if (instancing) {
@@ -513,17 +575,14 @@ void QSSGRenderer::intersectRayWithSubsetRenderable(const QSSGRef<QSSGBufferMana
         int resultSubset = 0;
         for (const auto &subMesh : subMeshes) {
             QSSGRenderRay::IntersectionResult result;
-            if (subMesh.bvhRoot) {
-                hit = QSSGRenderRay::intersectWithAABBv2(rayData, subMesh.bvhRoot->boundingData);
-                if (hit.intersects()) {
-                    results.clear();
-                    inRay.intersectWithBVH(rayData, subMesh.bvhRoot, mesh, results);
-                    float subMeshMinRayLength = std::numeric_limits<float>::max();
-                    for (const auto &subMeshResult : std::as_const(results)) {
-                        if (subMeshResult.rayLengthSquared < subMeshMinRayLength) {
-                            result = subMeshResult;
-                            subMeshMinRayLength = result.rayLengthSquared;
-                        }
+            if (subMesh.bvhRoot != QSSGMeshBVH::InvalidRoot && mesh->bvh) {
+                results.clear();
+                inRay.intersectWithBVH(rayData, mesh->bvh, subMesh.bvhRoot, results);
+                float subMeshMinRayLength = std::numeric_limits<float>::max();
+                for (const auto &subMeshResult : std::as_const(results)) {
+                    if (subMeshResult.rayLengthSquared < subMeshMinRayLength) {
+                        result = subMeshResult;
+                        subMeshMinRayLength = result.rayLengthSquared;
                     }
                 }
             } else {
@@ -610,10 +669,13 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGRenderer::getShaderPipelineForDefaultMaterial
         Q_QUICK3D_PROFILE_START(QQuick3DProfiler::Quick3DGenerateShader);
         shaderPipeline = generateRhiShaderPipeline(inRenderable, inFeatureSet);
         Q_QUICK3D_PROFILE_END_WITH_ID(QQuick3DProfiler::Quick3DGenerateShader, 0, inRenderable.material.profilingId);
-        // make skey useable as a key for the QHash (makes copies of materialKey and featureSet, instead of just referencing)
-        skey.detach();
-        // insert it no matter what, no point in trying over and over again
-        m_shaderMap.insert(skey, shaderPipeline);
+        // insert it no matter what, no point in trying over and over again, unless
+        // the shaders are still being compiled in the background
+        if (shaderPipeline || !m_contextInterface->shaderCache()->isCompilationPending(m_generatedShaderString, inFeatureSet)) {
+            // make skey useable as a key for the QHash (makes copies of materialKey and featureSet, instead of just referencing)
+            skey.detach();
+            m_shaderMap.insert(skey, shaderPipeline);
+        }
     } else {
         shaderPipeline = it.value();
     }
@@ -1299,12 +1361,25 @@ void RenderHelpers::rhiPrepareRenderable(QSSGRhiContext *rhiCtx,
                                                    : rhiCtx->drawCallData({ passKey, &modelNode,
                                                                             &subsetRenderable.material, 0, QSSGRhiDrawCallDataKey::Main }));
 
-            shaderPipeline->ensureCombinedMainLightsUniformBuffer(&dcd.ubuf);
-            char *ubufData = dcd.ubuf->beginFullDynamicBufferUpdateForCurrentFrame();
+            // With a uniform buffer ring the uniform data goes to a range of a
+            // buffer shared with the other draw calls, and the dcd only caches
+            // the srb and pipeline.
+            QSSGRhiUniformBufferRing::Allocation ubufAlloc;
+            if (inData.uniformBufferRing)
+                ubufAlloc = inData.uniformBufferRing->allocate(shaderPipeline->combinedMainLightsUniformDataSize());
+
+            char *ubufData = nullptr;
+            if (ubufAlloc.isValid()) {
+                ubufData = ubufAlloc.data;
+            } else {
+                shaderPipeline->ensureCombinedMainLightsUniformBuffer(&dcd.ubuf);
+                ubufData = dcd.ubuf->beginFullDynamicBufferUpdateForCurrentFrame();
+            }
             updateUniformsForDefaultMaterial(shaderPipeline, rhiCtx, ubufData, ps, subsetRenderable, *camera, nullptr, alteredModelViewProjection);
             if (blendParticles)
                 QSSGParticleRenderer::updateUniformsForParticleModel(shaderPipeline, ubufData, &subsetRenderable.modelContext.model, subsetRenderable.subset.offset);
-            dcd.ubuf->endFullDynamicBufferUpdateForCurrentFrame();
+            if (!ubufAlloc.isValid())
+                dcd.ubuf->endFullDynamicBufferUpdateForCurrentFrame();
 
             if (blendParticles)
                 QSSGParticleRenderer::prepareParticlesForModel(shaderPipeline, rhiCtx, bindings, &subsetRenderable.modelContext.model);
@@ -1359,12 +1434,23 @@ void RenderHelpers::rhiPrepareRenderable(QSSGRhiContext *rhiCtx,
             int instanceBufferBinding = setupInstancing(&subsetRenderable, ps, rhiCtx, cameraDirection, cameraPosition);
             ps->ia.bakeVertexInputLocations(*shaderPipeline, instanceBufferBinding);
 
-            bindings.addUniformBuffer(0, VISIBILITY_ALL, dcd.ubuf, 0, shaderPipeline->ub0Size());
+            QSSGRhiUniformBufferOffsets ubufOffsets;
+            if (ubufAlloc.isValid()) {
+                bindings.addUniformBufferWithDynamicOffset(0, VISIBILITY_ALL, ubufAlloc.buffer, shaderPipeline->ub0Size());
+                ubufOffsets.append(0, ubufAlloc.offset);
+                if (shaderPipeline->isLightingEnabled()) {
+                    bindings.addUniformBufferWithDynamicOffset(1, VISIBILITY_ALL, ubufAlloc.buffer,
+                                                               shaderPipeline->ub0LightDataSize());
+                    ubufOffsets.append(1, ubufAlloc.offset + shaderPipeline->ub0LightDataOffset());
+                }
+            } else {
+                bindings.addUniformBuffer(0, VISIBILITY_ALL, dcd.ubuf, 0, shaderPipeline->ub0Size());
 
-            if (shaderPipeline->isLightingEnabled()) {
-                bindings.addUniformBuffer(1, VISIBILITY_ALL, dcd.ubuf,
-                                          shaderPipeline->ub0LightDataOffset(),
-                                          shaderPipeline->ub0LightDataSize());
+                if (shaderPipeline->isLightingEnabled()) {
+                    bindings.addUniformBuffer(1, VISIBILITY_ALL, dcd.ubuf,
+                                              shaderPipeline->ub0LightDataOffset(),
+                                              shaderPipeline->ub0LightDataSize());
+                }
             }
 
             // Texture maps
@@ -1479,15 +1565,17 @@ void RenderHelpers::rhiPrepareRenderable(QSSGRhiContext *rhiCtx,
             QRhiShaderResourceBindings *&srb = dcd.srb;
             bool srbChanged = false;
             if (!srb || bindings != dcd.bindings) {
-                srb = rhiCtx->srb(bindings);
-                dcd.bindings = bindings;
+                rhiCtx->updateDrawCallSrb(dcd, bindings);
                 srbChanged = true;
             }
 
-            if (cubeFace >= 0)
+            if (cubeFace >= 0) {
                 subsetRenderable.rhiRenderData.reflectionPass.srb[cubeFace] = srb;
-            else
+                subsetRenderable.rhiRenderData.reflectionPass.ubufOffsets[cubeFace] = ubufOffsets;
+            } else {
                 subsetRenderable.rhiRenderData.mainPass.srb = srb;
+                subsetRenderable.rhiRenderData.mainPass.ubufOffsets = ubufOffsets;
+            }
 
             const QSSGGraphicsPipelineStateKey pipelineKey = QSSGGraphicsPipelineStateKey::create(*ps, renderPassDescriptor, srb);
             if (dcd.pipeline
@@ -1569,10 +1657,12 @@ void RenderHelpers::rhiRenderRenderable(QSSGRhiContext *rhiCtx,
 
         QRhiGraphicsPipeline *ps = subsetRenderable.rhiRenderData.mainPass.pipeline;
         QRhiShaderResourceBindings *srb = subsetRenderable.rhiRenderData.mainPass.srb;
+        const QSSGRhiUniformBufferOffsets *ubufOffsets = &subsetRenderable.rhiRenderData.mainPass.ubufOffsets;
 
         if (cubeFace >= 0) {
             ps = subsetRenderable.rhiRenderData.reflectionPass.pipeline;
             srb = subsetRenderable.rhiRenderData.reflectionPass.srb[cubeFace];
+            ubufOffsets = &subsetRenderable.rhiRenderData.reflectionPass.ubufOffsets[cubeFace];
         }
 
         if (!ps || !srb)
@@ -1584,7 +1674,7 @@ void RenderHelpers::rhiRenderRenderable(QSSGRhiContext *rhiCtx,
         QRhiCommandBuffer *cb = rhiCtx->commandBuffer();
         // QRhi optimizes out unnecessary binding of the same pipline
         cb->setGraphicsPipeline(ps);
-        cb->setShaderResources(srb);
+        cb->setShaderResources(srb, ubufOffsets->count, ubufOffsets->offsets);
 
         if (*needsSetViewport) {
             cb->setViewport(state.viewport);
@@ -1598,7 +1688,8 @@ void RenderHelpers::rhiRenderRenderable(QSSGRhiContext *rhiCtx,
         vertexBuffers[0] = QRhiCommandBuffer::VertexInput(vertexBuffer, 0);
         quint32 instances = 1;
         if ( subsetRenderable.modelContext.model.instancing()) {
-            instances = subsetRenderable.modelContext.model.instanceCount();
+            // Instances outside of the camera frustum are only drawn into reflection maps
+            instances = (cubeFace >= 0) ? subsetRenderable.instanceCount : subsetRenderable.visibleInstanceCount;
             // If the instance count is 0, the bail out before trying to do any
             // draw calls. Making an instanced draw call with a count of 0 is invalid
             // for Metal and likely other API's as well.
@@ -1639,6 +1730,104 @@ void RenderHelpers::rhiRenderRenderable(QSSGRhiContext *rhiCtx,
     }
 }
 
+// Whether what the renderable draws can change, or go outside of its global bounds, without its
+// node's global values changing. These casters are never culled and keep their shadow maps from
+// being cached.
+static bool hasDynamicShadowCasterGeometry(const QSSGSubsetRenderable &renderable)
+{
+    const QSSGRenderModel &model = renderable.modelContext.model;
+    if (model.instancing() || model.boneCount > 0 || model.particleBuffer != nullptr || renderable.subset.rhi.targetsTexture)
+        return true;
+    return renderable.type == QSSGRenderableObject::Type::CustomMaterialMeshSubset
+            && renderable.customMaterial().m_customShaderPresence.testFlag(QSSGRenderCustomMaterial::CustomShaderPresenceFlag::Vertex);
+}
+
+static QSSGClippingFrustum shadowCameraFrustum(const QSSGRenderCamera &camera, const QMatrix4x4 &viewProjection)
+{
+    QSSGClipPlane nearPlane;
+    const QMatrix3x3 theUpper33(camera.globalTransform.normalMatrix());
+    QVector3D dir(mat33::transform(theUpper33, QVector3D(0, 0, -1)));
+    dir.normalize();
+    nearPlane.normal = dir;
+    const QVector3D theGlobalPos = camera.getGlobalPos() + camera.clipNear * dir;
+    nearPlane.d = -(QVector3D::dotProduct(dir, theGlobalPos));
+    return QSSGClippingFrustum(viewProjection, nearPlane);
+}
+
+// Identifies the geometry a caster draws. Custom geometry bumps its generation id on every
+// update, meshes loaded from a source only change together with the path.
+static size_t shadowCasterGeometryHash(const QSSGRenderModel &model)
+{
+    if (model.geometry)
+        return qHashMulti(0, model.geometry, model.geometry->generationId());
+    return qHash(model.meshPath, 0);
+}
+
+static quint32 shadowCasterMaterialSerial(const QSSGSubsetRenderable &renderable)
+{
+    if (renderable.type == QSSGRenderableObject::Type::CustomMaterialMeshSubset)
+        return renderable.customMaterial().m_updateSerial;
+    return renderable.defaultMaterial().updateSerial;
+}
+
+// With a spatial index the models are classified per subtree first, so only the subsets of models
+// straddling the light frustum are tested one by one.
+void RenderHelpers::collectShadowCasters(const QVector<QSSGRenderableObjectHandle> &casters,
+                                         const QSSGRenderCamera &lightCamera,
+                                         const QMatrix4x4 &viewProjection,
+                                         const QSSGRenderSpatialIndex *spatialIndex,
+                                         QVector<QSSGRenderSpatialIndex::Visibility> &leafVisibility,
+                                         QVector<QSSGRenderableObjectHandle> &visibleCasters,
+                                         size_t &contentHash,
+                                         bool &cacheable)
+{
+    const QSSGClippingFrustum frustum = shadowCameraFrustum(lightCamera, viewProjection);
+    if (spatialIndex)
+        spatialIndex->classify(frustum, leafVisibility);
+    contentHash = qHashBits(viewProjection.constData(), 16 * sizeof(float), contentHash);
+    visibleCasters.clear();
+    // The casters come sorted for the main camera, so their order changes whenever that camera
+    // moves. The per-caster hashes are therefore summed up, which does not depend on the order.
+    size_t castersHash = 0;
+    for (const QSSGRenderableObjectHandle &handle : casters) {
+        if (handle.obj->type == QSSGRenderableObject::Type::Particles)
+            continue; // not rendered into shadow maps
+        const QSSGSubsetRenderable &renderable(static_cast<const QSSGSubsetRenderable &>(*handle.obj));
+        const bool dynamicGeometry = hasDynamicShadowCasterGeometry(renderable);
+        if (!dynamicGeometry) {
+            auto visibility = QSSGRenderSpatialIndex::Visibility::Intersecting;
+            const qint32 leaf = renderable.modelContext.spatialIndexLeaf;
+            if (spatialIndex && leaf >= 0 && leaf < leafVisibility.size())
+                visibility = leafVisibility.at(leaf);
+            if (visibility == QSSGRenderSpatialIndex::Visibility::Outside)
+                continue;
+            if (visibility == QSSGRenderSpatialIndex::Visibility::Intersecting && !frustum.intersectsWith(renderable.globalBounds))
+                continue;
+        }
+        visibleCasters.push_back(handle);
+        if (dynamicGeometry || renderable.modelContext.globalValuesDirty)
+            cacheable = false;
+        // The transform and the serials cover changes made in another View3D sharing the scene,
+        // where the dirty flags were cleared before this layer got to see them.
+        size_t casterHash = qHashMulti(0, &renderable.modelContext.model, &renderable.material,
+                                       shadowCasterGeometryHash(renderable.modelContext.model),
+                                       shadowCasterMaterialSerial(renderable), renderable.subset.offset,
+                                       renderable.subset.count, renderable.shaderDescription.hash());
+        casterHash = qHashBits(renderable.globalTransform.constData(), 16 * sizeof(float), casterHash);
+        castersHash += casterHash;
+    }
+    contentHash = qHashMulti(contentHash, castersHash, visibleCasters.size());
+}
+
+bool RenderHelpers::shadowMapNeedsRender(QSSGShadowMapEntry &entry, size_t contentHash, bool cacheable)
+{
+    if (cacheable && entry.m_contentCached && entry.m_contentHash == contentHash)
+        return false;
+    entry.m_contentHash = contentHash;
+    entry.m_contentCached = cacheable;
+    return true;
+}
+
 void RenderHelpers::rhiRenderShadowMap(QSSGRhiContext *rhiCtx,
                                        QSSGPassKey passKey,
                                        QSSGRhiGraphicsPipelineState &ps,
@@ -1648,7 +1837,8 @@ void RenderHelpers::rhiRenderShadowMap(QSSGRhiContext *rhiCtx,
                                        const QVector<QSSGRenderableObjectHandle> &sortedOpaqueObjects,
                                        const QSSGRef<QSSGRenderer> &renderer,
                                        const QSSGBoxPoints &castingObjectsBox,
-                                       const QSSGBoxPoints &receivingObjectsBox)
+                                       const QSSGBoxPoints &receivingObjectsBox,
+                                       const QSSGRenderSpatialIndex *spatialIndex)
 {
     const QSSGLayerGlobalRenderProperties &globalRenderProperties = renderer->getLayerGlobalRenderProperties();
 
@@ -1674,6 +1864,10 @@ void RenderHelpers::rhiRenderShadowMap(QSSGRhiContext *rhiCtx,
                 if (!renderable->rhiRenderData.shadowPass.pipeline)
                     continue;
 
+                // All instances can be outside of the level of detail range
+                if (renderable->modelContext.model.instancing() && renderable->instanceCount == 0)
+                    continue;
+
                 Q_QUICK3D_PROFILE_START(QQuick3DProfiler::Quick3DRenderCall);
 
                 cb->setGraphicsPipeline(renderable->rhiRenderData.shadowPass.pipeline);
@@ -1691,7 +1885,7 @@ void RenderHelpers::rhiRenderShadowMap(QSSGRhiContext *rhiCtx,
                 vertexBuffers[0] = QRhiCommandBuffer::VertexInput(vertexBuffer, 0);
                 quint32 instances = 1;
                 if (renderable->modelContext.model.instancing()) {
-                    instances = renderable->modelContext.model.instanceCount();
+                    instances = renderable->instanceCount;
                     vertexBuffers[1] = QRhiCommandBuffer::VertexInput(renderable->instanceBuffer, 0);
                     vertexBufferCount = 2;
                 }
@@ -1810,6 +2004,10 @@ void RenderHelpers::rhiRenderShadowMap(QSSGRhiContext *rhiCtx,
         depthAdjust[1] = 0.5f;
     }
 
+    static const bool shadowMapCaching = (qEnvironmentVariableIntValue("QT_QUICK3D_SHADOW_MAP_CACHING") != 0);
+    QVector<QSSGRenderableObjectHandle> visibleCasters[6];
+    QVector<QSSGRenderSpatialIndex::Visibility> leafVisibility;
+
     // Create shadow map for each light in the scene
     for (int i = 0, ie = globalLights.size(); i != ie; ++i) {
         if (!globalLights[i].shadows || globalLights[i].light->m_fullyBaked)
@@ -1821,19 +2019,27 @@ void RenderHelpers::rhiRenderShadowMap(QSSGRhiContext *rhiCtx,
 
         Q_ASSERT(pEntry->m_rhiDepthStencil);
         const bool orthographic = pEntry->m_rhiDepthMap && pEntry->m_rhiDepthCopy;
+        const auto &light = globalLights[i].light;
+        size_t contentHash = qHashMulti(0, light, pEntry->m_rhiDepthMap, pEntry->m_rhiDepthCube,
+                                        light->m_shadowFilter, light->m_shadowMapFar);
+        bool cacheable = shadowMapCaching;
         if (orthographic) {
             const QSize size = pEntry->m_rhiDepthMap->pixelSize();
             ps.viewport = QRhiViewport(0, 0, float(size.width()), float(size.height()));
 
-            const auto &light = globalLights[i].light;
             const auto cameraType = (light->type == QSSGRenderLight::Type::DirectionalLight) ? QSSGRenderCamera::Type::OrthographicCamera : QSSGRenderCamera::Type::CustomCamera;
             QSSGRenderCamera theCamera(cameraType);
             setupCameraForShadowMap(camera, light, theCamera, castingObjectsBox, receivingObjectsBox);
             theCamera.calculateViewProjectionMatrix(pEntry->m_lightVP);
             pEntry->m_lightView = theCamera.globalTransform.inverted(); // pre-calculate this for the material
 
+            collectShadowCasters(sortedOpaqueObjects, theCamera, pEntry->m_lightVP, spatialIndex, leafVisibility,
+                                 visibleCasters[0], contentHash, cacheable);
+            if (!shadowMapNeedsRender(*pEntry, contentHash, cacheable))
+                continue;
+
             rhiPrepareResourcesForShadowMap(rhiCtx, passKey, globalRenderProperties, pEntry, &ps, &depthAdjust,
-                                            sortedOpaqueObjects, theCamera, true, 0);
+                                            visibleCasters[0], theCamera, true, 0);
 
             // Render into the 2D texture pEntry->m_rhiDepthMap, using
             // pEntry->m_rhiDepthStencil as the (throwaway) depth/stencil buffer.
@@ -1841,7 +2047,7 @@ void RenderHelpers::rhiRenderShadowMap(QSSGRhiContext *rhiCtx,
             cb->beginPass(rt, Qt::white, { 1.0f, 0 }, nullptr, QSSGRhiContext::commonPassFlags());
             Q_QUICK3D_PROFILE_START(QQuick3DProfiler::Quick3DRenderPass);
             QSSGRHICTX_STAT(rhiCtx, beginRenderPass(rt));
-            rhiRenderOneShadowMap(rhiCtx, &ps, sortedOpaqueObjects, 0);
+            rhiRenderOneShadowMap(rhiCtx, &ps, visibleCasters[0], 0);
             cb->endPass();
             QSSGRHICTX_STAT(rhiCtx, endRenderPass());
             Q_QUICK3D_PROFILE_END_WITH_STRING(QQuick3DProfiler::Quick3DRenderPass, 0, QByteArrayLiteral("shadow_map"));
@@ -1864,12 +2070,21 @@ void RenderHelpers::rhiRenderShadowMap(QSSGRhiContext *rhiCtx,
             pEntry->m_lightView = QMatrix4x4();
 
             const bool swapYFaces = !rhi->isYUpInFramebuffer();
+            QMatrix4x4 faceViewProjections[6];
             for (const auto face : QSSGRenderTextureCubeFaces) {
-                theCameras[quint8(face)].calculateViewProjectionMatrix(pEntry->m_lightVP);
+                theCameras[quint8(face)].calculateViewProjectionMatrix(faceViewProjections[quint8(face)]);
                 pEntry->m_lightCubeView[quint8(face)] = theCameras[quint8(face)].globalTransform.inverted(); // pre-calculate this for the material
+                collectShadowCasters(sortedOpaqueObjects, theCameras[quint8(face)], faceViewProjections[quint8(face)],
+                                     spatialIndex, leafVisibility, visibleCasters[quint8(face)], contentHash, cacheable);
+            }
+            pEntry->m_lightVP = faceViewProjections[quint8(QSSGRenderTextureCubeFace::NegZ)];
+            if (!shadowMapNeedsRender(*pEntry, contentHash, cacheable))
+                continue;
 
+            for (const auto face : QSSGRenderTextureCubeFaces) {
+                pEntry->m_lightVP = faceViewProjections[quint8(face)];
                 rhiPrepareResourcesForShadowMap(rhiCtx, passKey, globalRenderProperties, pEntry, &ps, &depthAdjust,
-                                                sortedOpaqueObjects, theCameras[quint8(face)], false, quint8(face));
+                                                visibleCasters[quint8(face)], theCameras[quint8(face)], false, quint8(face));
             }
 
             for (const auto face : QSSGRenderTextureCubeFaces) {
@@ -1903,7 +2118,7 @@ void RenderHelpers::rhiRenderShadowMap(QSSGRhiContext *rhiCtx,
                 cb->beginPass(rt, Qt::white, { 1.0f, 0 }, nullptr, QSSGRhiContext::commonPassFlags());
                 QSSGRHICTX_STAT(rhiCtx, beginRenderPass(rt));
                 Q_QUICK3D_PROFILE_START(QQuick3DProfiler::Quick3DRenderPass);
-                rhiRenderOneShadowMap(rhiCtx, &ps, sortedOpaqueObjects, quint8(face));
+                rhiRenderOneShadowMap(rhiCtx, &ps, visibleCasters[quint8(face)], quint8(face));
                 cb->endPass();
                 QSSGRHICTX_STAT(rhiCtx, endRenderPass());
                 Q_QUICK3D_PROFILE_END_WITH_STRING(QQuick3DProfiler::Quick3DRenderPass, 0, QByteArrayLiteral("shadow_cube_")
@@ -2502,6 +2717,10 @@ void RenderHelpers::rhiRenderDepthPass(QSSGRhiContext *rhiCtx,
                 if (!srb)
                     return;
 
+                // All instances can be outside of the camera frustum or the level of detail range
+                if (subsetRenderable->modelContext.model.instancing() && subsetRenderable->visibleInstanceCount == 0)
+                    continue;
+
                 Q_QUICK3D_PROFILE_START(QQuick3DProfiler::Quick3DRenderCall);
                 cb->setGraphicsPipeline(ps);
                 cb->setShaderResources(srb);
@@ -2516,7 +2735,7 @@ void RenderHelpers::rhiRenderDepthPass(QSSGRhiContext *rhiCtx,
                 vertexBuffers[0] = QRhiCommandBuffer::VertexInput(vertexBuffer, 0);
                 quint32 instances = 1;
                 if (subsetRenderable->modelContext.model.instancing()) {
-                    instances = subsetRenderable->modelContext.model.instanceCount();
+                    instances = subsetRenderable->visibleInstanceCount;
                     vertexBuffers[1] = QRhiCommandBuffer::VertexInput(subsetRenderable->instanceBuffer, 0);
                     vertexBufferCount = 2;
                 }
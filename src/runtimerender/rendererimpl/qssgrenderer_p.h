@@ -32,6 +32,7 @@
 #include <QtQuick3DRuntimeRender/private/qssgrenderpickresult_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgshadermapkey_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrenderpass_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrenderspatialindex_p.h>
 
 #include <QtQuick3DUtils/private/qssgbounds3_p.h>
 #include <QtQuick3DUtils/private/qssgdataref_p.h>
@@ -101,7 +102,8 @@ public:
                                                                         const QSSGRef<QSSGProgramGenerator> &shaderProgramGenerator,
                                                                         QSSGShaderDefaultMaterialKeyProperties &shaderKeyProperties,
                                                                         const QSSGShaderFeatures &featureSet,
-                                                                        QByteArray &shaderString);
+                                                                        QByteArray &shaderString,
+                                                                        QSSGShaderCache::CompileMode compileMode = QSSGShaderCache::CompileMode::Synchronous);
 
     QSSGRef<QSSGRhiShaderPipeline> getShaderPipelineForDefaultMaterial(QSSGSubsetRenderable &inRenderable,
                                                                        const QSSGShaderFeatures &inFeatureSet);
@@ -111,7 +113,8 @@ public:
     QSSGRenderContextInterface *contextInterface() { return m_contextInterface; }
 
     // Returns true if the renderer expects new frame to be rendered
-    // Happens when progressive AA is enabled
+    // Happens when progressive AA is enabled, or while material shaders are
+    // being compiled in the background
     bool rendererRequestsFrames() const;
 
     enum class LightmapUVRasterizationShaderMode {
@@ -232,7 +235,24 @@ void rhiRenderShadowMap(QSSGRhiContext *rhiCtx, QSSGPassKey passKey,
                         const QVector<QSSGRenderableObjectHandle> &sortedOpaqueObjects,
                         const QSSGRef<QSSGRenderer> &renderer,
                         const QSSGBoxPoints &castingObjectsBox,
-                        const QSSGBoxPoints &receivingObjectsBox);
+                        const QSSGBoxPoints &receivingObjectsBox,
+                        const QSSGRenderSpatialIndex *spatialIndex);
+
+// Collects the casters that can end up in the shadow map rendered with the given light camera and
+// view projection matrix, and folds the light camera and these casters into contentHash.
+// cacheable is cleared when one of the casters changed in this frame.
+Q_QUICK3DRUNTIMERENDER_EXPORT void collectShadowCasters(const QVector<QSSGRenderableObjectHandle> &casters,
+                                                        const QSSGRenderCamera &lightCamera,
+                                                        const QMatrix4x4 &viewProjection,
+                                                        const QSSGRenderSpatialIndex *spatialIndex,
+                                                        QVector<QSSGRenderSpatialIndex::Visibility> &leafVisibility,
+                                                        QVector<QSSGRenderableObjectHandle> &visibleCasters,
+                                                        size_t &contentHash,
+                                                        bool &cacheable);
+
+// Whether the shadow map of entry has to be rendered for the given content. Keeps the map when it
+// is cacheable and was last rendered, as cacheable, for the same content.
+Q_QUICK3DRUNTIMERENDER_EXPORT bool shadowMapNeedsRender(QSSGShadowMapEntry &entry, size_t contentHash, bool cacheable);
 
 void rhiRenderReflectionMap(QSSGRhiContext *rhiCtx,
                             QSSGPassKey passKey,
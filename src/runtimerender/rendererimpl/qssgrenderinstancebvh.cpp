@@ -0,0 +1,164 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include "qssgrenderinstancebvh_p.h"
+
+#include <QtQuick3DRuntimeRender/private/qssgrenderinstancetable_p.h>
+
+#include <QtCore/qvarlengtharray.h>
+
+#include <numeric>
+
+QT_BEGIN_NAMESPACE
+
+void QSSGRenderInstanceBvh::update(const QSSGRenderInstanceTable &table)
+{
+    const int count = table.count();
+    if (count != m_count) {
+        rebuild(table);
+    } else if (table.serial() != m_serial) {
+        refitAll(table);
+    } else if (table.updateSerial() != m_updateSerial && !m_nodes.isEmpty()) {
+        if (table.updateSerial() == m_updateSerial + 1) {
+            // Only the leaves of the updated instances have to be refit
+            QVarLengthArray<qint32, 64> leaves;
+            for (const QSSGRenderInstanceTable::Range &range : table.lastUpdatedRanges()) {
+                for (qint32 idx = range.offset, end = qMin(range.offset + range.count, count); idx < end; ++idx)
+                    leaves.push_back(m_leafOfInstance.at(idx));
+            }
+            std::sort(leaves.begin(), leaves.end());
+            leaves.erase(std::unique(leaves.begin(), leaves.end()), leaves.end());
+            for (qint32 leaf : std::as_const(leaves))
+                refitLeaf(table, leaf);
+            m_refitsSinceRebuild += leaves.size() * MaxLeafSize;
+        } else {
+            refitAll(table);
+        }
+    }
+
+    // Refitting keeps the topology, so moving instances make the tree less efficient.
+    // Once the refits add up to refitting the whole table RefitsPerRebuild times we rebuild
+    // from scratch. Counting against the table once would rebuild tables that are replaced
+    // every frame on every other pick.
+    if (m_refitsSinceRebuild > RefitsPerRebuild * qsizetype(count))
+        rebuild(table);
+
+    m_serial = table.serial();
+    m_updateSerial = table.updateSerial();
+}
+
+void QSSGRenderInstanceBvh::rebuild(const QSSGRenderInstanceTable &table)
+{
+    m_count = table.count();
+    m_refitsSinceRebuild = 0;
+    m_nodes.clear();
+    m_instances.resize(m_count);
+    std::iota(m_instances.begin(), m_instances.end(), 0);
+    m_leafOfInstance.resize(m_count);
+
+    if (m_count == 0 || m_localBounds.isEmpty())
+        return;
+
+    QVector<QSSGBounds3> instanceBounds(m_count);
+    for (int idx = 0; idx < m_count; ++idx)
+        instanceBounds[idx] = table.instanceBounds(idx, m_localBounds);
+
+    m_nodes.reserve(2 * (m_count / MaxLeafSize + 1));
+    buildRecursive(0, m_count, -1, instanceBounds);
+}
+
+qint32 QSSGRenderInstanceBvh::buildRecursive(qint32 first, qint32 last, qint32 parent, const QVector<QSSGBounds3> &instanceBounds)
+{
+    const qint32 nodeIdx = qint32(m_nodes.size());
+    m_nodes.push_back(TreeNode { {}, parent });
+
+    if (last - first <= MaxLeafSize) {
+        TreeNode &node = m_nodes[nodeIdx];
+        node.first = first;
+        node.count = last - first;
+        for (qint32 idx = first; idx != last; ++idx) {
+            node.bounds.include(instanceBounds.at(m_instances.at(idx)));
+            m_leafOfInstance[m_instances.at(idx)] = nodeIdx;
+        }
+        return nodeIdx;
+    }
+
+    // Median split along the longest axis of the instance centers
+    QSSGBounds3 centerBounds;
+    for (qint32 idx = first; idx != last; ++idx)
+        centerBounds.include(instanceBounds.at(m_instances.at(idx)).center());
+    const QVector3D dim = centerBounds.dimensions();
+    const int axis = (dim.x() > dim.y() && dim.x() > dim.z()) ? 0 : (dim.y() > dim.z() ? 1 : 2);
+
+    const qint32 mid = first + (last - first) / 2;
+    std::nth_element(m_instances.begin() + first, m_instances.begin() + mid, m_instances.begin() + last,
+                     [&instanceBounds, axis](qint32 lhs, qint32 rhs) {
+        return instanceBounds.at(lhs).center(axis) < instanceBounds.at(rhs).center(axis);
+    });
+
+    const qint32 left = buildRecursive(first, mid, nodeIdx, instanceBounds);
+    const qint32 right = buildRecursive(mid, last, nodeIdx, instanceBounds);
+
+    TreeNode &node = m_nodes[nodeIdx];
+    node.left = left;
+    node.right = right;
+    node.bounds = m_nodes.at(left).bounds;
+    node.bounds.include(m_nodes.at(right).bounds);
+
+    return nodeIdx;
+}
+
+void QSSGRenderInstanceBvh::refitAll(const QSSGRenderInstanceTable &table)
+{
+    // Children are always created after their parent, so going backwards visits them first
+    for (qsizetype nodeIdx = m_nodes.size() - 1; nodeIdx >= 0; --nodeIdx) {
+        TreeNode &node = m_nodes[nodeIdx];
+        node.bounds = QSSGBounds3();
+        if (node.count > 0) {
+            for (qint32 idx = node.first, end = node.first + node.count; idx != end; ++idx)
+                node.bounds.include(table.instanceBounds(m_instances.at(idx), m_localBounds));
+        } else {
+            node.bounds = m_nodes.at(node.left).bounds;
+            node.bounds.include(m_nodes.at(node.right).bounds);
+        }
+    }
+    m_refitsSinceRebuild += m_count;
+}
+
+void QSSGRenderInstanceBvh::refitLeaf(const QSSGRenderInstanceTable &table, qint32 nodeIdx)
+{
+    TreeNode &leaf = m_nodes[nodeIdx];
+    leaf.bounds = QSSGBounds3();
+    for (qint32 idx = leaf.first, end = leaf.first + leaf.count; idx != end; ++idx)
+        leaf.bounds.include(table.instanceBounds(m_instances.at(idx), m_localBounds));
+    for (nodeIdx = leaf.parent; nodeIdx >= 0; nodeIdx = m_nodes.at(nodeIdx).parent) {
+        TreeNode &node = m_nodes[nodeIdx];
+        node.bounds = m_nodes.at(node.left).bounds;
+        node.bounds.include(m_nodes.at(node.right).bounds);
+    }
+}
+
+void QSSGRenderInstanceBvh::intersect(const QSSGRenderRay::RayData &rayData, QVector<int> &instances) const
+{
+    if (m_nodes.isEmpty())
+        return;
+
+    const qsizetype firstResult = instances.size();
+    QVarLengthArray<qint32, 64> stack;
+    stack.push_back(0);
+    while (!stack.isEmpty()) {
+        const TreeNode &node = m_nodes.at(stack.takeLast());
+        if (!QSSGRenderRay::intersectWithAABBv2(rayData, node.bounds).intersects())
+            continue;
+        if (node.count > 0) {
+            for (qint32 idx = node.first, end = node.first + node.count; idx != end; ++idx)
+                instances.push_back(m_instances.at(idx));
+        } else {
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+        }
+    }
+    std::sort(instances.begin() + firstResult, instances.end());
+}
+
+QT_END_NAMESPACE
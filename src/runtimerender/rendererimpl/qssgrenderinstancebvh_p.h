@@ -0,0 +1,85 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef QSSG_RENDER_INSTANCE_BVH_H
+#define QSSG_RENDER_INSTANCE_BVH_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtQuick3DRuntimeRender/private/qtquick3druntimerenderglobal_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrenderray_p.h>
+#include <QtQuick3DUtils/private/qssgbounds3_p.h>
+
+#include <QtCore/qlist.h>
+
+QT_BEGIN_NAMESPACE
+
+struct QSSGRenderInstanceTable;
+
+// Bounding volume hierarchy over the instances of an instance table, used for picking.
+//
+// The bounds of the instances are in the space the instance table is in (the parent of the
+// instance root), so a ray only has to be transformed once to query the whole table. The
+// tree is brought up to date lazily, when picking: changes to the table are refit, and the
+// tree is only rebuilt when the instance count changes, or when enough refits have
+// accumulated to degrade its quality.
+//
+// Each tree is for one local bounds, so that models sharing a table but having different
+// meshes don't rebuild each other's tree. The trees are owned by the instance table. Like
+// the mesh BVH they are only used with the buffer manager's mesh update mutex locked.
+class Q_QUICK3DRUNTIMERENDER_EXPORT QSSGRenderInstanceBvh
+{
+    Q_DISABLE_COPY(QSSGRenderInstanceBvh)
+public:
+    // localBounds are the bounds of a single instance in its local space
+    explicit QSSGRenderInstanceBvh(const QSSGBounds3 &localBounds) : m_localBounds(localBounds) {}
+
+    const QSSGBounds3 &localBounds() const { return m_localBounds; }
+
+    void update(const QSSGRenderInstanceTable &table);
+
+    // Appends the indices of the instances that might be hit by the ray (given in the space of
+    // the instance table), in ascending order.
+    void intersect(const QSSGRenderRay::RayData &rayData, QVector<int> &instances) const;
+
+private:
+    static constexpr qint32 MaxLeafSize = 4;
+    static constexpr qsizetype RefitsPerRebuild = 8;
+
+    struct TreeNode
+    {
+        QSSGBounds3 bounds;
+        qint32 parent = -1;
+        qint32 left = -1;
+        qint32 right = -1;
+        qint32 first = 0; // range in m_instances, for leaves
+        qint32 count = 0; // 0 for inner nodes
+    };
+
+    void rebuild(const QSSGRenderInstanceTable &table);
+    qint32 buildRecursive(qint32 first, qint32 last, qint32 parent, const QVector<QSSGBounds3> &instanceBounds);
+    void refitAll(const QSSGRenderInstanceTable &table);
+    void refitLeaf(const QSSGRenderInstanceTable &table, qint32 nodeIdx);
+
+    QVector<TreeNode> m_nodes;
+    QVector<qint32> m_instances; // instance indices, grouped by leaf
+    QVector<qint32> m_leafOfInstance;
+    QSSGBounds3 m_localBounds;
+    int m_count = -1;
+    int m_serial = -1;
+    int m_updateSerial = -1;
+    qsizetype m_refitsSinceRebuild = 0;
+};
+
+QT_END_NAMESPACE
+
+#endif // QSSG_RENDER_INSTANCE_BVH_H
@@ -28,6 +28,26 @@ static inline QMatrix4x4 correctMVPForScissor(QRectF viewportRect, QRect scissor
                       0.0f, 0.0f, 1.0f, 0.0f,
                       0.0f, 0.0f, 0.0f, 1.0f);
 }
+
+static quint64 mainPassPipelineSwitches(const QSSGRenderableObjectList &renderables)
+{
+    quint64 switches = 0;
+    QRhiGraphicsPipeline *current = nullptr;
+    for (const QSSGRenderableObjectHandle &handle : renderables) {
+        QRhiGraphicsPipeline *pipeline = nullptr;
+        if (handle.obj->type == QSSGRenderableObject::Type::Particles)
+            pipeline = static_cast<QSSGParticlesRenderable *>(handle.obj)->rhiRenderData.mainPass.pipeline;
+        else
+            pipeline = static_cast<QSSGSubsetRenderable *>(handle.obj)->rhiRenderData.mainPass.pipeline;
+        if (pipeline && pipeline != current) {
+            if (current)
+                ++switches;
+            current = pipeline;
+        }
+    }
+    return switches;
+}
+
 // SHADOW PASS
 
 void ShadowMapPass::renderPrep(const QSSGRef<QSSGRenderer> &renderer, QSSGLayerRenderData &data)
@@ -50,6 +70,7 @@ void ShadowMapPass::renderPrep(const QSSGRef<QSSGRenderer> &renderer, QSSGLayerR
     }
 
     globalLights = data.globalLights;
+    spatialIndex = data.spatialIndex;
 
     enabled = !shadowPassObjects.isEmpty() || !globalLights.isEmpty();
 
@@ -104,7 +125,8 @@ void ShadowMapPass::renderPass(const QSSGRef<QSSGRenderer> &renderer)
                            shadowPassObjects,
                            renderer,
                            castingObjectsBox,
-                           receivingObjectsBox);
+                           receivingObjectsBox,
+                           spatialIndex);
 
         cb->debugMarkEnd();
         Q_QUICK3D_PROFILE_END_WITH_STRING(QQuick3DProfiler::Quick3DRenderPass, 0, QByteArrayLiteral("shadow_map"));
@@ -115,6 +137,7 @@ void ShadowMapPass::release()
 {
     enabled = false;
     camera = nullptr;
+    spatialIndex = nullptr;
     castingObjectsBox = {};
     receivingObjectsBox = {};
     ps = {};
@@ -597,9 +620,16 @@ void MainPass::renderPrep(const QSSGRef<QSSGRenderer> &renderer, QSSGLayerRender
         const auto &clippingFrustum = data.clippingFrustum;
         const auto &opaqueObjects = data.getSortedOpaqueRenderableObjects();
         const auto &transparentObject = data.getSortedTransparentRenderableObjects();
-        if (clippingFrustum.has_value()) {
-            QSSGLayerRenderData::frustumCulling(clippingFrustum.value(), opaqueObjects, sortedOpaqueObjects);
-            QSSGLayerRenderData::frustumCulling(clippingFrustum.value(), transparentObject, sortedTransparentObjects);
+        if (clippingFrustum.has_value() && data.spatialIndex) {
+            data.spatialIndex->classify(clippingFrustum.value(), data.spatialIndexVisibility);
+            QSSGLayerRenderData::frustumCulling(clippingFrustum.value(), data.spatialIndexVisibility, opaqueObjects, sortedOpaqueObjects);
+            QSSGLayerRenderData::frustumCulling(clippingFrustum.value(), data.spatialIndexVisibility, transparentObject, sortedTransparentObjects);
+        } else if (clippingFrustum.has_value()) {
+            // One pass over the packed bounds of all renderables covers both lists
+            data.renderableVisibility.resize(QSSGBoundsSoA::maskSize(data.renderableBounds.size()));
+            clippingFrustum->intersectsWith(data.renderableBounds, data.renderableVisibility.data());
+            QSSGLayerRenderData::frustumCulling(clippingFrustum.value(), data.renderableVisibility, opaqueObjects, sortedOpaqueObjects);
+            QSSGLayerRenderData::frustumCulling(clippingFrustum.value(), data.renderableVisibility, transparentObject, sortedTransparentObjects);
         } else {
             sortedOpaqueObjects = opaqueObjects;
             sortedTransparentObjects = transparentObject;
@@ -638,6 +668,15 @@ void MainPass::renderPrep(const QSSGRef<QSSGRenderer> &renderer, QSSGLayerRender
         rhiPrepareRenderable(rhiCtx.data(), this, data, *theObject, mainRpDesc, &ps, shaderFeatures, samples);
     }
 
+    if (QSSGLayerRenderData::opaqueSortMode() != QSSGLayerRenderData::OpaqueSortMode::Distance && rhiCtx->stats().isEnabled()) {
+        QSSGRenderableObjectList distanceOrder = sortedOpaqueObjects;
+        std::stable_sort(distanceOrder.begin(), distanceOrder.end(), [](const QSSGRenderableObjectHandle &lhs, const QSSGRenderableObjectHandle &rhs) {
+            return lhs.cameraDistanceSq < rhs.cameraDistanceSq;
+        });
+        rhiCtx->stats().registerOpaquePipelineSwitches(mainPassPipelineSwitches(sortedOpaqueObjects),
+                                                       mainPassPipelineSwitches(distanceOrder));
+    }
+
     // objects that requires the screen texture
     ps.depthTestEnable = depthTestEnableDefault;
     ps.depthWriteEnable = depthWriteEnableDefault;
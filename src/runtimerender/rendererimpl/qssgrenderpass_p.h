@@ -28,6 +28,7 @@ class QSSGRenderer;
 class QSSGRenderShadowMap;
 class QSSGRenderReflectionMap;
 class QSSGLayerRenderData;
+class QSSGRenderSpatialIndex;
 struct QSSGRenderCamera;
 struct QSSGRenderItem2D;
 
@@ -65,6 +66,7 @@ public:
     QSSGRenderableObjectList shadowPassObjects;
     QSSGShaderLightList globalLights;
     QSSGRenderCamera *camera = nullptr;
+    const QSSGRenderSpatialIndex *spatialIndex = nullptr;
     QSSGRhiGraphicsPipelineState ps;
     QSSGBoxPoints castingObjectsBox;
     QSSGBoxPoints receivingObjectsBox;
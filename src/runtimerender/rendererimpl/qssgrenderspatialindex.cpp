@@ -0,0 +1,357 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include "qssgrenderspatialindex_p.h"
+
+#include <QtQuick3DRuntimeRender/private/qssglayerrenderdata_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrendermodel_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrendermesh_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrenderray_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrenderclippingfrustum_p.h>
+
+#include <QtCore/qset.h>
+
+QT_BEGIN_NAMESPACE
+
+static bool hasUnboundedWorldBounds(const QSSGRenderModel &model)
+{
+    // The mesh bounds transformed by the global transform don't cover what gets rendered
+    return model.instancing() || model.boneCount > 0 || model.particleBuffer != nullptr;
+}
+
+static quint32 meshGenerationId(const QSSGRenderMesh *mesh)
+{
+    return mesh ? mesh->generationId : 0;
+}
+
+static QSSGBounds3 calculateWorldBounds(const QSSGRenderModel &model, const QSSGRenderMesh &mesh)
+{
+    QSSGBounds3 bounds;
+    for (const auto &subset : mesh.subsets)
+        bounds.include(subset.bounds);
+    if (!bounds.isEmpty())
+        bounds.transform(model.globalTransform);
+    return bounds;
+}
+
+void QSSGRenderSpatialIndex::update(const QVector<QSSGRenderableNodeEntry> &renderableModels)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // The renderable models come in scene order, so as long as no models were added, removed
+    // or had their mesh loaded or released, the leaf of each entry is the same as last frame.
+    bool sameModels = (renderableModels.size() == m_entryNodes.size());
+    for (qsizetype idx = 0, end = renderableModels.size(); sameModels && idx != end; ++idx) {
+        const QSSGRenderableNodeEntry &entry = renderableModels.at(idx);
+        sameModels = (entry.node == m_entryNodes.at(idx) && !entry.mesh == (m_entryLeaves.at(idx) < 0));
+    }
+
+    if (sameModels)
+        updateLeaves(renderableModels);
+    else
+        updateStructure(renderableModels);
+}
+
+bool QSSGRenderSpatialIndex::updateLeaf(qint32 leafIdx, const QSSGRenderableNodeEntry &entry, QVarLengthArray<qint32, 64> &refitLeaves)
+{
+    Leaf &leaf = m_leaves[leafIdx];
+    const auto &model = static_cast<const QSSGRenderModel &>(*entry.node);
+    leaf.meshGenerationId = entry.mesh->generationId;
+    const bool unbounded = hasUnboundedWorldBounds(model);
+    bool structureChanged = (unbounded != leaf.unbounded);
+    leaf.unbounded = unbounded;
+    if (!unbounded) {
+        leaf.bounds = calculateWorldBounds(model, *entry.mesh);
+        if (leaf.treeNode >= 0)
+            refitLeaves.push_back(leafIdx);
+        else if (!leaf.bounds.isEmpty())
+            structureChanged = true;
+    }
+    return structureChanged;
+}
+
+void QSSGRenderSpatialIndex::updateLeaves(const QVector<QSSGRenderableNodeEntry> &renderableModels)
+{
+    bool structureChanged = false;
+    QVarLengthArray<qint32, 64> refitLeaves;
+
+    // Only the leaves of models that moved or got a different mesh are touched
+    for (qsizetype idx = 0, end = renderableModels.size(); idx != end; ++idx) {
+        const QSSGRenderableNodeEntry &entry = renderableModels.at(idx);
+        const qint32 leafIdx = m_entryLeaves.at(idx);
+        entry.spatialIndexLeaf = leafIdx;
+        const quint32 generationId = meshGenerationId(entry.mesh);
+        if (leafIdx < 0 || (!entry.globalValuesDirty && generationId == m_entryMeshGenerationIds.at(idx)))
+            continue;
+        m_entryMeshGenerationIds[idx] = generationId;
+        structureChanged |= updateLeaf(leafIdx, entry, refitLeaves);
+    }
+
+    finishUpdate(structureChanged, refitLeaves);
+}
+
+void QSSGRenderSpatialIndex::updateStructure(const QVector<QSSGRenderableNodeEntry> &renderableModels)
+{
+    ++m_frameId;
+    bool structureChanged = false;
+    qsizetype seenCount = 0;
+    QVarLengthArray<qint32, 64> refitLeaves;
+
+    for (const QSSGRenderableNodeEntry &entry : renderableModels) {
+        entry.spatialIndexLeaf = -1;
+        if (!entry.mesh)
+            continue;
+
+        auto it = m_leafLookup.constFind(entry.node);
+        const bool isNew = (it == m_leafLookup.cend());
+        qint32 leafIdx;
+        if (isNew) {
+            leafIdx = qint32(m_leaves.size());
+            m_leaves.push_back(Leaf { entry.node });
+            m_leafLookup.insert(entry.node, leafIdx);
+            structureChanged = true;
+        } else {
+            leafIdx = it.value();
+        }
+
+        Leaf &leaf = m_leaves[leafIdx];
+        if (leaf.frameId != m_frameId) {
+            leaf.frameId = m_frameId;
+            ++seenCount;
+        }
+        entry.spatialIndexLeaf = leafIdx;
+
+        if (isNew || entry.globalValuesDirty || leaf.meshGenerationId != entry.mesh->generationId)
+            structureChanged |= updateLeaf(leafIdx, entry, refitLeaves);
+    }
+
+    // Drop the leaves of models that were not part of this frame
+    if (seenCount != m_leaves.size()) {
+        structureChanged = true;
+        qsizetype dst = 0;
+        for (qsizetype src = 0, end = m_leaves.size(); src != end; ++src) {
+            if (m_leaves.at(src).frameId == m_frameId)
+                m_leaves[dst++] = m_leaves.at(src);
+        }
+        m_leaves.resize(dst);
+        m_leafLookup.clear();
+        for (qsizetype idx = 0; idx != dst; ++idx)
+            m_leafLookup.insert(m_leaves.at(idx).node, qint32(idx));
+        for (const QSSGRenderableNodeEntry &entry : renderableModels) {
+            if (entry.spatialIndexLeaf >= 0)
+                entry.spatialIndexLeaf = m_leafLookup.value(entry.node, -1);
+        }
+    }
+
+    // Remember the entry to leaf mapping, so that the following frames can skip the lookups
+    const qsizetype entryCount = renderableModels.size();
+    m_entryNodes.resize(entryCount);
+    m_entryMeshGenerationIds.resize(entryCount);
+    m_entryLeaves.resize(entryCount);
+    for (qsizetype idx = 0; idx != entryCount; ++idx) {
+        const QSSGRenderableNodeEntry &entry = renderableModels.at(idx);
+        m_entryNodes[idx] = entry.node;
+        m_entryMeshGenerationIds[idx] = meshGenerationId(entry.mesh);
+        m_entryLeaves[idx] = entry.spatialIndexLeaf;
+    }
+
+    finishUpdate(structureChanged, refitLeaves);
+}
+
+void QSSGRenderSpatialIndex::finishUpdate(bool structureChanged, const QVarLengthArray<qint32, 64> &refitLeaves)
+{
+    // Refitting keeps the topology, so moving nodes slowly make the tree less efficient.
+    // Once we've done as many refits as there are leaves we rebuild from scratch.
+    m_refitsSinceRebuild += refitLeaves.size();
+    if (structureChanged || m_refitsSinceRebuild > m_leaves.size()) {
+        rebuild();
+    } else {
+        for (qint32 leafIdx : refitLeaves)
+            refit(leafIdx);
+    }
+}
+
+void QSSGRenderSpatialIndex::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_leaves.clear();
+    m_leafLookup.clear();
+    m_nodes.clear();
+    m_entryNodes.clear();
+    m_entryMeshGenerationIds.clear();
+    m_entryLeaves.clear();
+    m_refitsSinceRebuild = 0;
+}
+
+void QSSGRenderSpatialIndex::rebuild()
+{
+    m_nodes.clear();
+    m_refitsSinceRebuild = 0;
+
+    QVector<qint32> leafIndices;
+    leafIndices.reserve(m_leaves.size());
+    for (qsizetype idx = 0, end = m_leaves.size(); idx != end; ++idx) {
+        Leaf &leaf = m_leaves[idx];
+        leaf.treeNode = -1;
+        if (!leaf.unbounded && !leaf.bounds.isEmpty())
+            leafIndices.push_back(qint32(idx));
+    }
+
+    if (leafIndices.isEmpty())
+        return;
+
+    m_nodes.reserve(leafIndices.size() * 2 - 1);
+    buildRecursive(leafIndices.data(), leafIndices.data() + leafIndices.size(), -1);
+}
+
+qint32 QSSGRenderSpatialIndex::buildRecursive(qint32 *first, qint32 *last, qint32 parent)
+{
+    const qint32 nodeIdx = qint32(m_nodes.size());
+    m_nodes.push_back(TreeNode { {}, parent });
+
+    if (last - first == 1) {
+        Leaf &leaf = m_leaves[*first];
+        leaf.treeNode = nodeIdx;
+        m_nodes[nodeIdx].bounds = leaf.bounds;
+        m_nodes[nodeIdx].leaf = *first;
+        return nodeIdx;
+    }
+
+    // Median split along the longest axis of the leaf centers
+    QSSGBounds3 centerBounds;
+    for (const qint32 *it = first; it != last; ++it)
+        centerBounds.include(m_leaves.at(*it).bounds.center());
+    const QVector3D dim = centerBounds.dimensions();
+    const int axis = (dim.x() > dim.y() && dim.x() > dim.z()) ? 0 : (dim.y() > dim.z() ? 1 : 2);
+
+    qint32 *mid = first + (last - first) / 2;
+    std::nth_element(first, mid, last, [this, axis](qint32 lhs, qint32 rhs) {
+        return m_leaves.at(lhs).bounds.center(axis) < m_leaves.at(rhs).bounds.center(axis);
+    });
+
+    const qint32 left = buildRecursive(first, mid, nodeIdx);
+    const qint32 right = buildRecursive(mid, last, nodeIdx);
+
+    TreeNode &node = m_nodes[nodeIdx];
+    node.left = left;
+    node.right = right;
+    node.bounds = m_nodes.at(left).bounds;
+    node.bounds.include(m_nodes.at(right).bounds);
+
+    return nodeIdx;
+}
+
+void QSSGRenderSpatialIndex::refit(qint32 leafIdx)
+{
+    qint32 nodeIdx = m_leaves.at(leafIdx).treeNode;
+    m_nodes[nodeIdx].bounds = m_leaves.at(leafIdx).bounds;
+    for (nodeIdx = m_nodes.at(nodeIdx).parent; nodeIdx >= 0; nodeIdx = m_nodes.at(nodeIdx).parent) {
+        TreeNode &node = m_nodes[nodeIdx];
+        node.bounds = m_nodes.at(node.left).bounds;
+        node.bounds.include(m_nodes.at(node.right).bounds);
+    }
+}
+
+void QSSGRenderSpatialIndex::markSubtree(qint32 nodeIdx, Visibility visibility, QVector<Visibility> &leafVisibility) const
+{
+    QVarLengthArray<qint32, 64> stack;
+    stack.push_back(nodeIdx);
+    while (!stack.isEmpty()) {
+        const TreeNode &node = m_nodes.at(stack.takeLast());
+        if (node.leaf >= 0) {
+            leafVisibility[node.leaf] = visibility;
+        } else {
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+        }
+    }
+}
+
+void QSSGRenderSpatialIndex::classify(const QSSGClippingFrustum &frustum, QVector<Visibility> &leafVisibility) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    leafVisibility.resize(m_leaves.size());
+    for (qsizetype idx = 0, end = m_leaves.size(); idx != end; ++idx)
+        leafVisibility[idx] = m_leaves.at(idx).unbounded ? Visibility::Intersecting : Visibility::Outside;
+
+    if (m_nodes.isEmpty())
+        return;
+
+    // Each stack entry carries the mask of planes the node still straddles; a node that is
+    // fully on the inside of a plane can't have children that are on the outside of it.
+    constexpr quint8 allPlanes = (1 << 6) - 1;
+    QVarLengthArray<std::pair<qint32, quint8>, 64> stack;
+    stack.push_back({ 0, allPlanes });
+    while (!stack.isEmpty()) {
+        const auto [nodeIdx, planeMask] = stack.takeLast();
+        const TreeNode &node = m_nodes.at(nodeIdx);
+        quint8 remainingPlanes = planeMask;
+        bool outside = false;
+        for (int planeIdx = 0; planeIdx < 6 && !outside; ++planeIdx) {
+            if ((planeMask & (1 << planeIdx)) == 0)
+                continue;
+            const int result = frustum.mPlanes[planeIdx].intersect(node.bounds);
+            if (result < 0)
+                outside = true;
+            else if (result > 0)
+                remainingPlanes &= ~(1 << planeIdx);
+        }
+
+        if (outside)
+            continue;
+
+        if (remainingPlanes == 0) {
+            markSubtree(nodeIdx, Visibility::Inside, leafVisibility);
+        } else if (node.leaf >= 0) {
+            leafVisibility[node.leaf] = Visibility::Intersecting;
+        } else {
+            stack.push_back({ node.left, remainingPlanes });
+            stack.push_back({ node.right, remainingPlanes });
+        }
+    }
+}
+
+void QSSGRenderSpatialIndex::removeRayMisses(const QSSGRenderRay &ray, QVarLengthArray<const QSSGRenderNode *> &nodes) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_leaves.isEmpty())
+        return;
+
+    QSet<const QSSGRenderNode *> hits;
+    for (const Leaf &leaf : m_leaves) {
+        if (leaf.unbounded)
+            hits.insert(leaf.node);
+    }
+
+    if (!m_nodes.isEmpty()) {
+        const QMatrix4x4 identity;
+        const auto rayData = QSSGRenderRay::createRayData(identity, ray);
+        QVarLengthArray<qint32, 64> stack;
+        stack.push_back(0);
+        while (!stack.isEmpty()) {
+            const TreeNode &node = m_nodes.at(stack.takeLast());
+            if (!QSSGRenderRay::intersectWithAABBv2(rayData, node.bounds).intersects())
+                continue;
+            if (node.leaf >= 0) {
+                hits.insert(m_leaves.at(node.leaf).node);
+            } else {
+                stack.push_back(node.left);
+                stack.push_back(node.right);
+            }
+        }
+    }
+
+    // Only nodes that are in the index and are unchanged since the last update can be skipped,
+    // anything else (new nodes, inactive nodes, items, nodes moved since the last frame) is kept.
+    const auto isMiss = [this, &hits](const QSSGRenderNode *node) {
+        return node->type == QSSGRenderGraphObject::Type::Model
+                && !node->isDirty(QSSGRenderNode::DirtyFlag::GlobalValuesDirty)
+                && m_leafLookup.contains(node)
+                && !hits.contains(node);
+    };
+    nodes.erase(std::remove_if(nodes.begin(), nodes.end(), isMiss), nodes.end());
+}
+
+QT_END_NAMESPACE
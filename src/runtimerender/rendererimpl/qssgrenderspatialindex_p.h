@@ -0,0 +1,118 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef QSSG_RENDER_SPATIAL_INDEX_H
+#define QSSG_RENDER_SPATIAL_INDEX_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtQuick3DRuntimeRender/private/qtquick3druntimerenderglobal_p.h>
+#include <QtQuick3DUtils/private/qssgbounds3_p.h>
+
+#include <QtCore/qhash.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qvarlengtharray.h>
+
+QT_BEGIN_NAMESPACE
+
+struct QSSGRenderNode;
+struct QSSGRenderMesh;
+struct QSSGRenderRay;
+struct QSSGClippingFrustum;
+struct QSSGRenderableNodeEntry;
+
+// Bounding volume hierarchy over the world bounds of the models in a layer.
+//
+// The index is updated once per frame from the list of renderable models. As long as the
+// same models are rendered, the leaves are looked up by position in that list and only
+// the leaves of models that had their global values changed (or got a different mesh)
+// are recomputed, after which the tree is refit bottom-up. Meshes are told apart by their
+// QSSGRenderMesh::generationId, as a released mesh's address can be reused by the next one. The tree is only rebuilt when
+// models are added or removed, or when enough refits have accumulated to degrade its quality.
+//
+// Models whose world bounds can not be derived from the mesh bounds and the global
+// transform (instancing, skinning, blend particles) are tracked, but never rejected.
+//
+// The queries are guarded by a mutex, as picking happens outside the render thread.
+class Q_QUICK3DRUNTIMERENDER_EXPORT QSSGRenderSpatialIndex
+{
+    Q_DISABLE_COPY(QSSGRenderSpatialIndex)
+public:
+    enum class Visibility : quint8
+    {
+        Outside,
+        Intersecting,
+        Inside
+    };
+
+    QSSGRenderSpatialIndex() = default;
+
+    // Sets QSSGRenderableNodeEntry::spatialIndexLeaf for each of the entries (-1 for
+    // entries without a mesh).
+    void update(const QVector<QSSGRenderableNodeEntry> &renderableModels);
+    void clear();
+
+    [[nodiscard]] qsizetype leafCount() const { return m_leaves.size(); }
+
+    // Classifies each leaf against the frustum, indexed by QSSGRenderableNodeEntry::spatialIndexLeaf.
+    // Whole subtrees are accepted or rejected at once.
+    void classify(const QSSGClippingFrustum &frustum, QVector<Visibility> &leafVisibility) const;
+
+    // Removes the models from 'nodes' that are known to the index, haven't changed since the
+    // index was last updated, and whose world bounds are not hit by the (world space) ray.
+    void removeRayMisses(const QSSGRenderRay &ray, QVarLengthArray<const QSSGRenderNode *> &nodes) const;
+
+private:
+    struct Leaf
+    {
+        const QSSGRenderNode *node = nullptr;
+        quint32 meshGenerationId = 0;
+        QSSGBounds3 bounds;
+        quint32 frameId = 0;
+        qint32 treeNode = -1;
+        bool unbounded = false;
+    };
+
+    struct TreeNode
+    {
+        QSSGBounds3 bounds;
+        qint32 parent = -1;
+        qint32 left = -1;
+        qint32 right = -1;
+        qint32 leaf = -1; // -1 for inner nodes
+    };
+
+    void updateLeaves(const QVector<QSSGRenderableNodeEntry> &renderableModels);
+    void updateStructure(const QVector<QSSGRenderableNodeEntry> &renderableModels);
+    bool updateLeaf(qint32 leafIdx, const QSSGRenderableNodeEntry &entry, QVarLengthArray<qint32, 64> &refitLeaves);
+    void finishUpdate(bool structureChanged, const QVarLengthArray<qint32, 64> &refitLeaves);
+    void rebuild();
+    qint32 buildRecursive(qint32 *first, qint32 *last, qint32 parent);
+    void refit(qint32 leafIdx);
+    void markSubtree(qint32 nodeIdx, Visibility visibility, QVector<Visibility> &leafVisibility) const;
+
+    mutable QMutex m_mutex;
+    QVector<Leaf> m_leaves;
+    QHash<const QSSGRenderNode *, qint32> m_leafLookup;
+    QVector<TreeNode> m_nodes;
+    // The renderable model list of the last update, with the leaf of each entry
+    QVector<const QSSGRenderNode *> m_entryNodes;
+    QVector<quint32> m_entryMeshGenerationIds;
+    QVector<qint32> m_entryLeaves;
+    quint32 m_frameId = 0;
+    qsizetype m_refitsSinceRebuild = 0;
+};
+
+QT_END_NAMESPACE
+
+#endif // QSSG_RENDER_SPATIAL_INDEX_H
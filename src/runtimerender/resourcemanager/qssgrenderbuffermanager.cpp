@@ -13,6 +13,9 @@
 #include <QtQuick/QSGTexture>
 
 #include <QtCore/QDir>
+#ifdef QT_QUICK3D_HAS_CONCURRENT
+#include <QtConcurrent/qtconcurrentrun.h>
+#endif
 #include <QtGui/private/qimage_p.h>
 #include <QtQuick/private/qsgtexture_p.h>
 #include <QtQuick/private/qsgcompressedtexture_p.h>
@@ -26,6 +29,8 @@
 #include <QtQuick3DRuntimeRender/private/qssglightmapper_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrenderresourceloader_p.h>
 
+#include <optional>
+
 QT_BEGIN_NAMESPACE
 
 //#define QSSG_RENDERBUFFER_DEBUGGING
@@ -46,6 +51,18 @@ QString QSSGBufferManager::runtimeMeshSourceName(const QString &assetId, qsizety
     return QString::fromUtf16(u"!%1@%2").arg(QString::number(meshId), assetId);
 }
 
+// Runs the loading and processing work below on the global thread pool. Without Qt Concurrent it
+// is done right away, and the returned future is already finished.
+template <typename Function>
+static auto runInBackground(Function &&function)
+{
+#ifdef QT_QUICK3D_HAS_CONCURRENT
+    return QtConcurrent::run(std::forward<Function>(function));
+#else
+    return QtFuture::makeReadyFuture(function());
+#endif
+}
+
 using MeshIdxNamePair = QPair<qsizetype, QString>;
 static MeshIdxNamePair splitRuntimeMeshPath(const QSSGRenderPath &rpath)
 {
@@ -87,8 +104,79 @@ static constexpr QSize sizeForMipLevel(int mipLevel, const QSize &baseLevelSize)
     return QSize(qMax(1, baseLevelSize.width() >> mipLevel), qMax(1, baseLevelSize.height() >> mipLevel));
 }
 
+static inline quint64 textureMemorySize(QRhiTexture *texture)
+{
+    quint64 s = 0;
+    if (!texture)
+        return s;
+
+    auto format = texture->format();
+    if (format == QRhiTexture::UnknownFormat)
+        return 0;
+
+    s = texture->pixelSize().width() * texture->pixelSize().height();
+    /*
+        UnknownFormat,
+        RGBA8,
+        BGRA8,
+        R8,
+        RG8,
+        R16,
+        RG16,
+        RED_OR_ALPHA8,
+        RGBA16F,
+        RGBA32F,
+        R16F,
+        R32F,
+        RGB10A2,
+        D16,
+        D24,
+        D24S8,
+        D32F,*/
+    static const quint64 pixelSizes[] = {0, 4, 4, 1, 2, 2, 4, 1, 2, 4, 2, 4, 4, 2, 4, 4, 4};
+    /*
+        BC1,
+        BC2,
+        BC3,
+        BC4,
+        BC5,
+        BC6H,
+        BC7,
+        ETC2_RGB8,
+        ETC2_RGB8A1,
+        ETC2_RGBA8,*/
+    static const quint64 blockSizes[] = {8, 16, 16, 8, 16, 16, 16, 8, 8, 16};
+    Q_STATIC_ASSERT_X(QRhiTexture::BC1 == 17 && QRhiTexture::ETC2_RGBA8 == 26,
+                      "QRhiTexture format constant value missmatch.");
+    if (format < QRhiTexture::BC1)
+        s *= pixelSizes[format];
+    else if (format >= QRhiTexture::BC1 && format <= QRhiTexture::ETC2_RGBA8)
+        s /= blockSizes[format - QRhiTexture::BC1];
+    else
+        s /= 16;
+
+    if (texture->flags() & QRhiTexture::MipMapped)
+        s += s / 4;
+    if (texture->flags() & QRhiTexture::CubeMap)
+        s *= 6;
+    return s;
+}
+
 QSSGBufferManager::QSSGBufferManager()
 {
+    static const quint64 budgetMB = quint64(qMax(0, qEnvironmentVariableIntValue("QT_QUICK3D_RESOURCE_BUDGET_MB")));
+    m_residencyBudget = budgetMB * 1024 * 1024;
+    static const quint64 streamingBudgetMB = quint64(qMax(0, qEnvironmentVariableIntValue("QT_QUICK3D_TEXTURE_STREAMING_BUDGET_MB")));
+    m_textureStreamingBudget = streamingBudgetMB * 1024 * 1024;
+    static const bool textureStreaming = qEnvironmentVariableIntValue("QT_QUICK3D_TEXTURE_STREAMING");
+    m_textureStreamingEnabled = textureStreaming;
+    static const int asyncMeshLoading = qEnvironmentVariableIntValue("QT_QUICK3D_ASYNC_MESH_LOADING");
+    if (asyncMeshLoading == 1)
+        m_meshLoadingMode = MeshLoadingMode::Progressive;
+    else if (asyncMeshLoading == 2)
+        m_meshLoadingMode = MeshLoadingMode::Parallel;
+    static const bool asyncTextureLoading = qEnvironmentVariableIntValue("QT_QUICK3D_ASYNC_TEXTURE_LOADING");
+    m_asyncTextureLoading = asyncTextureLoading;
 }
 
 QSSGBufferManager::~QSSGBufferManager()
@@ -107,9 +195,65 @@ void QSSGBufferManager::releaseCachedResources()
     clear();
 }
 
+bool QSSGBufferManager::canLoadAsynchronously(const QSSGRenderImage *image, MipMode inMipMode, LoadRenderImageFlags flags) const
+{
+    // The placeholder is a 2D texture, it cannot stand in for a cube map or a light probe
+    return m_asyncTextureLoading
+            && !flags.testFlag(LoadSynchronously)
+            && image->type == QSSGRenderGraphObject::Type::Image2D
+            && inMipMode != MipModeBsdf;
+}
+
+QFuture<QSharedPointer<QSSGLoadedTexture>> QSSGBufferManager::loadImageAsync(const QString &path,
+                                                                             const QSSGRenderTextureFormat &format,
+                                                                             bool flipY)
+{
+    return runInBackground([path, format, flipY]() {
+        QSharedPointer<QSSGLoadedTexture> texture(QSSGLoadedTexture::load(path, format, flipY));
+        // The transparency scan is a pass over all the pixels as well, do it here
+        // instead of in createRhiTexture()
+        if (texture && !texture->textureFileData.isValid()) {
+            if (!texture->image.isNull())
+                texture->hasTransparency = QImageData::get(texture->image)->checkForAlphaPixels();
+            else
+                texture->hasTransparency = texture->scanForTransparency();
+            texture->transparencyScanned = true;
+        }
+        return texture;
+    });
+}
+
+QSSGRenderImageTexture QSSGBufferManager::placeholderTexture(LoadRenderImageFlags flags)
+{
+    // Not kept around, the dummy textures are released with the rhi context's cached resources
+    auto context = m_contextInterface->rhiContext();
+    QRhiResourceUpdateBatch *rub = context->rhi()->nextResourceUpdateBatch();
+    const QColor color = flags.testFlag(LoadAsNormalMap) ? QColor(128, 128, 255) : QColor(Qt::white);
+    QSSGRenderImageTexture result;
+    result.m_texture = context->dummyTexture({}, rub, QSize(1, 1), color);
+    context->commandBuffer()->resourceUpdate(rub);
+    return result;
+}
+
+template<typename Key, typename Data>
+void QSSGBufferManager::markUsed(const Key &key, Data &data, Residency<Key> &residency, bool loaded)
+{
+    if (loaded)
+        ++m_residencyStats.misses;
+
+    uint32_t &count = data.usageCounts[currentLayer];
+    if (count++ == 0) {
+        residency.usedByLayer[currentLayer].append(key);
+        if (!loaded)
+            ++m_residencyStats.hits;
+    }
+    data.unusedSerial = 0;
+}
+
 QSSGRenderImageTexture QSSGBufferManager::loadRenderImage(const QSSGRenderImage *image,
                                                           MipMode inMipMode,
-                                                          LoadRenderImageFlags flags)
+                                                          LoadRenderImageFlags flags,
+                                                          quint32 requiredSize)
 {
     if (inMipMode == MipModeFollowRenderImage)
         inMipMode = image->m_generateMipmaps ? MipModeEnable : MipModeDisable;
@@ -141,7 +285,7 @@ QSSGRenderImageTexture QSSGBufferManager::loadRenderImage(const QSSGRenderImage
                 theImage = qsgImageMap.insert(qsgTexture, ImageData());
             theImage.value().renderImageTexture.m_texture = qsgTexture->rhiTexture();
             theImage.value().renderImageTexture.m_flags.setHasTransparency(qsgTexture->hasAlphaChannel());
-            theImage.value().usageCounts[currentLayer]++;
+            markUsed(qsgTexture, theImage.value(), qsgImageResidency, false);
             result = theImage.value().renderImageTexture;
             // inMipMode is ignored completely when sourcing the texture from a
             // QSGTexture. Mipmap generation is not supported, whereas
@@ -164,25 +308,71 @@ QSSGRenderImageTexture QSSGBufferManager::loadRenderImage(const QSSGRenderImage
 
         const ImageCacheKey imageKey = { image->m_imagePath, inMipMode, int(image->type) };
         auto foundIt = imageMap.find(imageKey);
+        bool loaded = false;
         if (foundIt != imageMap.cend()) {
+            if (!streamedTextures.isEmpty())
+                streamTexture(imageKey, foundIt.value(), requiredSize);
             result = foundIt.value().renderImageTexture;
         } else {
-            Q_QUICK3D_PROFILE_START(QQuick3DProfiler::Quick3DTextureLoad);
-            QScopedPointer<QSSGLoadedTexture> theLoadedTexture;
             const auto &path = image->m_imagePath.path();
             const bool flipY = flags.testFlag(LoadWithFlippedY);
-            theLoadedTexture.reset(QSSGLoadedTexture::load(path, image->m_format, flipY));
+            QSharedPointer<QSSGLoadedTexture> theLoadedTexture;
+            auto pendingIt = pendingImageLoads.find(imageKey);
+            if (pendingIt == pendingImageLoads.end() && canLoadAsynchronously(image, inMipMode, flags))
+                pendingIt = pendingImageLoads.insert(imageKey, { loadImageAsync(path, image->m_format, flipY) });
+            // Show a placeholder until the image is decoded, unless we have to wait anyway
+            if (pendingIt != pendingImageLoads.end()) {
+                pendingIt->requested = true;
+                if (!pendingIt->future.isFinished() && !flags.testFlag(LoadSynchronously))
+                    return placeholderTexture(flags);
+            }
+
+            loaded = true;
+            Q_QUICK3D_PROFILE_START(QQuick3DProfiler::Quick3DTextureLoad);
+            if (pendingIt != pendingImageLoads.end()) {
+                theLoadedTexture = pendingIt->future.result();
+                pendingImageLoads.erase(pendingIt);
+            } else {
+                theLoadedTexture.reset(QSSGLoadedTexture::load(path, image->m_format, flipY));
+            }
             if (theLoadedTexture) {
                 foundIt = imageMap.insert(imageKey, ImageData());
                 CreateRhiTextureFlags rhiTexFlags = ScanForTransparency;
                 if (image->type == QSSGRenderGraphObject::Type::ImageCube)
                     rhiTexFlags |= CubeMap;
-                if (!createRhiTexture(foundIt.value().renderImageTexture, theLoadedTexture.data(), inMipMode, rhiTexFlags, QFileInfo(path).fileName())) {
+                // Streamed textures start out with their coarse levels only. Images that are
+                // loaded without a size (custom materials, effects, lightmap baking, ...)
+                // are never streamed.
+                const QTextureFileData &fileData = theLoadedTexture->textureFileData;
+                StreamedTexture streamed;
+                if (m_textureStreamingEnabled && requiredSize > 0 && image->type == QSSGRenderGraphObject::Type::Image2D
+                        && inMipMode != MipModeBsdf && fileData.isValid() && fileData.numLevels() > 1) {
+                    streamed.path = path;
+                    streamed.format = image->m_format;
+                    streamed.flipY = flipY;
+                    streamed.size = fileData.size();
+                    streamed.levelCount = fileData.numLevels();
+                    streamed.residentLevel = streamedMipLevel(streamed, 128);
+                }
+                if (!createRhiTexture(foundIt.value().renderImageTexture, theLoadedTexture.data(), inMipMode, rhiTexFlags, QFileInfo(path).fileName(), streamed.residentLevel)) {
                     foundIt.value() = ImageData();
                 } else {
 #ifdef QSSG_RENDERBUFFER_DEBUGGING
                     qDebug() << "+ uploadTexture: " << image->m_imagePath.path() << currentLayer;
 #endif
+                    if (streamed.levelCount > 0) {
+                        streamed.texture = foundIt.value().renderImageTexture.m_texture;
+                        // Nothing used it yet. The finer levels are already loaded, so
+                        // keep them around for when the next frame asks for them.
+                        streamed.textureSize = textureMemorySize(streamed.texture);
+                        streamed.wantedLevel = streamedMipLevel(streamed, requiredSize);
+                        streamed.lastWantedLevel = streamed.levelCount;
+                        streamed.reload = QtFuture::makeReadyFuture(theLoadedTexture);
+                        m_streamedTextureSize += streamed.textureSize;
+                        m_streamedTextureSize -= streamedTextures.value(imageKey).textureSize;
+                        m_hasPendingStreamLoads = true;
+                        streamedTextures.insert(imageKey, streamed);
+                    }
                 }
                 result = foundIt.value().renderImageTexture;
                 increaseMemoryStat(result.m_texture);
@@ -195,11 +385,110 @@ QSSGRenderImageTexture QSSGBufferManager::loadRenderImage(const QSSGRenderImage
             }
             Q_QUICK3D_PROFILE_END_WITH_STRING(QQuick3DProfiler::Quick3DTextureLoad, stats.imageDataSize, path.toUtf8());
         }
-        foundIt.value().usageCounts[currentLayer]++;
+        markUsed(imageKey, foundIt.value(), imageResidency, loaded);
     }
     return result;
 }
 
+int QSSGBufferManager::streamedMipLevel(const StreamedTexture &streamed, quint32 requiredSize)
+{
+    if (requiredSize == 0)
+        return 0;
+    // The coarsest level that is still at least as large as requested
+    const int size = qMax(streamed.size.width(), streamed.size.height());
+    int level = 0;
+    while (level + 1 < streamed.levelCount && (size >> (level + 1)) >= int(requiredSize))
+        ++level;
+    return level;
+}
+
+int QSSGBufferManager::affordableMipLevel(const StreamedTexture &streamed, int mipLevel) const
+{
+    if (m_textureStreamingBudget == 0)
+        return mipLevel;
+    // Each finer level takes four times the memory of the one before
+    const quint64 othersSize = m_streamedTextureSize - streamed.textureSize;
+    while (mipLevel < streamed.residentLevel
+           && othersSize + (streamed.textureSize << (2 * (streamed.residentLevel - mipLevel))) > m_textureStreamingBudget) {
+        ++mipLevel;
+    }
+    return mipLevel;
+}
+
+void QSSGBufferManager::streamTexture(const ImageCacheKey &key, ImageData &data, quint32 requiredSize)
+{
+    const auto it = streamedTextures.find(key);
+    if (it == streamedTextures.end() || it->texture != data.renderImageTexture.m_texture)
+        return;
+
+    StreamedTexture &streamed = it.value();
+    streamed.wantedLevel = qMin(streamed.wantedLevel, streamedMipLevel(streamed, requiredSize));
+    const int mipLevel = affordableMipLevel(streamed, qMin(streamed.wantedLevel, streamed.lastWantedLevel));
+
+    if (streamed.reload.isValid()) {
+        if (!streamed.reload.isFinished())
+            return;
+        const QSharedPointer<QSSGLoadedTexture> loaded = streamed.reload.result();
+        streamed.reload = {};
+        if (mipLevel == streamed.residentLevel || !loaded
+                || loaded->textureFileData.numLevels() != streamed.levelCount) {
+            return;
+        }
+
+        QSSGRenderImageTexture texture;
+        if (!createRhiTexture(texture, loaded.data(), MipMode(key.mipMode), ScanForTransparency,
+                              QFileInfo(streamed.path).fileName(), mipLevel)) {
+            return;
+        }
+#ifdef QSSG_RENDERBUFFER_DEBUGGING
+        qDebug() << "~ streamTexture: " << streamed.path << streamed.residentLevel << "->" << mipLevel;
+#endif
+        // What got recorded for this frame so far may still use the previous texture
+        decreaseMemoryStat(streamed.texture);
+        m_contextInterface->rhiContext()->releaseTextureLater(streamed.texture);
+        m_streamedTextureSize -= streamed.textureSize;
+        data.renderImageTexture = texture;
+        streamed.texture = texture.m_texture;
+        streamed.textureSize = textureMemorySize(streamed.texture);
+        streamed.residentLevel = mipLevel;
+        increaseMemoryStat(streamed.texture);
+        m_streamedTextureSize += streamed.textureSize;
+        return;
+    }
+
+    // Finer levels are loaded as soon as they are needed. Coarser ones only replace
+    // the texture once it is used at a quarter of its width or less, or when the
+    // streamed textures are over the budget.
+    const bool overBudget = m_textureStreamingBudget != 0 && m_streamedTextureSize > m_textureStreamingBudget;
+    if (mipLevel < streamed.residentLevel || mipLevel > streamed.residentLevel + (overBudget ? 0 : 1)) {
+        streamed.reload = loadImageAsync(streamed.path, streamed.format, streamed.flipY);
+        m_hasPendingStreamLoads = true;
+    }
+}
+
+void QSSGBufferManager::updateStreamedTextures()
+{
+    m_hasPendingStreamLoads = false;
+    for (auto it = streamedTextures.begin(); it != streamedTextures.end(); ) {
+        // Released, or loaded again without streaming
+        const auto imageIt = imageMap.constFind(it.key());
+        if (imageIt == imageMap.cend() || imageIt->renderImageTexture.m_texture != it->texture) {
+            m_streamedTextureSize -= it->textureSize;
+            it = streamedTextures.erase(it);
+            continue;
+        }
+
+        // Nobody asked for the texture twice in a row, the reloaded levels are of no use
+        if (it->wantedLevel == it->levelCount && it->lastWantedLevel == it->levelCount && it->reload.isFinished())
+            it->reload = {};
+        m_hasPendingStreamLoads |= it->reload.isValid();
+
+        it->lastWantedLevel = it->wantedLevel;
+        it->wantedLevel = it->levelCount;
+        ++it;
+    }
+}
+
 QSSGRenderImageTexture QSSGBufferManager::loadTextureData(QSSGRenderTextureData *data, MipMode inMipMode)
 {
     const CustomImageCacheKey imageKey = { data, inMipMode };
@@ -213,7 +502,7 @@ QSSGRenderImageTexture QSSGBufferManager::loadTextureData(QSSGRenderTextureData
         theImageData = customTextureMap.insert(imageKey, ImageData());
     } else {
         // Return the currently loaded texture
-        theImageData.value().usageCounts[currentLayer]++;
+        markUsed(imageKey, theImageData.value(), customTextureResidency, false);
         return theImageData.value().renderImageTexture;
     }
 
@@ -233,7 +522,7 @@ QSSGRenderImageTexture QSSGBufferManager::loadTextureData(QSSGRenderTextureData
         }
     }
 
-    theImageData.value().usageCounts[currentLayer]++;
+    markUsed(imageKey, theImageData.value(), customTextureResidency, true);
     return theImageData.value().renderImageTexture;
 }
 
@@ -245,9 +534,11 @@ QSSGRenderImageTexture QSSGBufferManager::loadLightmap(const QSSGRenderModel &mo
     QSSGRenderImageTexture result;
     const ImageCacheKey imageKey = { QSSGRenderPath(imagePath), MipModeDisable, int(QSSGRenderGraphObject::Type::Image2D) };
     auto foundIt = imageMap.find(imageKey);
+    bool loaded = false;
     if (foundIt != imageMap.end()) {
         result = foundIt.value().renderImageTexture;
     } else {
+        loaded = true;
         Q_QUICK3D_PROFILE_START(QQuick3DProfiler::Quick3DTextureLoad);
         QScopedPointer<QSSGLoadedTexture> theLoadedTexture;
         theLoadedTexture.reset(QSSGLoadedTexture::load(imagePath, format));
@@ -262,7 +553,7 @@ QSSGRenderImageTexture QSSGBufferManager::loadLightmap(const QSSGRenderModel &mo
         increaseMemoryStat(result.m_texture);
         Q_QUICK3D_PROFILE_END_WITH_STRING(QQuick3DProfiler::Quick3DTextureLoad, stats.imageDataSize, imagePath.toUtf8());
     }
-    foundIt.value().usageCounts[currentLayer]++;
+    markUsed(imageKey, foundIt.value(), imageResidency, loaded);
     return result;
 }
 
@@ -853,7 +1144,8 @@ bool QSSGBufferManager::createRhiTexture(QSSGRenderImageTexture &texture,
                                          const QSSGLoadedTexture *inTexture,
                                          MipMode inMipMode,
                                          CreateRhiTextureFlags inFlags,
-                                         const QString &debugObjectName)
+                                         const QString &debugObjectName,
+                                         int baseMipLevel)
 {
     Q_ASSERT(inMipMode != MipModeFollowRenderImage);
     QVarLengthArray<QRhiTextureUploadEntry, 16> textureUploads;
@@ -914,8 +1206,10 @@ bool QSSGBufferManager::createRhiTexture(QSSGRenderImageTexture &texture,
         }
     } else if (inTexture->textureFileData.isValid()) {
         const QTextureFileData &tex = inTexture->textureFileData;
-        size = tex.size();
-        mipmapCount = tex.numLevels();
+        // Levels finer than baseMipLevel are left out (texture streaming)
+        baseMipLevel = qBound(0, baseMipLevel, tex.numLevels() - 1);
+        size = sizeForMipLevel(baseMipLevel, tex.size());
+        mipmapCount = tex.numLevels() - baseMipLevel;
 
         int numFaces = 1;
         // Just having a container with 6 faces is not enough, we only treat it
@@ -924,11 +1218,11 @@ bool QSSGBufferManager::createRhiTexture(QSSGRenderImageTexture &texture,
         if (tex.numFaces() == 6 && inFlags.testFlag(CubeMap))
             numFaces = 6;
 
-        for (int level = 0; level < tex.numLevels(); ++level) {
+        for (int level = 0; level < mipmapCount; ++level) {
             QRhiTextureSubresourceUploadDescription subDesc;
             subDesc.setSourceSize(sizeForMipLevel(level, size));
             for (int face = 0; face < numFaces; ++face) {
-                subDesc.setData(tex.getDataView(level, face).toByteArray());
+                subDesc.setData(tex.getDataView(baseMipLevel + level, face).toByteArray());
                 textureUploads << QRhiTextureUploadEntry{ face, level, subDesc };
             }
         }
@@ -944,15 +1238,17 @@ bool QSSGBufferManager::createRhiTexture(QSSGRenderImageTexture &texture,
             rhiFormat = toRhiFormat(inTexture->format.format);
             size = inTexture->image.size();
             subDesc.setImage(inTexture->image);
-            if (checkTransp)
-                hasTransp = QImageData::get(inTexture->image)->checkForAlphaPixels();
+            if (checkTransp) {
+                hasTransp = inTexture->transparencyScanned ? inTexture->hasTransparency
+                                                           : QImageData::get(inTexture->image)->checkForAlphaPixels();
+            }
         } else if (inTexture->data) {
             rhiFormat = toRhiFormat(inTexture->format.format);
             size = QSize(inTexture->width, inTexture->height);
             QByteArray buf(static_cast<const char *>(inTexture->data), qMax(0, int(inTexture->dataSizeInBytes)));
             subDesc.setData(buf);
             if (checkTransp)
-                hasTransp = inTexture->scanForTransparency();
+                hasTransp = inTexture->transparencyScanned ? inTexture->hasTransparency : inTexture->scanForTransparency();
 
         }
         subDesc.setSourceSize(size);
@@ -1036,28 +1332,44 @@ QSSGMesh::Mesh QSSGBufferManager::loadPrimitive(const QString &inRelativePath)
     return QSSGMesh::Mesh();
 }
 
-QSSGRenderMesh *QSSGBufferManager::loadMesh(const QSSGRenderModel *model)
+static QSSGMeshProcessingOptions meshProcessingOptions(const QSSGRenderModel &model)
 {
     QSSGMeshProcessingOptions options;
-    if (model->hasLightmap()) {
+    if (model.hasLightmap()) {
         options.wantsLightmapUVs = true;
-        options.lightmapBaseResolution = model->lightmapBaseResolution;
+        options.lightmapBaseResolution = model.lightmapBaseResolution;
+        if (!model.meshPath.isNull() || !model.geometry) {
+            options.meshFileOverride = QSSGLightmapper::lightmapAssetPathForLoad(model,
+                                                                                 QSSGLightmapper::LightmapAsset::MeshWithLightmapUV);
+        }
     }
+    return options;
+}
+
+QSSGRenderMesh *QSSGBufferManager::loadMesh(const QSSGRenderModel *model)
+{
+    const QSSGMeshProcessingOptions options = meshProcessingOptions(*model);
 
     QSSGRenderMesh *theMesh = nullptr;
-    if (model->meshPath.isNull() && model->geometry) {
+    if (model->meshPath.isNull() && model->geometry)
         theMesh = loadRenderMesh(model->geometry, options);
-    } else {
-        if (model->hasLightmap()) {
-            options.meshFileOverride = QSSGLightmapper::lightmapAssetPathForLoad(*model,
-                                                                                 QSSGLightmapper::LightmapAsset::MeshWithLightmapUV);
-        }
+    else
         theMesh = loadRenderMesh(model->meshPath, options);
-    }
 
     return theMesh;
 }
 
+void QSSGBufferManager::prefetchMesh(const QSSGRenderModel *model)
+{
+    if (m_meshLoadingMode == MeshLoadingMode::Synchronous || !canLoadMeshAsynchronously(model->meshPath))
+        return;
+
+    const QSSGMeshProcessingOptions options = meshProcessingOptions(*model);
+    const auto meshItr = meshMap.constFind(model->meshPath);
+    if (meshItr == meshMap.cend() || !options.isCompatible(meshItr.value().options))
+        startMeshLoad(model->meshPath, options);
+}
+
 QSSGBounds3 QSSGBufferManager::getModelBounds(const QSSGRenderModel *model) const
 {
     QSSGBounds3 retval;
@@ -1092,9 +1404,12 @@ QSSGBounds3 QSSGBufferManager::getModelBounds(const QSSGRenderModel *model) cons
 
 QSSGRenderMesh *QSSGBufferManager::createRenderMesh(const QSSGMesh::Mesh &mesh, const QString &debugObjectName)
 {
+    static QBasicAtomicInteger<quint32> meshGenerationId = Q_BASIC_ATOMIC_INITIALIZER(0);
+
     QSSGRenderMesh *newMesh = new QSSGRenderMesh(QSSGRenderDrawMode(mesh.drawMode()),
                                                  QSSGRenderWinding(mesh.winding()));
-    const QSSGMesh::Mesh::VertexBuffer vertexBuffer = mesh.vertexBuffer();
+    newMesh->generationId = meshGenerationId.fetchAndAddRelaxed(1) + 1;
+    QSSGMesh::Mesh::VertexBuffer vertexBuffer = mesh.vertexBuffer();
     const QSSGMesh::Mesh::IndexBuffer indexBuffer = mesh.indexBuffer();
     const QSSGMesh::Mesh::TargetBuffer targetBuffer = mesh.targetBuffer();
 
@@ -1125,12 +1440,21 @@ QSSGRenderMesh *QSSGBufferManager::createRenderMesh(const QSSGMesh::Mesh &mesh,
 
     QRhiResourceUpdateBatch *rub = meshBufferUpdateBatch();
     auto context = m_contextInterface->rhiContext();
+    if (!context->rhi()->isFeatureSupported(QRhi::HalfAttributes)) {
+        const auto isHalfFloat = [](const QSSGMesh::Mesh::VertexBufferEntry &entry) {
+            return entry.componentType == QSSGMesh::Mesh::ComponentType::Float16;
+        };
+        if (std::any_of(vertexBuffer.entries.cbegin(), vertexBuffer.entries.cend(), isHalfFloat))
+            vertexBuffer = QSSGMesh::MeshInternal::expandHalfFloatAttributes(vertexBuffer);
+    }
     rhi.vertexBuffer = new QSSGRhiBuffer(*context.data(),
                                          QRhiBuffer::Static,
                                          QRhiBuffer::VertexBuffer,
                                          vertexBuffer.stride,
                                          vertexBuffer.data.size());
     rhi.vertexBuffer->buffer()->setName(debugObjectName.toLatin1()); // this is what shows up in DebugView
+    // The update batch takes a copy of the data, so when that is a view into a memory mapped
+    // file, the mapping can go as soon as the render mesh is created.
     rub->uploadStaticBuffer(rhi.vertexBuffer->buffer(), vertexBuffer.data);
 
     if (!indexBuffer.data.isEmpty()) {
@@ -1250,7 +1574,7 @@ QSSGRenderMesh *QSSGBufferManager::createRenderMesh(const QSSGMesh::Mesh &mesh,
         QSSGRenderSubset subset;
         const QSSGMesh::Mesh::Subset &source(meshSubsets[subsetIdx]);
         subset.bounds = QSSGBounds3(source.bounds.min, source.bounds.max);
-        subset.bvhRoot = nullptr;
+        subset.bvhRoot = QSSGMeshBVH::InvalidRoot;
         subset.count = source.count;
         subset.offset = source.offset;
         for (auto &lod : source.lods)
@@ -1278,6 +1602,7 @@ QSSGRenderMesh *QSSGBufferManager::createRenderMesh(const QSSGMesh::Mesh &mesh,
 void QSSGBufferManager::releaseGeometry(QSSGRenderGeometry *geometry)
 {
     QMutexLocker meshMutexLocker(&meshBufferMutex);
+    pendingLodGenerations.remove(geometry);
     const auto meshItr = customMeshMap.constFind(geometry);
     if (meshItr != customMeshMap.cend()) {
 #ifdef QSSG_RENDERBUFFER_DEBUGGING
@@ -1359,105 +1684,221 @@ void QSSGBufferManager::releaseImage(const ImageCacheKey &key)
     }
 }
 
-void QSSGBufferManager::cleanupUnreferencedBuffers(quint32 frameId, QSSGRenderLayer *currentLayer)
+static inline bool hasGraphicsResources(const QSSGBufferManager::ImageData &data)
 {
-#if !defined(QSSG_RENDERBUFFER_DEBUGGING) && !defined(QSSG_RENDERBUFFER_DEBUGGING_USAGES)
-    Q_UNUSED(currentLayer);
-#endif
+    return data.renderImageTexture.m_texture != nullptr;
+}
 
-    // Don't cleanup if
-    if (frameId == frameCleanupIndex)
+static inline bool hasGraphicsResources(const QSSGBufferManager::MeshData &data)
+{
+    return data.mesh != nullptr;
+}
+
+template<typename Key, typename Data>
+void QSSGBufferManager::resetUsage(QHash<Key, Data> &map, Residency<Key> &residency, QSSGRenderLayer *layer)
+{
+    // Only the resources the layer used in its previous frame have a usage count for it
+    const auto usedIt = residency.usedByLayer.find(layer);
+    if (usedIt == residency.usedByLayer.end())
         return;
 
-    auto isUnused = [] (const QHash<QSSGRenderLayer*, uint32_t> &usages) -> bool {
-        for (const auto &value : std::as_const(usages))
-            if (value != 0)
-                return false;
-        return true;
-    };
+    for (const Key &key : std::as_const(usedIt.value())) {
+        const auto it = map.find(key);
+        if (it != map.end())
+            it.value().usageCounts.remove(layer);
+    }
+    residency.candidates.append(usedIt.value());
+    usedIt.value().clear();
+}
 
-    {
-        QMutexLocker meshMutexLocker(&meshBufferMutex);
-        // Meshes (by path)
-        auto meshIterator = meshMap.cbegin();
-        while (meshIterator != meshMap.cend()) {
-            if (isUnused(meshIterator.value().usageCounts)) {
-#ifdef QSSG_RENDERBUFFER_DEBUGGING
-                qDebug() << "- releaseGeometry: " << meshIterator.key().path() << currentLayer;
-#endif
-                decreaseMemoryStat(meshIterator.value().mesh);
-                m_contextInterface->rhiContext()->releaseMesh(meshIterator.value().mesh);
-                meshIterator = meshMap.erase(meshIterator);
-            } else {
-                ++meshIterator;
-            }
+template<typename Key, typename Data>
+void QSSGBufferManager::queueUnused(QHash<Key, Data> &map, Residency<Key> &residency)
+{
+    for (const Key &key : std::as_const(residency.candidates)) {
+        const auto it = map.find(key);
+        if (it == map.end() || !it.value().usageCounts.isEmpty() || it.value().unusedSerial != 0)
+            continue;
+        if (hasGraphicsResources(it.value())) {
+            it.value().unusedSerial = ++m_residencySerial;
+            residency.evictionQueue.append({ key, it.value().unusedSerial });
+        } else {
+            // Nothing worth keeping, f.ex. an image that failed to load
+            map.erase(it);
         }
+    }
+    residency.candidates.clear();
+}
 
-        // Meshes (custom)
-        auto customMeshIterator = customMeshMap.cbegin();
-        while (customMeshIterator != customMeshMap.cend()) {
-            if (isUnused(customMeshIterator.value().usageCounts)) {
-#ifdef QSSG_RENDERBUFFER_DEBUGGING
-                qDebug() << "- releaseGeometry: " << customMeshIterator.key() << currentLayer;
-#endif
-                decreaseMemoryStat(customMeshIterator.value().mesh);
-                m_contextInterface->rhiContext()->releaseMesh(customMeshIterator.value().mesh);
-                customMeshIterator = customMeshMap.erase(customMeshIterator);
-            } else {
-                ++customMeshIterator;
-            }
+template<typename Key, typename Data>
+quint64 QSSGBufferManager::oldestUnusedSerial(QHash<Key, Data> &map, Residency<Key> &residency)
+{
+    // Skip the resources that got used again, or were released, after being queued
+    while (!residency.evictionQueue.isEmpty()) {
+        const auto &entry = residency.evictionQueue.constFirst();
+        const auto it = map.constFind(entry.first);
+        if (it != map.cend() && it.value().unusedSerial == entry.second)
+            return entry.second;
+        residency.evictionQueue.removeFirst();
+    }
+    return 0;
+}
+
+template<typename Key, typename Data>
+void QSSGBufferManager::evictOldestUnused(QHash<Key, Data> &map, Residency<Key> &residency)
+{
+    const auto it = map.find(residency.evictionQueue.takeFirst().first);
+    releaseResources(it.value());
+    map.erase(it);
+    ++m_residencyStats.evictions;
+}
+
+void QSSGBufferManager::releaseResources(ImageData &data)
+{
+    if (QRhiTexture *rhiTexture = data.renderImageTexture.m_texture) {
+        decreaseMemoryStat(rhiTexture);
+        m_contextInterface->rhiContext()->releaseTexture(rhiTexture);
+    }
+}
+
+void QSSGBufferManager::releaseResources(MeshData &data)
+{
+    if (data.mesh) {
+        decreaseMemoryStat(data.mesh);
+        m_contextInterface->rhiContext()->releaseMesh(data.mesh);
+    }
+}
+
+void QSSGBufferManager::applyGeneratedLevelsOfDetail()
+{
+    for (auto it = pendingLodGenerations.begin(); it != pendingLodGenerations.end(); ) {
+        if (!it->future.isFinished()) {
+            ++it;
+            continue;
+        }
+
+        // Meshes that got evicted or changed since don't need the result anymore
+        auto meshItr = customMeshMap.find(it.key());
+        const QSSGMesh::Mesh mesh = it->future.result();
+        if (meshItr != customMeshMap.end() && meshItr->mesh && meshItr->generationId == it->generationId && mesh.isValid()) {
+            QSSGRenderMesh *lodMesh = createRenderMesh(mesh, it.key()->debugObjectName);
+            // The frame still being recorded draws with the full detail mesh's buffers
+            decreaseMemoryStat(meshItr->mesh);
+            m_contextInterface->rhiContext()->releaseMeshLater(meshItr->mesh);
+            meshItr->mesh = lodMesh;
+            m_contextInterface->rhiContext()->registerMesh(lodMesh);
+            increaseMemoryStat(lodMesh);
         }
+        it = pendingLodGenerations.erase(it);
     }
+}
 
-    // SG Textures
-    auto sgIterator = qsgImageMap.cbegin();
-    while (sgIterator != qsgImageMap.cend()) {
-        if (isUnused(sgIterator.value().usageCounts)) {
-            // Texture is no longer uses, so stop tracking
-            // We do not need to delete/release the texture
-            // because we don't own it.
-            sgIterator = qsgImageMap.erase(sgIterator);
-        } else {
-            ++sgIterator;
+void QSSGBufferManager::evictUnusedResources()
+{
+    const auto overBudget = [this]() {
+        return m_residencyBudget == 0 || stats.meshDataSize + stats.imageDataSize > m_residencyBudget;
+    };
+
+    while (overBudget()) {
+        // Every queue is in least recently used order, so the oldest is at the front of one of them
+        const quint64 serials[] = {
+            oldestUnusedSerial(meshMap, meshResidency),
+            oldestUnusedSerial(customMeshMap, customMeshResidency),
+            oldestUnusedSerial(imageMap, imageResidency),
+            oldestUnusedSerial(customTextureMap, customTextureResidency)
+        };
+        int oldest = -1;
+        for (int i = 0; i < 4; ++i) {
+            if (serials[i] != 0 && (oldest < 0 || serials[i] < serials[oldest]))
+                oldest = i;
+        }
+
+        switch (oldest) {
+        case 0:
+            evictOldestUnused(meshMap, meshResidency);
+            break;
+        case 1:
+            evictOldestUnused(customMeshMap, customMeshResidency);
+            break;
+        case 2:
+            evictOldestUnused(imageMap, imageResidency);
+            break;
+        case 3:
+            evictOldestUnused(customTextureMap, customTextureResidency);
+            break;
+        default:
+            return;
         }
     }
+}
 
-    // Images
-    auto imageKeyIterator = imageMap.cbegin();
-    while (imageKeyIterator != imageMap.cend()) {
-        if (isUnused(imageKeyIterator.value().usageCounts)) {
-            auto rhiTexture = imageKeyIterator.value().renderImageTexture.m_texture;
-            if (rhiTexture) {
-#ifdef QSSG_RENDERBUFFER_DEBUGGING
-                qDebug() << "- releaseTexture: " << imageKeyIterator.key().path.path() << currentLayer;
-#endif
-                decreaseMemoryStat(rhiTexture);
-                m_contextInterface->rhiContext()->releaseTexture(rhiTexture);
-            }
-            imageKeyIterator = imageMap.erase(imageKeyIterator);
+template<typename Key, typename PendingLoad>
+static void dropUnrequestedLoads(QHash<Key, PendingLoad> &pendingLoads)
+{
+    for (auto it = pendingLoads.begin(); it != pendingLoads.end(); ) {
+        if (it->requested) {
+            it->requested = false;
+            ++it;
+        } else if (it->future.isFinished()) {
+            it = pendingLoads.erase(it);
         } else {
-            ++imageKeyIterator;
+            ++it;
         }
     }
+}
 
-    // Custom Texture Data
-    auto textureDataIterator = customTextureMap.cbegin();
-    while (textureDataIterator != customTextureMap.cend()) {
-        if (isUnused(textureDataIterator.value().usageCounts)) {
-            auto rhiTexture = textureDataIterator.value().renderImageTexture.m_texture;
-            if (rhiTexture) {
-#ifdef QSSG_RENDERBUFFER_DEBUGGING
-                qDebug() << "- releaseTextureData: " << textureDataIterator.key() << currentLayer;
+void QSSGBufferManager::cleanupUnreferencedBuffers(quint32 frameId, QSSGRenderLayer *currentLayer)
+{
+#if !defined(QSSG_RENDERBUFFER_DEBUGGING) && !defined(QSSG_RENDERBUFFER_DEBUGGING_USAGES)
+    Q_UNUSED(currentLayer);
 #endif
-                decreaseMemoryStat(rhiTexture);
-                m_contextInterface->rhiContext()->releaseTexture(rhiTexture);
-            }
-            textureDataIterator = customTextureMap.erase(textureDataIterator);
+
+    // Don't cleanup if
+    if (frameId == frameCleanupIndex)
+        return;
+
+    // Only the resources some layer stopped using since the last cleanup can
+    // have become unused, so there is no need to look at the others.
+
+    // SG Textures
+    for (QSGTexture *texture : std::as_const(qsgImageResidency.candidates)) {
+        // Texture is no longer used, so stop tracking. We do not need to
+        // delete/release the texture because we don't own it.
+        const auto it = qsgImageMap.constFind(texture);
+        if (it != qsgImageMap.cend() && it.value().usageCounts.isEmpty())
+            qsgImageMap.erase(it);
+    }
+    qsgImageResidency.candidates.clear();
+
+    // Images and meshes still being loaded, that nobody asked for since the last cleanup
+    dropUnrequestedLoads(pendingImageLoads);
+    dropUnrequestedLoads(pendingMeshLoads);
+    for (auto it = failedMeshLoads.begin(); it != failedMeshLoads.end(); ) {
+        if (it.value()) {
+            it.value() = false;
+            ++it;
         } else {
-            ++textureDataIterator;
+            it = failedMeshLoads.erase(it);
         }
     }
 
+    {
+        QMutexLocker meshMutexLocker(&meshBufferMutex);
+        // The meshes being replaced are only released once the frame is submitted
+        applyGeneratedLevelsOfDetail();
+        queueUnused(meshMap, meshResidency);
+        queueUnused(customMeshMap, customMeshResidency);
+        queueUnused(imageMap, imageResidency);
+        queueUnused(customTextureMap, customTextureResidency);
+        evictUnusedResources();
+    }
+
+    if (!streamedTextures.isEmpty())
+        updateStreamedTextures();
+
+    m_contextInterface->rhiContext()->stats().bufferResidencyChanges(m_residencyStats.hits,
+                                                                      m_residencyStats.misses,
+                                                                      m_residencyStats.evictions);
+
     // Resource Tracking Debug Code
     frameCleanupIndex = frameId;
 #ifdef QSSG_RENDERBUFFER_DEBUGGING_USAGES
@@ -1476,23 +1917,19 @@ void QSSGBufferManager::resetUsageCounters(quint32 frameId, QSSGRenderLayer *lay
         return;
 
     // SG Textures
-    for (auto &imageData : qsgImageMap)
-        imageData.usageCounts[layer] = 0;
+    resetUsage(qsgImageMap, qsgImageResidency, layer);
 
     // Images
-    for (auto &imageData : imageMap)
-        imageData.usageCounts[layer] = 0;
+    resetUsage(imageMap, imageResidency, layer);
 
     // TextureDatas
-    for (auto &imageData : customTextureMap)
-        imageData.usageCounts[layer] = 0;
+    resetUsage(customTextureMap, customTextureResidency, layer);
+
     // Meshes
-    for (auto &meshData : meshMap)
-        meshData.usageCounts[layer] = 0;
+    resetUsage(meshMap, meshResidency, layer);
 
     // Meshes (custom)
-    for (auto &meshData : customMeshMap)
-        meshData.usageCounts[layer] = 0;
+    resetUsage(customMeshMap, customMeshResidency, layer);
 
     frameResetIndex = frameId;
     currentLayer = layer;
@@ -1523,35 +1960,39 @@ QSSGRenderMesh *QSSGBufferManager::loadRenderMesh(const QSSGRenderPath &inMeshPa
     auto meshItr = meshMap.find(inMeshPath);
     if (meshItr != meshMap.cend()) {
         if (options.isCompatible(meshItr.value().options)) {
-            meshItr.value().usageCounts[currentLayer]++;
+            markUsed(inMeshPath, meshItr.value(), meshResidency, false);
             return meshItr.value().mesh;
         } else {
             releaseMesh(inMeshPath);
         }
     }
 
-    Q_QUICK3D_PROFILE_START(QQuick3DProfiler::Quick3DMeshLoad);
-
-    QSSGMesh::Mesh result;
-    QString resultSourcePath;
+    const auto failedItr = failedMeshLoads.find(inMeshPath);
+    if (failedItr != failedMeshLoads.end()) {
+        failedItr.value() = true;
+        return nullptr;
+    }
 
-    if (options.wantsLightmapUVs && !options.meshFileOverride.isEmpty()) {
-        // So now we have a hint, e.g "qlm_xxxx.mesh" that says that if that
-        // file exists, then we should prefer that because it has the lightmap
-        // UV unwrapping and associated rebuilding already done.
-        if (QFileInfo(options.meshFileOverride).exists()) {
-            resultSourcePath = options.meshFileOverride;
-            result = loadMeshData(QSSGRenderPath(options.meshFileOverride));
-        }
+    PendingMeshLoad *pendingLoad = nullptr;
+    if (m_meshLoadingMode != MeshLoadingMode::Synchronous && canLoadMeshAsynchronously(inMeshPath)) {
+        pendingLoad = &startMeshLoad(inMeshPath, options);
+        if (m_meshLoadingMode == MeshLoadingMode::Progressive && !pendingLoad->future.isFinished())
+            return nullptr;
     }
 
-    if (!result.isValid()) {
-        resultSourcePath = inMeshPath.path();
-        result = loadMeshData(inMeshPath);
+    Q_QUICK3D_PROFILE_START(QQuick3DProfiler::Quick3DMeshLoad);
+
+    MeshLoadResult result;
+    if (pendingLoad) {
+        result = pendingLoad->future.result();
+        pendingMeshLoads.remove(inMeshPath);
+    } else {
+        result = loadAndProcessMeshData(inMeshPath, options);
     }
 
-    if (!result.isValid()) {
+    if (!result.mesh.isValid()) {
         qCWarning(WARNING, "Failed to load mesh: %s", qPrintable(inMeshPath.path()));
+        failedMeshLoads.insert(inMeshPath, true);
         Q_QUICK3D_PROFILE_END_WITH_PAYLOAD(QQuick3DProfiler::Quick3DMeshLoad,
                                            stats.meshDataSize);
         return nullptr;
@@ -1560,15 +2001,9 @@ QSSGRenderMesh *QSSGBufferManager::loadRenderMesh(const QSSGRenderPath &inMeshPa
     qDebug() << "+ uploadGeometry: " << inMeshPath.path() << currentLayer;
 #endif
 
-    if (options.wantsLightmapUVs) {
-        // Does nothing if the lightmap uv attribute is already present,
-        // otherwise this is a potentially expensive step that will do UV
-        // unwrapping and rebuild much of the mesh's data.
-        result.createLightmapUVChannel(options.lightmapBaseResolution);
-    }
-
-    auto ret = createRenderMesh(result, QFileInfo(resultSourcePath).fileName());
-    meshMap.insert(inMeshPath, { ret, {{currentLayer, 1}}, 0, options });
+    auto ret = createRenderMesh(result.mesh, QFileInfo(result.sourcePath).fileName());
+    meshItr = meshMap.insert(inMeshPath, { ret, {}, 0, options });
+    markUsed(inMeshPath, meshItr.value(), meshResidency, true);
     m_contextInterface->rhiContext()->registerMesh(ret);
     increaseMemoryStat(ret);
     Q_QUICK3D_PROFILE_END_WITH_STRING(QQuick3DProfiler::Quick3DMeshLoad,
@@ -1576,18 +2011,71 @@ QSSGRenderMesh *QSSGBufferManager::loadRenderMesh(const QSSGRenderPath &inMeshPa
     return ret;
 }
 
+QSSGBufferManager::MeshLoadResult QSSGBufferManager::loadAndProcessMeshData(const QSSGRenderPath &inMeshPath,
+                                                                             const QSSGMeshProcessingOptions &options)
+{
+    MeshLoadResult result;
+
+    if (options.wantsLightmapUVs && !options.meshFileOverride.isEmpty()) {
+        // So now we have a hint, e.g "qlm_xxxx.mesh" that says that if that
+        // file exists, then we should prefer that because it has the lightmap
+        // UV unwrapping and associated rebuilding already done.
+        if (QFileInfo(options.meshFileOverride).exists()) {
+            result.sourcePath = options.meshFileOverride;
+            result.mesh = loadMeshData(QSSGRenderPath(options.meshFileOverride), true);
+        }
+    }
+
+    if (!result.mesh.isValid()) {
+        result.sourcePath = inMeshPath.path();
+        result.mesh = loadMeshData(inMeshPath, true);
+    }
+
+    if (result.mesh.isValid() && options.wantsLightmapUVs) {
+        // Does nothing if the lightmap uv attribute is already present,
+        // otherwise this is a potentially expensive step that will do UV
+        // unwrapping and rebuild much of the mesh's data.
+        result.mesh.createLightmapUVChannel(options.lightmapBaseResolution);
+    }
+
+    return result;
+}
+
+bool QSSGBufferManager::canLoadMeshAsynchronously(const QSSGRenderPath &inMeshPath)
+{
+    // Primitives and meshes registered with registerMeshData() are in memory already
+    const QString &path = inMeshPath.path();
+    return !path.isEmpty() && !path.startsWith(QChar::fromLatin1('#')) && !path.startsWith(u'!');
+}
+
+QSSGBufferManager::PendingMeshLoad &QSSGBufferManager::startMeshLoad(const QSSGRenderPath &inMeshPath,
+                                                                     const QSSGMeshProcessingOptions &options)
+{
+    auto it = pendingMeshLoads.find(inMeshPath);
+    if (it == pendingMeshLoads.end() || !options.isCompatible(it->options)) {
+        auto future = runInBackground([inMeshPath, options]() {
+            return loadAndProcessMeshData(inMeshPath, options);
+        });
+        it = pendingMeshLoads.insert(inMeshPath, { future, options });
+    }
+    it->requested = true;
+    return it.value();
+}
+
 QSSGRenderMesh *QSSGBufferManager::loadRenderMesh(QSSGRenderGeometry *geometry, QSSGMeshProcessingOptions options)
 {
     auto meshIterator = customMeshMap.find(geometry);
     if (meshIterator == customMeshMap.end()) {
         meshIterator = customMeshMap.insert(geometry, MeshData());
+        markUsed(geometry, meshIterator.value(), customMeshResidency, true);
     } else if (geometry->generationId() != meshIterator->generationId || !options.isCompatible(meshIterator->options)) {
         // Release old data
         releaseGeometry(geometry);
         meshIterator = customMeshMap.insert(geometry, MeshData());
+        markUsed(geometry, meshIterator.value(), customMeshResidency, true);
     } else {
         // An up-to-date mesh was found
-        meshIterator.value().usageCounts[currentLayer]++;
+        markUsed(geometry, meshIterator.value(), customMeshResidency, false);
         return meshIterator.value().mesh;
     }
 
@@ -1608,11 +2096,18 @@ QSSGRenderMesh *QSSGBufferManager::loadRenderMesh(QSSGRenderGeometry *geometry,
             }
 
             meshIterator->mesh = createRenderMesh(mesh, geometry->debugObjectName);
-            meshIterator->usageCounts[currentLayer] = 1;
             meshIterator->generationId = geometry->generationId();
             meshIterator->options = options;
             m_contextInterface->rhiContext()->registerMesh(meshIterator->mesh);
             increaseMemoryStat(meshIterator->mesh);
+
+            if (geometry->automaticLevelsOfDetail()) {
+                // Rendered at full detail until the levels of detail are swapped in at the end of a frame
+                auto future = runInBackground([mesh]() mutable {
+                    return mesh.createLevelsOfDetail() ? mesh : QSSGMesh::Mesh();
+                });
+                pendingLodGenerations.insert(geometry, { future, meshIterator->generationId });
+            }
         } else {
             qWarning("Mesh building failed: %s", qPrintable(error));
         }
@@ -1635,14 +2130,14 @@ QSSGMeshBVH *QSSGBufferManager::loadMeshBVH(const QSSGRenderPath &inSourcePath)
     return meshBVHBuilder.buildTree();
 }
 
-QSSGMeshBVH *QSSGBufferManager::loadMeshBVH(QSSGRenderGeometry *geometry)
+static std::optional<QSSGMeshBVHBuilder> meshBVHBuilderForGeometry(const QSSGRenderGeometry *geometry)
 {
     if (!geometry)
-        return nullptr;
+        return std::nullopt;
 
     // We only support generating a BVH with Triangle primitives
     if (geometry->primitiveType() != QSSGMesh::Mesh::DrawMode::Triangles)
-        return nullptr;
+        return std::nullopt;
 
     // Build BVH
     bool hasIndexBuffer = false;
@@ -1670,18 +2165,59 @@ QSSGMeshBVH *QSSGBufferManager::loadMeshBVH(QSSGRenderGeometry *geometry)
         }
     }
 
-    QSSGMeshBVHBuilder meshBVHBuilder(geometry->vertexBuffer(),
-                                      geometry->stride(),
-                                      posOffset,
-                                      hasUV,
-                                      uvOffset,
-                                      hasIndexBuffer,
-                                      geometry->indexBuffer(),
-                                      indexBufferFormat);
-    return meshBVHBuilder.buildTree();
+    // The buffers are implicitly shared, so the builder holds on to the current
+    // contents even if the geometry is updated later on.
+    return QSSGMeshBVHBuilder(geometry->vertexBuffer(),
+                              geometry->stride(),
+                              posOffset,
+                              hasUV,
+                              uvOffset,
+                              hasIndexBuffer,
+                              geometry->indexBuffer(),
+                              indexBufferFormat);
+}
+
+QSSGMeshBVH *QSSGBufferManager::loadMeshBVH(QSSGRenderGeometry *geometry)
+{
+    auto meshBVHBuilder = meshBVHBuilderForGeometry(geometry);
+    if (!meshBVHBuilder)
+        return nullptr;
+    return meshBVHBuilder->buildTree();
+}
+
+QFuture<QSSGMeshBVH *> QSSGBufferManager::loadMeshBVHAsync(const QSSGRenderPath &inSourcePath)
+{
+    // Runtime meshes live in g_assetMeshMap, which is only safe to access from this thread.
+    // The mesh itself is implicitly shared, so only the build has to happen on the worker.
+    if (inSourcePath.path().startsWith(u'!')) {
+        const QSSGMesh::Mesh mesh = loadMeshData(inSourcePath);
+        if (!mesh.isValid()) {
+            qCWarning(WARNING, "Failed to load mesh: %s", qPrintable(inSourcePath.path()));
+            return QtFuture::makeReadyFuture<QSSGMeshBVH *>(nullptr);
+        }
+        return runInBackground([mesh]() {
+            QSSGMeshBVHBuilder meshBVHBuilder(mesh);
+            return meshBVHBuilder.buildTree();
+        });
+    }
+
+    return runInBackground([inSourcePath]() {
+        return loadMeshBVH(inSourcePath);
+    });
 }
 
-QSSGMesh::Mesh QSSGBufferManager::loadMeshData(const QSSGRenderPath &inMeshPath)
+QFuture<QSSGMeshBVH *> QSSGBufferManager::loadMeshBVHAsync(QSSGRenderGeometry *geometry)
+{
+    auto meshBVHBuilder = meshBVHBuilderForGeometry(geometry);
+    if (!meshBVHBuilder)
+        return QtFuture::makeReadyFuture<QSSGMeshBVH *>(nullptr);
+
+    return runInBackground([builder = std::move(*meshBVHBuilder)]() mutable {
+        return builder.buildTree();
+    });
+}
+
+QSSGMesh::Mesh QSSGBufferManager::loadMeshData(const QSSGRenderPath &inMeshPath, bool mapFile)
 {
     QSSGMesh::Mesh result;
 
@@ -1716,7 +2252,8 @@ QSSGMesh::Mesh QSSGBufferManager::loadMeshData(const QSSGRenderPath &inMeshPath)
         if (!pathBuilder.isEmpty()) {
             QSharedPointer<QIODevice> device(QSSGInputUtil::getStreamForFile(pathBuilder));
             if (device) {
-                QSSGMesh::Mesh mesh = QSSGMesh::Mesh::loadMesh(device.data(), id);
+                QSSGMesh::Mesh mesh = mapFile ? QSSGMesh::Mesh::loadMeshMapped(device.data(), id)
+                                              : QSSGMesh::Mesh::loadMesh(device.data(), id);
                 if (mesh.isValid())
                     result = mesh;
             }
@@ -1791,6 +2328,21 @@ void QSSGBufferManager::clear()
     // Textures (QSG)
     // these don't have any owned objects to release so just clearing is fine.
     qsgImageMap.clear();
+
+    // Results of loads that are still running get dropped with the last QFuture
+    pendingImageLoads.clear();
+    pendingMeshLoads.clear();
+    failedMeshLoads.clear();
+    pendingLodGenerations.clear();
+    streamedTextures.clear();
+    m_streamedTextureSize = 0;
+    m_hasPendingStreamLoads = false;
+
+    imageResidency.clear();
+    customTextureResidency.clear();
+    qsgImageResidency.clear();
+    meshResidency.clear();
+    customMeshResidency.clear();
 }
 
 QRhiResourceUpdateBatch *QSSGBufferManager::meshBufferUpdateBatch()
@@ -1825,64 +2377,6 @@ void QSSGBufferManager::processResourceLoader(const QSSGRenderResourceLoader *lo
     commitBufferResourceUpdates();
 }
 
-static inline quint64 textureMemorySize(QRhiTexture *texture)
-{
-    quint64 s = 0;
-    if (!texture)
-        return s;
-
-    auto format = texture->format();
-    if (format == QRhiTexture::UnknownFormat)
-        return 0;
-
-    s = texture->pixelSize().width() * texture->pixelSize().height();
-    /*
-        UnknownFormat,
-        RGBA8,
-        BGRA8,
-        R8,
-        RG8,
-        R16,
-        RG16,
-        RED_OR_ALPHA8,
-        RGBA16F,
-        RGBA32F,
-        R16F,
-        R32F,
-        RGB10A2,
-        D16,
-        D24,
-        D24S8,
-        D32F,*/
-    static const quint64 pixelSizes[] = {0, 4, 4, 1, 2, 2, 4, 1, 2, 4, 2, 4, 4, 2, 4, 4, 4};
-    /*
-        BC1,
-        BC2,
-        BC3,
-        BC4,
-        BC5,
-        BC6H,
-        BC7,
-        ETC2_RGB8,
-        ETC2_RGB8A1,
-        ETC2_RGBA8,*/
-    static const quint64 blockSizes[] = {8, 16, 16, 8, 16, 16, 16, 8, 8, 16};
-    Q_STATIC_ASSERT_X(QRhiTexture::BC1 == 17 && QRhiTexture::ETC2_RGBA8 == 26,
-                      "QRhiTexture format constant value missmatch.");
-    if (format < QRhiTexture::BC1)
-        s *= pixelSizes[format];
-    else if (format >= QRhiTexture::BC1 && format <= QRhiTexture::ETC2_RGBA8)
-        s /= blockSizes[format - QRhiTexture::BC1];
-    else
-        s /= 16;
-
-    if (texture->flags() & QRhiTexture::MipMapped)
-        s += s / 4;
-    if (texture->flags() & QRhiTexture::CubeMap)
-        s *= 6;
-    return s;
-}
-
 static inline quint64 bufferMemorySize(const QSSGRef<QSSGRhiBuffer> &buffer)
 {
     quint64 s = 0;
@@ -26,6 +26,8 @@
 #include <QtQuick3DUtils/private/qquick3dprofiler_p.h>
 
 #include <QtCore/QMutex>
+#include <QtCore/qfuture.h>
+#include <QtCore/qsharedpointer.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -88,10 +90,14 @@ public:
         int mipMode;
     };
 
+    // usageCounts only has entries for the layers that used the resource in
+    // their current frame. unusedSerial is non-zero while the resource is
+    // unused, but kept resident, and orders it in the eviction queue.
     struct ImageData {
         QSSGRenderImageTexture renderImageTexture;
         QHash<QSSGRenderLayer*, uint32_t> usageCounts;
         uint32_t generationId = 0;
+        quint64 unusedSerial = 0;
     };
 
     struct MeshData {
@@ -99,6 +105,7 @@ public:
         QHash<QSSGRenderLayer*, uint32_t> usageCounts;
         uint32_t generationId = 0;
         QSSGMeshProcessingOptions options;
+        quint64 unusedSerial = 0;
     };
 
     struct MemoryStats {
@@ -106,6 +113,12 @@ public:
         quint64 imageDataSize = 0;
     };
 
+    struct ResidencyStats {
+        quint64 hits = 0;       // resident resource used for the first time in a frame
+        quint64 misses = 0;     // resource loaded
+        quint64 evictions = 0;  // unused resource released
+    };
+
     enum MipMode {
         MipModeFollowRenderImage,
         MipModeEnable,
@@ -113,8 +126,24 @@ public:
         MipModeBsdf
     };
 
+    // How meshes loaded from files (except for the built-in primitives) get loaded.
+    // The default is Synchronous, unless set with QT_QUICK3D_ASYNC_MESH_LOADING
+    // (1 for Progressive, 2 for Parallel).
+    enum class MeshLoadingMode {
+        // On the render thread, when first needed
+        Synchronous,
+        // On the thread pool, all the meshes a frame needs at once. The frame waits for them.
+        Parallel,
+        // On the thread pool. Models are not rendered until their mesh is loaded.
+        Progressive
+    };
+
     enum LoadRenderImageFlag {
-        LoadWithFlippedY = 0x01
+        LoadWithFlippedY = 0x01,
+        // Never return the placeholder texture, even with QT_QUICK3D_ASYNC_TEXTURE_LOADING
+        LoadSynchronously = 0x02,
+        // The image is a tangent space normal map, its placeholder is a flat normal
+        LoadAsNormalMap = 0x04
     };
     Q_DECLARE_FLAGS(LoadRenderImageFlags, LoadRenderImageFlag)
 
@@ -125,20 +154,55 @@ public:
 
     void releaseCachedResources();
 
+    // requiredSize is the size, in pixels, the image covers on screen. It
+    // only matters for streamed textures (see textureStreamingEnabled()),
+    // 0 asks for the full resolution. Only images loaded with a size are
+    // streamed, the others always have all their levels.
     QSSGRenderImageTexture loadRenderImage(const QSSGRenderImage *image,
                                            MipMode inMipMode = MipModeFollowRenderImage,
-                                           LoadRenderImageFlags flags = LoadWithFlippedY);
+                                           LoadRenderImageFlags flags = LoadWithFlippedY,
+                                           quint32 requiredSize = 0);
     QSSGRenderImageTexture loadLightmap(const QSSGRenderModel &model);
+    // True while images are decoded in the background, and loadRenderImage()
+    // returns a placeholder for them. See QT_QUICK3D_ASYNC_TEXTURE_LOADING.
+    bool asyncTextureLoading() const { return m_asyncTextureLoading; }
+    void setAsyncTextureLoading(bool enable) { m_asyncTextureLoading = enable; }
+    bool hasPendingImageLoads() const { return !pendingImageLoads.isEmpty() || m_hasPendingStreamLoads; }
+
+    // With QT_QUICK3D_TEXTURE_STREAMING=1 mipmapped .ktx textures are first
+    // uploaded with only their coarse levels. The finer levels get loaded in
+    // the background once the texture is used at a size that needs them, and
+    // are dropped again when it no longer is. The memory used by streamed
+    // textures is bounded by textureStreamingBudget().
+    bool textureStreamingEnabled() const { return m_textureStreamingEnabled; }
+    void setTextureStreamingEnabled(bool enable) { m_textureStreamingEnabled = enable; }
+    // 0 (the default, unless set with QT_QUICK3D_TEXTURE_STREAMING_BUDGET_MB) is unbounded
+    quint64 textureStreamingBudget() const { return m_textureStreamingBudget; }
+    void setTextureStreamingBudget(quint64 bytes) { m_textureStreamingBudget = bytes; }
 
     QSSGRenderMesh *getMeshForPicking(const QSSGRenderModel &model) const;
     QSSGBounds3 getModelBounds(const QSSGRenderModel *model) const;
 
+    // Returns nullptr for meshes that are still loading with MeshLoadingMode::Progressive
     QSSGRenderMesh *loadMesh(const QSSGRenderModel *model);
+    // Starts loading the mesh on the thread pool, unless it is loaded synchronously
+    void prefetchMesh(const QSSGRenderModel *model);
+    MeshLoadingMode meshLoadingMode() const { return m_meshLoadingMode; }
+    void setMeshLoadingMode(MeshLoadingMode mode) { m_meshLoadingMode = mode; }
+    bool hasPendingMeshLoads() const { return !pendingMeshLoads.isEmpty() || !pendingLodGenerations.isEmpty(); }
 
     // Called at the end of the frame to release unreferenced geometry and textures
     void cleanupUnreferencedBuffers(quint32 frameId, QSSGRenderLayer *layer);
     void resetUsageCounters(quint32 frameId, QSSGRenderLayer *layer);
 
+    // Unused meshes and textures stay resident, least recently used ones
+    // being released first, for as long as the total size of the mesh and
+    // image data is within the budget. 0 (the default, unless set with
+    // QT_QUICK3D_RESOURCE_BUDGET_MB) releases them as soon as they are unused.
+    quint64 residencyBudget() const { return m_residencyBudget; }
+    void setResidencyBudget(quint64 bytes) { m_residencyBudget = bytes; }
+    const ResidencyStats &residencyStats() const { return m_residencyStats; }
+
     void releaseGeometry(QSSGRenderGeometry *geometry);
     void releaseTextureData(const QSSGRenderTextureData *data);
     void releaseTextureData(const CustomImageCacheKey &key);
@@ -149,8 +213,14 @@ public:
 
     static QSSGMeshBVH *loadMeshBVH(const QSSGRenderPath &inSourcePath);
     static QSSGMeshBVH *loadMeshBVH(QSSGRenderGeometry *geometry);
-
-    static QSSGMesh::Mesh loadMeshData(const QSSGRenderPath &inSourcePath);
+    // Same as loadMeshBVH(), but the tree is built on the global thread pool. Anything that
+    // isn't safe to access from another thread is resolved before returning.
+    static QFuture<QSSGMeshBVH *> loadMeshBVHAsync(const QSSGRenderPath &inSourcePath);
+    static QFuture<QSSGMeshBVH *> loadMeshBVHAsync(QSSGRenderGeometry *geometry);
+
+    // With mapFile, the buffers of meshes loaded from files refer to a memory mapping of
+    // the file (see QSSGMesh::Mesh::loadMeshMapped()) instead of being read into memory.
+    static QSSGMesh::Mesh loadMeshData(const QSSGRenderPath &inSourcePath, bool mapFile = false);
     QSSGMesh::Mesh loadMeshData(const QSSGRenderGeometry *geometry);
 
     static QRhiTexture::Format toRhiFormat(const QSSGRenderTextureFormat format);
@@ -188,11 +258,37 @@ private:
                           const QSSGLoadedTexture *inTexture,
                           MipMode inMipMode,
                           CreateRhiTextureFlags inFlags,
-                          const QString &debugObjectName);
+                          const QString &debugObjectName,
+                          int baseMipLevel = 0);
 
     QSSGRenderMesh *loadRenderMesh(const QSSGRenderPath &inSourcePath, QSSGMeshProcessingOptions options);
+
+    struct MeshLoadResult
+    {
+        QSSGMesh::Mesh mesh;
+        QString sourcePath;
+    };
+    // Everything loadRenderMesh() does before creating the buffers, safe to call from any thread.
+    // The mesh is only good for uploading, as the file is memory mapped.
+    static MeshLoadResult loadAndProcessMeshData(const QSSGRenderPath &inSourcePath,
+                                                 const QSSGMeshProcessingOptions &options);
+    static bool canLoadMeshAsynchronously(const QSSGRenderPath &inSourcePath);
+    struct PendingMeshLoad;
+    PendingMeshLoad &startMeshLoad(const QSSGRenderPath &inSourcePath, const QSSGMeshProcessingOptions &options);
     QSSGRenderMesh *loadRenderMesh(QSSGRenderGeometry *geometry, QSSGMeshProcessingOptions options);
 
+    bool canLoadAsynchronously(const QSSGRenderImage *image, MipMode inMipMode, LoadRenderImageFlags flags) const;
+    static QFuture<QSharedPointer<QSSGLoadedTexture>> loadImageAsync(const QString &path,
+                                                                     const QSSGRenderTextureFormat &format,
+                                                                     bool flipY);
+    QSSGRenderImageTexture placeholderTexture(LoadRenderImageFlags flags);
+
+    struct StreamedTexture;
+    static int streamedMipLevel(const StreamedTexture &streamed, quint32 requiredSize);
+    int affordableMipLevel(const StreamedTexture &streamed, int mipLevel) const;
+    void streamTexture(const ImageCacheKey &key, ImageData &data, quint32 requiredSize);
+    void updateStreamedTextures();
+
     QSSGRenderMesh *createRenderMesh(const QSSGMesh::Mesh &mesh, const QString &debugObjectName = {});
     QSSGRenderImageTexture loadTextureData(QSSGRenderTextureData *data, MipMode inMipMode);
     bool createEnvironmentMap(const QSSGLoadedTexture *inImage, QSSGRenderImageTexture *outTexture, const QString &debugObjectName);
@@ -200,6 +296,41 @@ private:
     void releaseMesh(const QSSGRenderPath &inSourcePath);
     void releaseImage(const ImageCacheKey &key);
 
+    // Bookkeeping of the resources of one of the maps below, so that the
+    // per-frame work only touches the resources that were actually used.
+    template<typename Key>
+    struct Residency
+    {
+        // The resources each layer used in its current frame
+        QHash<QSSGRenderLayer *, QList<Key>> usedByLayer;
+        // Resources a layer stopped using since the last cleanup
+        QList<Key> candidates;
+        // Unused resources kept resident, least recently used first
+        QList<std::pair<Key, quint64>> evictionQueue;
+
+        void clear()
+        {
+            usedByLayer.clear();
+            candidates.clear();
+            evictionQueue.clear();
+        }
+    };
+
+    template<typename Key, typename Data>
+    void markUsed(const Key &key, Data &data, Residency<Key> &residency, bool loaded);
+    template<typename Key, typename Data>
+    void resetUsage(QHash<Key, Data> &map, Residency<Key> &residency, QSSGRenderLayer *layer);
+    template<typename Key, typename Data>
+    void queueUnused(QHash<Key, Data> &map, Residency<Key> &residency);
+    template<typename Key, typename Data>
+    static quint64 oldestUnusedSerial(QHash<Key, Data> &map, Residency<Key> &residency);
+    template<typename Key, typename Data>
+    void evictOldestUnused(QHash<Key, Data> &map, Residency<Key> &residency);
+    void releaseResources(ImageData &data);
+    void releaseResources(MeshData &data);
+    void evictUnusedResources();
+    void applyGeneratedLevelsOfDetail();
+
     QSSGRenderContextInterface *m_contextInterface = nullptr; // ContextInterfaces owns BufferManager
 
     // These store the actual buffer handles
@@ -212,6 +343,66 @@ private:
     QRhiResourceUpdateBatch *meshBufferUpdates = nullptr;
     QMutex meshBufferMutex;
 
+    struct PendingImageLoad
+    {
+        QFuture<QSharedPointer<QSSGLoadedTexture>> future;
+        bool requested = true; // since the last cleanup
+    };
+    QHash<ImageCacheKey, PendingImageLoad> pendingImageLoads;
+
+    struct PendingMeshLoad
+    {
+        QFuture<MeshLoadResult> future;
+        QSSGMeshProcessingOptions options;
+        bool requested = true; // since the last cleanup
+    };
+    QHash<QSSGRenderPath, PendingMeshLoad> pendingMeshLoads;
+    // Meshes that failed to load, so that they aren't loaded (and warned about) again every
+    // frame. The value tells if the path was requested since the last cleanup, the ones that
+    // weren't are dropped and get loaded again when a model refers to them once more.
+    QHash<QSSGRenderPath, bool> failedMeshLoads;
+
+    // Levels of detail being generated for custom geometry, see
+    // QSSGRenderGeometry::automaticLevelsOfDetail()
+    struct PendingLodGeneration
+    {
+        QFuture<QSSGMesh::Mesh> future;
+        uint32_t generationId = 0;
+    };
+    QHash<QSSGRenderGeometry *, PendingLodGeneration> pendingLodGenerations;
+
+    MeshLoadingMode m_meshLoadingMode = MeshLoadingMode::Synchronous;
+    bool m_asyncTextureLoading = false;
+
+    struct StreamedTexture
+    {
+        QString path;
+        QSSGRenderTextureFormat format;
+        bool flipY = false;
+        QSize size;              // of the finest level in the file
+        int levelCount = 0;      // in the file
+        QRhiTexture *texture = nullptr;
+        quint64 textureSize = 0;
+        int residentLevel = 0;   // finest level in the texture
+        int wantedLevel = 0;     // finest level used since the last cleanup
+        int lastWantedLevel = 0; // the same, for the cleanup before that
+        QFuture<QSharedPointer<QSSGLoadedTexture>> reload;
+    };
+    QHash<ImageCacheKey, StreamedTexture> streamedTextures;
+    quint64 m_streamedTextureSize = 0;
+    quint64 m_textureStreamingBudget = 0;
+    bool m_textureStreamingEnabled = false;
+    bool m_hasPendingStreamLoads = false;
+
+    Residency<ImageCacheKey> imageResidency;
+    Residency<CustomImageCacheKey> customTextureResidency;
+    Residency<QSGTexture *> qsgImageResidency;
+    Residency<QSSGRenderPath> meshResidency;
+    Residency<QSSGRenderGeometry *> customMeshResidency;
+    quint64 m_residencySerial = 0;
+    quint64 m_residencyBudget = 0;
+    ResidencyStats m_residencyStats;
+
     quint32 frameCleanupIndex = 0;
     quint32 frameResetIndex = 0;
     QSSGRenderLayer *currentLayer = nullptr;
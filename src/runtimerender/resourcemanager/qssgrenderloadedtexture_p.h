@@ -62,6 +62,9 @@ public:
     QSSGRenderTextureFormat format = QSSGRenderTextureFormat::RGBA8;
     // #TODO: There should be more ways to influence this (hints on the texture)
     bool isSRGB = false;
+    // Result of the transparency scan, when it was already done while loading
+    bool transparencyScanned = false;
+    bool hasTransparency = false;
 
     ~QSSGLoadedTexture();
     void setFormatFromComponents()
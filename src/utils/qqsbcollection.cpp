@@ -3,6 +3,7 @@
 
 #include "qqsbcollection_p.h"
 #include <QtCore/QLockFile>
+#include <QtCore/QFileInfo>
 #include <QtCore/QSaveFile>
 #include <QtCore/QCryptographicHash>
 #include <QtGui/private/qrhi_p.h>
@@ -83,17 +84,19 @@ bool QQsbCollection::readEndHeader(QDataStream &ds, qint64 *startPos, quint8 *ve
     return true;
 }
 
-bool QQsbCollection::readEndHeader(QIODevice *device, EntryMap *entries, quint8 *version)
+bool QQsbCollection::readEndHeader(QIODevice *device, EntryMap *entries, quint8 *version, qint64 *startPos)
 {
     bool result = false;
     const qint64 size = device->size();
     if (device->seek(size - HeaderSize)) {
         QDataStream ds(device);
         ds.setVersion(QDataStream::Qt_6_0);
-        qint64 startPos = 0;
-        if (readEndHeader(ds, &startPos, version)) {
-            if (startPos >= 0 && startPos < size && device->seek(startPos)) {
+        qint64 indexPos = 0;
+        if (readEndHeader(ds, &indexPos, version)) {
+            if (indexPos >= 0 && indexPos < size && device->seek(indexPos)) {
                 ds >> *entries;
+                if (startPos)
+                    *startPos = indexPos;
                 result = true;
             }
         }
@@ -296,6 +299,8 @@ bool QQsbIODeviceCollection::map(MapMode mode)
 
     if (!ret)
         unmap();
+    else if (devOwner == DeviceOwner::Self)
+        mappedData = file.map(0, file.size()); // Falls back to seek and read if this fails
 
     return ret;
 }
@@ -310,6 +315,10 @@ void QQsbIODeviceCollection::unmap()
                 file.remove();
         }
     }
+    if (mappedData) {
+        file.unmap(mappedData);
+        mappedData = nullptr;
+    }
     device.close();
     entries.clear();
 }
@@ -339,6 +348,14 @@ bool QQsbIODeviceCollection::extractEntry(Entry entry, EntryDesc &entryDesc)
         const qint64 offset = entry.value;
         if (entry.isValid() && offset >= 0) {
             const qint64 size = device.size();
+            if (size > offset && mappedData) {
+                const QByteArray data = QByteArray::fromRawData(reinterpret_cast<const char *>(mappedData) + offset,
+                                                                size - offset);
+                QDataStream ds(data);
+                ds.setVersion(QDataStream::Qt_6_0);
+                ds >> entryDesc;
+                return true;
+            }
             if (size > offset && device.seek(offset)) {
                 QDataStream ds(&device);
                 ds.setVersion(QDataStream::Qt_6_0);
@@ -395,4 +412,300 @@ void QQsbIODeviceCollection::dumpInfo(QIODevice &device)
     qsbc.dumpInfo();
 }
 
+static constexpr quint64 MagicaJournal = 0x3933333335346338;
+// The journal is merged into the base file on close once it is larger than
+// this, and larger than a quarter of the base file.
+static constexpr qint64 MinCompactJournalSize = 1024 * 1024;
+
+// Journal layout: magic and Qt version, followed by (key, serialized entry)
+// records, both written as QByteArray. Returns the size of the journal up to
+// the end of the last complete record, or -1 if the journal has no valid header.
+static qint64 scanJournal(QIODevice *device, QQsbCollection::EntryMap *entries)
+{
+    if (!device->seek(0))
+        return -1;
+
+    QDataStream ds(device);
+    ds.setVersion(QDataStream::Qt_6_0);
+    quint64 fileId = 0;
+    quint32 qtver = 0;
+    ds >> fileId >> qtver;
+    if (ds.status() != QDataStream::Ok || fileId != MagicaJournal || qtver != QtVersion)
+        return -1;
+
+    const qint64 size = device->size();
+    qint64 validSize = device->pos();
+    while (validSize < size) {
+        QByteArray key;
+        quint32 entrySize = 0;
+        ds >> key >> entrySize;
+        const qint64 entryPos = device->pos();
+        // A process that crashed while appending leaves an incomplete record behind
+        if (ds.status() != QDataStream::Ok || key.isEmpty() || entryPos + qint64(entrySize) > size)
+            break;
+        entries->insert(QQsbCollection::Entry(key, entryPos));
+        validSize = entryPos + qint64(entrySize);
+        if (!device->seek(validSize))
+            break;
+    }
+
+    return validSize;
+}
+
+QQsbPersistentCollection::QQsbPersistentCollection(const QString &filePath)
+    : filePath(filePath)
+    , base(filePath)
+    , journal(journalFileName(filePath))
+{
+}
+
+QQsbPersistentCollection::~QQsbPersistentCollection()
+{
+    close();
+}
+
+QString QQsbPersistentCollection::journalFileName(const QString &filePath)
+{
+    return filePath + QLatin1String(".journal");
+}
+
+bool QQsbPersistentCollection::open(bool loadExisting)
+{
+    close();
+
+    QLockFile lock(lockFileName(filePath));
+    if (!lock.lock()) {
+        qWarning("Could not create shader cache lock file '%s'",
+                 qPrintable(lock.fileName()));
+        return false;
+    }
+
+    if (!journal.open(QIODevice::ReadWrite)) {
+        qWarning("Failed to open qsbc journal %s", qPrintable(journal.fileName()));
+        return false;
+    }
+
+    EntryMap existingJournalEntries;
+    const qint64 validSize = scanJournal(&journal, &existingJournalEntries);
+    if (validSize < 0) {
+        journal.resize(0);
+        journal.seek(0);
+        QDataStream ds(&journal);
+        ds.setVersion(QDataStream::Qt_6_0);
+        ds << MagicaJournal << QtVersion;
+        existingJournalEntries.clear();
+    } else if (validSize != journal.size()) {
+        journal.resize(validSize);
+    }
+    if (!journal.flush()) {
+        qWarning("Failed to write qsbc journal %s", qPrintable(journal.fileName()));
+        journal.close();
+        return false;
+    }
+
+    if (loadExisting) {
+        journalEntries = existingJournalEntries;
+        if (QFileInfo::exists(filePath)) {
+            if (base.map(QQsbIODeviceCollection::Read))
+                baseEntries = base.availableEntries();
+            else
+                qWarning("Ignoring qsbc file %s", qPrintable(filePath));
+        }
+    }
+
+    isOpen = true;
+    return true;
+}
+
+bool QQsbPersistentCollection::needsCompaction() const
+{
+    const qint64 journalSize = journal.size();
+    return journalSize > MinCompactJournalSize && journalSize > QFileInfo(filePath).size() / 4;
+}
+
+void QQsbPersistentCollection::close()
+{
+    if (!isOpen)
+        return;
+
+    const bool compactJournal = needsCompaction();
+
+    base.unmap();
+    baseEntries.clear();
+    journal.close();
+    journalEntries.clear();
+    isOpen = false;
+
+    if (compactJournal)
+        compact();
+}
+
+bool QQsbPersistentCollection::compact()
+{
+    const bool wasOpen = isOpen;
+    if (wasOpen) {
+        // The files need to be closed, as the base file is replaced
+        base.unmap();
+        baseEntries.clear();
+        journal.close();
+        journalEntries.clear();
+        isOpen = false;
+    }
+
+    bool result = false;
+    {
+        // Everything is read from disk again, as other processes may have added entries
+        QLockFile lock(lockFileName(filePath));
+        QFile journalFile(journalFileName(filePath));
+        EntryMap pendingEntries;
+        if (!lock.lock()) {
+            qWarning("Could not create shader cache lock file '%s'",
+                     qPrintable(lock.fileName()));
+        } else if (!journalFile.open(QIODevice::ReadOnly) || scanJournal(&journalFile, &pendingEntries) < 0
+                   || pendingEntries.isEmpty()) {
+            result = true; // Nothing to merge
+        } else {
+            QFile baseFile(filePath);
+            EntryMap existingEntries;
+            qint64 indexPos = 0;
+            uchar *baseData = nullptr;
+            if (baseFile.exists() && baseFile.open(QIODevice::ReadOnly)) {
+                quint8 version = 0;
+                if (readEndHeader(&baseFile, &existingEntries, &version, &indexPos) && indexPos > 0)
+                    baseData = baseFile.map(0, indexPos);
+                if (!baseData)
+                    existingEntries.clear();
+            }
+
+#if QT_CONFIG(temporaryfile)
+            QSaveFile f(filePath);
+#else
+            QFile f(filePath + QLatin1String(".tmp"));
+#endif
+            if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                qWarning("Failed to write qsbc file %s", qPrintable(filePath));
+            } else {
+                EntryMap entryMap;
+
+                // The entries are stored back to back in front of the index, so each one
+                // ends where the next one starts. They are copied without being decoded.
+                QVector<qint64> offsets;
+                offsets.reserve(existingEntries.size() + 1);
+                for (const Entry &e : std::as_const(existingEntries))
+                    offsets.push_back(e.value);
+                offsets.push_back(indexPos);
+                std::sort(offsets.begin(), offsets.end());
+                for (const Entry &e : std::as_const(existingEntries)) {
+                    const auto next = std::upper_bound(offsets.cbegin(), offsets.cend(), e.value);
+                    if (!e.isValid() || e.value < 0 || next == offsets.cend())
+                        continue;
+                    entryMap.insert(Entry(e.key, f.pos()));
+                    f.write(reinterpret_cast<const char *>(baseData) + e.value, *next - e.value);
+                }
+
+                QDataStream ds(&journalFile);
+                ds.setVersion(QDataStream::Qt_6_0);
+                for (const Entry &e : std::as_const(pendingEntries)) {
+                    if (entryMap.contains(e) || !journalFile.seek(e.value - qint64(sizeof(quint32))))
+                        continue;
+                    quint32 entrySize = 0;
+                    ds >> entrySize;
+                    const QByteArray entryData = journalFile.read(entrySize);
+                    if (entryData.size() != qsizetype(entrySize))
+                        continue;
+                    entryMap.insert(Entry(e.key, f.pos()));
+                    f.write(entryData);
+                }
+
+                writeEndHeader(&f, entryMap);
+
+                if (baseData)
+                    baseFile.unmap(baseData);
+                baseFile.close();
+                journalFile.close();
+
+#if QT_CONFIG(temporaryfile)
+                result = f.commit();
+#else
+                f.close();
+                QFile::remove(filePath);
+                result = f.rename(filePath);
+#endif
+                if (result)
+                    QFile::remove(journalFileName(filePath));
+                else
+                    qWarning("Failed to write qsbc file %s", qPrintable(filePath));
+            }
+        }
+    }
+
+    if (wasOpen)
+        open();
+
+    return result;
+}
+
+QQsbCollection::EntryMap QQsbPersistentCollection::availableEntries() const
+{
+    EntryMap entries = baseEntries;
+    entries.unite(journalEntries);
+    return entries;
+}
+
+QQsbCollection::Entry QQsbPersistentCollection::addEntry(const QByteArray &key, const EntryDesc &entryDesc)
+{
+    const Entry e(key);
+    if (!isOpen || !e.isValid() || journalEntries.contains(e) || baseEntries.contains(e))
+        return {}; // can only add with a given key once
+
+    QByteArray entryData;
+    {
+        QDataStream ds(&entryData, QIODevice::WriteOnly);
+        ds.setVersion(QDataStream::Qt_6_0);
+        ds << entryDesc;
+    }
+    QByteArray record;
+    {
+        QDataStream ds(&record, QIODevice::WriteOnly);
+        ds.setVersion(QDataStream::Qt_6_0);
+        ds << key << entryData;
+    }
+
+    QLockFile lock(lockFileName(filePath));
+    if (!lock.lock()) {
+        qWarning("Could not create shader cache lock file '%s'",
+                 qPrintable(lock.fileName()));
+        return {};
+    }
+
+    const qint64 recordPos = journal.size();
+    if (!journal.seek(recordPos) || journal.write(record) != record.size() || !journal.flush()) {
+        qWarning("Failed to write qsbc journal %s", qPrintable(journal.fileName()));
+        return {};
+    }
+
+    const Entry added(key, recordPos + record.size() - entryData.size());
+    journalEntries.insert(added);
+    return added;
+}
+
+bool QQsbPersistentCollection::extractEntry(Entry entry, EntryDesc &entryDesc)
+{
+    auto it = journalEntries.constFind(entry);
+    if (it != journalEntries.cend()) {
+        if (!journal.seek(it->value))
+            return false;
+        QDataStream ds(&journal);
+        ds.setVersion(QDataStream::Qt_6_0);
+        ds >> entryDesc;
+        return ds.status() == QDataStream::Ok;
+    }
+
+    it = baseEntries.constFind(entry);
+    if (it != baseEntries.cend())
+        return base.extractEntry(*it, entryDesc);
+
+    return false;
+}
+
 QT_END_NAMESPACE
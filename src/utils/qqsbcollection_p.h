@@ -87,7 +87,7 @@ protected:
     };
     bool readEndHeader(QDataStream &ds, qint64 *startPos, quint8 *version);
     void writeEndHeader(QDataStream &ds, qint64 startPos, quint8 version, quint64 magic);
-    bool readEndHeader(QIODevice *device, EntryMap *entries, quint8 *version);
+    bool readEndHeader(QIODevice *device, EntryMap *entries, quint8 *version, qint64 *startPos = nullptr);
     void writeEndHeader(QIODevice *device, const EntryMap &entries);
 };
 
@@ -124,7 +124,9 @@ private:
     QHash<Entry, EntryDesc> entries;
 };
 
-// Serial, direct-to/from-QIODevice implementation.
+// Serial, direct-to/from-QIODevice implementation. When reading a file the
+// collection opened itself, the file is memory mapped and entries are decoded
+// directly from the mapping when they are extracted.
 class Q_QUICK3DUTILS_EXPORT QQsbIODeviceCollection : public QQsbCollection
 {
 public:
@@ -161,9 +163,49 @@ private:
     QIODevice &device;
     DeviceOwner devOwner = DeviceOwner::Self;
     quint8 version = Version::Unknown;
+    uchar *mappedData = nullptr;
     EntryMap entries;
 };
 
+// Persistent collection made of a compacted base file, in the same format as
+// the other implementations, and a journal file next to it. Opening only reads
+// the indices, the base file is mapped and entries are decoded on extraction.
+// New entries are appended to the journal as they are added, so they survive
+// a crash, and the journal is merged into the base file on close once it has
+// grown large enough compared to the base file.
+class Q_QUICK3DUTILS_EXPORT QQsbPersistentCollection : public QQsbCollection
+{
+public:
+    explicit QQsbPersistentCollection(const QString &filePath);
+    ~QQsbPersistentCollection();
+
+    // When 'loadExisting' is false the existing entries are ignored, but still
+    // kept on disk.
+    bool open(bool loadExisting = true);
+    void close();
+    // Merges the journal into the base file, this is done by close() when needed.
+    bool compact();
+
+    EntryMap availableEntries() const override;
+    Entry addEntry(const QByteArray &key, const EntryDesc &entryDesc) override;
+    bool extractEntry(Entry entry, EntryDesc &entryDesc) override;
+
+    qsizetype journalEntryCount() const { return journalEntries.size(); }
+    static QString journalFileName(const QString &filePath);
+
+private:
+    Q_DISABLE_COPY(QQsbPersistentCollection);
+
+    bool needsCompaction() const;
+
+    QString filePath;
+    QQsbIODeviceCollection base;
+    EntryMap baseEntries;
+    QFile journal;
+    EntryMap journalEntries; // value is the offset of the serialized entry in the journal
+    bool isOpen = false;
+};
+
 QT_END_NAMESPACE
 
 #endif // QQSBCOLLECTION_H
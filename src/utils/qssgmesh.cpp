@@ -4,8 +4,10 @@
 #include "qssgmesh_p.h"
 
 #include <QtCore/QVector>
+#include <QtCore/QFile>
 #include <QtQuick3DUtils/private/qssgdataref_p.h>
 #include <QtQuick3DUtils/private/qssglightmapuvgenerator_p.h>
+#include <QtQuick3DUtils/private/qssgmeshbvhbuilder_p.h>
 
 #include "meshoptimizer.h"
 
@@ -40,6 +42,12 @@ static const size_t SUBSET_STRUCT_SIZE_V6 = 52;
 //lod entry: count, offset, distance
 static const size_t LOD_STRUCT_SIZE = 12;
 
+// bvh section: rootCount, nodeCount, triangleCount
+static const size_t BVH_STRUCT_SIZE = 12;
+// bvh node: minXYZ, maxXYZ, offset, count (same as QSSGMeshBVHNode)
+static const size_t BVH_NODE_STRUCT_SIZE = 32;
+static_assert(sizeof(QSSGMeshBVHNode) == BVH_NODE_STRUCT_SIZE);
+
 MeshInternal::MultiMeshInfo MeshInternal::readFileHeader(QIODevice *device)
 {
     const qint64 multiHeaderStartOffset = device->size() - qint64(MULTI_HEADER_STRUCT_SIZE);
@@ -92,7 +100,102 @@ void MeshInternal::writeFileHeader(QIODevice *device, const MeshInternal::MultiM
     outputStream << meshFileInfo.fileId << meshFileInfo.fileVersion << multiEntriesOffset << meshCount;
 }
 
-quint64 MeshInternal::readMeshData(QIODevice *device, quint64 offset, Mesh *mesh, MeshDataHeader *header)
+static QByteArray readBufferData(QIODevice *device, quint32 size, const QByteArray &mappedFile)
+{
+    const qint64 pos = device->pos();
+    if (!mappedFile.isEmpty() && pos + size <= mappedFile.size()) {
+        device->seek(pos + size);
+        return QByteArray::fromRawData(mappedFile.constData() + pos, size);
+    }
+    return device->read(size);
+}
+
+// Compressed buffers use meshoptimizer's codecs: vertex data (and the target data, as
+// vec4 texels) is encoded per vertex, index data of triangle lists as triangles. The
+// index codec may rotate the vertices of a triangle, but keeps the winding and the order
+// of the triangles. An empty result means the buffer is better stored as-is.
+static QByteArray encodeVertexData(const QByteArray &data, quint32 vertexSize)
+{
+    if (vertexSize == 0 || vertexSize % 4 != 0 || vertexSize > 256 || data.size() % vertexSize != 0)
+        return {};
+
+    const size_t vertexCount = data.size() / vertexSize;
+    QByteArray encoded(meshopt_encodeVertexBufferBound(vertexCount, vertexSize), Qt::Uninitialized);
+    const size_t encodedSize = meshopt_encodeVertexBuffer(reinterpret_cast<unsigned char *>(encoded.data()),
+                                                          encoded.size(),
+                                                          data.constData(),
+                                                          vertexCount,
+                                                          vertexSize);
+    if (encodedSize == 0 || encodedSize >= size_t(data.size()))
+        return {};
+    encoded.resize(encodedSize);
+    return encoded;
+}
+
+static QByteArray encodeIndexData(const QByteArray &data, Mesh::ComponentType componentType, Mesh::DrawMode drawMode)
+{
+    if (drawMode != Mesh::DrawMode::Triangles)
+        return {};
+    if (componentType != Mesh::ComponentType::UnsignedInt16 && componentType != Mesh::ComponentType::UnsignedInt32)
+        return {};
+
+    const quint32 indexSize = MeshInternal::byteSizeForComponentType(componentType);
+    const size_t indexCount = data.size() / indexSize;
+    if (indexCount == 0 || indexCount % 3 != 0 || data.size() % indexSize != 0)
+        return {};
+
+    QVector<quint32> indices(indexCount);
+    quint32 vertexCount = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        if (indexSize == sizeof(quint16))
+            indices[i] = reinterpret_cast<const quint16 *>(data.constData())[i];
+        else
+            indices[i] = reinterpret_cast<const quint32 *>(data.constData())[i];
+        vertexCount = qMax(vertexCount, indices[i] + 1);
+    }
+
+    QByteArray encoded(meshopt_encodeIndexBufferBound(indexCount, vertexCount), Qt::Uninitialized);
+    const size_t encodedSize = meshopt_encodeIndexBuffer(reinterpret_cast<unsigned char *>(encoded.data()),
+                                                         encoded.size(),
+                                                         indices.constData(),
+                                                         indexCount);
+    if (encodedSize == 0 || encodedSize >= size_t(data.size()))
+        return {};
+    encoded.resize(encodedSize);
+    return encoded;
+}
+
+static QByteArray decodeVertexData(const QByteArray &encoded, quint32 vertexSize, quint32 dataSize)
+{
+    if (vertexSize == 0 || dataSize % vertexSize != 0)
+        return {};
+
+    QByteArray data(dataSize, Qt::Uninitialized);
+    const int result = meshopt_decodeVertexBuffer(data.data(),
+                                                  dataSize / vertexSize,
+                                                  vertexSize,
+                                                  reinterpret_cast<const unsigned char *>(encoded.constData()),
+                                                  encoded.size());
+    return result == 0 ? data : QByteArray();
+}
+
+static QByteArray decodeIndexData(const QByteArray &encoded, Mesh::ComponentType componentType, quint32 dataSize)
+{
+    const quint32 indexSize = MeshInternal::byteSizeForComponentType(componentType);
+    if ((indexSize != sizeof(quint16) && indexSize != sizeof(quint32)) || dataSize % indexSize != 0)
+        return {};
+
+    QByteArray data(dataSize, Qt::Uninitialized);
+    const int result = meshopt_decodeIndexBuffer(data.data(),
+                                                 dataSize / indexSize,
+                                                 indexSize,
+                                                 reinterpret_cast<const unsigned char *>(encoded.constData()),
+                                                 encoded.size());
+    return result == 0 ? data : QByteArray();
+}
+
+quint64 MeshInternal::readMeshData(QIODevice *device, quint64 offset, Mesh *mesh, MeshDataHeader *header,
+                                   const QByteArray &mappedFile)
 {
     static char alignPadding[4] = {};
 
@@ -228,15 +331,35 @@ quint64 MeshInternal::readMeshData(QIODevice *device, quint64 offset, Mesh *mesh
         }
     }
 
-    mesh->m_vertexBuffer.data = device->read(vertexBufferDataSize);
-    alignAmount = offsetTracker.alignedAdvance(vertexBufferDataSize);
-    if (alignAmount)
-        device->read(alignPadding, alignAmount);
+    // Compressed buffers are preceded by their encoded size, 0 when stored as-is. The
+    // decoder function is only called for the encoded ones.
+    const bool compressedBuffers = header->hasCompressedBuffers();
+    bool decodingFailed = false;
+    const auto readBuffer = [&](quint32 dataSize, const auto &decode) {
+        quint32 encodedSize = 0;
+        if (compressedBuffers) {
+            inputStream >> encodedSize;
+            offsetTracker.advance(sizeof(quint32));
+        }
+        const quint32 storedSize = encodedSize ? encodedSize : dataSize;
+        QByteArray data = readBufferData(device, storedSize, mappedFile);
+        const quint32 paddingSize = offsetTracker.alignedAdvance(storedSize);
+        if (paddingSize)
+            device->read(alignPadding, paddingSize);
+        if (encodedSize) {
+            data = decode(data);
+            decodingFailed |= (quint32(data.size()) != dataSize);
+        }
+        return data;
+    };
 
-    mesh->m_indexBuffer.data = device->read(indexBufferDataSize);
-    alignAmount = offsetTracker.alignedAdvance(indexBufferDataSize);
-    if (alignAmount)
-        device->read(alignPadding, alignAmount);
+    mesh->m_vertexBuffer.data = readBuffer(vertexBufferDataSize, [mesh, vertexBufferDataSize](const QByteArray &encoded) {
+        return decodeVertexData(encoded, mesh->m_vertexBuffer.stride, vertexBufferDataSize);
+    });
+
+    mesh->m_indexBuffer.data = readBuffer(indexBufferDataSize, [mesh, indexBufferDataSize](const QByteArray &encoded) {
+        return decodeIndexData(encoded, mesh->m_indexBuffer.componentType, indexBufferDataSize);
+    });
 
     quint32 subsetByteSize = 0;
     QVector<MeshInternal::Subset> internalSubsets;
@@ -345,7 +468,9 @@ quint64 MeshInternal::readMeshData(QIODevice *device, quint64 offset, Mesh *mesh
                     device->read(alignPadding, alignAmount);
             }
 
-            mesh->m_targetBuffer.data = device->read(targetBufferDataSize);
+            mesh->m_targetBuffer.data = readBuffer(targetBufferDataSize, [targetBufferDataSize](const QByteArray &encoded) {
+                return decodeVertexData(encoded, 4 * sizeof(float), targetBufferDataSize);
+            });
         } else {
             // remove target entries from vertexbuffer entries
             mesh->m_vertexBuffer.entries.remove(vertexBufferEntriesCount - targetBufferEntriesCount,
@@ -375,6 +500,41 @@ quint64 MeshInternal::readMeshData(QIODevice *device, quint64 offset, Mesh *mesh
         }
     }
 
+    if (decodingFailed) {
+        qWarning("Failed to decode compressed mesh data");
+        return 0;
+    }
+
+    // The BVH section is found through its size, which is the last field of the mesh data
+    if (header->hasBvhSection()) {
+        const quint64 endOffset = offset + MESH_HEADER_STRUCT_SIZE + header->sizeInBytes;
+        device->seek(endOffset - sizeof(quint32));
+        quint32 bvhSectionSize = 0;
+        inputStream >> bvhSectionSize;
+        if (bvhSectionSize >= BVH_STRUCT_SIZE) {
+            device->seek(endOffset - sizeof(quint32) - bvhSectionSize);
+            quint32 rootCount = 0;
+            quint32 nodeCount = 0;
+            quint32 triangleCount = 0;
+            inputStream >> rootCount >> nodeCount >> triangleCount;
+            const quint64 expectedSize = BVH_STRUCT_SIZE
+                    + quint64(rootCount) * sizeof(qint32)
+                    + quint64(nodeCount) * BVH_NODE_STRUCT_SIZE
+                    + quint64(triangleCount) * sizeof(quint32);
+            if (expectedSize == bvhSectionSize) {
+                Mesh::BvhData &bvhData(mesh->m_bvhData);
+                bvhData.roots.resize(rootCount);
+                for (quint32 i = 0; i < rootCount; ++i)
+                    inputStream >> bvhData.roots[i];
+                // Nodes and triangle indices are stored as-is, no need to go through the stream
+                bvhData.nodes = device->read(nodeCount * BVH_NODE_STRUCT_SIZE);
+                bvhData.triangleIndices = device->read(triangleCount * sizeof(quint32));
+            } else {
+                qWarning("Mesh BVH section is invalid, ignoring it");
+            }
+        }
+    }
+
     return header->sizeInBytes;
 }
 
@@ -396,8 +556,9 @@ void MeshInternal::writeMeshHeader(QIODevice *device, const MeshDataHeader &head
 // that's also legacy nonsense, but having that allows the reader not have to
 // branch based on the version.
 
-quint64 MeshInternal::writeMeshData(QIODevice *device, const Mesh &mesh)
+quint64 MeshInternal::writeMeshData(QIODevice *device, const Mesh &mesh, const MeshDataHeader &header)
 {
+    const bool compressBuffers = header.hasCompressedBuffers();
     static const char alignPadding[4] = {};
 
     QDataStream outputStream(device);
@@ -466,15 +627,25 @@ quint64 MeshInternal::writeMeshData(QIODevice *device, const Mesh &mesh)
             device->write(alignPadding, alignAmount);
     }
 
-    device->write(mesh.m_vertexBuffer.data.constData(), vertexBufferDataSize);
-    alignAmount = offsetTracker.alignedAdvance(vertexBufferDataSize);
-    if (alignAmount)
-        device->write(alignPadding, alignAmount);
-
-    device->write(mesh.m_indexBuffer.data.constData(), indexBufferDataSize);
-    alignAmount = offsetTracker.alignedAdvance(indexBufferDataSize);
-    if (alignAmount)
-        device->write(alignPadding, alignAmount);
+    // See readMeshData() for the layout of compressed buffers
+    const auto writeBuffer = [&](const QByteArray &data, const QByteArray &encoded) {
+        const QByteArray &stored = encoded.isEmpty() ? data : encoded;
+        const quint32 storedSize = stored.size();
+        if (compressBuffers) {
+            outputStream << quint32(encoded.size());
+            offsetTracker.advance(sizeof(quint32));
+        }
+        device->write(stored.constData(), storedSize);
+        const quint32 paddingSize = offsetTracker.alignedAdvance(storedSize);
+        if (paddingSize)
+            device->write(alignPadding, paddingSize);
+    };
+
+    writeBuffer(mesh.m_vertexBuffer.data,
+                compressBuffers ? encodeVertexData(mesh.m_vertexBuffer.data, vertexBufferStride) : QByteArray());
+    writeBuffer(mesh.m_indexBuffer.data,
+                compressBuffers ? encodeIndexData(mesh.m_indexBuffer.data, mesh.m_indexBuffer.componentType, mesh.m_drawMode)
+                                : QByteArray());
 
     quint32 subsetByteSize = 0;
     for (quint32 i = 0; i < subsetsCount; ++i) {
@@ -562,7 +733,28 @@ quint64 MeshInternal::writeMeshData(QIODevice *device, const Mesh &mesh)
             device->write(alignPadding, alignAmount);
     }
 
-    device->write(mesh.m_targetBuffer.data.constData(), targetBufferDataSize);
+    writeBuffer(mesh.m_targetBuffer.data,
+                compressBuffers ? encodeVertexData(mesh.m_targetBuffer.data, 4 * sizeof(float)) : QByteArray());
+
+    // BVH
+    quint32 bvhSectionSize = 0;
+    const Mesh::BvhData &bvhData(mesh.m_bvhData);
+    if (header.hasBvhSection() && !bvhData.nodes.isEmpty()) {
+        const quint32 rootCount = bvhData.roots.size();
+        const quint32 nodeCount = bvhData.nodes.size() / BVH_NODE_STRUCT_SIZE;
+        const quint32 triangleCount = bvhData.triangleIndices.size() / sizeof(quint32);
+        outputStream << rootCount << nodeCount << triangleCount;
+        for (qint32 root : bvhData.roots)
+            outputStream << root;
+        device->write(bvhData.nodes.constData(), nodeCount * BVH_NODE_STRUCT_SIZE);
+        device->write(bvhData.triangleIndices.constData(), triangleCount * sizeof(quint32));
+        bvhSectionSize = BVH_STRUCT_SIZE
+                + rootCount * sizeof(qint32)
+                + nodeCount * BVH_NODE_STRUCT_SIZE
+                + triangleCount * sizeof(quint32);
+    }
+    if (header.hasBvhSection())
+        outputStream << bvhSectionSize;
 
     const quint32 endPos = device->pos();
     const quint32 sizeInBytes = endPos - startPos;
@@ -570,25 +762,51 @@ quint64 MeshInternal::writeMeshData(QIODevice *device, const Mesh &mesh)
     return sizeInBytes;
 }
 
-Mesh Mesh::loadMesh(QIODevice *device, quint32 id)
+static Mesh readMesh(QIODevice *device, quint32 id, const QByteArray &mappedFile)
 {
     MeshInternal::MeshDataHeader header;
     const MeshInternal::MultiMeshInfo meshFileInfo = MeshInternal::readFileHeader(device);
     auto it = meshFileInfo.meshEntries.constFind(id);
     if (it != meshFileInfo.meshEntries.constEnd()) {
         Mesh mesh;
-        quint64 size = MeshInternal::readMeshData(device, *it, &mesh, &header);
+        quint64 size = MeshInternal::readMeshData(device, *it, &mesh, &header, mappedFile);
         if (size)
             return mesh;
     } else if (id == 0 && !meshFileInfo.meshEntries.isEmpty()) {
         Mesh mesh;
-        quint64 size = MeshInternal::readMeshData(device, *meshFileInfo.meshEntries.cbegin(), &mesh, &header);
+        quint64 size = MeshInternal::readMeshData(device, *meshFileInfo.meshEntries.cbegin(), &mesh, &header, mappedFile);
         if (size)
             return mesh;
     }
     return Mesh();
 }
 
+Mesh Mesh::loadMesh(QIODevice *device, quint32 id)
+{
+    return readMesh(device, id, {});
+}
+
+Mesh Mesh::loadMeshMapped(QIODevice *device, quint32 id)
+{
+    // The mapping has to stay valid after the caller closes the device, so it
+    // comes from a file the mesh keeps open
+    QSharedPointer<QFile> mappedFile;
+    QByteArray mappedData;
+    if (QFile *file = qobject_cast<QFile *>(device)) {
+        mappedFile.reset(new QFile(file->fileName()));
+        const uchar *data = mappedFile->open(QIODevice::ReadOnly) ? mappedFile->map(0, mappedFile->size()) : nullptr;
+        if (data)
+            mappedData = QByteArray::fromRawData(reinterpret_cast<const char *>(data), mappedFile->size());
+        else
+            mappedFile.reset();
+    }
+
+    Mesh mesh = readMesh(device, id, mappedData);
+    if (mesh.isValid())
+        mesh.m_mappedFile = mappedFile;
+    return mesh;
+}
+
 QMap<quint32, Mesh> Mesh::loadAll(QIODevice *device)
 {
     MeshInternal::MeshDataHeader header;
@@ -902,7 +1120,7 @@ Mesh Mesh::fromRuntimeData(const RuntimeMeshData &data, QString *error)
     return mesh;
 }
 
-quint32 Mesh::save(QIODevice *device, quint32 id) const
+quint32 Mesh::save(QIODevice *device, quint32 id, bool compressBuffers) const
 {
     qint64 newMeshStartPosFromEnd = 0;
     quint32 newId = 1;
@@ -932,10 +1150,11 @@ quint32 Mesh::save(QIODevice *device, quint32 id) const
     const qint64 meshOffset = device->pos();
     header.meshEntries.insert(newId, meshOffset);
 
-    MeshInternal::MeshDataHeader meshHeader = MeshInternal::MeshDataHeader::withDefaults();
+    MeshInternal::MeshDataHeader meshHeader = MeshInternal::MeshDataHeader::withDefaults(
+            compressBuffers ? MeshInternal::MeshDataHeader::CompressedBuffers : 0, hasBvhData());
     // skip the space for the mesh header for now
     device->seek(device->pos() + MESH_HEADER_STRUCT_SIZE);
-    meshHeader.sizeInBytes = MeshInternal::writeMeshData(device, *this);
+    meshHeader.sizeInBytes = MeshInternal::writeMeshData(device, *this, meshHeader);
     // now the mesh header is ready to be written out
     device->seek(meshOffset);
     MeshInternal::writeMeshHeader(device, meshHeader);
@@ -946,6 +1165,39 @@ quint32 Mesh::save(QIODevice *device, quint32 id) const
     return newId;
 }
 
+Mesh::VertexBuffer MeshInternal::expandHalfFloatAttributes(const Mesh::VertexBuffer &vertexBuffer)
+{
+    Mesh::VertexBuffer result;
+    result.entries = vertexBuffer.entries;
+    quint32 stride = 0;
+    for (Mesh::VertexBufferEntry &entry : result.entries) {
+        if (entry.componentType == Mesh::ComponentType::Float16)
+            entry.componentType = Mesh::ComponentType::Float32;
+        entry.offset = (stride + 3) & ~3;
+        stride = entry.offset + entry.componentCount * byteSizeForComponentType(entry.componentType);
+    }
+    result.stride = (stride + 3) & ~3;
+
+    const quint32 vertexCount = vertexBuffer.stride ? vertexBuffer.data.size() / vertexBuffer.stride : 0;
+    result.data.resize(vertexCount * result.stride);
+    result.data.fill(0);
+    for (quint32 vertexIdx = 0; vertexIdx < vertexCount; ++vertexIdx) {
+        for (qsizetype entryIdx = 0, end = result.entries.size(); entryIdx < end; ++entryIdx) {
+            const Mesh::VertexBufferEntry &srcEntry(vertexBuffer.entries[entryIdx]);
+            const Mesh::VertexBufferEntry &dstEntry(result.entries[entryIdx]);
+            const char *src = vertexBuffer.data.constData() + vertexIdx * vertexBuffer.stride + srcEntry.offset;
+            char *dst = result.data.data() + vertexIdx * result.stride + dstEntry.offset;
+            if (srcEntry.componentType == Mesh::ComponentType::Float16) {
+                for (quint32 i = 0; i < srcEntry.componentCount; ++i)
+                    reinterpret_cast<float *>(dst)[i] = float(reinterpret_cast<const qfloat16 *>(src)[i]);
+            } else {
+                memcpy(dst, src, srcEntry.componentCount * byteSizeForComponentType(srcEntry.componentType));
+            }
+        }
+    }
+    return result;
+}
+
 QSSGBounds3 MeshInternal::calculateSubsetBounds(const Mesh::VertexBufferEntry &entry,
                                                 const QByteArray &vertexBufferData,
                                                 quint32 vertexBufferStride,
@@ -1036,6 +1288,9 @@ bool Mesh::createLightmapUVChannel(uint lightmapBaseResolution)
     quint32 positionOffset = UINT32_MAX;
     quint32 normalOffset = UINT32_MAX;
     quint32 uvOffset = UINT32_MAX;
+    // Normals and UVs may be quantized to half floats, normals then have a 4th (padding) component
+    bool halfFloatNormals = false;
+    bool halfFloatUVs = false;
 
     for (const VertexBufferEntry &vbe : std::as_const(m_vertexBuffer.entries)) {
         if (vbe.name == posAttrName) {
@@ -1045,7 +1300,8 @@ bool Mesh::createLightmapUVChannel(uint lightmapBaseResolution)
             }
             positionOffset = vbe.offset;
         } else if (vbe.name == normalAttrName) {
-            if (vbe.componentCount != 3) {
+            halfFloatNormals = (vbe.componentType == ComponentType::Float16);
+            if (vbe.componentCount != 3 && !(halfFloatNormals && vbe.componentCount == 4)) {
                 qWarning("Lightmap UV unwrapping encountered a Mesh non-float3 normal data, this cannot happen");
                 return false;
             }
@@ -1055,10 +1311,16 @@ bool Mesh::createLightmapUVChannel(uint lightmapBaseResolution)
                 qWarning("Lightmap UV unwrapping encountered a Mesh non-float2 UV0 data, this cannot happen");
                 return false;
             }
+            halfFloatUVs = (vbe.componentType == ComponentType::Float16);
             uvOffset = vbe.offset;
         }
     }
 
+    const auto readComponent = [](const char *ptr, int component, bool halfFloat) {
+        return halfFloat ? float(reinterpret_cast<const qfloat16 *>(ptr)[component])
+                         : reinterpret_cast<const float *>(ptr)[component];
+    };
+
     if (positionOffset == UINT32_MAX) {
         qWarning("Lightmap UV unwrapping encountered a Mesh without vertex positions, this cannot happen");
         return false;
@@ -1081,11 +1343,10 @@ bool Mesh::createLightmapUVChannel(uint lightmapBaseResolution)
         normalData.resize(vertexCount * 3 * sizeof(float));
         float *normPtr = reinterpret_cast<float *>(normalData.data());
         for (qsizetype i = 0; i < vertexCount; ++i) {
-            const char *vertexBasePtr = srcVertexData + i * srcVertexStride;
-            const float *srcNormal = reinterpret_cast<const float *>(vertexBasePtr + normalOffset);
-            *normPtr++ = *srcNormal++;
-            *normPtr++ = *srcNormal++;
-            *normPtr++ = *srcNormal++;
+            const char *srcNormal = srcVertexData + i * srcVertexStride + normalOffset;
+            *normPtr++ = readComponent(srcNormal, 0, halfFloatNormals);
+            *normPtr++ = readComponent(srcNormal, 1, halfFloatNormals);
+            *normPtr++ = readComponent(srcNormal, 2, halfFloatNormals);
         }
     }
 
@@ -1094,10 +1355,9 @@ bool Mesh::createLightmapUVChannel(uint lightmapBaseResolution)
         uvData.resize(vertexCount * 2 * sizeof(float));
         float *uvPtr = reinterpret_cast<float *>(uvData.data());
         for (qsizetype i = 0; i < vertexCount; ++i) {
-            const char *vertexBasePtr = srcVertexData + i * srcVertexStride;
-            const float *srcUv = reinterpret_cast<const float *>(vertexBasePtr + uvOffset);
-            *uvPtr++ = *srcUv++;
-            *uvPtr++ = *srcUv++;
+            const char *srcUv = srcVertexData + i * srcVertexStride + uvOffset;
+            *uvPtr++ = readComponent(srcUv, 0, halfFloatUVs);
+            *uvPtr++ = readComponent(srcUv, 1, halfFloatUVs);
         }
     }
 
@@ -1235,9 +1495,121 @@ bool Mesh::createLightmapUVChannel(uint lightmapBaseResolution)
     for (Subset &subset : m_subsets)
         subset.lightmapSizeHint = lightmapSizeHint;
 
+    // The geometry changed, a precomputed BVH may not match it anymore
+    m_bvhData = {};
+
     return true;
 }
 
+bool Mesh::createBvhData()
+{
+    if (m_drawMode != DrawMode::Triangles)
+        return false;
+
+    QSSGMeshBVHBuilder builder(*this);
+    m_bvhData = builder.buildBvhData();
+    return hasBvhData();
+}
+
+bool Mesh::createLevelsOfDetail()
+{
+    if (m_drawMode != DrawMode::Triangles || m_indexBuffer.data.isEmpty())
+        return false;
+
+    // The positions are simplified in place, which needs a float aligned stride
+    const quint32 stride = m_vertexBuffer.stride;
+    if (stride == 0 || stride % sizeof(float) != 0 || stride > 256)
+        return false;
+
+    const char *posAttrName = MeshInternal::getPositionAttrName();
+    quint32 positionOffset = UINT32_MAX;
+    for (const VertexBufferEntry &vbe : std::as_const(m_vertexBuffer.entries)) {
+        if (vbe.name == posAttrName && vbe.componentType == ComponentType::Float32 && vbe.componentCount == 3)
+            positionOffset = vbe.offset;
+    }
+    if (positionOffset == UINT32_MAX || positionOffset % sizeof(float) != 0)
+        return false;
+
+    const quint32 indexSize = MeshInternal::byteSizeForComponentType(m_indexBuffer.componentType);
+    if (indexSize != sizeof(quint16) && indexSize != sizeof(quint32))
+        return false;
+
+    const size_t vertexCount = m_vertexBuffer.data.size() / stride;
+    const quint32 indexCount = m_indexBuffer.data.size() / indexSize;
+    const char *indexData = m_indexBuffer.data.constData();
+    const float *positions = reinterpret_cast<const float *>(m_vertexBuffer.data.constData() + positionOffset);
+    const float scaleFactor = meshopt_simplifyScale(positions, vertexCount, stride);
+    const float targetError = std::numeric_limits<float>::max(); // error doesn't matter, index count is more important
+
+    QByteArray lodIndexData;
+    bool created = false;
+    for (Subset &subset : m_subsets) {
+        if (!subset.lods.isEmpty() || subset.count % 3 != 0 || quint64(subset.offset) + subset.count > indexCount)
+            continue;
+
+        QVector<quint32> indexes(subset.count);
+        bool validIndexes = true;
+        for (quint32 i = 0; i < subset.count; ++i) {
+            const char *src = indexData + (subset.offset + i) * indexSize;
+            indexes[i] = indexSize == sizeof(quint16) ? *reinterpret_cast<const quint16 *>(src)
+                                                      : *reinterpret_cast<const quint32 *>(src);
+            validIndexes &= (indexes[i] < vertexCount);
+        }
+        if (!validIndexes)
+            continue;
+
+        // Same progression as the asset importer: starting from a handful of triangles,
+        // keep raising the target until the result gets close to the original.
+        QVector<quint32> newIndexes(subset.count); // simplifying needs room for all the indexes
+        quint32 indexTarget = 12;
+        size_t lastIndexCount = 0;
+        while (indexTarget < subset.count) {
+            float error = 0.0f;
+            const size_t newLength = meshopt_simplify(newIndexes.data(), indexes.constData(), indexes.size(),
+                                                      positions, vertexCount, stride,
+                                                      indexTarget, targetError, 0, &error);
+
+            // Not good enough, try again
+            if (newLength < lastIndexCount * 1.5f) {
+                indexTarget = indexTarget * 1.5f;
+                continue;
+            }
+
+            // We are done
+            if (newLength == 0 || newLength >= subset.count * 0.75f)
+                break;
+
+            meshopt_optimizeVertexCache(newIndexes.data(), newIndexes.data(), newLength, vertexCount);
+
+            Lod lod;
+            lod.count = quint32(newLength);
+            lod.offset = indexCount + quint32(lodIndexData.size() / indexSize);
+            lod.distance = error * scaleFactor;
+            // Lods are sorted from the highest detail to the lowest
+            subset.lods.prepend(lod);
+            created = true;
+
+            if (indexSize == sizeof(quint16)) {
+                for (size_t i = 0; i < newLength; ++i) {
+                    const quint16 index = quint16(newIndexes[i]);
+                    lodIndexData.append(reinterpret_cast<const char *>(&index), sizeof(index));
+                }
+            } else {
+                lodIndexData.append(reinterpret_cast<const char *>(newIndexes.constData()), newLength * sizeof(quint32));
+            }
+
+            indexTarget = qMax(quint32(newLength), indexTarget) * 2;
+            lastIndexCount = newLength;
+
+            if (error == 0.0f)
+                break;
+        }
+    }
+
+    m_indexBuffer.data.append(lodIndexData);
+    return created;
+}
+
 size_t simplifyMesh(unsigned int *destination, const unsigned int *indices, size_t indexCount, const float *vertexPositions, size_t vertexCount, size_t vertexPositionsStride, size_t targetIndexCount, float targetError, unsigned int options, float *resultError)
 {
     return meshopt_simplify(destination, indices, indexCount, vertexPositions, vertexCount, vertexPositionsStride, targetIndexCount, targetError, options, resultError);
@@ -1253,6 +1625,16 @@ void optimizeVertexCache(unsigned int *destination, const unsigned int *indices,
     meshopt_optimizeVertexCache(destination, indices, indexCount, vertexCount);
 }
 
+void optimizeOverdraw(unsigned int *destination, const unsigned int *indices, size_t indexCount, const float *vertexPositions, size_t vertexCount, size_t vertexPositionsStride, float threshold)
+{
+    meshopt_optimizeOverdraw(destination, indices, indexCount, vertexPositions, vertexCount, vertexPositionsStride, threshold);
+}
+
+size_t optimizeVertexFetchRemap(unsigned int *destination, const unsigned int *indices, size_t indexCount, size_t vertexCount)
+{
+    return meshopt_optimizeVertexFetchRemap(destination, indices, indexCount, vertexCount);
+}
+
 } // namespace QSSGMesh
 
 QT_END_NAMESPACE
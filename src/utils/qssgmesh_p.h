@@ -25,9 +25,12 @@
 #include <QtCore/qbytearray.h>
 #include <QtCore/qiodevice.h>
 #include <QtCore/qmap.h>
+#include <QtCore/qsharedpointer.h>
 
 QT_BEGIN_NAMESPACE
 
+class QFile;
+
 namespace QSSGMesh {
 
 struct AssetVertexEntry;
@@ -93,14 +96,28 @@ public:
         QVector<Lod> lods;
     };
 
+    // Precomputed picking BVH, see QSSGMeshBVHBuilder
+    struct BvhData {
+        QByteArray nodes; // QSSGMeshBVHNode array
+        QByteArray triangleIndices; // quint32 per triangle, the index of the triangle in leaf order
+        QVector<qint32> roots; // per subset, index in nodes or -1
+    };
+
     // can just return by value (big data is all implicitly shared)
     VertexBuffer vertexBuffer() const { return m_vertexBuffer; }
     IndexBuffer indexBuffer() const { return m_indexBuffer; }
     TargetBuffer targetBuffer() const { return m_targetBuffer; }
     QVector<Subset> subsets() const { return m_subsets; }
+    BvhData bvhData() const { return m_bvhData; }
 
     // id 0 == first, otherwise has to match
     static Mesh loadMesh(QIODevice *device, quint32 id = 0);
+    // Same as loadMesh(), but when the device is a file that can be memory mapped,
+    // the vertex, index and target buffer data refer to the mapping instead of
+    // being read into memory. The mapping is released with the last copy of the
+    // mesh, so byte arrays taken out of it must not outlive the mesh.
+    static Mesh loadMeshMapped(QIODevice *device, quint32 id = 0);
+    bool isMemoryMapped() const { return !m_mappedFile.isNull(); }
 
     static QMap<quint32, Mesh> loadAll(QIODevice *device);
 
@@ -118,12 +135,22 @@ public:
     DrawMode drawMode() const { return m_drawMode; }
     Winding winding() const { return m_winding; }
 
-    // id 0 == generate new id; otherwise uses it as-is, and must be an unused one
-    quint32 save(QIODevice *device, quint32 id = 0) const;
+    // id 0 == generate new id; otherwise uses it as-is, and must be an unused one.
+    // With compressBuffers the vertex, index and target buffers are stored encoded
+    // with meshoptimizer's vertex and index codecs, and get decoded when loading.
+    quint32 save(QIODevice *device, quint32 id = 0, bool compressBuffers = false) const;
 
     bool hasLightmapUVChannel() const;
     bool createLightmapUVChannel(uint lightmapBaseResolution);
 
+    bool hasBvhData() const { return !m_bvhData.nodes.isEmpty(); }
+    bool createBvhData();
+
+    // Simplifies the subsets that have no levels of detail yet with meshoptimizer,
+    // appending the indices of the levels to the index buffer. The vertex buffer is
+    // not changed. Returns false when no levels of detail were created.
+    bool createLevelsOfDetail();
+
 private:
     DrawMode m_drawMode = DrawMode::Triangles;
     Winding m_winding = Winding::CounterClockwise;
@@ -131,6 +158,8 @@ private:
     IndexBuffer m_indexBuffer;
     TargetBuffer m_targetBuffer;
     QVector<Subset> m_subsets;
+    BvhData m_bvhData;
+    QSharedPointer<QFile> m_mappedFile;
     friend struct MeshInternal;
 };
 
@@ -267,10 +296,30 @@ struct Q_QUICK3DUTILS_EXPORT MeshInternal
         // Version 6 differs from 5 with additional lodCount per subset as well
         // as a list of Level of Detail data after the subset names.
         // Version 7 will split the morph target data
-        static const quint32 FILE_VERSION = 7;
+        // Version 8 adds an optional BVH section at the end of the mesh data,
+        // followed by the size of that section (so it can be found without
+        // parsing everything before it).
+        // Version 9 adds the CompressedBuffers flag. When set, the vertex, index
+        // and target buffer data is preceded by its encoded size, which is 0 for
+        // buffers that are stored as-is.
+        static const quint32 SEPARATE_TARGET_BUFFER_FILE_VERSION = 7;
+        static const quint32 BVH_SECTION_FILE_VERSION = 8;
+        static const quint32 COMPRESSED_BUFFERS_FILE_VERSION = 9;
+        static const quint32 FILE_VERSION = COMPRESSED_BUFFERS_FILE_VERSION;
+
+        enum Flag : quint16 {
+            CompressedBuffers = 0x1
+        };
 
-        static MeshDataHeader withDefaults() {
-            return { FILE_ID, FILE_VERSION, 0, 0 };
+        // Meshes are written with the lowest version that can hold them, so that
+        // older readers can still load the meshes that don't use the newer additions.
+        static MeshDataHeader withDefaults(quint16 flags = 0, bool hasBvhData = false) {
+            quint16 version = SEPARATE_TARGET_BUFFER_FILE_VERSION;
+            if (flags & CompressedBuffers)
+                version = COMPRESSED_BUFFERS_FILE_VERSION;
+            else if (hasBvhData)
+                version = BVH_SECTION_FILE_VERSION;
+            return { FILE_ID, version, flags, 0 };
         }
 
         bool isValid() const {
@@ -288,7 +337,15 @@ struct Q_QUICK3DUTILS_EXPORT MeshInternal
         }
 
         bool hasSeparateTargetBuffer() const {
-            return fileVersion >= 7;
+            return fileVersion >= SEPARATE_TARGET_BUFFER_FILE_VERSION;
+        }
+
+        bool hasBvhSection() const {
+            return fileVersion >= BVH_SECTION_FILE_VERSION;
+        }
+
+        bool hasCompressedBuffers() const {
+            return fileVersion >= COMPRESSED_BUFFERS_FILE_VERSION && (flags & CompressedBuffers);
         }
     };
 
@@ -340,9 +397,11 @@ struct Q_QUICK3DUTILS_EXPORT MeshInternal
 
     static MultiMeshInfo readFileHeader(QIODevice *device);
     static void writeFileHeader(QIODevice *device, const MultiMeshInfo &meshFileInfo);
-    static quint64 readMeshData(QIODevice *device, quint64 offset, Mesh *mesh, MeshDataHeader *header);
+    // With a non-empty mappedFile (the whole file the device reads), the buffer data refers to it
+    static quint64 readMeshData(QIODevice *device, quint64 offset, Mesh *mesh, MeshDataHeader *header,
+                                const QByteArray &mappedFile = {});
     static void writeMeshHeader(QIODevice *device, const MeshDataHeader &header);
-    static quint64 writeMeshData(QIODevice *device, const Mesh &mesh);
+    static quint64 writeMeshData(QIODevice *device, const Mesh &mesh, const MeshDataHeader &header);
 
     static quint32 byteSizeForComponentType(Mesh::ComponentType componentType) { return quint32(QSSGBaseTypeHelpers::getSizeOfType(componentType)); }
 
@@ -364,6 +423,10 @@ struct Q_QUICK3DUTILS_EXPORT MeshInternal
                                              Mesh::ComponentType indexComponentType,
                                              quint32 subsetCount,
                                              quint32 subsetOffset);
+
+    // Imported meshes can have their normals and texture coordinates quantized to half
+    // floats. This converts those to 32-bit floats, for when the backend can't take them.
+    static Mesh::VertexBuffer expandHalfFloatAttributes(const Mesh::VertexBuffer &vertexBuffer);
 };
 
 size_t Q_QUICK3DUTILS_EXPORT simplifyMesh(unsigned int* destination,
@@ -386,6 +449,19 @@ void Q_QUICK3DUTILS_EXPORT optimizeVertexCache(unsigned int* destination,
                                                size_t indexCount,
                                                size_t vertexCount);
 
+void Q_QUICK3DUTILS_EXPORT optimizeOverdraw(unsigned int* destination,
+                                            const unsigned int* indices,
+                                            size_t indexCount,
+                                            const float* vertexPositions,
+                                            size_t vertexCount,
+                                            size_t vertexPositionsStride,
+                                            float threshold);
+
+size_t Q_QUICK3DUTILS_EXPORT optimizeVertexFetchRemap(unsigned int* destination,
+                                                      const unsigned int* indices,
+                                                      size_t indexCount,
+                                                      size_t vertexCount);
+
 } // namespace QSSGMesh
 
 QT_END_NAMESPACE
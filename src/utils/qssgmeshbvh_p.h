@@ -23,22 +23,24 @@
 
 QT_BEGIN_NAMESPACE
 
+// Nodes are stored in a flat array (QSSGMeshBVH::nodes). The two children of an
+// inner node are always next to each other, so an inner node only stores the
+// index of its left child.
 struct Q_QUICK3DUTILS_EXPORT QSSGMeshBVHNode {
-    ~QSSGMeshBVHNode() {
-        delete left;
-        delete right;
-    }
-
-    // Internal
-    QSSGMeshBVHNode *left = nullptr;
-    QSSGMeshBVHNode *right = nullptr;
     QSSGBounds3 boundingData;
-    //splitAxis
 
-    // Leaf
-    int offset = 0;
-    int count = 0;
+    // Inner node: index of the left child (the right child is at offset + 1)
+    // Leaf: index of the first triangle
+    quint32 offset = 0;
+    // Number of triangles, 0 for inner nodes
+    quint32 count = 0;
+
+    [[nodiscard]] bool isLeaf() const { return count != 0; }
+    [[nodiscard]] quint32 left() const { return offset; }
+    [[nodiscard]] quint32 right() const { return offset + 1; }
 };
+static_assert(sizeof(QSSGMeshBVHNode) == 32, "QSSGMeshBVHNode is expected to be 32 bytes");
+Q_DECLARE_TYPEINFO(QSSGMeshBVHNode, Q_PRIMITIVE_TYPE);
 
 struct Q_QUICK3DUTILS_EXPORT QSSGMeshBVHTriangle {
     QSSGBounds3 bounds;
@@ -49,18 +51,26 @@ struct Q_QUICK3DUTILS_EXPORT QSSGMeshBVHTriangle {
     QVector2D uvCoord2;
     QVector2D uvCoord3;
 };
+Q_DECLARE_TYPEINFO(QSSGMeshBVHTriangle, Q_PRIMITIVE_TYPE);
 
 struct Q_QUICK3DUTILS_EXPORT QSSGMeshBVH
 {
-    QSSGMeshBVH(const QVector<QSSGMeshBVHNode *> &bvhRoots,
-                const QVector<QSSGMeshBVHTriangle *> &bvhTriangles)
-        : roots(bvhRoots)
-        , triangles(bvhTriangles)
+    static constexpr qint32 InvalidRoot = -1;
+
+    QSSGMeshBVH() = default;
+    QSSGMeshBVH(QVector<QSSGMeshBVHNode> &&bvhNodes,
+                QVector<qint32> &&bvhRoots,
+                QVector<QSSGMeshBVHTriangle> &&bvhTriangles)
+        : nodes(std::move(bvhNodes))
+        , roots(std::move(bvhRoots))
+        , triangles(std::move(bvhTriangles))
     {}
-    ~QSSGMeshBVH();
 
-    QVector<QSSGMeshBVHNode *> roots;
-    QVector<QSSGMeshBVHTriangle *> triangles;
+    QVector<QSSGMeshBVHNode> nodes;
+    // Index of the root node in 'nodes' for each subset (or InvalidRoot)
+    QVector<qint32> roots;
+    // Triangles, ordered so that each leaf references a contiguous range
+    QVector<QSSGMeshBVHTriangle> triangles;
 };
 
 QT_END_NAMESPACE
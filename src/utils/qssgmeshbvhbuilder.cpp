@@ -3,6 +3,12 @@
 
 #include "qssgmeshbvhbuilder_p.h"
 
+#ifdef QT_QUICK3D_HAS_CONCURRENT
+#include <QtConcurrent/qtconcurrentmap.h>
+#endif
+
+#include <algorithm>
+
 QT_BEGIN_NAMESPACE
 
 QSSGMeshBVHBuilder::QSSGMeshBVHBuilder(const QSSGMesh::Mesh &mesh)
@@ -63,79 +69,198 @@ QSSGMeshBVHBuilder::QSSGMeshBVHBuilder(const QByteArray &vertexBuffer,
 
 QSSGMeshBVH* QSSGMeshBVHBuilder::buildTree()
 {
-    m_roots.clear();
-
     // This only works with triangles
     if (m_mesh.isValid() && m_mesh.drawMode() != QSSGMesh::Mesh::DrawMode::Triangles)
         return nullptr;
 
+    // Use the tree that was computed when the mesh was imported, if there is one
+    if (m_mesh.hasBvhData()) {
+        if (QSSGMeshBVH *bvh = loadTree(m_mesh.bvhData()))
+            return bvh;
+        qWarning("Precomputed mesh BVH does not match the mesh, rebuilding it");
+    }
+
+    QVector<qint32> roots = build();
+
+    // Store the triangles in leaf order, so each leaf is a contiguous range
+    QVector<QSSGMeshBVHTriangle> triangles;
+    triangles.reserve(m_triangles.size());
+    for (qsizetype i = 0, end = m_triangles.size(); i < end; ++i)
+        triangles.append(m_triangles.at(m_order[i]));
+
+    QVector<QSSGMeshBVHNode> nodes = std::move(m_nodes);
+    clear();
+
+    return new QSSGMeshBVH(std::move(nodes), std::move(roots), std::move(triangles));
+}
+
+QSSGMesh::Mesh::BvhData QSSGMeshBVHBuilder::buildBvhData()
+{
+    QSSGMesh::Mesh::BvhData data;
+    if (m_mesh.isValid() && m_mesh.drawMode() != QSSGMesh::Mesh::DrawMode::Triangles)
+        return data;
+
+    data.roots = build();
+    // Both are stored as-is, matching the (little endian) layout used for the vertex data
+    data.nodes = QByteArray(reinterpret_cast<const char *>(m_nodes.constData()),
+                            m_nodes.size() * qsizetype(sizeof(QSSGMeshBVHNode)));
+    data.triangleIndices = QByteArray(reinterpret_cast<const char *>(m_triangleOrder.constData()),
+                                      m_triangleOrder.size() * qsizetype(sizeof(quint32)));
+    clear();
+
+    return data;
+}
+
+QSSGMeshBVH *QSSGMeshBVHBuilder::loadTree(const QSSGMesh::Mesh::BvhData &data) const
+{
+    const quint32 triangleCount = indexCount() / 3;
+    const qsizetype nodeCount = data.nodes.size() / qsizetype(sizeof(QSSGMeshBVHNode));
+    if (data.nodes.size() != nodeCount * qsizetype(sizeof(QSSGMeshBVHNode))
+            || data.triangleIndices.size() != qsizetype(triangleCount) * qsizetype(sizeof(quint32))) {
+        return nullptr;
+    }
+
+    QVector<QSSGMeshBVHNode> nodes(nodeCount);
+    memcpy(nodes.data(), data.nodes.constData(), data.nodes.size());
+
+    // The data comes from a file, so make sure that traversing it stays in bounds and
+    // terminates. Children are always stored after their parent.
+    for (qsizetype i = 0; i < nodeCount; ++i) {
+        const QSSGMeshBVHNode &node = nodes.at(i);
+        if (node.isLeaf()) {
+            if (quint64(node.offset) + node.count > triangleCount)
+                return nullptr;
+        } else if (node.left() <= quint64(i) || quint64(node.right()) >= quint64(nodeCount)) {
+            return nullptr;
+        }
+    }
+    for (qint32 root : data.roots) {
+        if (root != QSSGMeshBVH::InvalidRoot && (root < 0 || root >= nodeCount))
+            return nullptr;
+    }
+
+    const quint32 *triangleIndices = reinterpret_cast<const quint32 *>(data.triangleIndices.constData());
+    QVector<QSSGMeshBVHTriangle> triangles;
+    triangles.reserve(triangleCount);
+    for (quint32 i = 0; i < triangleCount; ++i) {
+        if (triangleIndices[i] >= triangleCount)
+            return nullptr;
+        triangles.append(calculateTriangle(triangleIndices[i] * 3));
+    }
+
+    QVector<qint32> roots = data.roots;
+    return new QSSGMeshBVH(std::move(nodes), std::move(roots), std::move(triangles));
+}
+
+QVector<qint32> QSSGMeshBVHBuilder::build()
+{
+    m_nodes.clear();
+
     // Calculate the bounds for each triangle in whole mesh once
-    quint32 indexCount = 0;
-    if (m_hasIndexBuffer)
-        indexCount = quint32(m_indexBufferData.size() / QSSGBaseTypeHelpers::getSizeOfType(m_indexBufferComponentType));
-    else
-        indexCount = m_vertexBufferData.size() / m_vertexStride;
-    m_triangleBounds = calculateTriangleBounds(0, indexCount);
+    m_triangles = calculateTriangleBounds(0, indexCount());
+
+    const quint32 triangleCount = quint32(m_triangles.size());
+    m_centroids.resize(triangleCount);
+    m_triangleOrder.resize(triangleCount);
+    m_order = m_triangleOrder.data();
+    for (quint32 i = 0; i < triangleCount; ++i) {
+        m_centroids[i] = m_triangles.at(i).bounds.center();
+        m_order[i] = i;
+    }
 
-    // For each submesh, generate a root bvh node
+    // For each submesh, generate a root bvh node. The top of each tree is split
+    // here, large subtrees below it are deferred and built in parallel. Meshes
+    // that would not give at least a few subtrees are not worth the threading.
+    QVector<qint32> roots;
+    QVector<SubtreeTask> deferred;
+    const bool parallel = m_parallelThreshold > 0 && triangleCount > 2 * quint64(m_parallelThreshold);
+    QVector<SubtreeTask> *deferredTasks = parallel ? &deferred : nullptr;
     if (m_mesh.isValid()) {
         const QVector<QSSGMesh::Mesh::Subset> subsets = m_mesh.subsets();
         for (quint32 subsetIdx = 0, subsetEnd = subsets.size(); subsetIdx < subsetEnd; ++subsetIdx) {
             const QSSGMesh::Mesh::Subset &source(subsets[subsetIdx]);
-            QSSGMeshBVHNode *root = new QSSGMeshBVHNode();
             // Offsets provided by subset are for the index buffer
-            // Convert them to work with the triangle bounds list
-            const quint32 triangleOffset = source.offset / 3;
-            const quint32 triangleCount = source.count / 3;
-            root->boundingData = getBounds(triangleOffset, triangleCount);
-            // Recursively split the mesh into a tree of smaller bounding volumns
-            root = splitNode(root, triangleOffset, triangleCount);
-            m_roots.append(root);
+            // Convert them to work with the triangle list
+            const quint32 triangleOffset = qMin(source.offset / 3, triangleCount);
+            const quint32 subsetTriangleCount = qMin(source.count / 3, triangleCount - triangleOffset);
+            roots.append(buildRoot({ triangleOffset, subsetTriangleCount }, deferredTasks));
         }
     } else {
         // Custom Geometry only has one subset
-        QSSGMeshBVHNode *root = new QSSGMeshBVHNode();
-        root->boundingData = getBounds(0, m_triangleBounds.size());
-        root = splitNode(root, 0, m_triangleBounds.size());
-        m_roots.append(root);
+        roots.append(buildRoot({ 0, triangleCount }, deferredTasks));
+    }
+
+    // The calling thread takes part in the build, so this also works when the tree
+    // itself is built on the global thread pool (see QSSGBufferManager::loadMeshBVHAsync())
+#ifdef QT_QUICK3D_HAS_CONCURRENT
+    if (deferred.size() > 1) {
+        QtConcurrent::blockingMap(deferred, [this](SubtreeTask &task) { buildSubtree(task); });
+    } else
+#endif
+    {
+        for (SubtreeTask &task : deferred)
+            buildSubtree(task);
     }
-    return new QSSGMeshBVH(m_roots, m_triangleBounds);
+
+    for (const SubtreeTask &task : std::as_const(deferred))
+        mergeSubtree(task);
+
+    return roots;
 }
 
-QVector<QSSGMeshBVHTriangle *> QSSGMeshBVHBuilder::calculateTriangleBounds(quint32 indexOffset, quint32 indexCount) const
+void QSSGMeshBVHBuilder::clear()
 {
-    QVector<QSSGMeshBVHTriangle *> triangleBounds;
-    const quint32 triangleCount = indexCount / 3;
+    m_nodes.clear();
+    m_triangles.clear();
+    m_centroids.clear();
+    m_triangleOrder.clear();
+    m_order = nullptr;
+}
 
-    for (quint32 i = 0; i < triangleCount; ++i) {
-        // Get the indices for the triangle
-        const quint32 triangleIndex = i * 3 + indexOffset;
+quint32 QSSGMeshBVHBuilder::indexCount() const
+{
+    if (m_hasIndexBuffer)
+        return quint32(m_indexBufferData.size() / QSSGBaseTypeHelpers::getSizeOfType(m_indexBufferComponentType));
+    return m_vertexStride ? quint32(m_vertexBufferData.size() / m_vertexStride) : 0;
+}
 
-        quint32 index1 = triangleIndex + 0;
-        quint32 index2 = triangleIndex + 1;
-        quint32 index3 = triangleIndex + 2;
+QVector<QSSGMeshBVHTriangle> QSSGMeshBVHBuilder::calculateTriangleBounds(quint32 indexOffset, quint32 indexCount) const
+{
+    QVector<QSSGMeshBVHTriangle> triangleBounds;
+    const quint32 triangleCount = indexCount / 3;
+    triangleBounds.reserve(triangleCount);
 
-        if (m_hasIndexBuffer) {
-            index1 = getIndexBufferValue(triangleIndex + 0);
-            index2 = getIndexBufferValue(triangleIndex + 1);
-            index3 = getIndexBufferValue(triangleIndex + 2);
-        }
+    for (quint32 i = 0; i < triangleCount; ++i)
+        triangleBounds.append(calculateTriangle(i * 3 + indexOffset));
+    return triangleBounds;
+}
 
-        QSSGMeshBVHTriangle *triangle = new QSSGMeshBVHTriangle();
+QSSGMeshBVHTriangle QSSGMeshBVHBuilder::calculateTriangle(quint32 triangleIndex) const
+{
+    // Get the indices for the triangle
+    quint32 index1 = triangleIndex + 0;
+    quint32 index2 = triangleIndex + 1;
+    quint32 index3 = triangleIndex + 2;
+
+    if (m_hasIndexBuffer) {
+        index1 = getIndexBufferValue(triangleIndex + 0);
+        index2 = getIndexBufferValue(triangleIndex + 1);
+        index3 = getIndexBufferValue(triangleIndex + 2);
+    }
 
-        triangle->vertex1 = getVertexBufferValuePosition(index1);
-        triangle->vertex2 = getVertexBufferValuePosition(index2);
-        triangle->vertex3 = getVertexBufferValuePosition(index3);
-        triangle->uvCoord1 = getVertexBufferValueUV(index1);
-        triangle->uvCoord2 = getVertexBufferValueUV(index2);
-        triangle->uvCoord3 = getVertexBufferValueUV(index3);
+    QSSGMeshBVHTriangle triangle;
 
-        triangle->bounds.include(triangle->vertex1);
-        triangle->bounds.include(triangle->vertex2);
-        triangle->bounds.include(triangle->vertex3);
-        triangleBounds.append(triangle);
-    }
-    return triangleBounds;
+    triangle.vertex1 = getVertexBufferValuePosition(index1);
+    triangle.vertex2 = getVertexBufferValuePosition(index2);
+    triangle.vertex3 = getVertexBufferValuePosition(index3);
+    triangle.uvCoord1 = getVertexBufferValueUV(index1);
+    triangle.uvCoord2 = getVertexBufferValueUV(index2);
+    triangle.uvCoord3 = getVertexBufferValueUV(index3);
+
+    triangle.bounds.include(triangle.vertex1);
+    triangle.bounds.include(triangle.vertex2);
+    triangle.bounds.include(triangle.vertex3);
+    return triangle;
 }
 
 quint32 QSSGMeshBVHBuilder::getIndexBufferValue(quint32 index) const
@@ -179,144 +304,183 @@ QVector2D QSSGMeshBVHBuilder::getVertexBufferValueUV(quint32 index) const
     return *uv;
 }
 
-QSSGMeshBVHNode *QSSGMeshBVHBuilder::splitNode(QSSGMeshBVHNode *node, quint32 offset, quint32 count, quint32 depth)
+qint32 QSSGMeshBVHBuilder::buildRoot(Range range, QVector<SubtreeTask> *deferred)
 {
+    if (range.count == 0)
+        return QSSGMeshBVH::InvalidRoot;
+
+    const quint32 rootIdx = quint32(m_nodes.size());
+    m_nodes.append(QSSGMeshBVHNode { getBounds(range) });
+    // Recursively split the mesh into a tree of smaller bounding volumes
+    splitNode(m_nodes, rootIdx, range, 0, deferred);
+    return qint32(rootIdx);
+}
+
+void QSSGMeshBVHBuilder::splitNode(QVector<QSSGMeshBVHNode> &nodes, quint32 nodeIdx, Range range, quint32 depth, QVector<SubtreeTask> *deferred)
+{
+    const auto makeLeaf = [&nodes, nodeIdx, range]() {
+        nodes[nodeIdx].offset = range.offset;
+        nodes[nodeIdx].count = range.count;
+    };
+
     // Force a leaf node if the there are too few triangles or the tree depth
     // has exceeded the maximum depth
-    if (count < m_maxLeafTriangles || depth >= m_maxTreeDepth) {
-        node->offset = offset;
-        node->count = count;
-        return node;
+    if (range.count <= m_maxLeafTriangles || depth >= m_maxTreeDepth) {
+        makeLeaf();
+        return;
     }
 
-    // Determine where to split the current bounds
-    const QSSGMeshBVHBuilder::Split split = getOptimalSplit(node->boundingData, offset, count);
-    // Really this shouldn't happen unless there is invalid bounding data, but if that
-    // that does happen make this a leaf node.
-    if (split.axis == QSSGMeshBVHBuilder::Axis::None) {
-        node->offset = offset;
-        node->count = count;
-        return node;
+    // Hand off subtrees that are small enough to be built on their own
+    if (deferred && depth > 0 && range.count <= m_parallelThreshold) {
+        deferred->append(SubtreeTask { nodeIdx, range, depth, {} });
+        return;
     }
 
-    // Create the split by sorting the values in m_triangleBounds between
-    // offset - count based on the split axis and position. The returned offset
-    // will determine which values go into the left and right nodes.
-    const quint32 splitOffset = partition(offset, count, split);
-
-    // Create the leaf nodes
-    if (splitOffset == offset || splitOffset == (offset + count)) {
-        // If the split is at the start or end, this is a leaf node now
-        // because there is no further branches necessary.
-        node->offset = offset;
-        node->count = count;
-    } else {
-        // Create the Left Node
-        node->left = new QSSGMeshBVHNode();
-        const quint32 leftOffset = offset;
-        const quint32 leftCount = splitOffset - offset;
-        node->left->boundingData = getBounds(leftOffset, leftCount);
-        node->left = splitNode(node->left, leftOffset, leftCount, depth + 1);
-
-        // Create the Right Node
-        node->right = new QSSGMeshBVHNode();
-        const quint32 rightOffset = splitOffset;
-        const quint32 rightCount = count - leftCount;
-        node->right->boundingData = getBounds(rightOffset, rightCount);
-        node->right = splitNode(node->right, rightOffset, rightCount, depth + 1);
+    // Sort the triangle range so that the left node's triangles come first.
+    // If the split is at the start or end, this is a leaf node now
+    // because there is no further branches necessary.
+    const quint32 splitOffset = partitionSAH(nodes.at(nodeIdx).boundingData, range);
+    if (splitOffset == range.offset || splitOffset == (range.offset + range.count)) {
+        makeLeaf();
+        return;
     }
 
-    return node;
-}
+    const Range leftRange { range.offset, splitOffset - range.offset };
+    const Range rightRange { splitOffset, range.count - leftRange.count };
 
-QSSGBounds3 QSSGMeshBVHBuilder::getBounds(quint32 offset, quint32 count) const
-{
-    QSSGBounds3 totalBounds;
+    // Children are always allocated in pairs
+    const quint32 leftIdx = quint32(nodes.size());
+    nodes.append(QSSGMeshBVHNode { getBounds(leftRange) });
+    nodes.append(QSSGMeshBVHNode { getBounds(rightRange) });
+    nodes[nodeIdx].offset = leftIdx;
+    nodes[nodeIdx].count = 0;
 
-    for (quint32 i = 0; i < count; ++i) {
-        QSSGBounds3 bounds = m_triangleBounds[i + offset]->bounds;
-        totalBounds.include(bounds);
-    }
-    return totalBounds;
+    splitNode(nodes, leftIdx, leftRange, depth + 1, deferred);
+    splitNode(nodes, leftIdx + 1, rightRange, depth + 1, deferred);
 }
 
-QSSGMeshBVHBuilder::Split QSSGMeshBVHBuilder::getOptimalSplit(const QSSGBounds3 &nodeBounds, quint32 offset, quint32 count) const
+void QSSGMeshBVHBuilder::buildSubtree(SubtreeTask &task)
 {
-    QSSGMeshBVHBuilder::Split split;
-    split.axis = getLongestDimension(nodeBounds);
-    split.pos = 0.f;
-
-    if (split.axis != Axis::None)
-        split.pos = getAverageValue(offset, count, split.axis);
-
-    return split;
+    // The subtree is built with local indices, the root being at 0
+    task.nodes.append(QSSGMeshBVHNode { m_nodes.at(task.rootNode).boundingData });
+    splitNode(task.nodes, 0, task.range, task.depth, nullptr);
 }
 
-QSSGMeshBVHBuilder::Axis QSSGMeshBVHBuilder::getLongestDimension(const QSSGBounds3 &nodeBounds)
+void QSSGMeshBVHBuilder::mergeSubtree(const SubtreeTask &task)
 {
-    QSSGMeshBVHBuilder::Axis axis = Axis::None;
-    float largestDistance = std::numeric_limits<float>::min();
-
-    if (!nodeBounds.isFinite() || nodeBounds.isEmpty())
-        return axis;
-
-    const QVector3D delta = nodeBounds.maximum - nodeBounds.minimum;
-
-    if (delta.x() > largestDistance) {
-        axis = Axis::X;
-        largestDistance = delta.x();
-    }
-    if (delta.y() > largestDistance) {
-        axis = Axis::Y;
-        largestDistance = delta.y();
-    }
-    if (delta.z() > largestDistance)
-        axis = Axis::Z;
+    // Local node 1 ends up at m_nodes.size(), the local root replaces task.rootNode
+    const quint32 base = quint32(m_nodes.size()) - 1;
+    const auto remap = [base](QSSGMeshBVHNode node) {
+        if (!node.isLeaf())
+            node.offset += base;
+        return node;
+    };
 
-    return axis;
+    m_nodes[task.rootNode] = remap(task.nodes.at(0));
+    m_nodes.reserve(m_nodes.size() + task.nodes.size() - 1);
+    for (qsizetype i = 1, end = task.nodes.size(); i < end; ++i)
+        m_nodes.append(remap(task.nodes.at(i)));
 }
 
-// Get the average values of triangles for a given axis
-float QSSGMeshBVHBuilder::getAverageValue(quint32 offset, quint32 count, QSSGMeshBVHBuilder::Axis axis) const
+QSSGBounds3 QSSGMeshBVHBuilder::getBounds(Range range) const
 {
-    float average = 0;
-
-    Q_ASSERT(axis != Axis::None);
-    Q_ASSERT(count != 0);
+    QSSGBounds3 totalBounds;
 
-    for (quint32 i = 0; i < count; ++i)
-        average += m_triangleBounds[i + offset]->bounds.center(int(axis));
+    for (quint32 i = range.offset, end = range.offset + range.count; i < end; ++i)
+        totalBounds.include(m_triangles.at(m_order[i]).bounds);
+    return totalBounds;
+}
 
-    return average / count;
+static inline float surfaceArea(const QSSGBounds3 &bounds)
+{
+    if (bounds.isEmpty())
+        return 0.0f;
+    const QVector3D d = bounds.dimensions();
+    return 2.0f * (d.x() * d.y() + d.y() * d.z() + d.z() * d.x());
 }
 
-quint32 QSSGMeshBVHBuilder::partition(quint32 offset, quint32 count, const QSSGMeshBVHBuilder::Split &split)
+quint32 QSSGMeshBVHBuilder::partitionSAH(const QSSGBounds3 &nodeBounds, Range range) const
 {
-    int left = offset;
-    int right = offset + count - 1;
-    const float pos = split.pos;
-    const int axis = int(split.axis);
-
-    while (true) {
-        while (left <= right && m_triangleBounds[left]->bounds.center()[axis] < pos)
-            left++;
-
-        while (left <= right && m_triangleBounds[right]->bounds.center()[axis] >= pos)
-            right--;
-
-        if (left < right) {
-            // Swap triangleBounds at left and right
-            auto temp = m_triangleBounds[left];
-            m_triangleBounds[left] = m_triangleBounds[right];
-            m_triangleBounds[right] = temp;
-
-            left++;
-            right--;
-        } else {
-            return left;
+    // Binned surface area heuristic: the triangle centroids are sorted into a fixed number
+    // of bins along each axis and the cheapest split between two bins is picked.
+    constexpr int BinCount = 16;
+    // Nodes up to this size are allowed to stay leaves if splitting them doesn't pay off
+    constexpr quint32 MaxSAHLeafTriangles = 16;
+
+    quint32 *const first = m_order + range.offset;
+    quint32 *const last = first + range.count;
+
+    QSSGBounds3 centroidBounds;
+    for (const quint32 *it = first; it != last; ++it)
+        centroidBounds.include(m_centroids.at(*it));
+
+    struct Bin
+    {
+        QSSGBounds3 bounds;
+        quint32 count = 0;
+    };
+
+    float bestCost = std::numeric_limits<float>::max();
+    int bestAxis = -1;
+    int bestBin = -1;
+    for (int axis = 0; axis < 3; ++axis) {
+        const float axisMin = centroidBounds.minimum[axis];
+        const float extent = centroidBounds.maximum[axis] - axisMin;
+        if (!(extent > 0.0f))
+            continue;
+
+        const float scale = BinCount / extent;
+        Bin bins[BinCount];
+        for (const quint32 *it = first; it != last; ++it) {
+            const int binIdx = qMin(int((m_centroids.at(*it)[axis] - axisMin) * scale), BinCount - 1);
+            bins[binIdx].bounds.include(m_triangles.at(*it).bounds);
+            ++bins[binIdx].count;
+        }
+
+        // Sweep from the right to get the cost of everything right of each split plane...
+        float rightArea[BinCount - 1];
+        quint32 rightCount[BinCount - 1];
+        QSSGBounds3 accumulated;
+        quint32 count = 0;
+        for (int binIdx = BinCount - 1; binIdx > 0; --binIdx) {
+            accumulated.include(bins[binIdx].bounds);
+            count += bins[binIdx].count;
+            rightArea[binIdx - 1] = surfaceArea(accumulated);
+            rightCount[binIdx - 1] = count;
+        }
+
+        // ... and then from the left
+        accumulated.setEmpty();
+        count = 0;
+        for (int binIdx = 0; binIdx < BinCount - 1; ++binIdx) {
+            accumulated.include(bins[binIdx].bounds);
+            count += bins[binIdx].count;
+            if (count == 0 || rightCount[binIdx] == 0)
+                continue;
+            const float cost = count * surfaceArea(accumulated) + rightCount[binIdx] * rightArea[binIdx];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = binIdx;
+            }
         }
     }
-    Q_UNREACHABLE();
+
+    // All centroids are in the same spot, nothing to split
+    if (bestAxis < 0)
+        return range.offset;
+
+    const float leafCost = range.count * surfaceArea(nodeBounds);
+    if (bestCost >= leafCost && range.count <= MaxSAHLeafTriangles)
+        return range.offset;
+
+    const float axisMin = centroidBounds.minimum[bestAxis];
+    const float scale = BinCount / (centroidBounds.maximum[bestAxis] - axisMin);
+    const quint32 *const mid = std::partition(first, last, [this, bestAxis, bestBin, axisMin, scale](quint32 triangle) {
+        return qMin(int((m_centroids.at(triangle)[bestAxis] - axisMin) * scale), BinCount - 1) <= bestBin;
+    });
+
+    return range.offset + quint32(mid - first);
 }
 
 QT_END_NAMESPACE
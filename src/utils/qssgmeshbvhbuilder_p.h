@@ -33,32 +33,49 @@ public:
                        const QByteArray &indexBuffer = QByteArray(),
                        QSSGRenderComponentType indexBufferType = QSSGRenderComponentType::Int32);
 
+    // Uses the precomputed tree if the mesh has one (see QSSGMesh::Mesh::createBvhData())
     QSSGMeshBVH* buildTree();
+    // Builds the tree in the form that is stored in mesh files
+    QSSGMesh::Mesh::BvhData buildBvhData();
+
+    // The top of the tree is split on the calling thread until the subtrees have at most
+    // this many triangles, those are then built on the global thread pool. Only meshes with
+    // more than twice this many triangles are built in parallel (0 disables threading).
+    void setParallelThreshold(quint32 triangleCount) { m_parallelThreshold = triangleCount; }
 
 private:
-    enum class Axis
+    struct Range
     {
-        None = -1,
-        X = 0,
-        Y = 1,
-        Z = 2
+        quint32 offset;
+        quint32 count;
     };
-    struct Split {
-        Axis axis;
-        float pos;
+
+    // A subtree that is built on its own (possibly on a worker thread) and merged afterwards.
+    struct SubtreeTask
+    {
+        quint32 rootNode; // index in m_nodes
+        Range range;
+        quint32 depth;
+        QVector<QSSGMeshBVHNode> nodes;
     };
 
-    QVector<QSSGMeshBVHTriangle*> calculateTriangleBounds(quint32 indexOffset, quint32 indexCount) const;
+    QVector<qint32> build();
+    void clear();
+    QSSGMeshBVH *loadTree(const QSSGMesh::Mesh::BvhData &data) const;
+
+    quint32 indexCount() const;
+    QVector<QSSGMeshBVHTriangle> calculateTriangleBounds(quint32 indexOffset, quint32 indexCount) const;
+    QSSGMeshBVHTriangle calculateTriangle(quint32 triangleIndex) const;
     quint32 getIndexBufferValue(quint32 index) const;
     QVector3D getVertexBufferValuePosition(quint32 index) const;
     QVector2D getVertexBufferValueUV(quint32 index) const;
 
-    QSSGMeshBVHNode *splitNode(QSSGMeshBVHNode *node, quint32 offset, quint32 count, quint32 depth = 0);
-    QSSGBounds3 getBounds(quint32 offset, quint32 count) const;
-    Split getOptimalSplit(const QSSGBounds3 &nodeBounds, quint32 offset, quint32 count) const;
-    static Axis getLongestDimension(const QSSGBounds3 &nodeBounds);
-    float getAverageValue(quint32 offset, quint32 count, Axis axis) const;
-    quint32 partition(quint32 offset, quint32 count, const Split &split);
+    qint32 buildRoot(Range range, QVector<SubtreeTask> *deferred);
+    void splitNode(QVector<QSSGMeshBVHNode> &nodes, quint32 nodeIdx, Range range, quint32 depth, QVector<SubtreeTask> *deferred);
+    void buildSubtree(SubtreeTask &task);
+    void mergeSubtree(const SubtreeTask &task);
+    QSSGBounds3 getBounds(Range range) const;
+    quint32 partitionSAH(const QSSGBounds3 &nodeBounds, Range range) const;
 
     QSSGMesh::Mesh m_mesh;
     QSSGRenderComponentType m_indexBufferComponentType;
@@ -71,11 +88,16 @@ private:
     quint32 m_vertexUVOffset;
     bool m_hasIndexBuffer = true;
 
-
-    QVector<QSSGMeshBVHTriangle *> m_triangleBounds;
-    QVector<QSSGMeshBVHNode *> m_roots;
-    quint32 m_maxTreeDepth = 40;
-    quint32 m_maxLeafTriangles = 10;
+    QVector<QSSGMeshBVHTriangle> m_triangles;
+    // Per triangle centroids and the permutation that is partitioned during the build,
+    // the triangles themselves are only reordered once at the end.
+    QVector<QVector3D> m_centroids;
+    QVector<quint32> m_triangleOrder;
+    quint32 *m_order = nullptr; // m_triangleOrder.data(), shared by the worker threads
+    QVector<QSSGMeshBVHNode> m_nodes;
+    quint32 m_maxTreeDepth = 64;
+    quint32 m_maxLeafTriangles = 4;
+    quint32 m_parallelThreshold = 1 << 16;
 };
 
 QT_END_NAMESPACE
@@ -5,6 +5,7 @@
 #include <QtTest>
 #include <QDebug>
 #include <QtQuick3DAssetImport/private/qssgassetimportmanager_p.h>
+#include <QtQuick3DUtils/private/qssgmesh_p.h>
 #include <QDir>
 #include <QByteArray>
 
@@ -23,7 +24,11 @@ private slots:
     void cleanupTestCase();
     void importFile_data();
     void importFile();
+    void optimizeMeshData();
+    void quantizeMeshAttributes();
 
+private:
+    static QSSGMesh::Mesh importMesh(const QJsonObject &options, QTemporaryDir *dir);
 };
 
 tst_assetimport::tst_assetimport()
@@ -83,6 +88,160 @@ void tst_assetimport::importFile()
     QCOMPARE(realResult, result);
 }
 
+QSSGMesh::Mesh tst_assetimport::importMesh(const QJsonObject &options, QTemporaryDir *dir)
+{
+    QSSGAssetImportManager importManager;
+    QString error;
+    const auto importState = importManager.importFile(QFINDTESTDATA("resources/cube_scene.gltf"),
+                                                      QDir(dir->path()), options, &error);
+    if (importState != QSSGAssetImportManager::ImportState::Success) {
+        qWarning() << "Import failed:" << error;
+        return QSSGMesh::Mesh();
+    }
+
+    const QDir meshDir(dir->filePath(QStringLiteral("meshes")));
+    const QStringList meshFiles = meshDir.entryList({ QStringLiteral("*.mesh") }, QDir::Files);
+    if (meshFiles.size() != 1)
+        return QSSGMesh::Mesh();
+
+    QFile file(meshDir.filePath(meshFiles.first()));
+    if (!file.open(QIODevice::ReadOnly))
+        return QSSGMesh::Mesh();
+    return QSSGMesh::Mesh::loadMesh(&file);
+}
+
+static const QSSGMesh::Mesh::VertexBufferEntry *findEntry(const QSSGMesh::Mesh &mesh, const char *name)
+{
+    for (const QSSGMesh::Mesh::VertexBufferEntry &entry : mesh.vertexBuffer().entries) {
+        if (entry.name == name)
+            return &entry;
+    }
+    return nullptr;
+}
+
+static float readComponent(const QSSGMesh::Mesh &mesh, const QSSGMesh::Mesh::VertexBufferEntry &entry,
+                           quint32 vertex, quint32 component)
+{
+    const char *ptr = mesh.vertexBuffer().data.constData() + vertex * mesh.vertexBuffer().stride + entry.offset;
+    if (entry.componentType == QSSGMesh::Mesh::ComponentType::Float16)
+        return float(reinterpret_cast<const qfloat16 *>(ptr)[component]);
+    return reinterpret_cast<const float *>(ptr)[component];
+}
+
+static quint32 vertexCount(const QSSGMesh::Mesh &mesh)
+{
+    return mesh.vertexBuffer().data.size() / mesh.vertexBuffer().stride;
+}
+
+static QVector<quint32> indices(const QSSGMesh::Mesh &mesh)
+{
+    QVector<quint32> result;
+    const QSSGMesh::Mesh::IndexBuffer &indexBuffer = mesh.indexBuffer();
+    if (indexBuffer.componentType == QSSGMesh::Mesh::ComponentType::UnsignedInt16) {
+        const quint16 *data = reinterpret_cast<const quint16 *>(indexBuffer.data.constData());
+        result.assign(data, data + indexBuffer.data.size() / sizeof(quint16));
+    } else {
+        const quint32 *data = reinterpret_cast<const quint32 *>(indexBuffer.data.constData());
+        result.assign(data, data + indexBuffer.data.size() / sizeof(quint32));
+    }
+    return result;
+}
+
+// Triangles as position triples, rotated to start at the smallest vertex so that
+// reordered indices with the same winding compare equal.
+static QList<QList<float>> trianglePositions(const QSSGMesh::Mesh &mesh)
+{
+    const QSSGMesh::Mesh::VertexBufferEntry *position = findEntry(mesh, QSSGMesh::MeshInternal::getPositionAttrName());
+    Q_ASSERT(position);
+    const QVector<quint32> idx = indices(mesh);
+    QList<QList<float>> result;
+    for (qsizetype i = 0; i + 2 < idx.size(); i += 3) {
+        QList<QList<float>> corners;
+        for (int c = 0; c < 3; ++c)
+            corners.append({ readComponent(mesh, *position, idx[i + c], 0),
+                             readComponent(mesh, *position, idx[i + c], 1),
+                             readComponent(mesh, *position, idx[i + c], 2) });
+        const int first = int(std::min_element(corners.cbegin(), corners.cend()) - corners.cbegin());
+        QList<float> triangle;
+        for (int c = 0; c < 3; ++c)
+            triangle += corners[(first + c) % 3];
+        result.append(triangle);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+void tst_assetimport::optimizeMeshData()
+{
+    QTemporaryDir plainDir;
+    QTemporaryDir optimizedDir;
+    QVERIFY(plainDir.isValid() && optimizedDir.isValid());
+
+    const QSSGMesh::Mesh plain = importMesh(QJsonObject(), &plainDir);
+    const QSSGMesh::Mesh optimized = importMesh(QJsonObject { { "optimizeMeshData", true } }, &optimizedDir);
+    QVERIFY(plain.isValid());
+    QVERIFY(optimized.isValid());
+
+    // The remapped index buffer must stay in range and reference every vertex
+    const quint32 count = vertexCount(optimized);
+    const QVector<quint32> idx = indices(optimized);
+    QVector<bool> used(count, false);
+    for (quint32 index : idx) {
+        QVERIFY(index < count);
+        used[index] = true;
+    }
+    QVERIFY(!used.contains(false));
+
+    // Reordering must not change the geometry itself
+    QCOMPARE(idx.size(), indices(plain).size());
+    QCOMPARE(trianglePositions(optimized), trianglePositions(plain));
+}
+
+void tst_assetimport::quantizeMeshAttributes()
+{
+    QTemporaryDir plainDir;
+    QTemporaryDir quantizedDir;
+    QVERIFY(plainDir.isValid() && quantizedDir.isValid());
+
+    const QSSGMesh::Mesh plain = importMesh(QJsonObject(), &plainDir);
+    const QSSGMesh::Mesh quantized = importMesh(QJsonObject { { "quantizeMeshAttributes", true } }, &quantizedDir);
+    QVERIFY(plain.isValid());
+    QVERIFY(quantized.isValid());
+    QCOMPARE(vertexCount(quantized), vertexCount(plain));
+    QCOMPARE(indices(quantized), indices(plain));
+
+    // Normals are padded to four half floats to keep the attribute 4-byte aligned
+    const auto *normal = findEntry(quantized, QSSGMesh::MeshInternal::getNormalAttrName());
+    const auto *plainNormal = findEntry(plain, QSSGMesh::MeshInternal::getNormalAttrName());
+    QVERIFY(normal && plainNormal);
+    QCOMPARE(normal->componentType, QSSGMesh::Mesh::ComponentType::Float16);
+    QCOMPARE(normal->componentCount, 4u);
+    QCOMPARE(normal->offset % 4, 0u);
+    for (quint32 v = 0; v < vertexCount(plain); ++v) {
+        for (quint32 c = 0; c < 3; ++c)
+            QVERIFY(qAbs(readComponent(quantized, *normal, v, c) - readComponent(plain, *plainNormal, v, c)) < 1.0f / 1024.0f);
+    }
+
+    // Texture coordinates are only quantized when they stay within half a texel of a
+    // 2048x2048 texture, otherwise they are kept as 32-bit floats.
+    const auto *uv = findEntry(quantized, QSSGMesh::MeshInternal::getUV0AttrName());
+    const auto *plainUV = findEntry(plain, QSSGMesh::MeshInternal::getUV0AttrName());
+    QVERIFY(uv && plainUV);
+    QCOMPARE(uv->componentCount, 2u);
+    for (quint32 v = 0; v < vertexCount(plain); ++v) {
+        for (quint32 c = 0; c < 2; ++c) {
+            const float expected = readComponent(plain, *plainUV, v, c);
+            const float actual = readComponent(quantized, *uv, v, c);
+            if (uv->componentType == QSSGMesh::Mesh::ComponentType::Float16) {
+                QVERIFY(expected >= 0.0f && expected <= 1.0f);
+                QVERIFY(qAbs(actual - expected) <= 1.0f / 4096.0f);
+            } else {
+                QCOMPARE(actual, expected);
+            }
+        }
+    }
+}
+
 QTEST_APPLESS_MAIN(tst_assetimport)
 
 #include "tst_assetimport.moc"
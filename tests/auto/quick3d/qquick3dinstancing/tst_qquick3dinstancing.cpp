@@ -0,0 +1,229 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include <QTest>
+#include <QSignalSpy>
+
+#include <QtQuick3D/private/qquick3dinstancing_p.h>
+
+#include <QtQuick3DRuntimeRender/private/qssgrenderinstancetable_p.h>
+
+#include <QtCore/qthread.h>
+
+class tst_QQuick3DInstancing : public QObject
+{
+    Q_OBJECT
+
+    // Work-around to get access to updateSpatialNode
+    class Instancing : public QQuick3DInstancing
+    {
+    public:
+        using QQuick3DInstancing::updateSpatialNode;
+        using QQuick3DInstancing::updateInstances;
+        using QQuick3DInstancing::markDirty;
+
+        explicit Instancing(int count)
+        {
+            for (int i = 0; i < count; ++i)
+                entries.append(entry(float(i)));
+        }
+
+        static InstanceTableEntry entry(float x)
+        {
+            return calculateTableEntry({ x, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f }, {}, Qt::white);
+        }
+
+        QVector<InstanceTableEntry> entries;
+
+    protected:
+        QByteArray getInstanceBuffer(int *instanceCount) override
+        {
+            *instanceCount = int(entries.size());
+            return QByteArray(reinterpret_cast<const char *>(entries.constData()), entries.size() * sizeof(InstanceTableEntry));
+        }
+    };
+
+private slots:
+    void testUpdateInstances();
+    void testMergeRanges_data();
+    void testMergeRanges();
+    void testCombinedUpdates();
+    void testCountChange();
+    void testWorkerThread();
+
+private:
+    static float instanceX(const QSSGRenderInstanceTable &table, int index);
+    static QList<QPair<int, int>> ranges(const QVector<QSSGRenderInstanceTable::Range> &ranges);
+};
+
+float tst_QQuick3DInstancing::instanceX(const QSSGRenderInstanceTable &table, int index)
+{
+    const char *data = static_cast<const char *>(table.constData()) + index * table.stride();
+    return reinterpret_cast<const QSSGRenderInstanceTableEntry *>(data)->row0.w();
+}
+
+QList<QPair<int, int>> tst_QQuick3DInstancing::ranges(const QVector<QSSGRenderInstanceTable::Range> &ranges)
+{
+    QList<QPair<int, int>> result;
+    for (const QSSGRenderInstanceTable::Range &range : ranges)
+        result.append({ range.offset, range.count });
+    return result;
+}
+
+void tst_QQuick3DInstancing::testUpdateInstances()
+{
+    Instancing instancing(8);
+    QScopedPointer<QSSGRenderInstanceTable> table(static_cast<QSSGRenderInstanceTable *>(instancing.updateSpatialNode(nullptr)));
+    QVERIFY(table);
+    QCOMPARE(table->count(), 8);
+    const int serial = table->serial();
+    const int updateSerial = table->updateSerial();
+
+    // Only the reported instances are copied, even when others changed in the buffer
+    instancing.entries[2] = Instancing::entry(20.0f);
+    instancing.entries[5] = Instancing::entry(50.0f);
+    instancing.updateInstances(2, 1);
+    QCOMPARE(instancing.updateSpatialNode(table.data()), table.data());
+
+    QCOMPARE(table->serial(), serial);
+    QCOMPARE(table->updateSerial(), updateSerial + 1);
+    QCOMPARE(ranges(table->lastUpdatedRanges()), (QList<QPair<int, int>> { { 2, 1 } }));
+    QCOMPARE(table->count(), 8);
+    QCOMPARE(instanceX(*table, 1), 1.0f);
+    QCOMPARE(instanceX(*table, 2), 20.0f);
+    QCOMPARE(instanceX(*table, 5), 5.0f);
+
+    // Nothing reported, nothing copied
+    QCOMPARE(instancing.updateSpatialNode(table.data()), table.data());
+    QCOMPARE(table->updateSerial(), updateSerial + 1);
+    QCOMPARE(instanceX(*table, 5), 5.0f);
+
+    // Invalid ranges are ignored
+    instancing.updateInstances(-1, 2);
+    instancing.updateInstances(3, 0);
+    instancing.updateSpatialNode(table.data());
+    QCOMPARE(table->updateSerial(), updateSerial + 1);
+
+    // markDirty() still takes over the whole table
+    instancing.markDirty();
+    instancing.updateSpatialNode(table.data());
+    QVERIFY(table->serial() != serial);
+    QCOMPARE(instanceX(*table, 5), 50.0f);
+}
+
+void tst_QQuick3DInstancing::testMergeRanges_data()
+{
+    using RangeList = QList<QPair<int, int>>;
+    QTest::addColumn<RangeList>("input");
+    QTest::addColumn<RangeList>("expected");
+
+    QTest::newRow("single") << RangeList { { 3, 2 } } << RangeList { { 3, 2 } };
+    QTest::newRow("overlapping") << RangeList { { 1, 3 }, { 2, 4 } } << RangeList { { 1, 5 } };
+    QTest::newRow("contained") << RangeList { { 1, 6 }, { 2, 2 } } << RangeList { { 1, 6 } };
+    QTest::newRow("adjacent") << RangeList { { 0, 2 }, { 2, 2 } } << RangeList { { 0, 4 } };
+    QTest::newRow("unsorted") << RangeList { { 4, 2 }, { 0, 1 }, { 1, 1 } } << RangeList { { 0, 2 }, { 4, 2 } };
+    QTest::newRow("disjoint") << RangeList { { 0, 1 }, { 6, 1 } } << RangeList { { 0, 1 }, { 6, 1 } };
+    QTest::newRow("clipped") << RangeList { { 6, 10 } } << RangeList { { 6, 2 } };
+    QTest::newRow("outside") << RangeList { { 8, 1 }, { 2, 1 } } << RangeList { { 2, 1 } };
+}
+
+void tst_QQuick3DInstancing::testMergeRanges()
+{
+    using RangeList = QList<QPair<int, int>>;
+    QFETCH(RangeList, input);
+    QFETCH(RangeList, expected);
+
+    Instancing instancing(8);
+    QSSGRenderInstanceTable table;
+    QByteArray data(reinterpret_cast<const char *>(instancing.entries.constData()),
+                    instancing.entries.size() * sizeof(QQuick3DInstancing::InstanceTableEntry));
+    table.setData(data, 8, sizeof(QQuick3DInstancing::InstanceTableEntry));
+
+    QVector<QSSGRenderInstanceTable::Range> updateRanges;
+    for (const auto &range : input)
+        updateRanges.append({ range.first, range.second });
+    for (int i = 0; i < 8; ++i)
+        reinterpret_cast<QQuick3DInstancing::InstanceTableEntry *>(data.data())[i] = Instancing::entry(float(i + 100));
+    table.updateData(data, updateRanges);
+
+    QCOMPARE(ranges(table.lastUpdatedRanges()), expected);
+    for (int i = 0; i < 8; ++i) {
+        bool updated = false;
+        for (const auto &range : expected)
+            updated |= (i >= range.first && i < range.first + range.second);
+        QCOMPARE(instanceX(table, i), updated ? float(i + 100) : float(i));
+    }
+}
+
+void tst_QQuick3DInstancing::testCombinedUpdates()
+{
+    Instancing instancing(16);
+    QScopedPointer<QSSGRenderInstanceTable> table(static_cast<QSSGRenderInstanceTable *>(instancing.updateSpatialNode(nullptr)));
+    const int updateSerial = table->updateSerial();
+
+    // Ranges reported between two synchronizations end up in one update
+    instancing.updateInstances(8, 2);
+    instancing.updateInstances(1, 2);
+    instancing.updateInstances(10, 1);
+    instancing.updateInstances(2, 2);
+    instancing.updateSpatialNode(table.data());
+
+    QCOMPARE(table->updateSerial(), updateSerial + 1);
+    QCOMPARE(ranges(table->lastUpdatedRanges()), (QList<QPair<int, int>> { { 1, 3 }, { 8, 3 } }));
+}
+
+void tst_QQuick3DInstancing::testCountChange()
+{
+    Instancing instancing(8);
+    QScopedPointer<QSSGRenderInstanceTable> table(static_cast<QSSGRenderInstanceTable *>(instancing.updateSpatialNode(nullptr)));
+    const int serial = table->serial();
+    const int updateSerial = table->updateSerial();
+
+    // The table can't be patched when the instance count changes, it's replaced instead
+    instancing.entries.append(Instancing::entry(80.0f));
+    instancing.entries[0] = Instancing::entry(-1.0f);
+    instancing.updateInstances(8, 1);
+    instancing.updateSpatialNode(table.data());
+
+    QVERIFY(table->serial() != serial);
+    QCOMPARE(table->updateSerial(), updateSerial);
+    QVERIFY(table->lastUpdatedRanges().isEmpty());
+    QCOMPARE(table->count(), 9);
+    QCOMPARE(instanceX(*table, 0), -1.0f);
+    QCOMPARE(instanceX(*table, 8), 80.0f);
+
+    // Back to partial updates once the count is stable
+    instancing.entries[4] = Instancing::entry(40.0f);
+    instancing.updateInstances(4, 1);
+    instancing.updateSpatialNode(table.data());
+    QCOMPARE(table->updateSerial(), updateSerial + 1);
+    QCOMPARE(instanceX(*table, 4), 40.0f);
+}
+
+void tst_QQuick3DInstancing::testWorkerThread()
+{
+    Instancing instancing(8);
+    QScopedPointer<QSSGRenderInstanceTable> table(static_cast<QSSGRenderInstanceTable *>(instancing.updateSpatialNode(nullptr)));
+    const int updateSerial = table->updateSerial();
+
+    auto *d = QQuick3DObjectPrivate::get(&instancing);
+    d->dirtyAttributes = 0;
+    QSignalSpy spy(&instancing, &QQuick3DInstancing::instanceTableChanged);
+
+    instancing.entries[6] = Instancing::entry(60.0f);
+    QScopedPointer<QThread> worker(QThread::create([&instancing] { instancing.updateInstances(6, 1); }));
+    worker->start();
+    QVERIFY(worker->wait());
+
+    // The node is marked dirty on the thread the object lives in
+    QTRY_COMPARE(spy.size(), 1);
+    QVERIFY(d->dirtyAttributes & QQuick3DObjectPrivate::Content);
+
+    instancing.updateSpatialNode(table.data());
+    QCOMPARE(table->updateSerial(), updateSerial + 1);
+    QCOMPARE(ranges(table->lastUpdatedRanges()), (QList<QPair<int, int>> { { 6, 1 } }));
+    QCOMPARE(instanceX(*table, 6), 60.0f);
+}
+
+QTEST_MAIN(tst_QQuick3DInstancing)
+#include "tst_qquick3dinstancing.moc"
@@ -23,11 +23,17 @@ class tst_QQuick3DParticleGravity : public QObject
         {
             QQuick3DParticleGravity::affectParticle(sd, d, time);
         }
+
+        void testAffectParticles(const QQuick3DParticleDataSpan &span)
+        {
+            QQuick3DParticleGravity::affectParticles(span);
+        }
     };
 
 private slots:
     void testGravity();
     void testGravityAffect();
+    void testGravityAffectParticles();
 };
 
 void tst_QQuick3DParticleGravity::testGravity()
@@ -69,5 +75,44 @@ void tst_QQuick3DParticleGravity::testGravityAffect()
     delete gravity;
 }
 
+void tst_QQuick3DParticleGravity::testGravityAffectParticles()
+{
+    Gravity *gravity = new Gravity();
+    const float magnitude = 50.0f;
+    const QVector3D direction(1.0f, 2.0f, 3.0f);
+    gravity->setMagnitude(magnitude);
+    gravity->setDirection(direction);
+
+    QList<QQuick3DParticleData> particleData(8);
+    const QList<int> indices = { 1, 2, 5, 7 };
+    const QList<float> times = { 0.0f, 0.5f, 1.0f, 2.5f };
+    QList<QVector3D> startPositions;
+    QList<QQuick3DParticleDataCurrent> batchData(indices.size());
+    for (qsizetype i = 0; i < batchData.size(); i++) {
+        batchData[i].position = QVector3D(float(i), 10.0f, -float(i));
+        startPositions.append(batchData.at(i).position);
+    }
+
+    gravity->testAffectParticles({ particleData.constData(), indices.constData(), times.constData(),
+                                   batchData.data(), int(batchData.size()) });
+
+    // Constant acceleration along the normalized direction: p(t) = p0 + 0.5 * magnitude * t^2 * direction
+    const QVector3D normalizedDirection = direction.normalized();
+    for (qsizetype i = 0; i < batchData.size(); i++) {
+        const float t = times.at(i);
+        const QVector3D expected = startPositions.at(i) + 0.5f * magnitude * t * t * normalizedDirection;
+        QVERIFY2((batchData.at(i).position - expected).length() < 1e-3f,
+                 qPrintable(QStringLiteral("particle %1 at time %2").arg(indices.at(i)).arg(t)));
+    }
+
+    // The single particle version gives the same result
+    QQuick3DParticleDataCurrent single = {};
+    single.position = startPositions.at(3);
+    gravity->testAffectParticle(particleData.at(indices.at(3)), &single, times.at(3));
+    QVERIFY((single.position - batchData.at(3).position).length() < 1e-3f);
+
+    delete gravity;
+}
+
 QTEST_APPLESS_MAIN(tst_QQuick3DParticleGravity)
 #include "tst_qquick3dparticlegravity.moc"
@@ -4,19 +4,62 @@
 #include <QTest>
 #include <QSignalSpy>
 #include <QScopedPointer>
+#include <QThreadPool>
 
 #include <QtQuick3DParticles/private/qquick3dparticlespriteparticle_p.h>
 #include <QtQuick3DParticles/private/qquick3dparticlemodelparticle_p.h>
 #include <QtQuick3DParticles/private/qquick3dparticlesystem_p.h>
+#include <QtQuick3DParticles/private/qquick3dparticleattractor_p.h>
+#include <QtQuick3DParticles/private/qquick3dparticlegravity_p.h>
+#include <QtQuick3DParticles/private/qquick3dparticlerepeller_p.h>
+#include <QtQuick3DParticles/private/qquick3dparticlescaleaffector_p.h>
+#include <QtQuick3DParticles/private/qquick3dparticlewander_p.h>
 
 
 class tst_QQuick3DParticleSystem : public QObject
 {
     Q_OBJECT
 
+    template <typename Affector, bool HasPrepareToAffect>
+    class TestAffector : public Affector
+    {
+    public:
+        using Affector::Affector;
+
+        void testPrepareToAffect()
+        {
+            if constexpr (HasPrepareToAffect)
+                Affector::prepareToAffect();
+        }
+
+        void testAffectParticles(const QQuick3DParticleDataSpan &span)
+        {
+            Affector::affectParticles(span);
+        }
+
+        bool testCanAffectConcurrently() const
+        {
+            return Affector::canAffectConcurrently();
+        }
+    };
+
+    using Attractor = TestAffector<QQuick3DParticleAttractor, true>;
+    using Gravity = TestAffector<QQuick3DParticleGravity, false>;
+    using Repeller = TestAffector<QQuick3DParticleRepeller, true>;
+    using ScaleAffector = TestAffector<QQuick3DParticleScaleAffector, true>;
+    using Wander = TestAffector<QQuick3DParticleWander, false>;
+
+    template <typename Affector>
+    void compareConcurrentWithSerial(Affector *concurrent, Affector *serial);
+
 private slots:
     void testInitialization();
     void testSystem();
+    void testConcurrentAttractor();
+    void testConcurrentGravity();
+    void testConcurrentRepeller();
+    void testConcurrentScaleAffector();
+    void testConcurrentWander();
 };
 
 void tst_QQuick3DParticleSystem::testInitialization()
@@ -66,6 +109,162 @@ void tst_QQuick3DParticleSystem::testSystem()
     delete system;
 }
 
+// Affects the same particles in chunks, like QQuick3DParticleSystem does, once on a thread
+// pool with the first affector and once one chunk after the other with the second. The
+// affectors are set up the same way, and the results must be identical.
+template <typename Affector>
+void tst_QQuick3DParticleSystem::compareConcurrentWithSerial(Affector *concurrent, Affector *serial)
+{
+    QVERIFY(concurrent->testCanAffectConcurrently());
+
+    constexpr int chunkSize = 1024;
+    constexpr int count = 16 * chunkSize;
+    QList<QQuick3DParticleData> particleData(count);
+    QList<int> indices(count);
+    QList<float> times(count);
+    QList<QQuick3DParticleDataCurrent> startData(count);
+    for (int i = 0; i < count; i++) {
+        particleData[i].startPosition = QVector3D(float(i % 7), float(i % 11), float(i % 13));
+        particleData[i].lifetime = 5.0f;
+        particleData[i].index = i;
+        // Use the particles in a different order than they are stored in
+        indices[i] = count - 1 - i;
+        times[i] = float(i % 500) * 0.01f;
+        startData[i].position = QVector3D(float(i % 17) - 8.0f, float(i % 19) - 9.0f, float(i % 23) - 11.0f);
+        startData[i].scale = QVector3D(1.0f, 1.0f, 1.0f);
+    }
+
+    const auto span = [&](QList<QQuick3DParticleDataCurrent> &data, int begin) -> QQuick3DParticleDataSpan {
+        return { particleData.constData(), indices.constData() + begin, times.constData() + begin,
+                 data.data() + begin, std::min(chunkSize, count - begin) };
+    };
+
+    // The concurrent affector goes first, so that nothing it sets up on first use has
+    // been done by the serial run already
+    QList<QQuick3DParticleDataCurrent> concurrentData = startData;
+    concurrent->testPrepareToAffect();
+    QThreadPool pool;
+    pool.setMaxThreadCount(4);
+    for (int begin = 0; begin < count; begin += chunkSize)
+        pool.start([&, begin]() { concurrent->testAffectParticles(span(concurrentData, begin)); });
+    pool.waitForDone();
+
+    QList<QQuick3DParticleDataCurrent> serialData = startData;
+    serial->testPrepareToAffect();
+    for (int begin = 0; begin < count; begin += chunkSize)
+        serial->testAffectParticles(span(serialData, begin));
+
+    bool changed = false;
+    for (int i = 0; i < count; i++) {
+        const QQuick3DParticleDataCurrent &c = concurrentData.at(i);
+        const QQuick3DParticleDataCurrent &s = serialData.at(i);
+        QVERIFY2(c.position == s.position && c.velocity == s.velocity && c.rotation == s.rotation
+                 && c.scale == s.scale && c.color.a == s.color.a,
+                 qPrintable(QStringLiteral("particle %1").arg(i)));
+        changed |= c.position != startData.at(i).position || c.scale != startData.at(i).scale
+                || c.color.a != startData.at(i).color.a;
+    }
+    // Make sure the comparison above was about something
+    QVERIFY(changed);
+}
+
+void tst_QQuick3DParticleSystem::testConcurrentAttractor()
+{
+    QQuick3DParticleSystem system;
+    system.setUseRandomSeed(false);
+    system.setSeed(1234);
+
+    Attractor concurrent(&system);
+    Attractor serial(&system);
+    for (Attractor *attractor : { &concurrent, &serial }) {
+        attractor->setSystem(&system);
+        attractor->setPosition(QVector3D(10.0f, 20.0f, 30.0f));
+        attractor->setPositionVariation(QVector3D(5.0f, 5.0f, 5.0f));
+        attractor->setDuration(2000);
+        attractor->setDurationVariation(500);
+    }
+    compareConcurrentWithSerial(&concurrent, &serial);
+}
+
+void tst_QQuick3DParticleSystem::testConcurrentGravity()
+{
+    QQuick3DParticleSystem system;
+
+    Gravity concurrent(&system);
+    Gravity serial(&system);
+    for (Gravity *gravity : { &concurrent, &serial }) {
+        gravity->setSystem(&system);
+        gravity->setMagnitude(50.0f);
+        gravity->setDirection(QVector3D(1.0f, 2.0f, 3.0f));
+    }
+    compareConcurrentWithSerial(&concurrent, &serial);
+}
+
+void tst_QQuick3DParticleSystem::testConcurrentRepeller()
+{
+    QQuick3DParticleSystem system;
+
+    Repeller concurrent(&system);
+    Repeller serial(&system);
+    for (Repeller *repeller : { &concurrent, &serial }) {
+        repeller->setSystem(&system);
+        repeller->setRadius(5.0f);
+        repeller->setOuterRadius(15.0f);
+        repeller->setStrength(2.0f);
+    }
+    compareConcurrentWithSerial(&concurrent, &serial);
+}
+
+void tst_QQuick3DParticleSystem::testConcurrentScaleAffector()
+{
+    QQuick3DParticleSystem system;
+
+    // Bezier spline curves are set up on their first use
+    QEasingCurve curve(QEasingCurve::BezierSpline);
+    curve.addCubicBezierSegment(QPointF(0.2, 0.0), QPointF(0.4, 1.0), QPointF(1.0, 1.0));
+
+    ScaleAffector concurrent(&system);
+    ScaleAffector serial(&system);
+    for (ScaleAffector *scaleAffector : { &concurrent, &serial }) {
+        scaleAffector->setSystem(&system);
+        scaleAffector->setType(QQuick3DParticleScaleAffector::SewSaw);
+        scaleAffector->setMinSize(0.5f);
+        scaleAffector->setMaxSize(3.0f);
+        scaleAffector->setDuration(1500);
+        scaleAffector->setEasingCurve(curve);
+    }
+    compareConcurrentWithSerial(&concurrent, &serial);
+    if (QTest::currentTestFailed())
+        return;
+
+    // A custom easing function isn't known to be thread-safe
+    QEasingCurve customCurve;
+    customCurve.setCustomType([](qreal progress) { return progress * progress; });
+    concurrent.setEasingCurve(customCurve);
+    QVERIFY(!concurrent.testCanAffectConcurrently());
+}
+
+void tst_QQuick3DParticleSystem::testConcurrentWander()
+{
+    QQuick3DParticleSystem system;
+    system.setUseRandomSeed(false);
+    system.setSeed(1234);
+
+    Wander concurrent(&system);
+    Wander serial(&system);
+    for (Wander *wander : { &concurrent, &serial }) {
+        wander->setSystem(&system);
+        wander->setGlobalAmount(QVector3D(2.0f, 3.0f, 4.0f));
+        wander->setGlobalPace(QVector3D(0.5f, 1.0f, 1.5f));
+        wander->setUniqueAmount(QVector3D(1.0f, 1.0f, 1.0f));
+        wander->setUniquePace(QVector3D(1.0f, 2.0f, 3.0f));
+        wander->setUniqueAmountVariation(0.5f);
+        wander->setUniquePaceVariation(0.5f);
+        wander->setFadeInDuration(500);
+        wander->setFadeOutDuration(500);
+    }
+    compareConcurrentWithSerial(&concurrent, &serial);
+}
 
 QTEST_APPLESS_MAIN(tst_QQuick3DParticleSystem)
 #include "tst_qquick3dparticlesystem.moc"
@@ -0,0 +1,42 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+import QtQuick
+import QtQuick3D
+
+View3D {
+    width: 640
+    height: 480
+    id: view1
+    anchors.fill: parent
+
+    function loadTextures() {
+        material.baseColorMap = baseColorTexture
+        material.normalMap = normalTexture
+    }
+
+    PerspectiveCamera {
+        id: camera1
+        z: 300
+    }
+
+    DirectionalLight {
+    }
+
+    Texture {
+        id: baseColorTexture
+        source: "noise4.jpg"
+    }
+
+    Texture {
+        id: normalTexture
+        source: "noise5.jpg"
+    }
+
+    Model {
+        source: "#Cube"
+        materials: PrincipledMaterial {
+            id: material
+        }
+    }
+}
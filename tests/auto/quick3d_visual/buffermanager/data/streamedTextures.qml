@@ -0,0 +1,51 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+import QtQuick
+import QtQuick3D
+
+View3D {
+    width: 640
+    height: 480
+    id: view1
+    anchors.fill: parent
+
+    property url defaultMaterialSource
+    property url customMaterialSource
+
+    PerspectiveCamera {
+        id: camera1
+        z: 600
+    }
+
+    DirectionalLight {
+    }
+
+    // Small on screen, only needs the coarse levels
+    Model {
+        source: "#Cube"
+        x: -100
+        scale: Qt.vector3d(0.1, 0.1, 0.1)
+        materials: PrincipledMaterial {
+            baseColorMap: Texture {
+                source: view1.defaultMaterialSource
+                generateMipmaps: true
+            }
+        }
+    }
+
+    Model {
+        source: "#Cube"
+        x: 100
+        scale: Qt.vector3d(0.1, 0.1, 0.1)
+        materials: CustomMaterial {
+            property TextureInput tex: TextureInput {
+                texture: Texture {
+                    source: view1.customMaterialSource
+                    generateMipmaps: true
+                }
+            }
+            fragmentShader: "streamedTextures.frag"
+        }
+    }
+}
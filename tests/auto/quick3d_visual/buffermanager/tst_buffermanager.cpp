@@ -8,12 +8,16 @@
 #include <private/qssgrendercontextcore_p.h>
 #include <private/qssgrenderbuffermanager_p.h>
 #include <private/qquick3dresourceloader_p.h>
+#include <private/qquickwindow_p.h>
+#include <private/qsgcontext_p.h>
 
 #if QT_CONFIG(vulkan)
 #include <QVulkanInstance>
 #endif
 
 #include <QThread>
+#include <QTemporaryDir>
+#include <QtEndian>
 
 #include "../shared/util.h"
 
@@ -29,6 +33,46 @@ static inline void renderNextFrame(QQuick3DTestOffscreenRenderer *renderer, bool
     renderer->renderControl->endFrame();
 }
 
+// Writes an uncompressed RGBA8 .ktx file with a full mip chain
+static bool writeMipmappedKtx(const QString &fileName, int size)
+{
+    QFile f(fileName);
+    if (!f.open(QIODevice::WriteOnly))
+        return false;
+
+    static const char identifier[] = { '\xAB', 'K', 'T', 'X', ' ', '1', '1', '\xBB', '\r', '\n', '\x1A', '\n' };
+    f.write(identifier, sizeof(identifier));
+    int levelCount = 1;
+    while ((size >> levelCount) > 0)
+        ++levelCount;
+    const quint32 header[] = {
+        0x04030201, // endianness
+        0x1401, // GL_UNSIGNED_BYTE
+        1,
+        0x1908, // GL_RGBA
+        0x8058, // GL_RGBA8
+        0x1908, // GL_RGBA
+        quint32(size),
+        quint32(size),
+        0, // depth
+        0, // array elements
+        1, // faces
+        quint32(levelCount),
+        0 // key/value data
+    };
+    for (quint32 value : header) {
+        const quint32 le = qToLittleEndian(value);
+        f.write(reinterpret_cast<const char *>(&le), sizeof(le));
+    }
+    for (int level = 0; level < levelCount; ++level) {
+        const int levelSize = qMax(1, size >> level);
+        const quint32 imageSize = qToLittleEndian(quint32(levelSize * levelSize * 4));
+        f.write(reinterpret_cast<const char *>(&imageSize), sizeof(imageSize));
+        f.write(QByteArray(levelSize * levelSize * 4, char(0x80)));
+    }
+    return true;
+}
+
 class tst_BufferManager : public QQuick3DDataTest
 {
     Q_OBJECT
@@ -38,6 +82,10 @@ private slots:
     void staticScene_data();
     void staticScene();
     void dynamicScene();
+    void residencyBudget();
+    void asyncMeshLoading();
+    void asyncTextureLoading();
+    void textureStreaming();
 
 private:
     bool initRenderer(QQuick3DTestOffscreenRenderer *renderer, const QString &filename);
@@ -327,6 +375,229 @@ void tst_BufferManager::dynamicScene()
     QCOMPARE(bufferManager->getCustomMeshMap().size(), 0);
 }
 
+void tst_BufferManager::residencyBudget()
+{
+    QQuick3DTestOffscreenRenderer renderer;
+    QVERIFY(initRenderer(&renderer, QString("dynamic.qml")));
+
+    bool readCompleted = false;
+    QRhiReadbackResult readResult;
+    QImage result;
+
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+
+    QSSGRenderContextInterface *context = QSSGRenderContextInterface::renderContextForWindow(*renderer.quickWindow);
+    QVERIFY(context);
+
+    auto bufferManager = context->bufferManager();
+    const auto controller = renderer.rootItem->property("controller").value<QQuick3DNode*>();
+    QVERIFY(controller);
+
+    auto addTexture = [controller](const QString &path) -> QQuick3DTexture* {
+        QQuick3DTexture *texture = nullptr;
+        QMetaObject::invokeMethod(controller, "addTexture", Q_RETURN_ARG(QQuick3DTexture*, texture), Q_ARG(QString, path));
+        return texture;
+    };
+
+    // Large enough for the textures, unused ones are kept
+    bufferManager->setResidencyBudget(64 * 1024 * 1024);
+    QCOMPARE(bufferManager->getImageMap().size(), 0);
+    auto texture = addTexture("noise1.jpg");
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QCOMPARE(bufferManager->getImageMap().size(), 1);
+    const quint64 misses = bufferManager->residencyStats().misses;
+    QMetaObject::invokeMethod(controller, "removeTexture");
+    delete texture;
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QCOMPARE(bufferManager->getImageMap().size(), 1);
+
+    // Using it again does not reload it
+    const quint64 hits = bufferManager->residencyStats().hits;
+    texture = addTexture("noise1.jpg");
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QCOMPARE(bufferManager->getImageMap().size(), 1);
+    QCOMPARE(bufferManager->residencyStats().misses, misses);
+    QVERIFY(bufferManager->residencyStats().hits > hits);
+
+    // The least recently used texture goes first when over the budget
+    auto texture2 = addTexture("noise2.jpg");
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QCOMPARE(bufferManager->getImageMap().size(), 2);
+    QMetaObject::invokeMethod(controller, "removeTexture");
+    delete texture2;
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QMetaObject::invokeMethod(controller, "removeTexture");
+    delete texture;
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QCOMPARE(bufferManager->getImageMap().size(), 2);
+
+    const quint64 evictions = bufferManager->residencyStats().evictions;
+    const auto &memoryStats = context->rhiContext()->stats().globalInfo;
+    bufferManager->setResidencyBudget(memoryStats.meshDataSize + memoryStats.imageDataSize - 1);
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QCOMPARE(bufferManager->getImageMap().size(), 1);
+    QCOMPARE(bufferManager->residencyStats().evictions, evictions + 1);
+    QVERIFY(bufferManager->getImageMap().constBegin().key().path.path().endsWith(QLatin1String("noise1.jpg")));
+
+    // No budget, unused resources are released right away
+    bufferManager->setResidencyBudget(0);
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QCOMPARE(bufferManager->getImageMap().size(), 0);
+    QCOMPARE(bufferManager->getMeshMap().size(), 1);
+}
+
+void tst_BufferManager::asyncMeshLoading()
+{
+    QQuick3DTestOffscreenRenderer renderer;
+    QVERIFY(initRenderer(&renderer, QString("dynamic.qml")));
+
+    bool readCompleted = false;
+    QRhiReadbackResult readResult;
+    QImage result;
+
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+
+    QSSGRenderContextInterface *context = QSSGRenderContextInterface::renderContextForWindow(*renderer.quickWindow);
+    QVERIFY(context);
+
+    auto bufferManager = context->bufferManager();
+    const auto controller = renderer.rootItem->property("controller").value<QQuick3DNode*>();
+    QVERIFY(controller);
+
+    auto addModel = [controller](const QString &path) -> QQuick3DModel* {
+        QQuick3DModel *model = nullptr;
+        QMetaObject::invokeMethod(controller, "addModel", Q_RETURN_ARG(QQuick3DModel*, model), Q_ARG(QString, path));
+        return model;
+    };
+
+    // Parallel loading still has the meshes by the end of the frame
+    bufferManager->setMeshLoadingMode(QSSGBufferManager::MeshLoadingMode::Parallel);
+    QCOMPARE(bufferManager->getMeshMap().size(), 1);
+    auto model1 = addModel("random1.mesh");
+    auto model2 = addModel("random2.mesh");
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QCOMPARE(bufferManager->getMeshMap().size(), 3);
+    QVERIFY(!bufferManager->hasPendingMeshLoads());
+    QMetaObject::invokeMethod(controller, "removeModel");
+    delete model2;
+    QMetaObject::invokeMethod(controller, "removeModel");
+    delete model1;
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QCOMPARE(bufferManager->getMeshMap().size(), 1);
+
+    // Progressive loading picks the meshes up in later frames, without waiting for them
+    bufferManager->setMeshLoadingMode(QSSGBufferManager::MeshLoadingMode::Progressive);
+    addModel("random1.mesh");
+    addModel("#Cube");
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QCOMPARE(bufferManager->getMeshMap().size() + int(bufferManager->hasPendingMeshLoads()), 3);
+    for (int frame = 0; frame < 100 && bufferManager->hasPendingMeshLoads(); ++frame) {
+        QThread::msleep(10);
+        renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    }
+    QVERIFY(!bufferManager->hasPendingMeshLoads());
+    QCOMPARE(bufferManager->getMeshMap().size(), 3);
+
+    // A mesh that fails to load isn't loaded again every frame, which would keep the
+    // loads pending forever
+    addModel("doesnotexist.mesh");
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    for (int frame = 0; frame < 100 && bufferManager->hasPendingMeshLoads(); ++frame) {
+        QThread::msleep(10);
+        renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    }
+    QVERIFY(!bufferManager->hasPendingMeshLoads());
+    for (int frame = 0; frame < 3; ++frame) {
+        renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+        QVERIFY(!bufferManager->hasPendingMeshLoads());
+    }
+    QCOMPARE(bufferManager->getMeshMap().size(), 3);
+}
+
+void tst_BufferManager::asyncTextureLoading()
+{
+    QQuick3DTestOffscreenRenderer renderer;
+    QVERIFY(initRenderer(&renderer, QString("asyncTextures.qml")));
+
+    bool readCompleted = false;
+    QRhiReadbackResult readResult;
+    QImage result;
+
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+
+    QSSGRenderContextInterface *context = QSSGRenderContextInterface::renderContextForWindow(*renderer.quickWindow);
+    QVERIFY(context);
+
+    auto bufferManager = context->bufferManager();
+    bufferManager->setAsyncTextureLoading(true);
+    QCOMPARE(bufferManager->getImageMap().size(), 0);
+
+    // The frame is rendered with placeholders for the images that are still being decoded
+    QMetaObject::invokeMethod(renderer.rootItem, "loadTextures");
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    if (!bufferManager->hasPendingImageLoads())
+        QSKIP("The images were decoded before the frame needed them");
+    QVERIFY(bufferManager->getImageMap().size() < 2);
+
+    // Releasing the cached resources, as QQuickWindow::releaseResources() does, also
+    // releases the placeholders. The frames after that must not use the released ones.
+    QSGRenderContext *rc = QQuickWindowPrivate::get(renderer.quickWindow.data())->context;
+    QVERIFY(rc);
+    emit rc->releaseCachedResourcesRequested();
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+
+    for (int frame = 0; frame < 100 && bufferManager->hasPendingImageLoads(); ++frame) {
+        QThread::msleep(10);
+        renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    }
+    QVERIFY(!bufferManager->hasPendingImageLoads());
+    QCOMPARE(bufferManager->getImageMap().size(), 2);
+}
+
+void tst_BufferManager::textureStreaming()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString defaultMaterialTexture = dir.filePath(QLatin1String("default.ktx"));
+    const QString customMaterialTexture = dir.filePath(QLatin1String("custom.ktx"));
+    QVERIFY(writeMipmappedKtx(defaultMaterialTexture, 512));
+    QVERIFY(writeMipmappedKtx(customMaterialTexture, 512));
+
+    QQuick3DTestOffscreenRenderer renderer;
+    QVERIFY(initRenderer(&renderer, QString("streamedTextures.qml")));
+
+    bool readCompleted = false;
+    QRhiReadbackResult readResult;
+    QImage result;
+
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+
+    QSSGRenderContextInterface *context = QSSGRenderContextInterface::renderContextForWindow(*renderer.quickWindow);
+    QVERIFY(context);
+
+    auto bufferManager = context->bufferManager();
+    bufferManager->setTextureStreamingEnabled(true);
+
+    renderer.rootItem->setProperty("defaultMaterialSource", QUrl::fromLocalFile(defaultMaterialTexture));
+    renderer.rootItem->setProperty("customMaterialSource", QUrl::fromLocalFile(customMaterialTexture));
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+
+    const auto &imageMap = bufferManager->getImageMap();
+    QCOMPARE(imageMap.size(), 2);
+    for (auto it = imageMap.cbegin(), end = imageMap.cend(); it != end; ++it) {
+        const QRhiTexture *texture = it.value().renderImageTexture.m_texture;
+        QVERIFY(texture);
+        if (it.key().path.path() == defaultMaterialTexture) {
+            // The default material passes the size it covers on screen, so it starts coarse
+            QVERIFY(texture->pixelSize().width() < 512);
+        } else {
+            // Custom materials don't, they always get all the levels
+            QCOMPARE(it.key().path.path(), customMaterialTexture);
+            QCOMPARE(texture->pixelSize(), QSize(512, 512));
+        }
+    }
+}
+
 bool tst_BufferManager::initRenderer(QQuick3DTestOffscreenRenderer *renderer, const QString &filename)
 {
     const bool initSuccess = renderer->init(testFileUrl(filename),
@@ -26,6 +26,10 @@ private:
 
 void tst_Picking::initTestCase()
 {
+    // The mesh BVHs are built in the background, make sure the picks
+    // below don't fall back to bounds because they happen too early.
+    qputenv("QT_QUICK3D_PICK_BVH_WAIT_TIMEOUT", "5000");
+
     QQuick3DDataTest::initTestCase();
     if (!initialized())
         return;
@@ -0,0 +1,167 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include <QtTest>
+
+#include <QtQuick3DRuntimeRender/private/qssgrendercontextcore_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrendershadercache_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrhicontext_p.h>
+
+using CompileMode = QSSGShaderCache::CompileMode;
+
+class tst_QSSGAsyncShaderCompilation : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void test_synchronous();
+    void test_pendingPipelineIsPickedUpLater();
+    void test_finishedCompilationsAreCollected();
+    void test_pendingCompilationsRequestFrames();
+    void test_failedCompilationStopsRequestingFrames();
+
+private:
+    QRhi *rhi = nullptr;
+    QSSGRef<QSSGRhiContext> rhiContext;
+};
+
+// compileForRhi() adds the version, the feature defines and fragOutput
+static const QByteArray vertexShader = QByteArrayLiteral("void main() { gl_Position = vec4(0.0, 0.0, 0.0, 1.0); }\n");
+static const QByteArray fragmentShader = QByteArrayLiteral("void main() { fragOutput = vec4(1.0); }\n");
+static constexpr int bakeTimeout = 60000;
+
+void tst_QSSGAsyncShaderCompilation::initTestCase()
+{
+    // Keep the baked pipelines in memory, instead of in (and from) the cache file
+    qputenv("QT_DISABLE_SHADER_DISK_CACHE", "1");
+    rhi = QRhi::create(QRhi::Null, nullptr);
+    QVERIFY(rhi);
+    rhiContext = new QSSGRhiContext;
+    rhiContext->initialize(rhi);
+}
+
+void tst_QSSGAsyncShaderCompilation::cleanupTestCase()
+{
+    rhiContext.clear();
+    delete rhi;
+}
+
+void tst_QSSGAsyncShaderCompilation::test_synchronous()
+{
+    QSSGRef<QSSGShaderCache> cache(new QSSGShaderCache(rhiContext));
+    const QSSGShaderFeatures features;
+    const QSSGRef<QSSGRhiShaderPipeline> pipeline = cache->compileForRhi("sync", vertexShader, fragmentShader, features, {});
+    QVERIFY(pipeline);
+    QVERIFY(pipeline->vertexStage());
+    QVERIFY(pipeline->fragmentStage());
+    QVERIFY(!cache->isCompilationPending("sync", features));
+    QVERIFY(!cache->hasPendingCompilations());
+}
+
+void tst_QSSGAsyncShaderCompilation::test_pendingPipelineIsPickedUpLater()
+{
+    QSSGRef<QSSGShaderCache> cache(new QSSGShaderCache(rhiContext));
+    const QSSGShaderFeatures features;
+    QSSGShaderFeatures depthPassFeatures;
+    depthPassFeatures.set(QSSGShaderFeatures::Feature::DepthPass, true);
+
+    // The first frame gets no pipeline, the renderables using it are skipped
+    QVERIFY(!cache->compileForRhi("async", vertexShader, fragmentShader, features, {}, CompileMode::Asynchronous));
+    QVERIFY(cache->isCompilationPending("async", features));
+    QVERIFY(!cache->isCompilationPending("async", depthPassFeatures));
+    QVERIFY(cache->hasPendingCompilations());
+
+    // Asking again doesn't start another compilation
+    QVERIFY(!cache->compileForRhi("async", vertexShader, fragmentShader, features, {}, CompileMode::Asynchronous));
+    QVERIFY(cache->isCompilationPending("async", features));
+
+    // A later frame looking the pipeline up gets it once baking finished
+    QSSGRef<QSSGRhiShaderPipeline> pipeline;
+    QTRY_VERIFY_WITH_TIMEOUT((pipeline = cache->tryGetRhiShaderPipeline("async", features)), bakeTimeout);
+    QVERIFY(pipeline->vertexStage());
+    QVERIFY(pipeline->fragmentStage());
+    QVERIFY(!cache->isCompilationPending("async", features));
+    QVERIFY(!cache->hasPendingCompilations());
+
+    // From then on it is cached
+    QCOMPARE(cache->tryGetRhiShaderPipeline("async", features).data(), pipeline.data());
+    QCOMPARE(cache->compileForRhi("async", vertexShader, fragmentShader, features, {}, CompileMode::Asynchronous).data(),
+             pipeline.data());
+}
+
+void tst_QSSGAsyncShaderCompilation::test_finishedCompilationsAreCollected()
+{
+    // Nothing asks for the pipeline anymore, for example because the model got hidden
+    QSSGRef<QSSGShaderCache> cache(new QSSGShaderCache(rhiContext));
+    const QSSGShaderFeatures features;
+    QVERIFY(!cache->compileForRhi("unused", vertexShader, fragmentShader, features, {}, CompileMode::Asynchronous));
+    QVERIFY(cache->hasPendingCompilations());
+
+    const auto endFrame = [&cache]() {
+        cache->collectFinishedCompilations();
+        return !cache->hasPendingCompilations();
+    };
+    QTRY_VERIFY_WITH_TIMEOUT(endFrame(), bakeTimeout);
+    QVERIFY(!cache->isCompilationPending("unused", features));
+
+    const QSSGRef<QSSGRhiShaderPipeline> pipeline = cache->tryGetRhiShaderPipeline("unused", features);
+    QVERIFY(pipeline);
+    QVERIFY(pipeline->vertexStage());
+    QVERIFY(pipeline->fragmentStage());
+}
+
+void tst_QSSGAsyncShaderCompilation::test_pendingCompilationsRequestFrames()
+{
+    QSSGRef<QSSGShaderCache> cache(new QSSGShaderCache(rhiContext));
+    QSSGRenderContextInterface context(rhiContext, new QSSGBufferManager, new QSSGRenderer, new QSSGShaderLibraryManager,
+                                       cache, new QSSGCustomMaterialSystem, new QSSGProgramGenerator);
+    const QSSGRef<QSSGRenderer> &renderer = context.renderer();
+    QVERIFY(!renderer->rendererRequestsFrames());
+
+    const QSSGShaderFeatures features;
+    QVERIFY(!cache->compileForRhi("frames", vertexShader, fragmentShader, features, {}, CompileMode::Asynchronous));
+    QVERIFY(renderer->rendererRequestsFrames());
+
+    // Frames keep coming until one of them renders with the pipeline, also when the
+    // compilation gets collected at the end of a frame that went without it
+    bool framesRequested = true;
+    const auto renderFrame = [&]() {
+        const bool rendered = bool(cache->tryGetRhiShaderPipeline("frames", features));
+        cache->collectFinishedCompilations(); // as in QSSGRenderContextInterface::endFrame()
+        if (!rendered && !renderer->rendererRequestsFrames())
+            framesRequested = false;
+        return rendered || !framesRequested;
+    };
+    QTRY_VERIFY_WITH_TIMEOUT(renderFrame(), bakeTimeout);
+    QVERIFY(framesRequested);
+    QVERIFY(!renderer->rendererRequestsFrames());
+}
+
+void tst_QSSGAsyncShaderCompilation::test_failedCompilationStopsRequestingFrames()
+{
+    QSSGRef<QSSGShaderCache> cache(new QSSGShaderCache(rhiContext));
+    QSSGRenderContextInterface context(rhiContext, new QSSGBufferManager, new QSSGRenderer, new QSSGShaderLibraryManager,
+                                       cache, new QSSGCustomMaterialSystem, new QSSGProgramGenerator);
+    const QSSGRef<QSSGRenderer> &renderer = context.renderer();
+
+    const QSSGShaderFeatures features;
+    const QByteArray brokenShader = QByteArrayLiteral("void main() { fragOutput = notDeclared; }\n");
+    QVERIFY(!cache->compileForRhi("broken", vertexShader, brokenShader, features, {}, CompileMode::Asynchronous));
+    QVERIFY(renderer->rendererRequestsFrames());
+
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("Failed to compile fragment shader"));
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("broken"));
+    const auto endFrame = [&]() {
+        cache->collectFinishedCompilations();
+        return !renderer->rendererRequestsFrames();
+    };
+    QTRY_VERIFY_WITH_TIMEOUT(endFrame(), bakeTimeout);
+    QVERIFY(!cache->isCompilationPending("broken", features));
+    QVERIFY(!cache->tryGetRhiShaderPipeline("broken", features));
+}
+
+QTEST_GUILESS_MAIN(tst_QSSGAsyncShaderCompilation)
+#include "tst_asyncshadercompilation.moc"
@@ -0,0 +1,450 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include <QtTest>
+
+#include <QtQuick3DRuntimeRender/private/qssglayerrenderdata_p.h>
+
+#include <QtCore/qrandom.h>
+
+#include <numeric>
+
+using LodRange = QSSGLayerRenderData::InstanceLodRange;
+
+class tst_QSSGInstanceFilter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_instanceSpaceFrustum();
+    void test_collectInstanceBounds();
+    void test_appendBounds();
+    void test_compactVisibleFirst();
+    void test_compactLodOnly();
+    void test_drawnInstanceCounts();
+    void test_sortBackToFront();
+    void test_sortIncremental();
+    void test_sortGiveUpThenRadix();
+    void test_sortFilteredSurvivors();
+};
+
+// Unscaled, unrotated instance at pos, with id stored in the instance data
+static QSSGRenderInstanceTableEntry instanceAt(const QVector3D &pos, int id)
+{
+    return { QVector4D(1, 0, 0, pos.x()), QVector4D(0, 1, 0, pos.y()), QVector4D(0, 0, 1, pos.z()),
+             QVector4D(1, 1, 1, 1), QVector4D(float(id), 0, 0, 0) };
+}
+
+// Instances at x = 0, 10, 20, ... with the index as id
+static QVector<QSSGRenderInstanceTableEntry> instanceRow(int count)
+{
+    QVector<QSSGRenderInstanceTableEntry> instances;
+    for (int idx = 0; idx < count; ++idx)
+        instances.append(instanceAt(QVector3D(10.0f * idx, 0, 0), idx));
+    return instances;
+}
+
+static QVector<int> ids(const QVector<QSSGRenderInstanceTableEntry> &entries, quint32 count)
+{
+    QVector<int> result;
+    for (quint32 idx = 0; idx < count; ++idx)
+        result.append(int(entries.at(idx).instanceData.x()));
+    return result;
+}
+
+// The frustum of an axis aligned box, with the plane normals pointing inside
+static QSSGClippingFrustum boxFrustum(const QVector3D &minimum, const QVector3D &maximum)
+{
+    QSSGClippingFrustum frustum;
+    for (int axis = 0; axis < 3; ++axis) {
+        QVector3D normal;
+        normal[axis] = 1.0f;
+        frustum.mPlanes[2 * axis].normal = normal;
+        frustum.mPlanes[2 * axis].d = -minimum[axis];
+        frustum.mPlanes[2 * axis + 1].normal = -normal;
+        frustum.mPlanes[2 * axis + 1].d = maximum[axis];
+    }
+    for (QSSGClipPlane &plane : frustum.mPlanes)
+        plane.calculateBBoxEdges();
+    return frustum;
+}
+
+static const QSSGBounds3 unitBounds(QVector3D(-1, -1, -1), QVector3D(1, 1, 1));
+
+static QVector<quint32> cullInstances(const QSSGClippingFrustum &frustum, const QVector<QSSGRenderInstanceTableEntry> &instances)
+{
+    QSSGBoundsSoA bounds;
+    QSSGLayerRenderData::collectInstanceBounds(bounds, instances.constData(), quint32(instances.size()), unitBounds);
+    QVector<quint32> mask(QSSGBoundsSoA::maskSize(instances.size()));
+    frustum.intersectsWith(bounds, mask.data());
+    return mask;
+}
+
+// Instances at random integer positions, many of them at the same depth
+static QVector<QSSGRenderInstanceTableEntry> randomInstances(int count, int range, quint32 seed)
+{
+    QRandomGenerator rng(seed);
+    QVector<QSSGRenderInstanceTableEntry> instances;
+    for (int idx = 0; idx < count; ++idx) {
+        const QVector3D pos(rng.bounded(-range, range + 1), rng.bounded(-range, range + 1), rng.bounded(-range, range + 1));
+        instances.append(instanceAt(pos, idx));
+    }
+    return instances;
+}
+
+static float depth(const QSSGRenderInstanceTableEntry &instance, const QVector3D &direction)
+{
+    return QVector3D::dotProduct(QVector3D(instance.row0.w(), instance.row1.w(), instance.row2.w()), direction);
+}
+
+// The ids of the instances in order, stable sorted back to front along direction
+static QVector<int> backToFront(const QVector<QSSGRenderInstanceTableEntry> &instances, QVector<quint32> order, const QVector3D &direction)
+{
+    std::stable_sort(order.begin(), order.end(), [&](quint32 lhs, quint32 rhs) {
+        return depth(instances.at(lhs), direction) > depth(instances.at(rhs), direction);
+    });
+    QVector<int> result;
+    for (quint32 idx : std::as_const(order))
+        result.append(int(instances.at(idx).instanceData.x()));
+    return result;
+}
+
+static QVector<quint32> identityOrder(qsizetype count)
+{
+    QVector<quint32> order(count);
+    std::iota(order.begin(), order.end(), 0u);
+    return order;
+}
+
+static bool isPermutation(QVector<quint32> order)
+{
+    std::sort(order.begin(), order.end());
+    return order == identityOrder(order.size());
+}
+
+// Sorts all instances, and checks the result against a stable back to front std::sort
+// starting from the order of the previous sort
+static bool sortsLikeStdSort(const QVector<QSSGRenderInstanceTableEntry> &instances, QVector<quint32> &sortOrder, const QVector3D &direction)
+{
+    const QVector<quint32> previousOrder = sortOrder.isEmpty() ? identityOrder(instances.size()) : sortOrder;
+    QVector<QSSGRenderInstanceTableEntry> dest(instances.size());
+    quint32 visibleCount = 0;
+    const quint32 count = QSSGLayerRenderData::sortInstances(dest.data(), sortOrder, instances.constData(), quint32(instances.size()),
+                                                             nullptr, nullptr, direction, &visibleCount);
+    if (count != quint32(instances.size()) || visibleCount != count || !isPermutation(sortOrder))
+        return false;
+    const QVector<int> expected = backToFront(instances, previousOrder, direction);
+    QVector<int> sortOrderIds;
+    for (quint32 idx : std::as_const(sortOrder))
+        sortOrderIds.append(int(idx));
+    return ids(dest, count) == expected && sortOrderIds == expected;
+}
+
+void tst_QSSGInstanceFilter::test_instanceSpaceFrustum()
+{
+    const QSSGClippingFrustum worldFrustum = boxFrustum(QVector3D(90, -10, -10), QVector3D(110, 10, 10));
+    QMatrix4x4 parentTransform;
+    parentTransform.translate(100, 0, 0);
+    parentTransform.rotate(90, 0, 1, 0);
+    parentTransform.scale(2);
+    const QSSGClippingFrustum instanceFrustum = QSSGLayerRenderData::instanceSpaceFrustum(worldFrustum, parentTransform);
+
+    // Points in the space of the table classify the same as their world space positions.
+    // The grid doesn't hit the frustum planes, which are at +-5 in the space of the table.
+    int inside = 0;
+    int outside = 0;
+    for (int x = 0; x < 29; ++x) {
+        for (int y = 0; y < 29; ++y) {
+            for (int z = 0; z < 29; ++z) {
+                const QVector3D pos(-8.3f + 0.6f * x, -8.3f + 0.6f * y, -8.3f + 0.6f * z);
+                const bool visible = worldFrustum.intersectsWith(parentTransform.map(pos));
+                QCOMPARE(instanceFrustum.intersectsWith(pos), visible);
+                if (visible)
+                    ++inside;
+                else
+                    ++outside;
+            }
+        }
+    }
+    QVERIFY(inside > 0);
+    QVERIFY(outside > 0);
+}
+
+void tst_QSSGInstanceFilter::test_collectInstanceBounds()
+{
+    // Rotated by 90 degrees around z and scaled by 2
+    QVector<QSSGRenderInstanceTableEntry> instances;
+    instances.append({ QVector4D(0, -2, 0, 10), QVector4D(2, 0, 0, 20), QVector4D(0, 0, 2, 30), QVector4D(), QVector4D() });
+    instances.append(instanceAt(QVector3D(), 1));
+
+    QSSGBoundsSoA bounds;
+    const QSSGBounds3 localBounds(QVector3D(0, 0, 0), QVector3D(1, 2, 3));
+    QSSGLayerRenderData::collectInstanceBounds(bounds, instances.constData(), quint32(instances.size()), localBounds);
+    QCOMPARE(bounds.size(), qsizetype(2));
+    QCOMPARE(bounds.paddedSize() % QSSGBoundsSoA::Alignment, qsizetype(0));
+
+    QCOMPARE(bounds.minX.at(0), 6.0f);
+    QCOMPARE(bounds.minY.at(0), 20.0f);
+    QCOMPARE(bounds.minZ.at(0), 30.0f);
+    QCOMPARE(bounds.maxX.at(0), 10.0f);
+    QCOMPARE(bounds.maxY.at(0), 22.0f);
+    QCOMPARE(bounds.maxZ.at(0), 36.0f);
+
+    QCOMPARE(bounds.minX.at(1), 0.0f);
+    QCOMPARE(bounds.minY.at(1), 0.0f);
+    QCOMPARE(bounds.minZ.at(1), 0.0f);
+    QCOMPARE(bounds.maxX.at(1), 1.0f);
+    QCOMPARE(bounds.maxY.at(1), 2.0f);
+    QCOMPARE(bounds.maxZ.at(1), 3.0f);
+}
+
+void tst_QSSGInstanceFilter::test_appendBounds()
+{
+    QSSGBoundsSoA bounds;
+    bounds.reserve(20);
+    const float *reserved = bounds.minX.constData();
+    for (int idx = 0; idx < 20; ++idx) {
+        bounds.append(QSSGBounds3(QVector3D(idx, 0, 0), QVector3D(idx + 1, 1, 1)));
+        QCOMPARE(bounds.size(), qsizetype(idx + 1));
+        QCOMPARE(bounds.paddedSize(), QSSGBoundsSoA::alignedSize(idx + 1));
+    }
+    // No reallocation within the reserved size
+    QCOMPARE(bounds.minX.constData(), reserved);
+    for (int idx = 0; idx < 20; ++idx) {
+        QCOMPARE(bounds.minX.at(idx), float(idx));
+        QCOMPARE(bounds.maxX.at(idx), float(idx + 1));
+        QCOMPARE(bounds.maxZ.at(idx), 1.0f);
+    }
+
+    // Cleared for the next frame, the capacity stays
+    bounds.clear();
+    QVERIFY(bounds.isEmpty());
+    bounds.append(QSSGBounds3(QVector3D(-1, -1, -1), QVector3D(1, 1, 1)));
+    QCOMPARE(bounds.size(), qsizetype(1));
+    QCOMPARE(bounds.minX.constData(), reserved);
+    QCOMPARE(bounds.minY.at(0), -1.0f);
+}
+
+void tst_QSSGInstanceFilter::test_compactVisibleFirst()
+{
+    const QVector<QSSGRenderInstanceTableEntry> instances = instanceRow(10);
+    const QVector<quint32> mask = cullInstances(boxFrustum(QVector3D(25, -5, -5), QVector3D(65, 5, 5)), instances);
+    QVector<QSSGRenderInstanceTableEntry> dest(instances.size());
+    quint32 visibleCount = 0;
+
+    // The visible instances first, both parts keep the table order
+    quint32 count = QSSGLayerRenderData::compactInstances(dest.data(), instances.constData(), quint32(instances.size()),
+                                                         mask.constData(), nullptr, &visibleCount);
+    QCOMPARE(count, 10u);
+    QCOMPARE(visibleCount, 4u);
+    QCOMPARE(ids(dest, count), QVector<int>({ 3, 4, 5, 6, 0, 1, 2, 7, 8, 9 }));
+
+    // The level of detail range drops instances from both parts
+    const LodRange nearRange { QVector3D(), -1.0f, 55.0f };
+    count = QSSGLayerRenderData::compactInstances(dest.data(), instances.constData(), quint32(instances.size()),
+                                                 mask.constData(), &nearRange, &visibleCount);
+    QCOMPARE(count, 6u);
+    QCOMPARE(visibleCount, 3u);
+    QCOMPARE(ids(dest, count), QVector<int>({ 3, 4, 5, 0, 1, 2 }));
+
+    const LodRange farRange { QVector3D(), 35.0f, -1.0f };
+    count = QSSGLayerRenderData::compactInstances(dest.data(), instances.constData(), quint32(instances.size()),
+                                                 mask.constData(), &farRange, &visibleCount);
+    QCOMPARE(count, 6u);
+    QCOMPARE(visibleCount, 3u);
+    QCOMPARE(ids(dest, count), QVector<int>({ 4, 5, 6, 7, 8, 9 }));
+}
+
+void tst_QSSGInstanceFilter::test_compactLodOnly()
+{
+    const QVector<QSSGRenderInstanceTableEntry> instances = instanceRow(10);
+    QVector<QSSGRenderInstanceTableEntry> dest(instances.size());
+    quint32 visibleCount = 0;
+
+    // Without a mask all instances count as visible
+    quint32 count = QSSGLayerRenderData::compactInstances(dest.data(), instances.constData(), quint32(instances.size()),
+                                                         nullptr, nullptr, &visibleCount);
+    QCOMPARE(count, 10u);
+    QCOMPARE(visibleCount, 10u);
+    QCOMPARE(ids(dest, count), QVector<int>({ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 }));
+
+    // The minimum is inclusive, the maximum exclusive
+    const LodRange range { QVector3D(), 30.0f, 70.0f };
+    count = QSSGLayerRenderData::compactInstances(dest.data(), instances.constData(), quint32(instances.size()),
+                                                 nullptr, &range, &visibleCount);
+    QCOMPARE(count, 4u);
+    QCOMPARE(visibleCount, 4u);
+    QCOMPARE(ids(dest, count), QVector<int>({ 3, 4, 5, 6 }));
+
+    // The distance is from the camera position
+    const LodRange movedRange { QVector3D(90, 0, 0), -1.0f, 15.0f };
+    count = QSSGLayerRenderData::compactInstances(dest.data(), instances.constData(), quint32(instances.size()),
+                                                 nullptr, &movedRange, &visibleCount);
+    QCOMPARE(count, 2u);
+    QCOMPARE(visibleCount, 2u);
+    QCOMPARE(ids(dest, count), QVector<int>({ 8, 9 }));
+
+    const LodRange emptyRange { QVector3D(), 1000.0f, -1.0f };
+    count = QSSGLayerRenderData::compactInstances(dest.data(), instances.constData(), quint32(instances.size()),
+                                                 nullptr, &emptyRange, &visibleCount);
+    QCOMPARE(count, 0u);
+    QCOMPARE(visibleCount, 0u);
+}
+
+void tst_QSSGInstanceFilter::test_drawnInstanceCounts()
+{
+    // Spans several mask words. The passes drawing from the camera draw the first visibleCount
+    // instances, the shadow and reflection map passes draw all count instances.
+    const QVector<QSSGRenderInstanceTableEntry> instances = instanceRow(100);
+    QVector<QSSGRenderInstanceTableEntry> dest(instances.size());
+    quint32 visibleCount = 0;
+
+    // Nothing in the frustum: nothing to draw from the camera, shadows still get all
+    QVector<quint32> mask = cullInstances(boxFrustum(QVector3D(-5, 95, -5), QVector3D(995, 105, 5)), instances);
+    quint32 count = QSSGLayerRenderData::compactInstances(dest.data(), instances.constData(), quint32(instances.size()),
+                                                         mask.constData(), nullptr, &visibleCount);
+    QCOMPARE(count, 100u);
+    QCOMPARE(visibleCount, 0u);
+
+    // Everything in the frustum
+    mask = cullInstances(boxFrustum(QVector3D(-5, -5, -5), QVector3D(995, 5, 5)), instances);
+    count = QSSGLayerRenderData::compactInstances(dest.data(), instances.constData(), quint32(instances.size()),
+                                                 mask.constData(), nullptr, &visibleCount);
+    QCOMPARE(count, 100u);
+    QCOMPARE(visibleCount, 100u);
+
+    // Instances 30 to 69 in the frustum, crossing word boundaries
+    mask = cullInstances(boxFrustum(QVector3D(295, -5, -5), QVector3D(695, 5, 5)), instances);
+    count = QSSGLayerRenderData::compactInstances(dest.data(), instances.constData(), quint32(instances.size()),
+                                                 mask.constData(), nullptr, &visibleCount);
+    QCOMPARE(count, 100u);
+    QCOMPARE(visibleCount, 40u);
+    QVector<int> expected;
+    for (int id = 30; id < 70; ++id)
+        expected.append(id);
+    QCOMPARE(ids(dest, visibleCount), expected);
+    for (int id = 0; id < 30; ++id)
+        expected.append(id);
+    for (int id = 70; id < 100; ++id)
+        expected.append(id);
+    QCOMPARE(ids(dest, count), expected);
+
+    // With the level of detail range only instances 0 to 49 are drawn at all
+    const LodRange range { QVector3D(), -1.0f, 495.0f };
+    count = QSSGLayerRenderData::compactInstances(dest.data(), instances.constData(), quint32(instances.size()),
+                                                 mask.constData(), &range, &visibleCount);
+    QCOMPARE(count, 50u);
+    QCOMPARE(visibleCount, 20u);
+    expected.clear();
+    for (int id = 30; id < 50; ++id)
+        expected.append(id);
+    for (int id = 0; id < 30; ++id)
+        expected.append(id);
+    QCOMPARE(ids(dest, count), expected);
+}
+
+void tst_QSSGInstanceFilter::test_sortBackToFront()
+{
+    const QVector<QSSGRenderInstanceTableEntry> instances = randomInstances(1000, 50, 4321);
+
+    // Along an axis: negative depths and lots of ties, which keep the table order
+    QVector<quint32> sortOrder;
+    QVERIFY(sortsLikeStdSort(instances, sortOrder, QVector3D(0, 0, 1)));
+    QVERIFY(depth(instances.at(sortOrder.first()), QVector3D(0, 0, 1)) > 0.0f);
+    QVERIFY(depth(instances.at(sortOrder.last()), QVector3D(0, 0, 1)) < 0.0f);
+
+    sortOrder.clear();
+    QVERIFY(sortsLikeStdSort(instances, sortOrder, QVector3D(1, 2, -3).normalized()));
+
+    // Depths far apart in magnitude, on both sides of zero
+    QVector<QSSGRenderInstanceTableEntry> spread;
+    const float depths[] = { 1e-6f, -1e6f, 0.0f, 3.5f, -1e-6f, 1e6f, -3.5f, 0.0f, 3.5f };
+    for (int idx = 0; idx < int(std::size(depths)); ++idx)
+        spread.append(instanceAt(QVector3D(0, 0, depths[idx]), idx));
+    sortOrder.clear();
+    QVERIFY(sortsLikeStdSort(spread, sortOrder, QVector3D(0, 0, 1)));
+    QCOMPARE(sortOrder, QVector<quint32>({ 5, 3, 8, 0, 2, 7, 4, 6, 1 }));
+}
+
+void tst_QSSGInstanceFilter::test_sortIncremental()
+{
+    // A camera turning a little at a time, each sort starts from the previous order
+    const QVector<QSSGRenderInstanceTableEntry> instances = randomInstances(1000, 50, 8765);
+    QVector<quint32> sortOrder;
+    for (int step = 0; step < 20; ++step) {
+        const QVector3D direction = QVector3D(0.01f * step, 0.005f * step, 1).normalized();
+        QVERIFY(sortsLikeStdSort(instances, sortOrder, direction));
+    }
+}
+
+void tst_QSSGInstanceFilter::test_sortGiveUpThenRadix()
+{
+    // Turning the camera around reverses the order, which is too far for the insertion sort
+    QVector<QSSGRenderInstanceTableEntry> instances = randomInstances(1000, 50, 1357);
+    QVector<quint32> sortOrder;
+    QVERIFY(sortsLikeStdSort(instances, sortOrder, QVector3D(0, 0, 1)));
+    QVERIFY(sortsLikeStdSort(instances, sortOrder, QVector3D(0, 0, -1)));
+    QVERIFY(sortsLikeStdSort(instances, sortOrder, QVector3D(1, 0, 0)));
+
+    // Enough instances for the radix sort to be split over the thread pool
+    instances = randomInstances(100000, 1000, 2468);
+    sortOrder.clear();
+    QVERIFY(sortsLikeStdSort(instances, sortOrder, QVector3D(0, 0, 1)));
+    QVERIFY(sortsLikeStdSort(instances, sortOrder, QVector3D(0, 0, -1)));
+    QVERIFY(sortsLikeStdSort(instances, sortOrder, QVector3D(1, 2, 3).normalized()));
+}
+
+void tst_QSSGInstanceFilter::test_sortFilteredSurvivors()
+{
+    const QVector<QSSGRenderInstanceTableEntry> instances = randomInstances(500, 50, 9753);
+    const QVector<quint32> mask = cullInstances(boxFrustum(QVector3D(-20, -20, -20), QVector3D(20, 20, 20)), instances);
+    const LodRange range { QVector3D(), -1.0f, 60.0f };
+    const auto isVisible = [&mask](quint32 idx) { return (mask.at(idx >> 5) & (1u << (idx & 31))) != 0; };
+
+    QVector<QSSGRenderInstanceTableEntry> dest(instances.size());
+    QVector<quint32> sortOrder;
+    quint32 visibleCount = 0;
+    QSSGLayerRenderData::sortInstances(dest.data(), sortOrder, instances.constData(), quint32(instances.size()),
+                                       mask.constData(), &range, QVector3D(0, 0, 1), &visibleCount);
+
+    for (const QVector3D &direction : { QVector3D(0.1f, 0, 1).normalized(), QVector3D(0, 0, -1), QVector3D(0, 1, 0) }) {
+        const QVector<quint32> previousOrder = sortOrder;
+        const quint32 count = QSSGLayerRenderData::sortInstances(dest.data(), sortOrder, instances.constData(), quint32(instances.size()),
+                                                                 mask.constData(), &range, direction, &visibleCount);
+        QVERIFY(isPermutation(sortOrder));
+
+        QVector<quint32> visible;
+        QVector<int> hidden;
+        for (quint32 idx : previousOrder) {
+            if (!range.contains(instances.at(idx)))
+                continue;
+            if (isVisible(idx))
+                visible.append(idx);
+            else
+                hidden.append(int(idx));
+        }
+        QVERIFY(!visible.isEmpty());
+        QVERIFY(!hidden.isEmpty());
+        QCOMPARE(visibleCount, quint32(visible.size()));
+        QCOMPARE(count, quint32(visible.size() + hidden.size()));
+
+        // The visible survivors sorted back to front, then the ones outside of the frustum
+        // in their previous order
+        QCOMPARE(ids(dest, count), backToFront(instances, visible, direction) + hidden);
+
+        // Only the visible survivors move, and only among the positions they had
+        const QVector<int> sortedVisible = backToFront(instances, visible, direction);
+        qsizetype next = 0;
+        for (qsizetype position = 0; position < sortOrder.size(); ++position) {
+            const quint32 previous = previousOrder.at(position);
+            if (range.contains(instances.at(previous)) && isVisible(previous))
+                QCOMPARE(int(sortOrder.at(position)), sortedVisible.at(next++));
+            else
+                QCOMPARE(sortOrder.at(position), previous);
+        }
+        QCOMPARE(next, sortedVisible.size());
+    }
+}
+
+QTEST_APPLESS_MAIN(tst_QSSGInstanceFilter)
+#include "tst_instancefilter.moc"
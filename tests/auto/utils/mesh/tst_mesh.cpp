@@ -0,0 +1,319 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include <QtTest>
+
+#include <QtQuick3DUtils/private/qssgmesh_p.h>
+
+class tst_QSSGMesh : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_loadMeshMapped();
+    void test_compressedBuffers();
+    void test_fileVersion();
+    void test_createLevelsOfDetail();
+    void test_expandHalfFloatAttributes();
+
+private:
+    static QSSGMesh::Mesh createTriangleMesh(float z);
+    static QSSGMesh::Mesh createGridMesh(int size);
+};
+
+QSSGMesh::Mesh tst_QSSGMesh::createTriangleMesh(float z)
+{
+    QSSGMesh::RuntimeMeshData data;
+    data.m_stride = 3 * sizeof(float);
+    data.m_attributes[0].semantic = QSSGMesh::RuntimeMeshData::Attribute::PositionSemantic;
+    data.m_attributes[0].componentType = QSSGMesh::Mesh::ComponentType::Float32;
+    data.m_attributes[0].offset = 0;
+    data.m_attributes[1].semantic = QSSGMesh::RuntimeMeshData::Attribute::IndexSemantic;
+    data.m_attributes[1].componentType = QSSGMesh::Mesh::ComponentType::UnsignedInt16;
+    data.m_attributeCount = 2;
+
+    const float vertices[9] = { 0, 0, z, 1, 0, z, 0, 1, z };
+    data.m_vertexBuffer = QByteArray(reinterpret_cast<const char *>(vertices), sizeof(vertices));
+    const quint16 indices[3] = { 0, 1, 2 };
+    data.m_indexBuffer = QByteArray(reinterpret_cast<const char *>(indices), sizeof(indices));
+
+    QSSGMesh::Mesh::Subset subset;
+    subset.count = 3;
+    subset.offset = 0;
+    subset.bounds.min = QVector3D(0, 0, z);
+    subset.bounds.max = QVector3D(1, 1, z);
+    data.m_subsets.append(subset);
+
+    QString error;
+    QSSGMesh::Mesh mesh = QSSGMesh::Mesh::fromRuntimeData(data, &error);
+    Q_ASSERT(mesh.isValid());
+    return mesh;
+}
+
+QSSGMesh::Mesh tst_QSSGMesh::createGridMesh(int size)
+{
+    QSSGMesh::RuntimeMeshData data;
+    data.m_stride = 3 * sizeof(float);
+    data.m_attributes[0].semantic = QSSGMesh::RuntimeMeshData::Attribute::PositionSemantic;
+    data.m_attributes[0].componentType = QSSGMesh::Mesh::ComponentType::Float32;
+    data.m_attributes[0].offset = 0;
+    data.m_attributes[1].semantic = QSSGMesh::RuntimeMeshData::Attribute::IndexSemantic;
+    data.m_attributes[1].componentType = QSSGMesh::Mesh::ComponentType::UnsignedInt16;
+    data.m_attributeCount = 2;
+
+    QVector<float> vertices;
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x)
+            vertices << float(x) << float(y) << 0.0f;
+    }
+    QVector<quint16> indices;
+    for (int y = 0; y < size - 1; ++y) {
+        for (int x = 0; x < size - 1; ++x) {
+            const quint16 i = quint16(y * size + x);
+            indices << i << quint16(i + 1) << quint16(i + size);
+            indices << quint16(i + 1) << quint16(i + size + 1) << quint16(i + size);
+        }
+    }
+    data.m_vertexBuffer = QByteArray(reinterpret_cast<const char *>(vertices.constData()), vertices.size() * sizeof(float));
+    data.m_indexBuffer = QByteArray(reinterpret_cast<const char *>(indices.constData()), indices.size() * sizeof(quint16));
+
+    QSSGMesh::Mesh::Subset subset;
+    subset.count = indices.size();
+    subset.offset = 0;
+    subset.bounds.min = QVector3D(0, 0, 0);
+    subset.bounds.max = QVector3D(size - 1, size - 1, 0);
+    data.m_subsets.append(subset);
+
+    QString error;
+    QSSGMesh::Mesh mesh = QSSGMesh::Mesh::fromRuntimeData(data, &error);
+    Q_ASSERT(mesh.isValid());
+    return mesh;
+}
+
+void tst_QSSGMesh::test_loadMeshMapped()
+{
+    const QSSGMesh::Mesh mesh1 = createTriangleMesh(1.0f);
+    const QSSGMesh::Mesh mesh2 = createTriangleMesh(2.0f);
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QVERIFY(mesh1.save(&file, 1) != 0);
+    QVERIFY(mesh2.save(&file, 2) != 0);
+    file.close();
+
+    QSSGMesh::Mesh mapped;
+    {
+        QFile device(file.fileName());
+        QVERIFY(device.open(QIODevice::ReadOnly));
+        mapped = QSSGMesh::Mesh::loadMeshMapped(&device, 2);
+    }
+
+    // Still valid after the device is gone
+    QVERIFY(mapped.isValid());
+    QVERIFY(mapped.isMemoryMapped());
+    QCOMPARE(mapped.vertexBuffer().data, mesh2.vertexBuffer().data);
+    QCOMPARE(mapped.indexBuffer().data, mesh2.indexBuffer().data);
+    QCOMPARE(mapped.subsets().size(), 1);
+
+    // Modifying the data detaches from the mapping
+    QSSGMesh::Mesh::VertexBuffer vertexBuffer = mapped.vertexBuffer();
+    vertexBuffer.data[0] = ~vertexBuffer.data.at(0);
+    QCOMPARE(mapped.vertexBuffer().data, mesh2.vertexBuffer().data);
+
+    // Anything but a file is read as usual
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::ReadWrite));
+    QVERIFY(mesh1.save(&buffer) != 0);
+    buffer.seek(0);
+    const QSSGMesh::Mesh loaded = QSSGMesh::Mesh::loadMeshMapped(&buffer);
+    QVERIFY(loaded.isValid());
+    QVERIFY(!loaded.isMemoryMapped());
+    QCOMPARE(loaded.vertexBuffer().data, mesh1.vertexBuffer().data);
+}
+
+void tst_QSSGMesh::test_compressedBuffers()
+{
+    const QSSGMesh::Mesh grid = createGridMesh(32);
+    // Too small to benefit from encoding, stored as-is
+    const QSSGMesh::Mesh triangle = createTriangleMesh(1.0f);
+
+    QBuffer uncompressed;
+    QVERIFY(uncompressed.open(QIODevice::ReadWrite));
+    QVERIFY(grid.save(&uncompressed) != 0);
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QVERIFY(grid.save(&file, 1, true) != 0);
+    QVERIFY(triangle.save(&file, 2, true) != 0);
+    QVERIFY(file.size() < uncompressed.size());
+    file.close();
+
+    QFile device(file.fileName());
+    QVERIFY(device.open(QIODevice::ReadOnly));
+    const QSSGMesh::Mesh loadedGrid = QSSGMesh::Mesh::loadMeshMapped(&device, 1);
+    const QSSGMesh::Mesh loadedTriangle = QSSGMesh::Mesh::loadMesh(&device, 2);
+
+    QVERIFY(loadedGrid.isValid());
+    QCOMPARE(loadedGrid.vertexBuffer().data, grid.vertexBuffer().data);
+    QCOMPARE(loadedGrid.subsets().size(), 1);
+    QCOMPARE(loadedGrid.subsets().first().count, grid.subsets().first().count);
+
+    // The index codec may rotate the vertices of a triangle, but keeps the winding
+    const QByteArray indexData = grid.indexBuffer().data;
+    const QByteArray loadedIndexData = loadedGrid.indexBuffer().data;
+    QCOMPARE(loadedIndexData.size(), indexData.size());
+    const quint16 *indices = reinterpret_cast<const quint16 *>(indexData.constData());
+    const quint16 *loadedIndices = reinterpret_cast<const quint16 *>(loadedIndexData.constData());
+    for (qsizetype i = 0, end = indexData.size() / sizeof(quint16); i < end; i += 3) {
+        bool rotated = false;
+        for (int r = 0; r < 3 && !rotated; ++r) {
+            rotated = loadedIndices[i] == indices[i + r]
+                    && loadedIndices[i + 1] == indices[i + (r + 1) % 3]
+                    && loadedIndices[i + 2] == indices[i + (r + 2) % 3];
+        }
+        QVERIFY(rotated);
+    }
+
+    QVERIFY(loadedTriangle.isValid());
+    QCOMPARE(loadedTriangle.vertexBuffer().data, triangle.vertexBuffer().data);
+    QCOMPARE(loadedTriangle.indexBuffer().data, triangle.indexBuffer().data);
+}
+
+void tst_QSSGMesh::test_fileVersion()
+{
+    const QSSGMesh::Mesh grid = createGridMesh(8);
+
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::ReadWrite));
+    QVERIFY(grid.save(&buffer, 1) != 0);
+    QVERIFY(grid.save(&buffer, 2, true) != 0);
+    QSSGMesh::Mesh gridWithBvh = grid;
+    QVERIFY(gridWithBvh.createBvhData());
+    QVERIFY(gridWithBvh.save(&buffer, 3) != 0);
+
+    buffer.seek(0);
+    const QSSGMesh::MeshInternal::MultiMeshInfo fileInfo = QSSGMesh::MeshInternal::readFileHeader(&buffer);
+    QVERIFY(fileInfo.isValid());
+
+    // Only meshes with a BVH need version 8, and only the ones using compression need version 9
+    using MeshDataHeader = QSSGMesh::MeshInternal::MeshDataHeader;
+    QSSGMesh::Mesh mesh;
+    MeshDataHeader header;
+    QVERIFY(QSSGMesh::MeshInternal::readMeshData(&buffer, fileInfo.meshEntries.value(1), &mesh, &header) != 0);
+    QCOMPARE(header.fileVersion, quint16(MeshDataHeader::SEPARATE_TARGET_BUFFER_FILE_VERSION));
+    QVERIFY(!header.hasBvhSection());
+    QVERIFY(!header.hasCompressedBuffers());
+    QCOMPARE(mesh.vertexBuffer().data, grid.vertexBuffer().data);
+
+    QSSGMesh::Mesh meshWithBvh;
+    QVERIFY(QSSGMesh::MeshInternal::readMeshData(&buffer, fileInfo.meshEntries.value(3), &meshWithBvh, &header) != 0);
+    QCOMPARE(header.fileVersion, quint16(MeshDataHeader::BVH_SECTION_FILE_VERSION));
+    QVERIFY(!header.hasCompressedBuffers());
+    QVERIFY(meshWithBvh.hasBvhData());
+    QCOMPARE(meshWithBvh.vertexBuffer().data, grid.vertexBuffer().data);
+
+    QSSGMesh::Mesh compressedMesh;
+    QVERIFY(QSSGMesh::MeshInternal::readMeshData(&buffer, fileInfo.meshEntries.value(2), &compressedMesh, &header) != 0);
+    QCOMPARE(header.fileVersion, quint16(MeshDataHeader::COMPRESSED_BUFFERS_FILE_VERSION));
+    QVERIFY(header.hasCompressedBuffers());
+    QCOMPARE(compressedMesh.vertexBuffer().data, grid.vertexBuffer().data);
+}
+
+void tst_QSSGMesh::test_createLevelsOfDetail()
+{
+    QSSGMesh::Mesh grid = createGridMesh(32);
+    const QByteArray originalIndexData = grid.indexBuffer().data;
+    const quint32 originalCount = grid.subsets().first().count;
+
+    QVERIFY(grid.createLevelsOfDetail());
+
+    // The original indices are kept as they are, the levels of detail come after them
+    const QByteArray indexData = grid.indexBuffer().data;
+    QVERIFY(indexData.startsWith(originalIndexData));
+
+    const QSSGMesh::Mesh::Subset subset = grid.subsets().first();
+    QCOMPARE(subset.count, originalCount);
+    QVERIFY(!subset.lods.isEmpty());
+
+    const quint16 *indices = reinterpret_cast<const quint16 *>(indexData.constData());
+    const qsizetype indexCount = indexData.size() / sizeof(quint16);
+    const quint32 vertexCount = 32 * 32;
+    quint32 previousCount = subset.count;
+    float previousDistance = 0.0f;
+    for (const QSSGMesh::Mesh::Lod &lod : subset.lods) {
+        QVERIFY(lod.count > 0);
+        QCOMPARE(lod.count % 3, 0u);
+        QVERIFY(lod.count < previousCount);
+        QVERIFY(lod.distance >= previousDistance);
+        QVERIFY(lod.offset >= originalCount);
+        QVERIFY(lod.offset + lod.count <= indexCount);
+        for (quint32 i = 0; i < lod.count; ++i)
+            QVERIFY(indices[lod.offset + i] < vertexCount);
+        previousCount = lod.count;
+        previousDistance = lod.distance;
+    }
+
+    // Subsets that already have levels of detail are left alone
+    QVERIFY(!grid.createLevelsOfDetail());
+    QCOMPARE(grid.indexBuffer().data, indexData);
+
+    // Nothing to simplify in a single triangle
+    QSSGMesh::Mesh triangle = createTriangleMesh(0.0f);
+    QVERIFY(!triangle.createLevelsOfDetail());
+    QVERIFY(triangle.subsets().first().lods.isEmpty());
+}
+
+void tst_QSSGMesh::test_expandHalfFloatAttributes()
+{
+    // position (3 x float) + normal (4 x half) + uv0 (2 x half)
+    QSSGMesh::Mesh::VertexBuffer vertexBuffer;
+    vertexBuffer.stride = 12 + 8 + 4;
+    vertexBuffer.entries = {
+        { QSSGMesh::Mesh::ComponentType::Float32, 3, 0, QSSGMesh::MeshInternal::getPositionAttrName() },
+        { QSSGMesh::Mesh::ComponentType::Float16, 4, 12, QSSGMesh::MeshInternal::getNormalAttrName() },
+        { QSSGMesh::Mesh::ComponentType::Float16, 2, 20, QSSGMesh::MeshInternal::getUV0AttrName() }
+    };
+    const int vertexCount = 3;
+    vertexBuffer.data.resize(vertexCount * vertexBuffer.stride);
+    for (int v = 0; v < vertexCount; ++v) {
+        char *vertex = vertexBuffer.data.data() + v * vertexBuffer.stride;
+        const float position[3] = { float(v), float(v) * 2.0f, -1.0f };
+        const qfloat16 normal[4] = { qfloat16(0.0f), qfloat16(1.0f), qfloat16(0.0f), qfloat16(0.0f) };
+        const qfloat16 uv[2] = { qfloat16(0.25f * v), qfloat16(1.0f - 0.25f * v) };
+        memcpy(vertex, position, sizeof(position));
+        memcpy(vertex + 12, normal, sizeof(normal));
+        memcpy(vertex + 20, uv, sizeof(uv));
+    }
+
+    const QSSGMesh::Mesh::VertexBuffer expanded = QSSGMesh::MeshInternal::expandHalfFloatAttributes(vertexBuffer);
+    QCOMPARE(expanded.entries.size(), vertexBuffer.entries.size());
+    QCOMPARE(expanded.stride, quint32(12 + 16 + 8));
+    QCOMPARE(expanded.data.size(), qsizetype(vertexCount * expanded.stride));
+    for (const QSSGMesh::Mesh::VertexBufferEntry &entry : expanded.entries) {
+        QCOMPARE(entry.componentType, QSSGMesh::Mesh::ComponentType::Float32);
+        QCOMPARE(entry.offset % 4, quint32(0));
+    }
+    QCOMPARE(expanded.entries[1].offset, quint32(12));
+    QCOMPARE(expanded.entries[2].offset, quint32(28));
+
+    for (int v = 0; v < vertexCount; ++v) {
+        const float *vertex = reinterpret_cast<const float *>(expanded.data.constData() + v * expanded.stride);
+        QCOMPARE(vertex[0], float(v));
+        QCOMPARE(vertex[1], float(v) * 2.0f);
+        QCOMPARE(vertex[2], -1.0f);
+        QCOMPARE(vertex[3], 0.0f);
+        QCOMPARE(vertex[4], 1.0f);
+        QCOMPARE(vertex[5], 0.0f);
+        QCOMPARE(vertex[6], 0.0f);
+        QCOMPARE(vertex[7], 0.25f * v);
+        QCOMPARE(vertex[8], 1.0f - 0.25f * v);
+    }
+
+    // Buffers without half floats come back unchanged
+    const QSSGMesh::Mesh::VertexBuffer again = QSSGMesh::MeshInternal::expandHalfFloatAttributes(expanded);
+    QCOMPARE(again.stride, expanded.stride);
+    QCOMPARE(again.data, expanded.data);
+}
+
+QTEST_APPLESS_MAIN(tst_QSSGMesh)
+#include "tst_mesh.moc"
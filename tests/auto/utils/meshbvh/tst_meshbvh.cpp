@@ -0,0 +1,141 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include <QtTest>
+
+#include <QtQuick3DUtils/private/qssgmesh_p.h>
+#include <QtQuick3DUtils/private/qssgmeshbvh_p.h>
+#include <QtQuick3DUtils/private/qssgmeshbvhbuilder_p.h>
+
+#include <memory>
+
+class tst_QSSGMeshBVH : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_buildTree();
+    void test_saveLoadBvhData();
+
+private:
+    static QSSGMesh::Mesh createGridMesh(int size);
+    static void verifyTree(const QSSGMeshBVH &bvh, qint32 root, qsizetype expectedTriangleCount);
+};
+
+// A size x size grid of quads, slightly bent so that the bounds aren't flat
+QSSGMesh::Mesh tst_QSSGMeshBVH::createGridMesh(int size)
+{
+    QSSGMesh::RuntimeMeshData data;
+    data.m_stride = 3 * sizeof(float);
+    data.m_attributes[0].semantic = QSSGMesh::RuntimeMeshData::Attribute::PositionSemantic;
+    data.m_attributes[0].componentType = QSSGMesh::Mesh::ComponentType::Float32;
+    data.m_attributes[0].offset = 0;
+    data.m_attributes[1].semantic = QSSGMesh::RuntimeMeshData::Attribute::IndexSemantic;
+    data.m_attributes[1].componentType = QSSGMesh::Mesh::ComponentType::UnsignedInt32;
+    data.m_attributeCount = 2;
+
+    for (int y = 0; y <= size; ++y) {
+        for (int x = 0; x <= size; ++x) {
+            const float v[3] = { float(x), float(y), float((x * y) % 7) };
+            data.m_vertexBuffer.append(reinterpret_cast<const char *>(v), sizeof(v));
+        }
+    }
+
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            const quint32 base = y * (size + 1) + x;
+            const quint32 indices[6] = { base, base + 1, base + size + 1, base + 1, base + size + 2, base + size + 1 };
+            data.m_indexBuffer.append(reinterpret_cast<const char *>(indices), sizeof(indices));
+        }
+    }
+
+    QSSGMesh::Mesh::Subset subset;
+    subset.count = size * size * 6;
+    subset.offset = 0;
+    subset.bounds.min = QVector3D(0, 0, 0);
+    subset.bounds.max = QVector3D(size, size, 6);
+    data.m_subsets.append(subset);
+
+    QString error;
+    QSSGMesh::Mesh mesh = QSSGMesh::Mesh::fromRuntimeData(data, &error);
+    Q_ASSERT(mesh.isValid());
+    return mesh;
+}
+
+void tst_QSSGMeshBVH::verifyTree(const QSSGMeshBVH &bvh, qint32 root, qsizetype expectedTriangleCount)
+{
+    QVERIFY(root >= 0 && root < bvh.nodes.size());
+
+    // Every triangle ends up in exactly one leaf, and the bounds of each node contain its children
+    QBitArray seen(bvh.triangles.size());
+    QVector<quint32> stack { quint32(root) };
+    while (!stack.isEmpty()) {
+        const QSSGMeshBVHNode &node = bvh.nodes.at(stack.takeLast());
+        if (node.isLeaf()) {
+            QVERIFY(node.offset + node.count <= quint32(bvh.triangles.size()));
+            for (quint32 i = node.offset; i < node.offset + node.count; ++i) {
+                QVERIFY(!seen.testBit(i));
+                seen.setBit(i);
+                const QSSGBounds3 &triangleBounds = bvh.triangles.at(i).bounds;
+                QVERIFY(node.boundingData.contains(triangleBounds.minimum));
+                QVERIFY(node.boundingData.contains(triangleBounds.maximum));
+            }
+        } else {
+            QVERIFY(node.right() < quint32(bvh.nodes.size()));
+            for (quint32 child : { node.left(), node.right() }) {
+                QVERIFY(node.boundingData.contains(bvh.nodes.at(child).boundingData.minimum));
+                QVERIFY(node.boundingData.contains(bvh.nodes.at(child).boundingData.maximum));
+                stack.append(child);
+            }
+        }
+    }
+    QCOMPARE(seen.count(true), expectedTriangleCount);
+}
+
+void tst_QSSGMeshBVH::test_buildTree()
+{
+    const int size = 64;
+    const QSSGMesh::Mesh mesh = createGridMesh(size);
+
+    for (quint32 parallelThreshold : { 0u, 256u }) {
+        QSSGMeshBVHBuilder builder(mesh);
+        builder.setParallelThreshold(parallelThreshold);
+        std::unique_ptr<QSSGMeshBVH> bvh(builder.buildTree());
+        QVERIFY(bvh);
+        QCOMPARE(bvh->roots.size(), 1);
+        QCOMPARE(bvh->triangles.size(), size * size * 2);
+        verifyTree(*bvh, bvh->roots.first(), size * size * 2);
+    }
+}
+
+void tst_QSSGMeshBVH::test_saveLoadBvhData()
+{
+    const int size = 32;
+    QSSGMesh::Mesh mesh = createGridMesh(size);
+    QVERIFY(!mesh.hasBvhData());
+    QVERIFY(mesh.createBvhData());
+
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::ReadWrite));
+    QVERIFY(mesh.save(&buffer) != 0);
+
+    buffer.seek(0);
+    const QSSGMesh::Mesh loadedMesh = QSSGMesh::Mesh::loadMesh(&buffer);
+    QVERIFY(loadedMesh.isValid());
+    QVERIFY(loadedMesh.hasBvhData());
+    QCOMPARE(loadedMesh.bvhData().roots, mesh.bvhData().roots);
+    QCOMPARE(loadedMesh.bvhData().nodes, mesh.bvhData().nodes);
+    QCOMPARE(loadedMesh.bvhData().triangleIndices, mesh.bvhData().triangleIndices);
+    QCOMPARE(loadedMesh.vertexBuffer().data, mesh.vertexBuffer().data);
+    QCOMPARE(loadedMesh.indexBuffer().data, mesh.indexBuffer().data);
+
+    // The tree from the file is used as-is
+    QSSGMeshBVHBuilder builder(loadedMesh);
+    std::unique_ptr<QSSGMeshBVH> bvh(builder.buildTree());
+    QVERIFY(bvh);
+    QCOMPARE(bvh->nodes.size() * qsizetype(sizeof(QSSGMeshBVHNode)), mesh.bvhData().nodes.size());
+    verifyTree(*bvh, bvh->roots.first(), size * size * 2);
+}
+
+QTEST_APPLESS_MAIN(tst_QSSGMeshBVH)
+#include "tst_meshbvh.moc"
@@ -0,0 +1,223 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include <QtTest>
+
+#include <QtQuick3DRuntimeRender/private/qssgrenderinstancebvh_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrenderinstancetable_p.h>
+
+#include <QtCore/qrandom.h>
+
+class tst_QSSGRenderInstanceBvh : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_build();
+    void test_refitAfterUpdateInstances();
+    void test_refitAfterSetData();
+    void test_countChange();
+    void test_emptyTable();
+};
+
+static const QSSGBounds3 localBounds(QVector3D(-1, -1, -1), QVector3D(1, 2, 1));
+
+// Randomly placed and scaled instances in a 100 unit cube
+static QByteArray randomInstances(int count, QRandomGenerator &rng)
+{
+    QByteArray data(count * int(sizeof(QSSGRenderInstanceTableEntry)), Qt::Uninitialized);
+    auto *entries = reinterpret_cast<QSSGRenderInstanceTableEntry *>(data.data());
+    for (int idx = 0; idx < count; ++idx) {
+        const float scale = 0.5f + 1.5f * float(rng.generateDouble());
+        const QVector3D pos(100.0f * float(rng.generateDouble()) - 50.0f,
+                            100.0f * float(rng.generateDouble()) - 50.0f,
+                            100.0f * float(rng.generateDouble()) - 50.0f);
+        entries[idx] = { QVector4D(scale, 0, 0, pos.x()), QVector4D(0, scale, 0, pos.y()), QVector4D(0, 0, scale, pos.z()),
+                         QVector4D(1, 1, 1, 1), QVector4D() };
+    }
+    return data;
+}
+
+// Rays from outside of the cube, through points inside of it
+static QVector<QSSGRenderRay> randomRays(int count, QRandomGenerator &rng)
+{
+    QVector<QSSGRenderRay> rays;
+    for (int idx = 0; idx < count; ++idx) {
+        const QVector3D target(60.0f * float(rng.generateDouble()) - 30.0f,
+                               60.0f * float(rng.generateDouble()) - 30.0f,
+                               60.0f * float(rng.generateDouble()) - 30.0f);
+        const QVector3D origin = QVector3D(float(rng.generateDouble()) - 0.5f,
+                                           float(rng.generateDouble()) - 0.5f,
+                                           float(rng.generateDouble()) - 0.5f).normalized() * 200.0f;
+        rays.append(QSSGRenderRay(origin, (target - origin).normalized()));
+    }
+    // Along the axes as well, where the ray direction has zero components
+    rays.append(QSSGRenderRay(QVector3D(0, 0, 200), QVector3D(0, 0, -1)));
+    rays.append(QSSGRenderRay(QVector3D(10, -200, 5), QVector3D(0, 1, 0)));
+    return rays;
+}
+
+// The tree has to find the same instances as testing each one, after dropping the candidates
+// that only share a leaf with a hit instance.
+static bool matchesLinearScan(QSSGRenderInstanceBvh &bvh, const QSSGRenderInstanceTable &table, const QVector<QSSGRenderRay> &rays)
+{
+    bvh.update(table);
+    const QMatrix4x4 tableTransform;
+    int hitCount = 0;
+    for (const QSSGRenderRay &ray : rays) {
+        const QSSGRenderRay::RayData rayData = QSSGRenderRay::createRayData(tableTransform, ray);
+        const auto hitsInstance = [&](int idx) {
+            return QSSGRenderRay::intersectWithAABBv2(rayData, table.instanceBounds(idx, localBounds)).intersects();
+        };
+
+        QVector<int> expected;
+        for (int idx = 0; idx < table.count(); ++idx) {
+            if (hitsInstance(idx))
+                expected.append(idx);
+        }
+        hitCount += expected.size();
+
+        QVector<int> candidates;
+        bvh.intersect(rayData, candidates);
+        if (!std::is_sorted(candidates.cbegin(), candidates.cend()))
+            return false;
+        QVector<int> hits;
+        for (int idx : std::as_const(candidates)) {
+            if (idx < 0 || idx >= table.count())
+                return false;
+            if (hitsInstance(idx))
+                hits.append(idx);
+        }
+        if (hits != expected) {
+            qWarning() << "Expected" << expected << "got" << hits;
+            return false;
+        }
+    }
+    // The rays must actually hit something for the comparison to mean anything
+    return table.count() == 0 || hitCount > 0;
+}
+
+void tst_QSSGRenderInstanceBvh::test_build()
+{
+    QRandomGenerator rng(1234);
+    const QVector<QSSGRenderRay> rays = randomRays(200, rng);
+
+    for (int count : { 1, 3, 4, 5, 17, 1000 }) {
+        QSSGRenderInstanceTable table;
+        table.setData(randomInstances(count, rng), count, sizeof(QSSGRenderInstanceTableEntry));
+        QSSGRenderInstanceBvh bvh(localBounds);
+        QVERIFY(matchesLinearScan(bvh, table, rays));
+    }
+
+    // Instances at the same position still get split into leaves
+    QSSGRenderInstanceTable table;
+    QByteArray data = randomInstances(100, rng);
+    auto *entries = reinterpret_cast<QSSGRenderInstanceTableEntry *>(data.data());
+    for (int idx = 0; idx < 100; ++idx) {
+        entries[idx].row0.setW(0);
+        entries[idx].row1.setW(0);
+        entries[idx].row2.setW(0);
+    }
+    table.setData(data, 100, sizeof(QSSGRenderInstanceTableEntry));
+    QSSGRenderInstanceBvh bvh(localBounds);
+    QVERIFY(matchesLinearScan(bvh, table, rays));
+}
+
+void tst_QSSGRenderInstanceBvh::test_refitAfterUpdateInstances()
+{
+    QRandomGenerator rng(5678);
+    const QVector<QSSGRenderRay> rays = randomRays(200, rng);
+    constexpr int count = 1000;
+
+    QSSGRenderInstanceTable table;
+    QByteArray data = randomInstances(count, rng);
+    table.setData(data, count, sizeof(QSSGRenderInstanceTableEntry));
+    QSSGRenderInstanceBvh bvh(localBounds);
+    QVERIFY(matchesLinearScan(bvh, table, rays));
+
+    // One update since the last pick: only the leaves of the moved instances are refit
+    for (int round = 0; round < 50; ++round) {
+        const QByteArray moved = randomInstances(count, rng);
+        const QVector<QSSGRenderInstanceTable::Range> ranges = { { rng.bounded(count - 10), 10 }, { rng.bounded(count), 1 } };
+        constexpr int stride = sizeof(QSSGRenderInstanceTableEntry);
+        for (const auto &range : ranges)
+            memcpy(data.data() + range.offset * stride, moved.constData() + range.offset * stride, range.count * stride);
+        table.updateData(data, ranges);
+        QVERIFY(matchesLinearScan(bvh, table, rays));
+    }
+
+    // Several updates since the last pick: the whole tree is refit
+    for (int round = 0; round < 3; ++round) {
+        data = randomInstances(count, rng);
+        table.updateData(data, { { 0, count / 2 } });
+        table.updateData(data, { { count / 2, count - count / 2 } });
+        QVERIFY(matchesLinearScan(bvh, table, rays));
+    }
+}
+
+void tst_QSSGRenderInstanceBvh::test_refitAfterSetData()
+{
+    // A table replaced before every pick, the tree is refit and rebuilt every so often
+    QRandomGenerator rng(9012);
+    const QVector<QSSGRenderRay> rays = randomRays(200, rng);
+    constexpr int count = 500;
+
+    QSSGRenderInstanceTable table;
+    QSSGRenderInstanceBvh bvh(localBounds);
+    for (int round = 0; round < 20; ++round) {
+        table.setData(randomInstances(count, rng), count, sizeof(QSSGRenderInstanceTableEntry));
+        QVERIFY(matchesLinearScan(bvh, table, rays));
+    }
+}
+
+void tst_QSSGRenderInstanceBvh::test_countChange()
+{
+    QRandomGenerator rng(3456);
+    const QVector<QSSGRenderRay> rays = randomRays(200, rng);
+
+    QSSGRenderInstanceTable table;
+    QSSGRenderInstanceBvh bvh(localBounds);
+    table.setData(randomInstances(800, rng), 800, sizeof(QSSGRenderInstanceTableEntry));
+    QVERIFY(matchesLinearScan(bvh, table, rays));
+
+    // Fewer and more instances
+    table.setData(randomInstances(300, rng), 300, sizeof(QSSGRenderInstanceTableEntry));
+    QVERIFY(matchesLinearScan(bvh, table, rays));
+    table.setData(randomInstances(1200, rng), 1200, sizeof(QSSGRenderInstanceTableEntry));
+    QVERIFY(matchesLinearScan(bvh, table, rays));
+
+    // The instance count override changes the count without a new serial
+    table.setInstanceCountOverride(700);
+    QVERIFY(matchesLinearScan(bvh, table, rays));
+    table.setInstanceCountOverride(1200);
+    QVERIFY(matchesLinearScan(bvh, table, rays));
+
+    // Down to nothing and back
+    table.setData(QByteArray(), 0, sizeof(QSSGRenderInstanceTableEntry));
+    QVERIFY(matchesLinearScan(bvh, table, rays));
+    table.setData(randomInstances(50, rng), 50, sizeof(QSSGRenderInstanceTableEntry));
+    QVERIFY(matchesLinearScan(bvh, table, rays));
+}
+
+void tst_QSSGRenderInstanceBvh::test_emptyTable()
+{
+    QRandomGenerator rng(7890);
+    const QVector<QSSGRenderRay> rays = randomRays(10, rng);
+
+    QSSGRenderInstanceTable table;
+    QSSGRenderInstanceBvh bvh(localBounds);
+    QVERIFY(matchesLinearScan(bvh, table, rays));
+
+    // Empty local bounds can't be hit
+    table.setData(randomInstances(10, rng), 10, sizeof(QSSGRenderInstanceTableEntry));
+    QSSGRenderInstanceBvh emptyBoundsBvh{ QSSGBounds3() };
+    emptyBoundsBvh.update(table);
+    const QMatrix4x4 tableTransform;
+    QVector<int> candidates;
+    for (const QSSGRenderRay &ray : rays)
+        emptyBoundsBvh.intersect(QSSGRenderRay::createRayData(tableTransform, ray), candidates);
+    QVERIFY(candidates.isEmpty());
+}
+
+QTEST_APPLESS_MAIN(tst_QSSGRenderInstanceBvh)
+#include "tst_instancebvh.moc"
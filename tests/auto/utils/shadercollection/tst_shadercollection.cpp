@@ -50,6 +50,7 @@ private Q_SLOTS:
     void test_readWriteOpenDevice();
     void test_mapModes();
     void test_inMemoryCollection();
+    void test_persistentCollection();
 
 private:
     QShader vert;
@@ -275,6 +276,78 @@ void ShaderCollection::test_inMemoryCollection()
 
 }
 
+void ShaderCollection::test_persistentCollection()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath(QLatin1String(tempOutFileName()));
+    const QString journalFileName = QQsbPersistentCollection::journalFileName(fileName);
+
+    const QByteArray hkey = QByteArrayLiteral("12345");
+    const QByteArray otherKey = QByteArrayLiteral("12346");
+
+    {
+        QQsbPersistentCollection qsbc(fileName);
+        QVERIFY(qsbc.open());
+        QVERIFY(qsbc.availableEntries().isEmpty());
+        QVERIFY(qsbc.addEntry(hkey, { QByteArray(shaderDescription()), featureSet, vert, frag }).isValid());
+        QVERIFY(!qsbc.addEntry(hkey, { QByteArray(shaderDescription()), featureSet, vert, frag }).isValid());
+        QCOMPARE(qsbc.journalEntryCount(), 1);
+        // The entry is on disk before the collection is closed
+        QVERIFY(QFile::exists(journalFileName));
+    }
+
+    {
+        // A small journal is kept around rather than merged
+        QVERIFY(!QFile::exists(fileName));
+        QQsbPersistentCollection qsbc(fileName);
+        QVERIFY(qsbc.open());
+        QCOMPARE(qsbc.availableEntries().size(), 1);
+        QVERIFY(qsbc.addEntry(otherKey, { QByteArray(shaderDescription()), featureSet, vert, frag }).isValid());
+        QVERIFY(qsbc.compact());
+        QCOMPARE(qsbc.journalEntryCount(), 0);
+        QCOMPARE(qsbc.availableEntries().size(), 2);
+    }
+
+    QVERIFY(QFile::exists(fileName));
+    QVERIFY(!QFile::exists(journalFileName));
+
+    {
+        // The compacted file can be read by the other implementations
+        QQsbIODeviceCollection qsbc(fileName);
+        QVERIFY(qsbc.map(QQsbIODeviceCollection::Read));
+        QCOMPARE(qsbc.availableEntries().size(), 2);
+        qsbc.unmap();
+    }
+
+    {
+        // An incomplete record at the end of the journal is dropped
+        QQsbPersistentCollection qsbc(fileName);
+        QVERIFY(qsbc.open());
+        QVERIFY(qsbc.addEntry(QByteArrayLiteral("12347"), { QByteArray(shaderDescription()), featureSet, vert, frag }).isValid());
+        qsbc.close();
+        QFile journal(journalFileName);
+        QVERIFY(journal.open(QIODevice::ReadWrite));
+        QVERIFY(journal.resize(journal.size() - 4));
+    }
+
+    {
+        QQsbPersistentCollection qsbc(fileName);
+        QVERIFY(qsbc.open());
+        QCOMPARE(qsbc.journalEntryCount(), 0);
+        QCOMPARE(qsbc.availableEntries().size(), 2);
+
+        for (const QByteArray &key : { hkey, otherKey }) {
+            QQsbCollection::EntryDesc entryDesc;
+            QVERIFY(qsbc.extractEntry(QQsbCollection::Entry(key), entryDesc));
+            QCOMPARE(entryDesc.materialKey, QByteArray(shaderDescription()));
+            QCOMPARE(entryDesc.vertShader, vert);
+            QCOMPARE(entryDesc.fragShader, frag);
+            QCOMPARE(entryDesc.featureSet, featureSet);
+        }
+    }
+}
+
 QTEST_APPLESS_MAIN(ShaderCollection)
 
 #include "tst_shadercollection.moc"
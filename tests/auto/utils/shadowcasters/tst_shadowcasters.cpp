@@ -0,0 +1,193 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include <QtTest>
+
+#include <QtQuick3DRuntimeRender/private/qssgrenderer_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrendershadowmap_p.h>
+
+#include <optional>
+
+class tst_QSSGShadowCasters : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_castersOutsideOfTheLightAreSkipped();
+    void test_unchangedMapIsCached();
+    void test_movedCasterInvalidatesCachedMap();
+    void test_materialChangeInvalidatesCachedMap();
+    void test_viewsSharingTheScene();
+};
+
+// A model with a single unit cube subset, and its renderable as prepared for one frame
+class Caster
+{
+public:
+    explicit Caster(const QVector3D &position)
+    {
+        m_subset.count = 36;
+        m_subset.offset = 0;
+        m_subset.bounds = QSSGBounds3(QVector3D(-1, -1, -1), QVector3D(1, 1, 1));
+        moveTo(position);
+    }
+
+    void moveTo(const QVector3D &position)
+    {
+        model.globalTransform = QMatrix4x4();
+        model.globalTransform.translate(position);
+    }
+
+    // globalValuesDirty is what the layer saw: only the first layer to prepare the
+    // model in a frame sees it dirty.
+    QSSGRenderableObjectHandle prepare(bool globalValuesDirty)
+    {
+        m_renderable.reset();
+        m_context.emplace(model, QMatrix4x4());
+        m_context->globalValuesDirty = globalValuesDirty;
+        m_renderable.emplace(QSSGRenderableObject::Type::DefaultMaterialMeshSubset, QSSGRenderableObjectFlags(),
+                             model.globalTransform.column(3).toVector3D(), m_renderer, m_subset, *m_context, 1.0f, 0,
+                             material, nullptr, QSSGShaderDefaultMaterialKey(), m_lights);
+        return QSSGRenderableObjectHandle(&*m_renderable, 0.0f);
+    }
+
+    QSSGRenderModel model;
+    QSSGRenderDefaultMaterial material;
+
+private:
+    QSSGRenderSubset m_subset;
+    QSSGRef<QSSGRenderer> m_renderer;
+    QSSGShaderLightListView m_lights;
+    std::optional<QSSGModelContext> m_context;
+    std::optional<QSSGSubsetRenderable> m_renderable;
+};
+
+// Collects the casters of a directional light looking down -z, seeing x and y in [-20, 20]
+// and z in [-50, 49]. Returns whether the shadow map has to be rendered.
+static bool prepareShadowMap(QSSGShadowMapEntry &entry, const QVector<QSSGRenderableObjectHandle> &casters,
+                             QVector<QSSGRenderableObjectHandle> *visibleCasters = nullptr)
+{
+    QSSGRenderCamera lightCamera(QSSGRenderGraphObject::Type::OrthographicCamera);
+    lightCamera.clipNear = 1.0f;
+    lightCamera.clipFar = 100.0f;
+    lightCamera.localTransform.translate(0, 0, 50);
+    lightCamera.calculateGlobalVariables(QRectF(0, 0, 40, 40));
+    QMatrix4x4 viewProjection;
+    lightCamera.calculateViewProjectionMatrix(viewProjection);
+
+    QVector<QSSGRenderSpatialIndex::Visibility> leafVisibility;
+    QVector<QSSGRenderableObjectHandle> collected;
+    size_t contentHash = 0;
+    bool cacheable = true;
+    RenderHelpers::collectShadowCasters(casters, lightCamera, viewProjection, nullptr, leafVisibility,
+                                        collected, contentHash, cacheable);
+    if (visibleCasters)
+        *visibleCasters = collected;
+    return RenderHelpers::shadowMapNeedsRender(entry, contentHash, cacheable);
+}
+
+void tst_QSSGShadowCasters::test_castersOutsideOfTheLightAreSkipped()
+{
+    Caster inside(QVector3D(0, 0, 0));
+    Caster straddling(QVector3D(20.5f, 0, 0));
+    Caster beside(QVector3D(30, 0, 0));
+    Caster beyondFar(QVector3D(0, 0, -60));
+    Caster behind(QVector3D(0, 10, 60));
+
+    const QVector<QSSGRenderableObjectHandle> casters = { beside.prepare(true), inside.prepare(true), beyondFar.prepare(true),
+                                                          straddling.prepare(true), behind.prepare(true) };
+    QSSGShadowMapEntry entry;
+    QVector<QSSGRenderableObjectHandle> visibleCasters;
+    QVERIFY(prepareShadowMap(entry, casters, &visibleCasters));
+    QCOMPARE(visibleCasters.size(), 2);
+    QCOMPARE(visibleCasters.at(0).obj, casters.at(1).obj);
+    QCOMPARE(visibleCasters.at(1).obj, casters.at(3).obj);
+}
+
+void tst_QSSGShadowCasters::test_unchangedMapIsCached()
+{
+    Caster first(QVector3D(0, 0, 0));
+    Caster second(QVector3D(5, 5, 5));
+    QSSGShadowMapEntry entry;
+
+    // Rendered while the casters change, and once more before the map is kept
+    QVERIFY(prepareShadowMap(entry, { first.prepare(true), second.prepare(true) }));
+    QVERIFY(prepareShadowMap(entry, { first.prepare(false), second.prepare(false) }));
+    QVERIFY(!prepareShadowMap(entry, { first.prepare(false), second.prepare(false) }));
+
+    // The order of the casters follows the main camera, and doesn't matter
+    QVERIFY(!prepareShadowMap(entry, { second.prepare(false), first.prepare(false) }));
+
+    // A caster that is no longer rendered
+    QVERIFY(prepareShadowMap(entry, { first.prepare(false) }));
+}
+
+void tst_QSSGShadowCasters::test_movedCasterInvalidatesCachedMap()
+{
+    Caster caster(QVector3D(0, 0, 0));
+    Caster outside(QVector3D(40, 0, 0));
+    QSSGShadowMapEntry entry;
+    QVERIFY(prepareShadowMap(entry, { caster.prepare(false), outside.prepare(false) }));
+    QVERIFY(!prepareShadowMap(entry, { caster.prepare(false), outside.prepare(false) }));
+
+    // Moved this frame
+    caster.moveTo(QVector3D(2, 0, 0));
+    QVERIFY(prepareShadowMap(entry, { caster.prepare(true), outside.prepare(false) }));
+    QVERIFY(prepareShadowMap(entry, { caster.prepare(false), outside.prepare(false) }));
+    QVERIFY(!prepareShadowMap(entry, { caster.prepare(false), outside.prepare(false) }));
+
+    // Moving a caster that stays outside of the light frustum doesn't matter
+    outside.moveTo(QVector3D(50, 0, 0));
+    QVERIFY(!prepareShadowMap(entry, { caster.prepare(false), outside.prepare(false) }));
+
+    // ... but moving into it does
+    outside.moveTo(QVector3D(10, 0, 0));
+    QVERIFY(prepareShadowMap(entry, { caster.prepare(false), outside.prepare(false) }));
+}
+
+void tst_QSSGShadowCasters::test_materialChangeInvalidatesCachedMap()
+{
+    Caster caster(QVector3D(0, 0, 0));
+    QSSGShadowMapEntry entry;
+    QVERIFY(prepareShadowMap(entry, { caster.prepare(false) }));
+    QVERIFY(!prepareShadowMap(entry, { caster.prepare(false) }));
+
+    ++caster.material.updateSerial;
+    QVERIFY(prepareShadowMap(entry, { caster.prepare(false) }));
+    QVERIFY(!prepareShadowMap(entry, { caster.prepare(false) }));
+
+    // Another mesh
+    caster.model.meshPath = QSSGRenderPath(QStringLiteral("#Sphere"));
+    QVERIFY(prepareShadowMap(entry, { caster.prepare(false) }));
+    QVERIFY(!prepareShadowMap(entry, { caster.prepare(false) }));
+}
+
+void tst_QSSGShadowCasters::test_viewsSharingTheScene()
+{
+    // Each View3D has shadow maps of its own. The first one to prepare the scene in a frame
+    // clears the dirty flags, so the second one never sees them.
+    Caster caster(QVector3D(0, 0, 0));
+    QSSGShadowMapEntry firstView;
+    QSSGShadowMapEntry secondView;
+    const auto renderFrame = [&](bool dirty) {
+        const bool first = prepareShadowMap(firstView, { caster.prepare(dirty) });
+        const bool second = prepareShadowMap(secondView, { caster.prepare(false) });
+        return std::make_pair(first, second);
+    };
+
+    QCOMPARE(renderFrame(true), std::make_pair(true, true));
+    QCOMPARE(renderFrame(false), std::make_pair(true, false));
+    QCOMPARE(renderFrame(false), std::make_pair(false, false));
+
+    caster.moveTo(QVector3D(0, 3, 0));
+    QCOMPARE(renderFrame(true), std::make_pair(true, true));
+    QCOMPARE(renderFrame(false), std::make_pair(true, false));
+    QCOMPARE(renderFrame(false), std::make_pair(false, false));
+
+    ++caster.material.updateSerial;
+    QCOMPARE(renderFrame(false), std::make_pair(true, true));
+    QCOMPARE(renderFrame(false), std::make_pair(false, false));
+}
+
+QTEST_APPLESS_MAIN(tst_QSSGShadowCasters)
+#include "tst_shadowcasters.moc"
@@ -0,0 +1,332 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include <QtTest>
+
+#include <QtQuick3DRuntimeRender/private/qssgrenderspatialindex_p.h>
+#include <QtQuick3DRuntimeRender/private/qssglayerrenderdata_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrendermodel_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrendermesh_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrenderclippingfrustum_p.h>
+
+#include <QtCore/qrandom.h>
+#include <QtCore/qset.h>
+
+#include <memory>
+
+using Visibility = QSSGRenderSpatialIndex::Visibility;
+
+class tst_QSSGRenderSpatialIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_insert();
+    void test_refit();
+    void test_refitRandom();
+    void test_meshChange();
+    void test_remove();
+    void test_clear();
+};
+
+// A model with a mesh made of a single subset with the given (local) bounds
+struct Model
+{
+    explicit Model(const QVector3D &position, const QSSGBounds3 &bounds = QSSGBounds3(QVector3D(-1, -1, -1), QVector3D(1, 1, 1)))
+        : mesh(QSSGRenderDrawMode::Triangles, QSSGRenderWinding::CounterClockwise)
+    {
+        static quint32 generationId = 0;
+        mesh.generationId = ++generationId;
+        QSSGRenderSubset subset;
+        subset.count = 36;
+        subset.offset = 0;
+        subset.bounds = bounds;
+        mesh.subsets.append(subset);
+        moveTo(position);
+    }
+
+    void moveTo(const QVector3D &position)
+    {
+        model.globalTransform = QMatrix4x4();
+        model.globalTransform.translate(position);
+    }
+
+    QSSGRenderModel model;
+    QSSGRenderMesh mesh;
+};
+
+using Models = std::vector<std::unique_ptr<Model>>;
+
+static QSSGRenderableNodeEntry entryFor(Model &model, bool globalValuesDirty)
+{
+    QSSGRenderableNodeEntry entry(model.model, globalValuesDirty);
+    entry.mesh = &model.mesh;
+    return entry;
+}
+
+static QVector<QSSGRenderableNodeEntry> entriesFor(Models &models, bool globalValuesDirty)
+{
+    QVector<QSSGRenderableNodeEntry> entries;
+    for (auto &model : models)
+        entries.append(entryFor(*model, globalValuesDirty));
+    return entries;
+}
+
+// Looking down -z from (0, 0, 50), seeing x and y in [-20, 20] and z in [-50, 49]
+static QSSGClippingFrustum testFrustum()
+{
+    QMatrix4x4 viewProjection;
+    viewProjection.ortho(-20, 20, -20, 20, 1, 100);
+    viewProjection.translate(0, 0, -50);
+    QSSGClipPlane nearPlane;
+    nearPlane.normal = QVector3D(0, 0, -1);
+    nearPlane.d = 49;
+    return QSSGClippingFrustum(viewProjection, nearPlane);
+}
+
+static Visibility expectedVisibility(const QSSGClippingFrustum &frustum, const QSSGBounds3 &bounds)
+{
+    Visibility visibility = Visibility::Inside;
+    for (const QSSGClipPlane &plane : frustum.mPlanes) {
+        const int result = plane.intersect(bounds);
+        if (result < 0)
+            return Visibility::Outside;
+        if (result == 0)
+            visibility = Visibility::Intersecting;
+    }
+    return visibility;
+}
+
+static QVector<Visibility> classify(const QSSGRenderSpatialIndex &index, const QVector<QSSGRenderableNodeEntry> &entries)
+{
+    QVector<Visibility> leafVisibility;
+    index.classify(testFrustum(), leafVisibility);
+    QVector<Visibility> visibility;
+    for (const QSSGRenderableNodeEntry &entry : entries)
+        visibility.append(leafVisibility.value(entry.spatialIndexLeaf, Visibility::Intersecting));
+    return visibility;
+}
+
+// Every entry must have a leaf of its own, classified the same as testing its bounds directly
+static bool matchesFrustum(const QSSGRenderSpatialIndex &index, const QVector<QSSGRenderableNodeEntry> &entries)
+{
+    const QSSGClippingFrustum frustum = testFrustum();
+    QVector<Visibility> leafVisibility;
+    index.classify(frustum, leafVisibility);
+    if (leafVisibility.size() != index.leafCount() || index.leafCount() != entries.size())
+        return false;
+
+    QSet<qint32> leaves;
+    for (const QSSGRenderableNodeEntry &entry : entries) {
+        const qint32 leaf = entry.spatialIndexLeaf;
+        if (leaf < 0 || leaf >= index.leafCount() || leaves.contains(leaf))
+            return false;
+        leaves.insert(leaf);
+        QSSGBounds3 bounds = entry.mesh->subsets.first().bounds;
+        bounds.transform(entry.node->globalTransform);
+        const Visibility expected = expectedVisibility(frustum, bounds);
+        if (leafVisibility.at(leaf) != expected) {
+            qWarning() << "Leaf" << leaf << "at" << bounds.center() << "is" << int(leafVisibility.at(leaf))
+                       << "instead of" << int(expected);
+            return false;
+        }
+    }
+    return true;
+}
+
+void tst_QSSGRenderSpatialIndex::test_insert()
+{
+    Models models;
+    models.push_back(std::make_unique<Model>(QVector3D(0, 0, 0)));
+    models.push_back(std::make_unique<Model>(QVector3D(100, 0, 0)));
+    models.push_back(std::make_unique<Model>(QVector3D(20, 0, 0)));
+    models.push_back(std::make_unique<Model>(QVector3D(0, 0, -60)));
+    models.push_back(std::make_unique<Model>(QVector3D(-10, 10, 10)));
+
+    QSSGRenderSpatialIndex index;
+    QVector<QSSGRenderableNodeEntry> entries = entriesFor(models, true);
+    index.update(entries);
+    QCOMPARE(index.leafCount(), qsizetype(5));
+    QVERIFY(matchesFrustum(index, entries));
+    QCOMPARE(classify(index, entries),
+             QVector<Visibility>({ Visibility::Inside, Visibility::Outside, Visibility::Intersecting,
+                                   Visibility::Outside, Visibility::Inside }));
+
+    // Another model, and one without a mesh
+    models.push_back(std::make_unique<Model>(QVector3D(0, -30, 0)));
+    QSSGRenderModel withoutMesh;
+    entries = entriesFor(models, false);
+    entries.last().globalValuesDirty = true;
+    entries.insert(2, QSSGRenderableNodeEntry(withoutMesh, true));
+    index.update(entries);
+    QCOMPARE(index.leafCount(), qsizetype(6));
+    QCOMPARE(entries.at(2).spatialIndexLeaf, -1);
+    entries.removeAt(2);
+    QVERIFY(matchesFrustum(index, entries));
+
+    // Skinned models are never rejected, wherever their mesh bounds are
+    Model skinned(QVector3D(0, 0, 1000));
+    skinned.model.boneCount = 1;
+    entries.append(entryFor(skinned, true));
+    index.update(entries);
+    QCOMPARE(classify(index, entries).last(), Visibility::Intersecting);
+}
+
+void tst_QSSGRenderSpatialIndex::test_refit()
+{
+    Models models;
+    for (int idx = 0; idx < 8; ++idx)
+        models.push_back(std::make_unique<Model>(QVector3D(-35 + 10 * idx, 0, 0)));
+
+    QSSGRenderSpatialIndex index;
+    QVector<QSSGRenderableNodeEntry> entries = entriesFor(models, true);
+    index.update(entries);
+    QVERIFY(matchesFrustum(index, entries));
+    QVector<qint32> leaves;
+    for (const QSSGRenderableNodeEntry &entry : std::as_const(entries))
+        leaves.append(entry.spatialIndexLeaf);
+
+    // The same models keep their leaves, the moved ones get new bounds
+    models[0]->moveTo(QVector3D(0, 5, 0));
+    models[4]->moveTo(QVector3D(0, 0, 200));
+    entries = entriesFor(models, false);
+    entries[0].globalValuesDirty = true;
+    entries[4].globalValuesDirty = true;
+    index.update(entries);
+    QVERIFY(matchesFrustum(index, entries));
+    for (qsizetype idx = 0; idx < entries.size(); ++idx)
+        QCOMPARE(entries.at(idx).spatialIndexLeaf, leaves.at(idx));
+    QCOMPARE(classify(index, entries).at(0), Visibility::Inside);
+    QCOMPARE(classify(index, entries).at(4), Visibility::Outside);
+
+    // Nothing changed
+    entries = entriesFor(models, false);
+    index.update(entries);
+    QVERIFY(matchesFrustum(index, entries));
+}
+
+void tst_QSSGRenderSpatialIndex::test_refitRandom()
+{
+    // Enough moves to go through refits as well as rebuilds
+    QRandomGenerator rng(1234);
+    const auto randomPosition = [&rng]() {
+        return QVector3D(80.0f * float(rng.generateDouble()) - 40.0f,
+                         80.0f * float(rng.generateDouble()) - 40.0f,
+                         160.0f * float(rng.generateDouble()) - 80.0f);
+    };
+
+    Models models;
+    for (int idx = 0; idx < 100; ++idx)
+        models.push_back(std::make_unique<Model>(randomPosition()));
+    QSSGRenderSpatialIndex index;
+    QVector<QSSGRenderableNodeEntry> entries = entriesFor(models, true);
+    index.update(entries);
+    QVERIFY(matchesFrustum(index, entries));
+
+    for (int round = 0; round < 100; ++round) {
+        entries = entriesFor(models, false);
+        for (int move = 0; move < 5; ++move) {
+            const int idx = rng.bounded(100);
+            models[idx]->moveTo(randomPosition());
+            entries[idx].globalValuesDirty = true;
+        }
+        index.update(entries);
+        QVERIFY(matchesFrustum(index, entries));
+    }
+}
+
+void tst_QSSGRenderSpatialIndex::test_meshChange()
+{
+    Models models;
+    models.push_back(std::make_unique<Model>(QVector3D(0, 0, 0)));
+    models.push_back(std::make_unique<Model>(QVector3D(10, 0, 0)));
+
+    QSSGRenderSpatialIndex index;
+    QVector<QSSGRenderableNodeEntry> entries = entriesFor(models, true);
+    index.update(entries);
+    QCOMPARE(classify(index, entries).at(1), Visibility::Inside);
+
+    // A new mesh at the address of the released one, for a model that didn't move
+    models[1]->mesh.subsets.first().bounds = QSSGBounds3(QVector3D(-1, -1, -1), QVector3D(20, 1, 1));
+    models[1]->mesh.generationId += 1000;
+    entries = entriesFor(models, false);
+    index.update(entries);
+    QVERIFY(matchesFrustum(index, entries));
+    QCOMPARE(classify(index, entries).at(1), Visibility::Intersecting);
+
+    // The same when the models are added or removed in the same frame
+    models[1]->mesh.subsets.first().bounds = QSSGBounds3(QVector3D(-1, -1, -1), QVector3D(1, 1, 1));
+    models[1]->mesh.generationId += 1000;
+    models.push_back(std::make_unique<Model>(QVector3D(0, 10, 0)));
+    entries = entriesFor(models, false);
+    entries[2].globalValuesDirty = true;
+    index.update(entries);
+    QVERIFY(matchesFrustum(index, entries));
+    QCOMPARE(classify(index, entries).at(1), Visibility::Inside);
+}
+
+void tst_QSSGRenderSpatialIndex::test_remove()
+{
+    Models models;
+    for (int idx = 0; idx < 10; ++idx)
+        models.push_back(std::make_unique<Model>(QVector3D(-45 + 10 * idx, 0, 0)));
+
+    QSSGRenderSpatialIndex index;
+    QVector<QSSGRenderableNodeEntry> entries = entriesFor(models, true);
+    index.update(entries);
+    QVERIFY(matchesFrustum(index, entries));
+
+    // The leaves of the models left are compacted
+    models.erase(models.begin() + 7);
+    models.erase(models.begin() + 2);
+    models.erase(models.begin());
+    entries = entriesFor(models, false);
+    index.update(entries);
+    QCOMPARE(index.leafCount(), qsizetype(7));
+    QVERIFY(matchesFrustum(index, entries));
+
+    // The removed models don't show up among the visible ones
+    const QVector<Visibility> visibility = classify(index, entries);
+    QCOMPARE(visibility.count(Visibility::Outside), 3);
+    QCOMPARE(visibility.count(Visibility::Inside), 4);
+
+    // Removing and moving in the same frame
+    models.erase(models.begin() + 3);
+    models[0]->moveTo(QVector3D(0, 0, 0));
+    entries = entriesFor(models, false);
+    entries[0].globalValuesDirty = true;
+    index.update(entries);
+    QCOMPARE(index.leafCount(), qsizetype(6));
+    QVERIFY(matchesFrustum(index, entries));
+
+    // Down to nothing
+    entries.clear();
+    index.update(entries);
+    QCOMPARE(index.leafCount(), qsizetype(0));
+    QVector<Visibility> leafVisibility;
+    index.classify(testFrustum(), leafVisibility);
+    QVERIFY(leafVisibility.isEmpty());
+}
+
+void tst_QSSGRenderSpatialIndex::test_clear()
+{
+    Models models;
+    models.push_back(std::make_unique<Model>(QVector3D(0, 0, 0)));
+    models.push_back(std::make_unique<Model>(QVector3D(100, 0, 0)));
+
+    QSSGRenderSpatialIndex index;
+    QVector<QSSGRenderableNodeEntry> entries = entriesFor(models, true);
+    index.update(entries);
+    index.clear();
+    QCOMPARE(index.leafCount(), qsizetype(0));
+
+    // Everything is picked up again, even without dirty flags
+    models[1]->moveTo(QVector3D(5, 0, 0));
+    entries = entriesFor(models, false);
+    index.update(entries);
+    QVERIFY(matchesFrustum(index, entries));
+    QCOMPARE(classify(index, entries).at(1), Visibility::Inside);
+}
+
+QTEST_APPLESS_MAIN(tst_QSSGRenderSpatialIndex)
+#include "tst_spatialindex.moc"
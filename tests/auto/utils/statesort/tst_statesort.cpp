@@ -0,0 +1,126 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include <QtTest>
+
+#include <QtQuick3DRuntimeRender/private/qssglayerrenderdata_p.h>
+
+#include <QtCore/qrandom.h>
+
+#include <numeric>
+
+using SortMode = QSSGLayerRenderData::OpaqueSortMode;
+
+class tst_QSSGStateSort : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_stateKeyOrdering();
+    void test_coarseDistanceSlices();
+    void test_sortedKeyOrder();
+    void test_sortedKeyOrderStable();
+};
+
+void tst_QSSGStateSort::test_stateKeyOrdering()
+{
+    for (const SortMode mode : { SortMode::State, SortMode::CoarseDistanceThenState }) {
+        // Within the same distance, the pipeline is the most significant, then the material, then the mesh
+        QVERIFY(QSSGLayerRenderData::stateSortKey(0, 5, 5, 0.5f, mode) < QSSGLayerRenderData::stateSortKey(1, 0, 0, 0.5f, mode));
+        QVERIFY(QSSGLayerRenderData::stateSortKey(1, 0, 5, 0.5f, mode) < QSSGLayerRenderData::stateSortKey(1, 1, 0, 0.5f, mode));
+        QVERIFY(QSSGLayerRenderData::stateSortKey(1, 1, 0, 0.5f, mode) < QSSGLayerRenderData::stateSortKey(1, 1, 1, 0.5f, mode));
+
+        // The largest ids must not spill into the neighbouring fields
+        const quint64 maxPipeline = (1u << 14) - 1;
+        const quint64 maxMaterial = (1u << 14) - 1;
+        const quint64 maxMesh = (1u << 16) - 1;
+        QVERIFY(QSSGLayerRenderData::stateSortKey(0, maxMaterial, maxMesh, 0.5f, mode) < QSSGLayerRenderData::stateSortKey(1, 0, 0, 0.5f, mode));
+        QVERIFY(QSSGLayerRenderData::stateSortKey(0, 0, maxMesh, 0.5f, mode) < QSSGLayerRenderData::stateSortKey(0, 1, 0, 0.5f, mode));
+        QVERIFY(QSSGLayerRenderData::stateSortKey(maxPipeline, maxMaterial, maxMesh, 0.5f, mode) > QSSGLayerRenderData::stateSortKey(maxPipeline, maxMaterial, maxMesh - 1, 0.5f, mode));
+
+        // Same state, nearer first
+        QVERIFY(QSSGLayerRenderData::stateSortKey(3, 2, 1, 0.25f, mode) < QSSGLayerRenderData::stateSortKey(3, 2, 1, 0.26f, mode));
+        QVERIFY(QSSGLayerRenderData::stateSortKey(3, 2, 1, 0.0f, mode) < QSSGLayerRenderData::stateSortKey(3, 2, 1, 1.0f, mode));
+    }
+
+    // Without slices the state wins over the distance, and the farthest distance doesn't spill into the mesh id
+    QVERIFY(QSSGLayerRenderData::stateSortKey(0, 0, 1, 1.0f, SortMode::State) < QSSGLayerRenderData::stateSortKey(0, 1, 0, 0.0f, SortMode::State));
+    QVERIFY(QSSGLayerRenderData::stateSortKey(0, 0, 0, 1.0f, SortMode::State) < QSSGLayerRenderData::stateSortKey(0, 0, 1, 0.0f, SortMode::State));
+    QVERIFY(QSSGLayerRenderData::stateSortKey(0, 0, 0, 1.0f, SortMode::CoarseDistanceThenState) < QSSGLayerRenderData::stateSortKey(0, 0, 1, 0.95f, SortMode::CoarseDistanceThenState));
+}
+
+void tst_QSSGStateSort::test_coarseDistanceSlices()
+{
+    const auto slice = [](float normalizedDistance) {
+        return uint(QSSGLayerRenderData::stateSortKey(0, 0, 0, normalizedDistance, SortMode::CoarseDistanceThenState) >> 60);
+    };
+
+    // 16 slices of equal size, with the far end in the last one
+    QCOMPARE(slice(0.0f), 0u);
+    QCOMPARE(slice(0.0624f), 0u);
+    QCOMPARE(slice(0.0626f), 1u);
+    QCOMPARE(slice(0.49f), 7u);
+    QCOMPARE(slice(0.51f), 8u);
+    QCOMPARE(slice(0.9374f), 14u);
+    QCOMPARE(slice(0.9376f), 15u);
+    QCOMPARE(slice(1.0f), 15u);
+
+    // The distance slice is more significant than the state
+    QVERIFY(QSSGLayerRenderData::stateSortKey(100, 100, 100, 0.1f, SortMode::CoarseDistanceThenState)
+            < QSSGLayerRenderData::stateSortKey(0, 0, 0, 0.2f, SortMode::CoarseDistanceThenState));
+    // ... but within a slice the state comes first
+    QVERIFY(QSSGLayerRenderData::stateSortKey(0, 0, 0, 0.12f, SortMode::CoarseDistanceThenState)
+            < QSSGLayerRenderData::stateSortKey(1, 0, 0, 0.07f, SortMode::CoarseDistanceThenState));
+}
+
+void tst_QSSGStateSort::test_sortedKeyOrder()
+{
+    QVERIFY(QSSGLayerRenderData::sortedKeyOrder({}).isEmpty());
+    QCOMPARE(QSSGLayerRenderData::sortedKeyOrder({ 42 }), QVector<quint32>({ 0 }));
+
+    // Keys that differ in every byte, so that no pass is skipped
+    QRandomGenerator rng(1234);
+    QVector<quint64> keys(1000);
+    for (quint64 &key : keys)
+        key = rng.generate64();
+    keys[10] = 0;
+    keys[20] = std::numeric_limits<quint64>::max();
+
+    const QVector<quint32> order = QSSGLayerRenderData::sortedKeyOrder(keys);
+    QCOMPARE(order.size(), keys.size());
+    QCOMPARE(order.first(), 10u);
+    QCOMPARE(order.last(), 20u);
+    for (qsizetype idx = 1; idx < order.size(); ++idx)
+        QVERIFY(keys.at(order.at(idx - 1)) <= keys.at(order.at(idx)));
+
+    QVector<quint32> sortedIndices = order;
+    std::sort(sortedIndices.begin(), sortedIndices.end());
+    for (qsizetype idx = 0; idx < sortedIndices.size(); ++idx)
+        QCOMPARE(sortedIndices.at(idx), quint32(idx));
+}
+
+void tst_QSSGStateSort::test_sortedKeyOrderStable()
+{
+    // Few distinct keys spread over different bytes, with many duplicates of each
+    QRandomGenerator rng(5678);
+    const quint64 distinctKeys[] = { 0, 0xff, 0x100, 0xff00000000ull, 0x1000000000000000ull, 0x10000000000000ffull };
+    QVector<quint64> keys(2000);
+    for (quint64 &key : keys)
+        key = distinctKeys[rng.bounded(int(std::size(distinctKeys)))];
+
+    QVector<quint32> expected(keys.size());
+    std::iota(expected.begin(), expected.end(), 0u);
+    std::stable_sort(expected.begin(), expected.end(), [&keys](quint32 lhs, quint32 rhs) {
+        return keys.at(lhs) < keys.at(rhs);
+    });
+    QCOMPARE(QSSGLayerRenderData::sortedKeyOrder(keys), expected);
+
+    // All keys equal: every pass is skipped and the order is kept
+    const QVector<quint64> sameKeys(100, 0x1234567890abcdefull);
+    QVector<quint32> identity(sameKeys.size());
+    std::iota(identity.begin(), identity.end(), 0u);
+    QCOMPARE(QSSGLayerRenderData::sortedKeyOrder(sameKeys), identity);
+}
+
+QTEST_APPLESS_MAIN(tst_QSSGStateSort)
+#include "tst_statesort.moc"
@@ -0,0 +1,277 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include <QtTest>
+
+#include <QtQuick3DRuntimeRender/private/qssgrhicontext_p.h>
+
+class tst_QSSGRhiUniformBufferRing : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+
+    void test_alignment();
+    void test_rollover();
+    void test_flush();
+    void test_oversizedAllocation();
+    void test_beginFrameReusesBuffers();
+    void test_releasesSrbs();
+    void test_sharedSrbsAreReleasedWithTheirLastDrawCall();
+
+private:
+    quint32 bufferSize() const;
+
+    QRhi *rhi = nullptr;
+    QSSGRhiContext *context = nullptr;
+};
+
+void tst_QSSGRhiUniformBufferRing::initTestCase()
+{
+    rhi = QRhi::create(QRhi::Null, nullptr);
+    QVERIFY(rhi);
+    context = new QSSGRhiContext;
+    context->initialize(rhi);
+}
+
+void tst_QSSGRhiUniformBufferRing::cleanupTestCase()
+{
+    delete context;
+    delete rhi;
+}
+
+void tst_QSSGRhiUniformBufferRing::init()
+{
+    QRhiCommandBuffer *cb = nullptr;
+    QCOMPARE(rhi->beginOffscreenFrame(&cb), QRhi::FrameOpSuccess);
+    context->setCommandBuffer(cb);
+}
+
+void tst_QSSGRhiUniformBufferRing::cleanup()
+{
+    rhi->endOffscreenFrame();
+    context->setCommandBuffer(nullptr);
+}
+
+// Same as what the ring picks on its first allocation
+quint32 tst_QSSGRhiUniformBufferRing::bufferSize() const
+{
+    return quint32(qBound(64 * 1024, context->maxUniformBufferRange(), 1024 * 1024));
+}
+
+void tst_QSSGRhiUniformBufferRing::test_alignment()
+{
+    QSSGRhiUniformBufferRing ring(*context);
+    ring.beginFrame();
+
+    const QSSGRhiUniformBufferRing::Allocation first = ring.allocate(100);
+    QVERIFY(first.isValid());
+    QCOMPARE(first.offset, 0u);
+    QVERIFY(first.data);
+
+    const QSSGRhiUniformBufferRing::Allocation second = ring.allocate(4);
+    QVERIFY(second.isValid());
+    QCOMPARE(second.buffer, first.buffer);
+    QCOMPARE(second.offset, quint32(rhi->ubufAligned(100)));
+    QCOMPARE(second.offset % quint32(rhi->ubufAlignment()), 0u);
+    QCOMPARE(second.data, first.data + second.offset);
+
+    const QSSGRhiUniformBufferRing::Allocation third = ring.allocate(1);
+    QCOMPARE(third.buffer, first.buffer);
+    QCOMPARE(third.offset, second.offset + quint32(rhi->ubufAligned(4)));
+    QCOMPARE(ring.bufferCount(), 1);
+
+    ring.endFrame();
+}
+
+void tst_QSSGRhiUniformBufferRing::test_rollover()
+{
+    QSSGRhiUniformBufferRing ring(*context);
+    ring.beginFrame();
+
+    const quint32 size = quint32(rhi->ubufAlignment()) * 4;
+    const quint32 perBuffer = bufferSize() / size;
+
+    const QSSGRhiUniformBufferRing::Allocation first = ring.allocate(size);
+    QVERIFY(first.isValid());
+    QSSGRhiUniformBufferRing::Allocation last = first;
+    for (quint32 i = 1; i < perBuffer; ++i) {
+        last = ring.allocate(size);
+        QVERIFY(last.isValid());
+        QCOMPARE(last.buffer, first.buffer);
+    }
+    QCOMPARE(last.offset + size, perBuffer * size);
+    QCOMPARE(ring.bufferCount(), 1);
+
+    // The next one doesn't fit, and starts a new buffer
+    const QSSGRhiUniformBufferRing::Allocation next = ring.allocate(size);
+    QVERIFY(next.isValid());
+    QVERIFY(next.buffer != first.buffer);
+    QCOMPARE(next.offset, 0u);
+    QCOMPARE(ring.bufferCount(), 2);
+
+    // A range may end exactly at the end of the buffer
+    const QSSGRhiUniformBufferRing::Allocation rest = ring.allocate(bufferSize() - quint32(rhi->ubufAligned(int(size))));
+    QVERIFY(rest.isValid());
+    QCOMPARE(rest.buffer, next.buffer);
+    QCOMPARE(ring.bufferCount(), 2);
+
+    ring.endFrame();
+}
+
+void tst_QSSGRhiUniformBufferRing::test_flush()
+{
+    QSSGRhiUniformBufferRing ring(*context);
+    ring.beginFrame();
+
+    const QSSGRhiUniformBufferRing::Allocation before = ring.allocate(64);
+    QVERIFY(before.isValid());
+    ring.flush();
+
+    // Mapping the buffer again would discard what was written before the flush
+    const QSSGRhiUniformBufferRing::Allocation after = ring.allocate(64);
+    QVERIFY(after.isValid());
+    QVERIFY(after.buffer != before.buffer);
+    QCOMPARE(after.offset, 0u);
+    QCOMPARE(ring.bufferCount(), 2);
+
+    // Flushing without allocations in between doesn't waste a buffer
+    ring.flush();
+    ring.flush();
+    const QSSGRhiUniformBufferRing::Allocation again = ring.allocate(64);
+    QVERIFY(again.isValid());
+    QVERIFY(again.buffer != after.buffer);
+    QCOMPARE(ring.bufferCount(), 3);
+
+    ring.endFrame();
+}
+
+void tst_QSSGRhiUniformBufferRing::test_oversizedAllocation()
+{
+    QSSGRhiUniformBufferRing ring(*context);
+    ring.beginFrame();
+
+    // Too large for one buffer: the caller falls back to a buffer of its own
+    QVERIFY(!ring.allocate(bufferSize() + 1).isValid());
+    QVERIFY(!ring.allocate(0).isValid());
+    QCOMPARE(ring.bufferCount(), 0);
+
+    // The largest allocation that fits takes a whole buffer
+    const QSSGRhiUniformBufferRing::Allocation whole = ring.allocate(bufferSize());
+    QVERIFY(whole.isValid());
+    QCOMPARE(whole.offset, 0u);
+    const QSSGRhiUniformBufferRing::Allocation next = ring.allocate(16);
+    QVERIFY(next.isValid());
+    QVERIFY(next.buffer != whole.buffer);
+
+    ring.endFrame();
+}
+
+void tst_QSSGRhiUniformBufferRing::test_beginFrameReusesBuffers()
+{
+    QSSGRhiUniformBufferRing ring(*context);
+    ring.beginFrame();
+    const QSSGRhiUniformBufferRing::Allocation first = ring.allocate(bufferSize());
+    const QSSGRhiUniformBufferRing::Allocation second = ring.allocate(bufferSize());
+    QVERIFY(first.isValid() && second.isValid());
+    QCOMPARE(ring.bufferCount(), 2);
+    ring.endFrame();
+
+    // The next frame starts over with the first buffer
+    ring.beginFrame();
+    const QSSGRhiUniformBufferRing::Allocation reused = ring.allocate(16);
+    QCOMPARE(reused.buffer, first.buffer);
+    QCOMPARE(reused.offset, 0u);
+    QCOMPARE(ring.allocate(bufferSize()).buffer, second.buffer);
+    QCOMPARE(ring.bufferCount(), 2);
+    ring.endFrame();
+}
+
+void tst_QSSGRhiUniformBufferRing::test_releasesSrbs()
+{
+    QScopedPointer<QRhiBuffer> otherBuffer(rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 256));
+    QVERIFY(otherBuffer->create());
+    QSSGRhiShaderResourceBindingList otherBindings;
+    otherBindings.addUniformBuffer(0, QRhiShaderResourceBinding::VertexStage, otherBuffer.data(), 0, 256);
+    QRhiShaderResourceBindings *otherSrb = context->srb(otherBindings);
+    QVERIFY(otherSrb);
+
+    {
+        QSSGRhiUniformBufferRing ring(*context);
+        ring.beginFrame();
+        const QSSGRhiUniformBufferRing::Allocation alloc = ring.allocate(64);
+        QVERIFY(alloc.isValid());
+        ring.endFrame();
+
+        QSSGRhiShaderResourceBindingList bindings;
+        bindings.addUniformBufferWithDynamicOffset(0, QRhiShaderResourceBinding::VertexStage, alloc.buffer, 64);
+        QRhiShaderResourceBindings *srb = context->srb(bindings);
+        QVERIFY(srb);
+        QCOMPARE(context->srb(bindings), srb);
+    }
+
+    // Only the srbs using the ring's buffers are released
+    QCOMPARE(context->srb(otherBindings), otherSrb);
+}
+
+void tst_QSSGRhiUniformBufferRing::test_sharedSrbsAreReleasedWithTheirLastDrawCall()
+{
+    QSSGRhiUniformBufferRing ring(*context);
+    ring.beginFrame();
+    const QSSGRhiUniformBufferRing::Allocation alloc = ring.allocate(64);
+    QVERIFY(alloc.isValid());
+    ring.endFrame();
+
+    QScopedPointer<QRhiTexture> texture1(rhi->newTexture(QRhiTexture::RGBA8, QSize(4, 4)));
+    QScopedPointer<QRhiTexture> texture2(rhi->newTexture(QRhiTexture::RGBA8, QSize(4, 4)));
+    QVERIFY(texture1->create() && texture2->create());
+    QScopedPointer<QRhiSampler> sampler(rhi->newSampler(QRhiSampler::Linear, QRhiSampler::Linear, QRhiSampler::None,
+                                                        QRhiSampler::ClampToEdge, QRhiSampler::ClampToEdge));
+    QVERIFY(sampler->create());
+
+    const auto bindingsFor = [&](QRhiTexture *texture) {
+        QSSGRhiShaderResourceBindingList bindings;
+        bindings.addUniformBufferWithDynamicOffset(0, QRhiShaderResourceBinding::VertexStage, alloc.buffer, 64);
+        bindings.addTexture(1, QRhiShaderResourceBinding::FragmentStage, texture, sampler.data());
+        return bindings;
+    };
+    const QSSGRhiShaderResourceBindingList bindings1 = bindingsFor(texture1.data());
+    const QSSGRhiShaderResourceBindingList bindings2 = bindingsFor(texture2.data());
+
+    // Draw calls with the same textures share the srb
+    QSSGRhiDrawCallData dcd1;
+    QSSGRhiDrawCallData dcd2;
+    context->updateDrawCallSrb(dcd1, bindings1);
+    context->updateDrawCallSrb(dcd2, bindings1);
+    QRhiShaderResourceBindings *srb1 = dcd1.srb;
+    QVERIFY(srb1);
+    QCOMPARE(dcd2.srb, srb1);
+
+    // It stays while one of them still uses it
+    context->updateDrawCallSrb(dcd1, bindings2);
+    QRhiShaderResourceBindings *srb2 = dcd1.srb;
+    QVERIFY(srb2 && srb2 != srb1);
+    QCOMPARE(context->srb(bindings1), srb1);
+
+    // Updating to the same bindings again keeps it
+    context->updateDrawCallSrb(dcd2, bindings1);
+    QCOMPARE(context->srb(bindings1), srb1);
+
+    // The last one moving on releases it, the srbs are deleted later, so the
+    // pointers can't be reused for new ones during this frame
+    context->updateDrawCallSrb(dcd2, bindings2);
+    QCOMPARE(dcd2.srb, srb2);
+    QVERIFY(context->srb(bindings1) != srb1);
+
+    context->releaseDrawCallData(dcd1);
+    QCOMPARE(context->srb(bindings2), srb2);
+    context->releaseDrawCallData(dcd2);
+    QVERIFY(context->srb(bindings2) != srb2);
+}
+
+QTEST_MAIN(tst_QSSGRhiUniformBufferRing)
+#include "tst_uniformbufferring.moc"
@@ -24,6 +24,8 @@ private slots:
     void test_frustumCulling();
     void bench_outputlist();
     void bench_inline();
+    void bench_soa_data();
+    void bench_soa();
 
 private:
     struct ObjectData
@@ -224,6 +226,98 @@ void BenchFrustumCulling::bench_inline()
     QCOMPARE(ret, nonCulledItemCount);
 }
 
+void BenchFrustumCulling::bench_soa_data()
+{
+    QTest::addColumn<quint32>("objectCount");
+    QTest::addColumn<bool>("useSoA");
+
+    QTest::newRow("10k - list") << 10000u << false;
+    QTest::newRow("10k - soa") << 10000u << true;
+    QTest::newRow("100k - list") << 100000u << false;
+    QTest::newRow("100k - soa") << 100000u << true;
+}
+
+void BenchFrustumCulling::bench_soa()
+{
+    QFETCH(quint32, objectCount);
+    QFETCH(bool, useSoA);
+
+    // bounds 10x10x10 all in world coordinates
+    constexpr float widthAndHeight = 10.0f;
+    constexpr QSSGBounds3 bounds { { -widthAndHeight / 2.0f, -widthAndHeight / 2.0f, -widthAndHeight / 2.0f }, { widthAndHeight / 2.0f, widthAndHeight / 2.0f, widthAndHeight / 2.0f } };
+
+    // For simplicity we only do put "cullable" object in front or behind the frustum for now.
+    const float frustumNearBorder = camera.position().z() - camera.clipNear() + widthAndHeight;
+    const float frustumFarBorder = camera.position().z() - camera.clipFar() - widthAndHeight;
+
+    const quint32 nonCulledItemCount = 3;
+
+    QSet<quint32> replaceIndexes;
+    while (replaceIndexes.size() < nonCulledItemCount)
+        replaceIndexes.insert(QRandomGenerator::global()->bounded(objectCount));
+
+    QList<ObjectData> objects;
+    objects.reserve(objectCount);
+
+    // Fill the list with object data that should be culled
+    for (quint32 i = 0, end = objectCount; i != end; ++i) {
+        if (i % 2)
+            objects.push_back(createRenderableData({0.0f, 0.0f, frustumNearBorder }, QQuaternion::fromEulerAngles({}), bounds));
+        else
+            objects.push_back(createRenderableData({0.0f, 0.0f, frustumFarBorder }, QQuaternion::fromEulerAngles({}), bounds));
+    }
+
+    // Insert items at random positions in the list that should not be culled
+    for (auto v : std::as_const(replaceIndexes))
+        objects.replace(v, createRenderableData({0.0f, 0.0f, 0.0f}, QQuaternion::fromEulerAngles({}), bounds));
+
+    QCOMPARE(objects.size(), objectCount);
+
+    QList<QSSGRenderableObject> renderableObjects;
+
+    // List of renderables
+    populateRenderableList(objects, renderableObjects);
+
+    // Renderable object handle class...
+    QSSGRenderableObjectList renderables;
+    renderables.reserve(objects.size());
+
+    QSSGRenderableObjectList culledrenderables;
+    culledrenderables.reserve(objects.size());
+
+    // The packed bounds are recorded as the renderables are created, like in
+    // QSSGLayerRenderData::createRenderableHandle(), so they are not part of the measurement.
+    QSSGBoundsSoA renderableBounds;
+    for (auto &ro : renderableObjects) {
+        QSSGRenderableObjectHandle handle(&ro, 0.0f);
+        handle.boundsIndex = qint32(renderableBounds.size());
+        renderableBounds.append(ro.globalBounds);
+        renderables.push_back(handle);
+    }
+    QCOMPARE(renderableBounds.size(), renderables.size());
+
+    QVERIFY(!cameraNode->isDirty(QSSGRenderCamera::DirtyFlag::CameraDirty));
+
+    if (useSoA) {
+        QVector<quint32> visibilityMask;
+        QBENCHMARK {
+            culledrenderables.clear();
+            visibilityMask.resize(QSSGBoundsSoA::maskSize(renderableBounds.size()));
+            clipFrustum.intersectsWith(renderableBounds, visibilityMask.data());
+            QSSGLayerRenderData::frustumCulling(clipFrustum, visibilityMask, renderables, culledrenderables);
+        }
+    } else {
+        QBENCHMARK {
+            culledrenderables.clear();
+            QSSGLayerRenderData::frustumCulling(clipFrustum, renderables, culledrenderables);
+        }
+    }
+
+    QCOMPARE(culledrenderables.size(), nonCulledItemCount);
+    for (const auto &handle : std::as_const(culledrenderables))
+        QCOMPARE(handle.obj->globalBounds.center().z(), 0.0f);
+}
+
 QTEST_APPLESS_MAIN(BenchFrustumCulling)
 
 #include "tst_benchfrustumculling.moc"
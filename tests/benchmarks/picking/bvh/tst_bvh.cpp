@@ -0,0 +1,130 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#include <QtTest>
+
+#include <QtQuick3DRuntimeRender/private/qssgrenderray_p.h>
+#include <QtQuick3DUtils/private/qssgmeshbvh_p.h>
+#include <QtQuick3DUtils/private/qssgmeshbvhbuilder_p.h>
+
+#include <memory>
+
+class bvh : public QObject
+{
+    Q_OBJECT
+
+public:
+    bvh() = default;
+    ~bvh() = default;
+
+private slots:
+    void bench_build_data();
+    void bench_build();
+    void bench_rays_data();
+    void bench_rays();
+
+private:
+    static QSSGMeshBVHBuilder createGridBuilder(int size);
+};
+
+// A size x size grid of quads in the XY plane, centered at the origin, each quad 1 unit wide
+QSSGMeshBVHBuilder bvh::createGridBuilder(int size)
+{
+    const int vertexCount = (size + 1) * (size + 1);
+    QByteArray vertexBuffer(vertexCount * 3 * sizeof(float), Qt::Uninitialized);
+    float *v = reinterpret_cast<float *>(vertexBuffer.data());
+    for (int y = 0; y <= size; ++y) {
+        for (int x = 0; x <= size; ++x) {
+            *v++ = x - size * 0.5f;
+            *v++ = y - size * 0.5f;
+            *v++ = 0.0f;
+        }
+    }
+
+    QByteArray indexBuffer(size * size * 6 * sizeof(quint32), Qt::Uninitialized);
+    quint32 *i = reinterpret_cast<quint32 *>(indexBuffer.data());
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            const quint32 base = y * (size + 1) + x;
+            *i++ = base;
+            *i++ = base + 1;
+            *i++ = base + size + 1;
+            *i++ = base + 1;
+            *i++ = base + size + 2;
+            *i++ = base + size + 1;
+        }
+    }
+
+    return QSSGMeshBVHBuilder(vertexBuffer, 3 * sizeof(float), 0, false, -1, true, indexBuffer, QSSGRenderComponentType::UnsignedInt32);
+}
+
+void bvh::bench_build_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<bool>("threaded");
+
+    QTest::newRow("20k triangles") << 100 << true;
+    QTest::newRow("500k triangles") << 500 << true;
+    QTest::newRow("500k triangles, single thread") << 500 << false;
+}
+
+void bvh::bench_build()
+{
+    QFETCH(int, size);
+    QFETCH(bool, threaded);
+
+    QBENCHMARK {
+        auto builder = createGridBuilder(size);
+        if (!threaded)
+            builder.setParallelThreshold(0);
+        std::unique_ptr<QSSGMeshBVH> tree(builder.buildTree());
+        QVERIFY(tree);
+        QCOMPARE(tree->triangles.size(), qsizetype(size) * size * 2);
+    }
+}
+
+void bvh::bench_rays_data()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("20k triangles") << 100;
+    QTest::newRow("500k triangles") << 500;
+}
+
+void bvh::bench_rays()
+{
+    QFETCH(int, size);
+
+    auto builder = createGridBuilder(size);
+    std::unique_ptr<QSSGMeshBVH> tree(builder.buildTree());
+    QVERIFY(tree);
+    QCOMPARE(tree->roots.size(), 1);
+
+    // Rays straight down the z-axis, spread over the grid (but not through its vertices or edges)
+    constexpr int rayCount = 1000;
+    const QMatrix4x4 globalTransform;
+    QVector<QSSGRenderRay> rays;
+    rays.reserve(rayCount);
+    for (int i = 0; i < rayCount; ++i) {
+        const float x = (i % 37) / 37.0f * size - size * 0.5f + 0.25f;
+        const float y = (i % 41) / 41.0f * size - size * 0.5f + 0.3f;
+        rays.append(QSSGRenderRay({ x, y, 10.0f }, { 0.0f, 0.0f, -1.0f }));
+    }
+
+    QVector<QSSGRenderRay::IntersectionResult> results;
+    QSSGRenderRay::intersectWithBVH(QSSGRenderRay::createRayData(globalTransform, rays.first()),
+                                    tree.get(), tree->roots.first(), results);
+    QCOMPARE(results.size(), 1);
+
+    QBENCHMARK {
+        for (const auto &ray : std::as_const(rays)) {
+            results.clear();
+            const auto rayData = QSSGRenderRay::createRayData(globalTransform, ray);
+            QSSGRenderRay::intersectWithBVH(rayData, tree.get(), tree->roots.first(), results);
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(bvh)
+
+#include "tst_bvh.moc"
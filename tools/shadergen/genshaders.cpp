@@ -74,6 +74,18 @@ GenShaders::GenShaders()
 
 GenShaders::~GenShaders() = default;
 
+static bool ensureResourceFolder(const QDir &outDir, bool dryRun)
+{
+    const QString resourceFolderRelative = QSSGShaderCache::resourceFolder().mid(2);
+    if (!dryRun && !outDir.exists(resourceFolderRelative)) {
+        if (!outDir.mkpath(resourceFolderRelative)) {
+            qDebug("Unable to create folder: %s", qPrintable(outDir.path() + QDir::separator() + resourceFolderRelative));
+            return false;
+        }
+    }
+    return true;
+}
+
 bool GenShaders::process(const MaterialParser::SceneData &sceneData,
                          QVector<QString> &qsbcFiles,
                          const QDir &outDir,
@@ -83,12 +95,8 @@ bool GenShaders::process(const MaterialParser::SceneData &sceneData,
     Q_UNUSED(generateMultipleLights);
 
     const QString resourceFolderRelative = QSSGShaderCache::resourceFolder().mid(2);
-    if (!dryRun && !outDir.exists(resourceFolderRelative)) {
-        if (!outDir.mkpath(resourceFolderRelative)) {
-            qDebug("Unable to create folder: %s", qPrintable(outDir.path() + QDir::separator() + resourceFolderRelative));
-            return false;
-        }
-    }
+    if (!ensureResourceFolder(outDir, dryRun))
+        return false;
 
     const QString outputFolder = outDir.canonicalPath() + QDir::separator() + resourceFolderRelative;
 
@@ -353,3 +361,59 @@ bool GenShaders::process(const MaterialParser::SceneData &sceneData,
 
     return true;
 }
+
+bool GenShaders::processManifest(const QString &manifestFile,
+                                 QVector<QString> &qsbcFiles,
+                                 const QDir &outDir,
+                                 bool dryRun)
+{
+    QVector<QSSGShaderCache::ShaderManifestEntry> entries;
+    if (!QSSGShaderCache::readShaderManifest(manifestFile, entries))
+        return false;
+
+    const QString resourceFolderRelative = QSSGShaderCache::resourceFolder().mid(2);
+    if (!ensureResourceFolder(outDir, dryRun))
+        return false;
+
+    const QString outputFolder = outDir.canonicalPath() + QDir::separator() + resourceFolderRelative;
+    const QString outCollectionFile = outputFolder + QString::fromLatin1(QSSGShaderCache::shaderCollectionFile());
+    QQsbIODeviceCollection qsbc(outCollectionFile);
+    if (!dryRun && !qsbc.map(QQsbIODeviceCollection::Write))
+        return false;
+
+    // The manifest has the exact inputs the application passed to the shader cache,
+    // so the pipelines only need to be baked, there's no scene to generate them from.
+    const auto &shaderCache = renderContext->shaderCache();
+    QSet<QByteArray> bakedKeys;
+    for (const auto &entry : std::as_const(entries)) {
+        const auto qsbcFeatureList = QQsbCollection::toFeatureSet(entry.features);
+        const QByteArray qsbcKey = QQsbCollection::EntryDesc::generateSha(entry.key, qsbcFeatureList);
+        // The same pipeline is recorded again after releasing the cached resources, or in a later run
+        if (bakedKeys.contains(qsbcKey))
+            continue;
+        bakedKeys.insert(qsbcKey);
+
+        if (dryRun) {
+            qDryRunPrintQsbcAdd(entry.key);
+            continue;
+        }
+
+        const auto shaderPipeline = shaderCache->compileForRhi(entry.key,
+                                                               entry.vertexSource,
+                                                               entry.fragmentSource,
+                                                               entry.features,
+                                                               {});
+        const auto vertexStage = shaderPipeline ? shaderPipeline->vertexStage() : nullptr;
+        const auto fragmentStage = shaderPipeline ? shaderPipeline->fragmentStage() : nullptr;
+        if (vertexStage && fragmentStage)
+            qsbc.addEntry(qsbcKey, { entry.key, qsbcFeatureList, vertexStage->shader(), fragmentStage->shader() });
+        else
+            qWarning("Failed to bake shaders for %s", entry.key.constData());
+    }
+
+    if (!qsbc.availableEntries().isEmpty())
+        qsbcFiles.push_back(resourceFolderRelative + QDir::separator() + QString::fromLatin1(QSSGShaderCache::shaderCollectionFile()));
+    qsbc.unmap();
+
+    return true;
+}
@@ -25,6 +25,7 @@ struct GenShaders
     ~GenShaders();
     bool process(const MaterialParser::SceneData &sceneData, QVector<QString> &qsbcFiles, const QDir &outDir,
                  bool generateMultipleLights, bool dryRun);
+    bool processManifest(const QString &manifestFile, QVector<QString> &qsbcFiles, const QDir &outDir, bool dryRun);
 
     QRhi *rhi = nullptr;
     QSSGRef<QSSGRenderContextInterface> renderContext;
@@ -132,6 +132,11 @@ int main(int argc, char *argv[])
     QCommandLineOption extractQsbFileOption({QChar(u'e'), QLatin1String("extract-qsb")}, QLatin1String("Extract qsb from collection."), QLatin1String("key:[desc|vert|frag]"));
     cmdLineparser.addOption(extractQsbFileOption);
 
+    QCommandLineOption manifestOption({QChar(u'm'), QLatin1String("manifest")},
+                                      QLatin1String("Bake the shaders recorded by an application run with QT_QUICK3D_RECORD_SHADER_MANIFEST set, instead of generating them from QML files."),
+                                      QLatin1String("file"));
+    cmdLineparser.addOption(manifestOption);
+
     QCommandLineOption dirDepthOption(QLatin1String("depth"), QLatin1String("Override default max depth (16) value when traversing the filesystem."), QLatin1String("number"));
     cmdLineparser.addOption(dirDepthOption);
 
@@ -150,7 +155,8 @@ int main(int argc, char *argv[])
     QSet<QString> filePaths;
     auto args = cmdLineparser.positionalArguments();
 
-    const bool collectQmlFilesMode = !(cmdLineparser.isSet(dumpQsbcFileOption) || cmdLineparser.isSet(extractQsbFileOption));
+    const bool manifestMode = cmdLineparser.isSet(manifestOption);
+    const bool collectQmlFilesMode = !(cmdLineparser.isSet(dumpQsbcFileOption) || cmdLineparser.isSet(extractQsbFileOption) || manifestMode);
     if (collectQmlFilesMode) {
         if (args.isEmpty())
             args.push_back(QDir::currentPath());
@@ -169,7 +175,7 @@ int main(int argc, char *argv[])
         filePaths.insert(args.first());
     }
 
-    if (filePaths.isEmpty()) {
+    if (filePaths.isEmpty() && !manifestMode) {
         qWarning("No input file(s) found!");
         a.exit(-1);
         return -1;
@@ -262,8 +268,13 @@ int main(int argc, char *argv[])
     QVector<QString> qsbcFiles;
 
     int ret = 0;
-    if (filePaths.size())
+    if (manifestMode) {
+        GenShaders genShaders;
+        if (!genShaders.processManifest(cmdLineparser.value(manifestOption), qsbcFiles, outDir, dryRun))
+            ret = -1;
+    } else if (filePaths.size()) {
         ret = generateShaders(qsbcFiles, filePaths.values(), QDir::currentPath(), outDir, multilight, verboseOutput, dryRun);
+    }
 
     if (ret == 0 && !dryRun)
         writeResourceFile(resourceFile, qsbcFiles, outDir);